@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bootstrap.h"
+#include "token_manager.h"
+
+#define BOOTSTRAP_MAX_IN_FLIGHT 64
+#define BOOTSTRAP_DEFAULT_TIMEOUT_MS 10000
+#define BOOTSTRAP_POLL_MS 10
+
+typedef enum {
+    FETCH_INSTRUMENTS,
+    FETCH_BOOK,
+    FETCH_POSITIONS,
+    FETCH_OPEN_ORDERS
+} FetchKind;
+
+typedef struct {
+    FetchKind kind;
+    int book_index;
+    char url[128];
+    char post_data[256];
+    DeribitRequestHandle handle;
+    bool done;
+    bool ok;
+} Fetch;
+
+// Results accumulate here and are handed to the caller only when complete
+typedef struct {
+    BootstrapState* state;
+    Fetch* fetches;
+    int completed;
+    bool failed;
+    DeribitError first_error;
+} BootstrapRun;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void record_failure(BootstrapRun* run, DeribitErrorCode code, const char* message) {
+    if (!run->failed) {
+        run->failed = true;
+        run->first_error.code = code;
+        snprintf(run->first_error.message, sizeof(run->first_error.message), "%s", message);
+    }
+}
+
+// Append count items of size bytes from *items to the staged array
+static bool append_items(void** array, int* array_count, void* items, int count, size_t size) {
+    if (count == 0) {
+        free(items);
+        return true;
+    }
+    void* grown = realloc(*array, (size_t)(*array_count + count) * size);
+    if (!grown) {
+        free(items);
+        return false;
+    }
+    memcpy((char*)grown + (size_t)*array_count * size, items, (size_t)count * size);
+    *array = grown;
+    *array_count += count;
+    free(items);
+    return true;
+}
+
+static bool apply_response(BootstrapRun* run, const Fetch* fetch, const char* response) {
+    BootstrapState* state = run->state;
+    size_t length = strlen(response);
+
+    switch (fetch->kind) {
+        case FETCH_INSTRUMENTS: {
+            DeribitInstrument* instruments = NULL;
+            int count = 0;
+            return deribit_parse_instruments(response, length, &instruments, &count) &&
+                   append_items((void**)&state->instruments, &state->instruments_count, instruments, count, sizeof(*instruments));
+        }
+        case FETCH_BOOK:
+            return deribit_parse_orderbook(response, length, &state->books[fetch->book_index]);
+        case FETCH_POSITIONS: {
+            Position* positions = NULL;
+            int count = 0;
+            return deribit_parse_positions(response, length, &positions, &count) &&
+                   append_items((void**)&state->positions, &state->positions_count, positions, count, sizeof(*positions));
+        }
+        case FETCH_OPEN_ORDERS: {
+            Order* orders = NULL;
+            int count = 0;
+            return parse_order_list(response, length, &orders, &count) &&
+                   append_items((void**)&state->open_orders, &state->open_orders_count, orders, count, sizeof(*orders));
+        }
+    }
+    return false;
+}
+
+static void on_fetch_complete(DeribitRequestHandle handle, const char* response, const DeribitError* error, void* user_data) {
+    BootstrapRun* run = user_data;
+    Fetch* fetch = NULL;
+    for (int i = 0; i < run->state->requests; i++) {
+        if (run->fetches[i].handle == handle && !run->fetches[i].done) {
+            fetch = &run->fetches[i];
+            break;
+        }
+    }
+    if (!fetch) {
+        return;
+    }
+
+    fetch->done = true;
+    run->completed++;
+    if (!response) {
+        record_failure(run, error->code, error->message);
+        return;
+    }
+    fetch->ok = apply_response(run, fetch, response);
+    if (!fetch->ok) {
+        char message[256];
+        snprintf(message, sizeof(message), "Unexpected response from %s", fetch->url);
+        record_failure(run, DERIBIT_ERROR_INTERNAL, message);
+    }
+}
+
+static void add_fetch(Fetch* fetches, int* count, FetchKind kind, int book_index, const char* method, const char* post_data) {
+    Fetch* fetch = &fetches[(*count)++];
+    memset(fetch, 0, sizeof(*fetch));
+    fetch->kind = kind;
+    fetch->book_index = book_index;
+    snprintf(fetch->url, sizeof(fetch->url), "https://www.deribit.com/api/v2/%s", method);
+    snprintf(fetch->post_data, sizeof(fetch->post_data), "%s", post_data);
+}
+
+static int plan_fetches(const BootstrapConfig* config, Fetch* fetches) {
+    int count = 0;
+    char post_data[256];
+    for (int i = 0; i < config->currency_count; i++) {
+        snprintf(post_data, sizeof(post_data), "{\"currency\":\"%s\"}", config->currencies[i]);
+        add_fetch(fetches, &count, FETCH_INSTRUMENTS, 0, "public/get_instruments", post_data);
+        add_fetch(fetches, &count, FETCH_POSITIONS, 0, "private/get_positions", post_data);
+        add_fetch(fetches, &count, FETCH_OPEN_ORDERS, 0, "private/get_open_orders_by_currency", post_data);
+    }
+    for (int i = 0; i < config->instrument_count; i++) {
+        snprintf(post_data, sizeof(post_data), "{\"instrument_name\":\"%s\",\"depth\":%d}",
+                 config->instruments[i], config->book_depth > 0 ? config->book_depth : 10);
+        add_fetch(fetches, &count, FETCH_BOOK, i, "public/get_order_book", post_data);
+    }
+    return count;
+}
+
+// Issue requests until the async client or the request credits push back;
+// returns false if a request could not be started for any other reason
+static bool submit_fetches(BootstrapRun* run, int* next) {
+    char access_token[DERIBIT_TOKEN_SIZE];
+    if (*next < run->state->requests && !token_manager_get(access_token, sizeof(access_token))) {
+        record_failure(run, DERIBIT_ERROR_AUTH, "No access token");
+        return false;
+    }
+    while (*next < run->state->requests) {
+        Fetch* fetch = &run->fetches[*next];
+        fetch->handle = deribit_async_request(fetch->url, fetch->post_data, access_token, on_fetch_complete, run);
+        if (fetch->handle == 0) {
+            DeribitError error = get_last_error();
+            if (error.code == DERIBIT_ERROR_BUSY || error.code == DERIBIT_ERROR_RATE_LIMIT) {
+                return true;            // Out of slots or credits; retry after the next poll
+            }
+            record_failure(run, error.code, error.message);
+            return false;
+        }
+        (*next)++;
+    }
+    return true;
+}
+
+static void cancel_outstanding(BootstrapRun* run, int submitted) {
+    for (int i = 0; i < submitted; i++) {
+        if (!run->fetches[i].done) {
+            deribit_async_cancel(run->fetches[i].handle);
+        }
+    }
+}
+
+bool bootstrap_run(const BootstrapConfig* config, BootstrapState* state) {
+    if (!config || !state || (config->currency_count > 0 && !config->currencies) ||
+        (config->instrument_count > 0 && !config->instruments) ||
+        config->currency_count < 0 || config->instrument_count < 0) {
+        printf("Invalid bootstrap configuration\n");
+        return false;
+    }
+    memset(state, 0, sizeof(*state));
+
+    double start = now_ms();
+    if (!token_manager_start(config->client_id, config->client_secret, 0)) {
+        printf("Bootstrap failed: authentication (%s)\n", get_last_error().message);
+        return false;
+    }
+    double authed = now_ms();
+
+    if (!deribit_async_init(BOOTSTRAP_MAX_IN_FLIGHT)) {
+        printf("Bootstrap failed: could not start the async client\n");
+        return false;
+    }
+
+    BootstrapState staging = {0};
+    BootstrapRun run = {0};
+    run.state = &staging;
+    run.fetches = calloc((size_t)(config->currency_count * 3 + config->instrument_count) + 1, sizeof(Fetch));
+    staging.books = config->instrument_count > 0 ? calloc((size_t)config->instrument_count, sizeof(OrderBook)) : NULL;
+    if (!run.fetches || (config->instrument_count > 0 && !staging.books)) {
+        printf("Bootstrap failed: out of memory\n");
+        free(run.fetches);
+        free(staging.books);
+        return false;
+    }
+    staging.books_count = config->instrument_count;
+    staging.requests = plan_fetches(config, run.fetches);
+
+    int timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : BOOTSTRAP_DEFAULT_TIMEOUT_MS;
+    double deadline = authed + timeout_ms;
+    int next = 0;
+    while (!run.failed && run.completed < staging.requests) {
+        if (!submit_fetches(&run, &next)) {
+            break;
+        }
+        if (now_ms() > deadline) {
+            record_failure(&run, DERIBIT_ERROR_NETWORK, "Timed out waiting for startup snapshot");
+            break;
+        }
+        if (deribit_async_poll(BOOTSTRAP_POLL_MS) == 0 && deribit_async_in_flight() == 0) {
+            // Nothing in flight: waiting on request credits
+            struct timespec pause = {0, 1000000};
+            nanosleep(&pause, NULL);
+        }
+    }
+    cancel_outstanding(&run, next);
+    free(run.fetches);
+
+    double ready = now_ms();
+    staging.auth_ms = authed - start;
+    staging.fetch_ms = ready - authed;
+    staging.time_to_ready_ms = ready - start;
+
+    if (run.failed) {
+        printf("Bootstrap failed after %.1f ms: %s\n", staging.time_to_ready_ms, run.first_error.message);
+        bootstrap_state_free(&staging);
+        return false;
+    }
+
+    *state = staging;
+    printf("Bootstrap ready in %.1f ms (auth %.1f ms, %d requests in %.1f ms): %d instruments, %d books, %d positions, %d open orders\n",
+           state->time_to_ready_ms, state->auth_ms, state->requests, state->fetch_ms,
+           state->instruments_count, state->books_count, state->positions_count, state->open_orders_count);
+    return true;
+}
+
+void bootstrap_state_free(BootstrapState* state) {
+    if (!state) {
+        return;
+    }
+    for (int i = 0; i < state->books_count; i++) {
+        free(state->books[i].bids);
+        free(state->books[i].asks);
+    }
+    free(state->books);
+    free(state->instruments);
+    free(state->positions);
+    free(state->open_orders);
+    memset(state, 0, sizeof(*state));
+}
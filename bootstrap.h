@@ -0,0 +1,54 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <stdbool.h>
+#include "order.h"
+#include "deribit_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Startup snapshot: authenticate once through the token manager, then fetch
+// instruments, order books, positions and open orders concurrently on the
+// deribit_async event loop
+
+typedef struct {
+    const char* client_id;
+    const char* client_secret;
+    const char* const* currencies;      // Instruments, positions and open orders per currency
+    int currency_count;
+    const char* const* instruments;     // Order books to snapshot
+    int instrument_count;
+    int book_depth;
+    int timeout_ms;                     // Whole fetch phase; 0 for the default
+} BootstrapConfig;
+
+typedef struct {
+    DeribitInstrument* instruments;
+    int instruments_count;
+    OrderBook* books;                   // One per configured instrument, same order
+    int books_count;
+    Position* positions;
+    int positions_count;
+    Order* open_orders;
+    int open_orders_count;
+
+    int requests;                       // Requests issued after authentication
+    double auth_ms;
+    double fetch_ms;
+    double time_to_ready_ms;            // auth_ms + fetch_ms
+} BootstrapState;
+
+// Fill state in one step once every request has succeeded; on failure state
+// is left empty and the first failed request is reported
+bool bootstrap_run(const BootstrapConfig* config, BootstrapState* state);
+
+// Release everything bootstrap_run allocated
+void bootstrap_state_free(BootstrapState* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOTSTRAP_H
@@ -1,12 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+#include <curl/curl.h>
 #include <cJSON.h>
 #include "deribit_api.h"
+#include "rate_limiter.h"
 
-// Global error state
-static DeribitError last_error = {DERIBIT_OK, ""};
+// Error state, per thread like the transport handles
+static __thread DeribitError last_error = {DERIBIT_OK, ""};
 
 // Set error message
 static void set_error(DeribitErrorCode code, const char* message) {
@@ -24,18 +28,88 @@ static void reset_error() {
     last_error.message[0] = '\0';
 }
 
-// Internal function to initialize response data
-typedef struct {
-    char* data;
-    size_t size;
-} ResponseData;
+// Receive buffers are pooled per thread and keep their capacity between requests
+#define RESPONSE_POOL_SIZE 8
+#define RESPONSE_INITIAL_CAPACITY 4096
+#define RESPONSE_MAX_RETAINED (1024 * 1024)
+
+typedef DeribitResponse ResponseData;
+
+static __thread ResponseData* response_pool[RESPONSE_POOL_SIZE];
+static __thread int response_pool_count = 0;
+
+// Make room for at least needed bytes plus the terminator, doubling as it grows
+static bool reserve_response(ResponseData* response, size_t needed) {
+    if (needed + 1 <= response->capacity) {
+        return true;
+    }
+    size_t capacity = response->capacity ? response->capacity : RESPONSE_INITIAL_CAPACITY;
+    while (capacity < needed + 1) {
+        capacity *= 2;
+    }
+    char* data = realloc(response->data, capacity);
+    if (!data) {
+        return false;
+    }
+    response->data = data;
+    response->capacity = capacity;
+    return true;
+}
 
 static void init_response_data(ResponseData* response) {
-    response->data = malloc(1);
-    if (response->data) {
+    response->size = 0;
+    if (reserve_response(response, 0)) {
         response->data[0] = '\0';
     }
-    response->size = 0;
+}
+
+static bool append_response(ResponseData* response, const char* data, size_t size) {
+    if (!reserve_response(response, response->size + size)) {
+        return false;
+    }
+    memcpy(response->data + response->size, data, size);
+    response->size += size;
+    response->data[response->size] = '\0';
+    return true;
+}
+
+static ResponseData* acquire_response(void) {
+    ResponseData* response;
+    if (response_pool_count > 0) {
+        response = response_pool[--response_pool_count];
+    } else {
+        response = calloc(1, sizeof(ResponseData));
+        if (!response) {
+            return NULL;
+        }
+    }
+    init_response_data(response);
+    if (!response->data) {
+        free(response);
+        return NULL;
+    }
+    return response;
+}
+
+void deribit_response_release(ResponseData* response) {
+    if (!response) {
+        return;
+    }
+    // Oversized buffers go back to the allocator rather than pinning memory
+    if (response_pool_count < RESPONSE_POOL_SIZE && response->capacity <= RESPONSE_MAX_RETAINED) {
+        response_pool[response_pool_count++] = response;
+        return;
+    }
+    free(response->data);
+    free(response);
+}
+
+static void free_response_pool(void) {
+    while (response_pool_count > 0) {
+        ResponseData* response = response_pool[--response_pool_count];
+        free(response->data);
+        free(response);
+    }
 }
 
 // Callback function for receiving HTTP response data
@@ -43,24 +117,315 @@ static size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdat
     size_t real_size = size * nmemb;
     ResponseData* response = (ResponseData*)userdata;
     
-    char* new_data = realloc(response->data, response->size + real_size + 1);
-    if (!new_data) {
+    if (!append_response(response, ptr, real_size)) {
         fprintf(stderr, "Failed to allocate memory for response\n");
         return 0;
     }
     
-    response->data = new_data;
-    memcpy(&(response->data[response->size]), ptr, real_size);
-    response->size += real_size;
-    response->data[response->size] = '\0';
-    
     return real_size;
 }
 
-// Helper function to perform HTTP requests
-// This is a placeholder for the actual curl implementation
-// In a real implementation, you would use curl_easy_init(), curl_easy_setopt(), etc.
-char* perform_request(const char* url, const char* post_data, const char* access_token) {
+// Transport state
+static DeribitTransport transport = DERIBIT_TRANSPORT_MOCK;
+static DeribitHttpVersion http_version = DERIBIT_HTTP_1_1;   // Atomic: any request thread may fall back
+static char base_url[256] = DERIBIT_DEFAULT_BASE_URL;
+static pthread_once_t transport_once = PTHREAD_ONCE_INIT;
+static CURLSH* transport_share = NULL;
+static pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+
+// Request headers, rebuilt only when the token changes
+typedef struct {
+    struct curl_slist* list;
+    char token[1024];
+} HeaderCache;
+
+// One long-lived handle per thread keeps its connection, DNS entry and TLS session warm
+static __thread CURL* thread_handle = NULL;
+static __thread HeaderCache thread_headers = {NULL, {0}};
+static __thread unsigned int thread_request_id = 0;
+static __thread int thread_http_version = 0;
+
+static void share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    pthread_mutex_lock(&share_locks[data]);
+}
+
+static void share_unlock(CURL* handle, curl_lock_data data, void* userptr) {
+    (void)handle;
+    (void)userptr;
+    pthread_mutex_unlock(&share_locks[data]);
+}
+
+static void transport_global_init(void) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&share_locks[i], NULL);
+    }
+
+    // DNS results and TLS sessions are shared so a new thread's first request
+    // resumes a session instead of doing a full handshake
+    transport_share = curl_share_init();
+    if (transport_share) {
+        curl_share_setopt(transport_share, CURLSHOPT_LOCKFUNC, share_lock);
+        curl_share_setopt(transport_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(transport_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(transport_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+}
+
+// Options common to every handle we create
+static CURL* create_handle(void) {
+    pthread_once(&transport_once, transport_global_init);
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return NULL;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, transport_share);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+    curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 600L);
+    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, 4L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 10000L);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    return curl;
+}
+
+static DeribitHttpVersion current_http_version(void) {
+    return __atomic_load_n(&http_version, __ATOMIC_RELAXED);
+}
+
+static long curl_http_version(void) {
+    switch (current_http_version()) {
+        case DERIBIT_HTTP_2: return CURL_HTTP_VERSION_2TLS;
+        case DERIBIT_HTTP_2_PRIOR_KNOWLEDGE: return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+        default: return CURL_HTTP_VERSION_1_1;
+    }
+}
+
+static void fall_back_to_http1(DeribitHttpVersion from) {
+    if (__atomic_compare_exchange_n(&http_version, &from, DERIBIT_HTTP_1_1, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        printf("HTTP/2 not available, falling back to HTTP/1.1\n");
+    }
+}
+
+// A server without HTTP/2 cannot answer a prior-knowledge request: a new
+// connection opens but no response of any HTTP version comes back (the error
+// code varies by libcurl release). Drop to HTTP/1.1 for good rather than
+// failing every request; true if the request may be sent again.
+static bool http2_fallback(CURL* curl, CURLcode res) {
+    if (res == CURLE_OK || res == CURLE_OPERATION_TIMEDOUT ||
+        current_http_version() != DERIBIT_HTTP_2_PRIOR_KNOWLEDGE) {
+        return false;
+    }
+    long version = 0;
+    curl_off_t connect_us = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect_us);
+    if (version != 0 || connect_us == 0) {
+        return false;
+    }
+    fall_back_to_http1(DERIBIT_HTTP_2_PRIOR_KNOWLEDGE);
+    return true;
+}
+
+// Record the protocol the server actually answered with. Over https, ALPN
+// settling on HTTP/1.1 means the server has no HTTP/2 either.
+static void note_http_version(CURL* curl) {
+    long version = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_VERSION, &version);
+    thread_http_version = version >= CURL_HTTP_VERSION_2_0 ? 2 : version > 0 ? 1 : 0;
+    if (thread_http_version == 1 && current_http_version() == DERIBIT_HTTP_2) {
+        fall_back_to_http1(DERIBIT_HTTP_2);
+    }
+}
+
+static CURL* get_thread_handle(void) {
+    if (!thread_handle) {
+        thread_handle = create_handle();
+    }
+    return thread_handle;
+}
+
+static struct curl_slist* headers_for_token(HeaderCache* cache, const char* access_token) {
+    const char* token = access_token ? access_token : "";
+    if (cache->list && strcmp(cache->token, token) == 0) {
+        return cache->list;
+    }
+
+    curl_slist_free_all(cache->list);
+    cache->list = curl_slist_append(NULL, "Content-Type: application/json");
+    if (token[0]) {
+        char auth_header[1100];
+        snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", token);
+        cache->list = curl_slist_append(cache->list, auth_header);
+    }
+    strncpy(cache->token, token, sizeof(cache->token) - 1);
+    cache->token[sizeof(cache->token) - 1] = '\0';
+    return cache->list;
+}
+
+static void free_header_cache(HeaderCache* cache) {
+    curl_slist_free_all(cache->list);
+    cache->list = NULL;
+    cache->token[0] = '\0';
+}
+
+void deribit_set_transport(DeribitTransport mode) {
+    transport = mode;
+}
+
+void deribit_set_http_version(DeribitHttpVersion version) {
+    __atomic_store_n(&http_version, version, __ATOMIC_RELAXED);
+}
+
+DeribitHttpVersion deribit_get_http_version(void) {
+    return current_http_version();
+}
+
+int deribit_last_http_version(void) {
+    return thread_http_version;
+}
+
+bool deribit_set_base_url(const char* url) {
+    if (!url || strlen(url) >= sizeof(base_url)) {
+        return false;
+    }
+    strcpy(base_url, url);
+    size_t len = strlen(base_url);
+    if (len > 0 && base_url[len - 1] == '/') {
+        base_url[len - 1] = '\0';
+    }
+    return true;
+}
+
+void deribit_transport_thread_cleanup(void) {
+    if (thread_handle) {
+        curl_easy_cleanup(thread_handle);
+        thread_handle = NULL;
+    }
+    free_header_cache(&thread_headers);
+    free_response_pool();
+}
+
+void deribit_transport_cleanup(void) {
+    deribit_transport_thread_cleanup();
+    if (transport_share) {
+        curl_share_cleanup(transport_share);
+        transport_share = NULL;
+    }
+}
+
+// Callers build URLs against the production host; map them onto base_url
+static bool build_request_url(const char* url, char* out, size_t out_size) {
+    const char* path = url;
+    size_t prefix_len = strlen(DERIBIT_DEFAULT_BASE_URL);
+    if (strncmp(url, DERIBIT_DEFAULT_BASE_URL, prefix_len) == 0) {
+        path = url + prefix_len;
+    } else if (strstr(url, "://")) {
+        path = NULL;
+    }
+
+    int n = path ? snprintf(out, out_size, "%s%s", base_url, path) : snprintf(out, out_size, "%s", url);
+    return n > 0 && (size_t)n < out_size;
+}
+
+// JSON-RPC method named by a REST URL ("private/buy")
+static const char* request_method(const char* url) {
+    const char* method = strstr(url, "/api/v2/");
+    return method ? method + strlen("/api/v2/") : url;
+}
+
+// Reads may be sent twice; order entry never is, in case the first one landed
+static bool retry_safe(const char* url) {
+    const char* method = request_method(url);
+    return strncmp(method, "public/", 7) == 0 || strncmp(method, "private/get_", 12) == 0;
+}
+
+// Deribit accepts JSON-RPC over POST; the method is the path after /api/v2/.
+// Returns the length needed, like snprintf.
+
+static int format_jsonrpc_body(char* out, size_t out_size, const char* url, const char* post_data, unsigned int id) {
+    const char* method = request_method(url);
+    return snprintf(out, out_size, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"%s\",\"params\":%s}",
+                    id, method, post_data ? post_data : "{}");
+}
+
+static bool perform_http_request(const char* url, const char* post_data, const char* access_token, ResponseData* response) {
+    CURL* curl = get_thread_handle();
+    if (!curl) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to initialize HTTP handle");
+        return false;
+    }
+
+    char full_url[512];
+    if (!build_request_url(url, full_url, sizeof(full_url))) {
+        set_error(DERIBIT_ERROR_PARAMS, "Request URL too long");
+        return false;
+    }
+
+    char stack_body[1024];
+    char* body = stack_body;
+    unsigned int id = ++thread_request_id;
+    int body_len = format_jsonrpc_body(stack_body, sizeof(stack_body), url, post_data, id);
+    if (body_len < 0) {
+        set_error(DERIBIT_ERROR_PARAMS, "Failed to format request");
+        return false;
+    }
+    if ((size_t)body_len >= sizeof(stack_body)) {
+        body = malloc((size_t)body_len + 1);
+        if (!body) {
+            set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate request body");
+            return false;
+        }
+        format_jsonrpc_body(body, (size_t)body_len + 1, url, post_data, id);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, full_url);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body_len);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers_for_token(&thread_headers, access_token));
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, curl_http_version());
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK && http2_fallback(curl, res) && retry_safe(url)) {
+        response->size = 0;
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, curl_http_version());
+        res = curl_easy_perform(curl);
+    }
+    if (body != stack_body) {
+        free(body);
+    }
+
+    if (res != CURLE_OK) {
+        set_error(DERIBIT_ERROR_NETWORK, curl_easy_strerror(res));
+        return false;
+    }
+
+    note_http_version(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status == 429) {
+        set_error(DERIBIT_ERROR_RATE_LIMIT, "Rate limit exceeded");
+        return false;
+    }
+
+    // Error bodies (HTTP 400 and friends) still carry a JSON-RPC error for parse_api_error
+    return true;
+}
+
+// Canned responses for offline runs
+static const char* mock_response_body(const char* url, const char* post_data, const char* access_token) {
     // Simulate successful request for testing
     printf("Performing request to: %s\n", url);
     if (post_data) {
@@ -70,92 +435,491 @@ char* perform_request(const char* url, const char* post_data, const char* access
         printf("Using access token: %s\n", access_token);
     }
     
-    // Create a dummy response for testing purposes
-    // In a real implementation, this would contain the actual API response
-    
     // Determine which API endpoint we're hitting to craft an appropriate dummy response
     if (strstr(url, "get_access_token") || strstr(url, "auth")) {
         // Authentication response
-        char* response = malloc(256);
-        sprintf(response, "{\"result\":{\"access_token\":\"dummy_token\",\"expires_in\":3600},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+        return "{\"result\":{\"access_token\":\"dummy_token\",\"refresh_token\":\"dummy_refresh_token\",\"expires_in\":3600},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     } 
     else if (strstr(url, "get_order_book")) {
         // Orderbook response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":{"
             "\"bids\":[[25000.0,0.5],[24950.0,1.2],[24900.0,0.8]],"
             "\"asks\":[[25050.0,0.3],[25100.0,0.9],[25150.0,1.5]],"
             "\"timestamp\":1621234567890"
-            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     } 
     else if (strstr(url, "get_positions")) {
         // Positions response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":["
             "{\"instrument_name\":\"BTC-PERPETUAL\",\"size\":0.5,\"average_price\":25000.0,\"mark_price\":25050.0,\"floating_profit_loss\":0.00125,\"realized_profit_loss\":0.0035,\"last_update_timestamp\":1621234567890}"
-            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     } 
     else if (strstr(url, "get_open_orders")) {
         // Open orders response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":["
             "{\"order_id\":\"ETH-12345\",\"instrument_name\":\"BTC-PERPETUAL\",\"price\":25000.0,\"amount\":0.1,\"direction\":\"buy\",\"order_type\":\"limit\",\"order_state\":\"open\",\"creation_timestamp\":1621234567890,\"last_update_timestamp\":1621234567890}"
-            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     }
     else if (strstr(url, "get_instruments")) {
         // Instruments response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":["
             "{\"instrument_name\":\"BTC-PERPETUAL\",\"kind\":\"future\",\"base_currency\":\"BTC\",\"quote_currency\":\"USD\",\"tick_size\":0.5,\"min_trade_amount\":0.001},"
             "{\"instrument_name\":\"ETH-PERPETUAL\",\"kind\":\"future\",\"base_currency\":\"ETH\",\"quote_currency\":\"USD\",\"tick_size\":0.05,\"min_trade_amount\":0.01}"
-            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     }
     else if (strstr(url, "get_account_summary")) {
         // Account summary response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":{"
             "\"equity\":1.0,\"available_funds\":0.9,\"balance\":1.0,\"initial_margin\":0.1,\"maintenance_margin\":0.05,"
             "\"margin_balance\":1.0,\"session_upl\":0.01,\"session_rpl\":0.005,\"session_funding\":0.001"
-            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     }
     else if (strstr(url, "get_trades")) {
         // Trades response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":["
             "{\"trade_id\":\"12345\",\"instrument_name\":\"BTC-PERPETUAL\",\"price\":25000.0,\"amount\":0.1,\"direction\":\"buy\",\"timestamp\":1621234567890},"
             "{\"trade_id\":\"12346\",\"instrument_name\":\"BTC-PERPETUAL\",\"price\":25005.0,\"amount\":0.2,\"direction\":\"sell\",\"timestamp\":1621234567891}"
-            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "],\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     }
     else if (strstr(url, "get_ticker")) {
         // Ticker response
-        char* response = malloc(1024);
-        sprintf(response, 
+        return
             "{\"result\":{"
             "\"instrument_name\":\"BTC-PERPETUAL\",\"last_price\":25000.0,\"best_bid_price\":24995.0,\"best_ask_price\":25005.0,"
             "\"best_bid_amount\":0.5,\"best_ask_amount\":0.3,\"mark_price\":25001.0,\"index_price\":25002.0,\"volume\":100.5,"
             "\"open_interest\":1000.0,\"timestamp\":1621234567890"
-            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+            "},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
     }
     else {
         // Generic response for other endpoints
-        char* response = malloc(256);
-        sprintf(response, "{\"result\":{\"success\":true},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}");
-        return response;
+        return "{\"result\":{\"success\":true},\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}";
+    }
+}
+
+// Write the canned response straight into the receive buffer
+static bool perform_mock_request(const char* url, const char* post_data, const char* access_token, ResponseData* response) {
+    const char* body = mock_response_body(url, post_data, access_token);
+    if (!append_response(response, body, strlen(body))) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate memory for response");
+        return false;
+    }
+    return true;
+}
+
+ResponseData* perform_request_pooled(const char* url, const char* post_data, const char* access_token) {
+    if (!url) {
+        return NULL;
+    }
+    if (!rate_limit_admit(request_method(url))) {
+        set_error(DERIBIT_ERROR_RATE_LIMIT, "Request credits exhausted");
+        return NULL;
+    }
+    ResponseData* response = acquire_response();
+    if (!response) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate memory for response");
+        return NULL;
+    }
+
+    bool ok = transport == DERIBIT_TRANSPORT_HTTP
+        ? perform_http_request(url, post_data, access_token, response)
+        : perform_mock_request(url, post_data, access_token, response);
+    if (!ok) {
+        deribit_response_release(response);
+        return NULL;
+    }
+    return response;
+}
+
+char* perform_request(const char* url, const char* post_data, const char* access_token) {
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
+    if (!response) {
+        return NULL;
+    }
+    // Hand over the buffer itself rather than copying it; the pool allocates a new one
+    char* data = response->data;
+    free(response);
+    return data;
+}
+
+// Asynchronous requests: many in flight on one curl multi event loop,
+// driven by deribit_async_poll from the caller's thread
+#define ASYNC_HANDLE_SLOT_BITS 16
+
+typedef struct {
+    bool in_use;
+    bool done;                   // Mock mode: completes on the next poll
+    bool completing;             // Callback running; response buffer still in use
+    bool waiting;                // Held for its rate limit slot, not yet sent
+    uint64_t send_at_ns;
+    char method[64];             // Pool the credits were booked against
+    uint32_t generation;
+    CURL* easy;
+    HeaderCache headers;
+    ResponseData response;       // Owned by the slot, keeps its capacity
+    char* body;
+    size_t body_capacity;
+    DeribitCompletionCallback callback;
+    void* user_data;
+} AsyncRequest;
+
+static CURLM* async_multi = NULL;
+static AsyncRequest* async_requests = NULL;
+static int async_capacity = 0;
+static int async_in_flight = 0;
+static bool async_closing = false;  // Cleanup is cancelling; callbacks may not issue requests
+static unsigned int async_request_id = 0;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static DeribitRequestHandle make_handle(int slot) {
+    return ((DeribitRequestHandle)async_requests[slot].generation << ASYNC_HANDLE_SLOT_BITS) | (DeribitRequestHandle)slot;
+}
+
+static int slot_from_handle(DeribitRequestHandle handle) {
+    int slot = (int)(handle & ((1u << ASYNC_HANDLE_SLOT_BITS) - 1));
+    if (slot >= async_capacity || !async_requests[slot].in_use ||
+        async_requests[slot].generation != (uint32_t)(handle >> ASYNC_HANDLE_SLOT_BITS)) {
+        return -1;
+    }
+    return slot;
+}
+
+bool deribit_async_init(int max_in_flight) {
+    if (async_requests) {
+        return true;
+    }
+    if (max_in_flight <= 0 || max_in_flight > (1 << ASYNC_HANDLE_SLOT_BITS)) {
+        return false;
+    }
+
+    pthread_once(&transport_once, transport_global_init);
+    async_multi = curl_multi_init();
+    async_requests = calloc(max_in_flight, sizeof(AsyncRequest));
+    if (!async_multi || !async_requests) {
+        deribit_async_cleanup();
+        return false;
+    }
+    async_capacity = max_in_flight;
+
+    // Parallel HTTP/1.1 connections to the same host, all kept alive in the
+    // multi's pool; with HTTP/2 requests become streams on one connection
+    curl_multi_setopt(async_multi, CURLMOPT_MAX_HOST_CONNECTIONS, 8L);
+    curl_multi_setopt(async_multi, CURLMOPT_MAXCONNECTS, 16L);
+    curl_multi_setopt(async_multi, CURLMOPT_MAX_CONCURRENT_STREAMS, 256L);
+    curl_multi_setopt(async_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    return true;
+}
+
+static void release_slot(int slot) {
+    AsyncRequest* req = &async_requests[slot];
+    req->response.size = 0;
+    req->in_use = false;
+    req->done = false;
+    req->completing = false;
+    req->waiting = false;
+    async_in_flight--;
+}
+
+static void complete_slot(int slot, const DeribitError* error) {
+    AsyncRequest* req = &async_requests[slot];
+
+    // The slot stays taken while the callback reads its buffer, so requests
+    // issued from the callback land in other slots
+    req->completing = true;
+    if (req->callback) {
+        req->callback(make_handle(slot), error->code == DERIBIT_OK ? req->response.data : NULL, error, req->user_data);
+    }
+    release_slot(slot);
+}
+
+DeribitRequestHandle deribit_async_request(const char* url, const char* post_data, const char* access_token,
+                                           DeribitCompletionCallback callback, void* user_data) {
+    if (!async_requests || !url || async_closing) {
+        return 0;
+    }
+
+    // Credits are spent last, once the request is certain to go out
+    int slot = -1;
+    for (int i = 0; i < async_capacity; i++) {
+        if (!async_requests[i].in_use) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        set_error(DERIBIT_ERROR_BUSY, "Too many requests in flight");
+        return 0;
+    }
+
+    AsyncRequest* req = &async_requests[slot];
+    req->generation++;
+    if (req->generation == 0 || (req->generation >> (32 - ASYNC_HANDLE_SLOT_BITS)) != 0) {
+        req->generation = 1;
+    }
+    req->callback = callback;
+    req->user_data = user_data;
+    snprintf(req->method, sizeof(req->method), "%s", request_method(url));
+
+    if (transport != DERIBIT_TRANSPORT_HTTP) {
+        init_response_data(&req->response);
+        if (!perform_mock_request(url, post_data, access_token, &req->response)) {
+            return 0;
+        }
+        uint64_t delay = rate_limit_book(req->method);
+        if (delay == RATE_LIMIT_NEVER) {
+            set_error(DERIBIT_ERROR_RATE_LIMIT, "Request credits exhausted");
+            return 0;
+        }
+        req->in_use = true;
+        req->waiting = delay > 0;
+        req->send_at_ns = monotonic_ns() + delay;
+        req->done = !req->waiting;
+        async_in_flight++;
+        return make_handle(slot);
+    }
+
+    if (!req->easy) {
+        req->easy = create_handle();
+        if (!req->easy) {
+            set_error(DERIBIT_ERROR_INTERNAL, "Failed to initialize HTTP handle");
+            return 0;
+        }
+        curl_easy_setopt(req->easy, CURLOPT_PRIVATE, (void*)(intptr_t)slot);
+    }
+
+    char full_url[512];
+    if (!build_request_url(url, full_url, sizeof(full_url))) {
+        set_error(DERIBIT_ERROR_PARAMS, "Request URL too long");
+        return 0;
+    }
+
+    unsigned int id = ++async_request_id;
+    int body_len = format_jsonrpc_body(req->body, req->body_capacity, url, post_data, id);
+    if (body_len < 0) {
+        set_error(DERIBIT_ERROR_PARAMS, "Failed to format request");
+        return 0;
+    }
+    if ((size_t)body_len >= req->body_capacity) {
+        size_t capacity = (size_t)body_len + 1 > 1024 ? (size_t)body_len + 1 : 1024;
+        char* body = realloc(req->body, capacity);
+        if (!body) {
+            set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate request body");
+            return 0;
+        }
+        req->body = body;
+        req->body_capacity = capacity;
+        format_jsonrpc_body(req->body, req->body_capacity, url, post_data, id);
+    }
+
+    init_response_data(&req->response);
+    if (!req->response.data) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate memory for response");
+        return 0;
+    }
+    curl_easy_setopt(req->easy, CURLOPT_URL, full_url);
+    curl_easy_setopt(req->easy, CURLOPT_POSTFIELDS, req->body);
+    curl_easy_setopt(req->easy, CURLOPT_POSTFIELDSIZE, (long)body_len);
+    curl_easy_setopt(req->easy, CURLOPT_HTTPHEADER, headers_for_token(&req->headers, access_token));
+    curl_easy_setopt(req->easy, CURLOPT_WRITEDATA, &req->response);
+    curl_easy_setopt(req->easy, CURLOPT_HTTP_VERSION, curl_http_version());
+    // Wait for the existing connection to confirm multiplexing instead of opening another
+    curl_easy_setopt(req->easy, CURLOPT_PIPEWAIT, current_http_version() == DERIBIT_HTTP_1_1 ? 0L : 1L);
+
+    // Never sleeps here: a request over its pool's rate is held in the slot
+    // and handed to the multi by deribit_async_poll once its slot comes up
+    uint64_t delay = rate_limit_book(req->method);
+    if (delay == RATE_LIMIT_NEVER) {
+        set_error(DERIBIT_ERROR_RATE_LIMIT, "Request credits exhausted");
+        return 0;
+    }
+    if (delay == RATE_LIMIT_GRANTED) {
+        CURLMcode mres = curl_multi_add_handle(async_multi, req->easy);
+        if (mres != CURLM_OK) {
+            rate_limit_refund(req->method);
+            set_error(DERIBIT_ERROR_INTERNAL, curl_multi_strerror(mres));
+            return 0;
+        }
+    }
+
+    req->in_use = true;
+    req->waiting = delay > 0;
+    req->send_at_ns = monotonic_ns() + delay;
+    async_in_flight++;
+    return make_handle(slot);
+}
+
+// Send held requests whose rate limit slot has come up; returns failures delivered
+static int start_due_requests(void) {
+    int completed = 0;
+    uint64_t now = monotonic_ns();
+    for (int i = 0; i < async_capacity; i++) {
+        AsyncRequest* req = &async_requests[i];
+        if (!req->in_use || !req->waiting || req->send_at_ns > now) {
+            continue;
+        }
+        req->waiting = false;
+        if (transport != DERIBIT_TRANSPORT_HTTP) {
+            req->done = true;
+            continue;
+        }
+        CURLMcode mres = curl_multi_add_handle(async_multi, req->easy);
+        if (mres != CURLM_OK) {
+            rate_limit_refund(req->method);
+            DeribitError error = {DERIBIT_ERROR_INTERNAL, ""};
+            strncpy(error.message, curl_multi_strerror(mres), sizeof(error.message) - 1);
+            complete_slot(i, &error);
+            completed++;
+        }
+    }
+    return completed;
+}
+
+// Mock completions are immediate
+static int complete_mock_requests(void) {
+    int completed = 0;
+    for (int i = 0; i < async_capacity; i++) {
+        if (async_requests[i].in_use && async_requests[i].done) {
+            DeribitError ok = {DERIBIT_OK, ""};
+            complete_slot(i, &ok);
+            completed++;
+        }
+    }
+    return completed;
+}
+
+// Cap a poll timeout at the next held request's send time; -1 if none is held
+static int held_request_wait_ms(int timeout_ms) {
+    uint64_t now = monotonic_ns();
+    int wait = -1;
+    for (int i = 0; i < async_capacity; i++) {
+        AsyncRequest* req = &async_requests[i];
+        if (!req->in_use || !req->waiting) {
+            continue;
+        }
+        uint64_t due = req->send_at_ns > now ? (req->send_at_ns - now + 999999) / 1000000 : 0;
+        int due_ms = due < (uint64_t)timeout_ms ? (int)due : timeout_ms;
+        if (wait < 0 || due_ms < wait) {
+            wait = due_ms;
+        }
+    }
+    return wait;
+}
+
+int deribit_async_poll(int timeout_ms) {
+    if (!async_requests) {
+        return 0;
+    }
+
+    int completed = start_due_requests();
+    completed += complete_mock_requests();
+    if (completed > 0 || !async_multi) {
+        return completed;
+    }
+
+    int running = 0;
+    curl_multi_perform(async_multi, &running);
+    int held_wait = held_request_wait_ms(timeout_ms);
+    if ((running > 0 || held_wait >= 0) && timeout_ms > 0) {
+        curl_multi_poll(async_multi, NULL, 0, held_wait >= 0 ? held_wait : timeout_ms, NULL);
+        completed += start_due_requests();
+        completed += complete_mock_requests();
+        curl_multi_perform(async_multi, &running);
+    }
+
+    CURLMsg* msg;
+    int queued;
+    while ((msg = curl_multi_info_read(async_multi, &queued)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        CURL* easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        void* priv = NULL;
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+        curl_multi_remove_handle(async_multi, easy);
+        int slot = (int)(intptr_t)priv;
+
+        DeribitError error = {DERIBIT_OK, ""};
+        long status = 0;
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+        if (result == CURLE_OK) {
+            note_http_version(easy);
+        }
+        if (result != CURLE_OK) {
+            http2_fallback(easy, result);
+            error.code = DERIBIT_ERROR_NETWORK;
+            strncpy(error.message, curl_easy_strerror(result), sizeof(error.message) - 1);
+        } else if (status == 429) {
+            error.code = DERIBIT_ERROR_RATE_LIMIT;
+            strncpy(error.message, "Rate limit exceeded", sizeof(error.message) - 1);
+        }
+
+        complete_slot(slot, &error);
+        completed++;
+    }
+    return completed;
+}
+
+bool deribit_async_cancel(DeribitRequestHandle handle) {
+    if (!async_requests) {
+        return false;
+    }
+    int slot = slot_from_handle(handle);
+    if (slot < 0 || async_requests[slot].completing) {
+        return false;
+    }
+    if (async_requests[slot].waiting) {
+        rate_limit_refund(async_requests[slot].method);
+    } else if (async_requests[slot].easy && !async_requests[slot].done) {
+        curl_multi_remove_handle(async_multi, async_requests[slot].easy);
+    }
+    DeribitError cancelled = {DERIBIT_ERROR_CANCELLED, "Request cancelled"};
+    complete_slot(slot, &cancelled);
+    return true;
+}
+
+int deribit_async_in_flight(void) {
+    return async_in_flight;
+}
+
+void deribit_async_cleanup(void) {
+    if (async_requests) {
+        async_closing = true;
+        for (int i = 0; i < async_capacity; i++) {
+            if (async_requests[i].in_use && !async_requests[i].completing) {
+                deribit_async_cancel(make_handle(i));
+            }
+        }
+        async_closing = false;
+        for (int i = 0; i < async_capacity; i++) {
+            AsyncRequest* req = &async_requests[i];
+            if (req->easy) {
+                curl_easy_cleanup(req->easy);
+            }
+            free_header_cache(&req->headers);
+            free(req->response.data);
+            free(req->body);
+        }
+        free(async_requests);
+        async_requests = NULL;
     }
+    if (async_multi) {
+        curl_multi_cleanup(async_multi);
+        async_multi = NULL;
+    }
+    async_capacity = 0;
+    async_in_flight = 0;
 }
 
 // Parse API error from response
@@ -191,61 +955,311 @@ DeribitError get_last_error() {
 }
 
 // Authentication
-bool get_access_token(const char* client_id, const char* client_secret, char* access_token) {
+static bool request_auth(const char* post_data, DeribitAuthResult* out) {
+    ResponseData* response = perform_request_pooled("https://www.deribit.com/api/v2/public/auth", post_data, NULL);
+    if (!response) {
+        set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
+        return false;
+    }
+    
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
+        return false;
+    }
+    
+    cJSON* json = cJSON_ParseWithLength(response->data, response->size);
+    if (!json) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
+        deribit_response_release(response);
+        return false;
+    }
+    
+    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
+    if (!cJSON_IsObject(result)) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
+        cJSON_Delete(json);
+        deribit_response_release(response);
+        return false;
+    }
+    
+    cJSON* token = cJSON_GetObjectItemCaseSensitive(result, "access_token");
+    if (!cJSON_IsString(token) || !token->valuestring || strlen(token->valuestring) >= DERIBIT_TOKEN_SIZE) {
+        set_error(DERIBIT_ERROR_INTERNAL, "No access token in response");
+        cJSON_Delete(json);
+        deribit_response_release(response);
+        return false;
+    }
+    strcpy(out->access_token, token->valuestring);
+    
+    cJSON* refresh = cJSON_GetObjectItemCaseSensitive(result, "refresh_token");
+    out->refresh_token[0] = '\0';
+    if (cJSON_IsString(refresh) && refresh->valuestring && strlen(refresh->valuestring) < DERIBIT_TOKEN_SIZE) {
+        strcpy(out->refresh_token, refresh->valuestring);
+    }
+    
+    cJSON* expires_in = cJSON_GetObjectItemCaseSensitive(result, "expires_in");
+    out->expires_in = cJSON_IsNumber(expires_in) ? expires_in->valueint : 0;
+    
+    cJSON_Delete(json);
+    deribit_response_release(response);
+    return true;
+}
+
+bool deribit_authenticate(const char* client_id, const char* client_secret, DeribitAuthResult* result) {
     reset_error();
     
-    if (!client_id || !client_secret || !access_token) {
+    if (!client_id || !client_secret || !result) {
         set_error(DERIBIT_ERROR_PARAMS, "Invalid parameters for authentication");
         return false;
     }
 
-    char url[256] = {0};
     char post_data[512] = {0};
-    
-    snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/public/auth");
-    snprintf(post_data, sizeof(post_data), 
+    int len = snprintf(post_data, sizeof(post_data), 
         "{\"grant_type\":\"client_credentials\",\"client_id\":\"%s\",\"client_secret\":\"%s\"}",
         client_id, client_secret);
+    if (len < 0 || (size_t)len >= sizeof(post_data)) {
+        set_error(DERIBIT_ERROR_PARAMS, "Credentials too long");
+        return false;
+    }
+    return request_auth(post_data, result);
+}
+
+bool deribit_refresh_token(const char* refresh_token, DeribitAuthResult* result) {
+    reset_error();
     
-    char* response = perform_request(url, post_data, NULL);
-    if (!response) {
-        set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
+    if (!refresh_token || !refresh_token[0] || !result) {
+        set_error(DERIBIT_ERROR_PARAMS, "Invalid parameters for token refresh");
+        return false;
+    }
+
+    char post_data[DERIBIT_TOKEN_SIZE + 64];
+    int len = snprintf(post_data, sizeof(post_data), 
+        "{\"grant_type\":\"refresh_token\",\"refresh_token\":\"%s\"}", refresh_token);
+    if (len < 0 || (size_t)len >= sizeof(post_data)) {
+        set_error(DERIBIT_ERROR_PARAMS, "Refresh token too long");
+        return false;
+    }
+    return request_auth(post_data, result);
+}
+
+bool get_access_token(const char* client_id, const char* client_secret, char* access_token) {
+    if (!access_token) {
+        reset_error();
+        set_error(DERIBIT_ERROR_PARAMS, "Invalid parameters for authentication");
+        return false;
+    }
+    
+    DeribitAuthResult result;
+    if (!deribit_authenticate(client_id, client_secret, &result)) {
+        return false;
+    }
+    strcpy(access_token, result.access_token);
+    return true;
+}
+
+// Parse a get_instruments response
+bool deribit_parse_instruments(const char* data, size_t length, DeribitInstrument** instruments, int* instruments_count) {
+    cJSON* json = cJSON_ParseWithLength(data, length);
+    if (!json) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
+        return false;
+    }
+    
+    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
+    if (!cJSON_IsArray(result)) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
+        cJSON_Delete(json);
+        return false;
+    }
+    
+    int count = cJSON_GetArraySize(result);
+    *instruments_count = count;
+    *instruments = NULL;
+    
+    if (count > 0) {
+        *instruments = (DeribitInstrument*)calloc(count, sizeof(DeribitInstrument));
+        if (!*instruments) {
+            set_error(DERIBIT_ERROR_INTERNAL, "Failed to allocate instruments");
+            cJSON_Delete(json);
+            return false;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            cJSON* item = cJSON_GetArrayItem(result, i);
+            cJSON* instrument_name = cJSON_GetObjectItemCaseSensitive(item, "instrument_name");
+            cJSON* tick_size = cJSON_GetObjectItemCaseSensitive(item, "tick_size");
+            cJSON* min_trade_amount = cJSON_GetObjectItemCaseSensitive(item, "min_trade_amount");
+            cJSON* contract_size = cJSON_GetObjectItemCaseSensitive(item, "contract_size");
+            
+            DeribitInstrument* inst = &(*instruments)[i];
+            if (cJSON_IsString(instrument_name) && instrument_name->valuestring) {
+                strncpy(inst->instrument_name, instrument_name->valuestring, sizeof(inst->instrument_name) - 1);
+            }
+            inst->tick_size = cJSON_IsNumber(tick_size) ? tick_size->valuedouble : 0.0;
+            inst->min_trade_amount = cJSON_IsNumber(min_trade_amount) ? min_trade_amount->valuedouble : 0.0;
+            inst->contract_size = cJSON_IsNumber(contract_size) ? contract_size->valuedouble : 1.0;
+        }
+    }
+    
+    cJSON_Delete(json);
+    return true;
+}
+
+// Parse a get_order_book response
+bool deribit_parse_orderbook(const char* data, size_t length, OrderBook* orderbook) {
+    cJSON* json = cJSON_ParseWithLength(data, length);
+    if (!json) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
         return false;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
-        return false;
+    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
+    if (!cJSON_IsObject(result)) {
+        set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
+        cJSON_Delete(json);
+        return false;
+    }
+    
+    // Process bids
+    cJSON* bids = cJSON_GetObjectItemCaseSensitive(result, "bids");
+    if (cJSON_IsArray(bids)) {
+        int bids_count = cJSON_GetArraySize(bids);
+        orderbook->bids_count = bids_count;
+        orderbook->bids = (OrderBookEntry*)malloc(bids_count * sizeof(OrderBookEntry));
+        
+        for (int i = 0; i < bids_count; i++) {
+            cJSON* bid = cJSON_GetArrayItem(bids, i);
+            if (cJSON_IsArray(bid) && cJSON_GetArraySize(bid) >= 2) {
+                cJSON* price = cJSON_GetArrayItem(bid, 0);
+                cJSON* amount = cJSON_GetArrayItem(bid, 1);
+                
+                if (cJSON_IsNumber(price) && cJSON_IsNumber(amount)) {
+                    orderbook->bids[i].price = price->valuedouble;
+                    orderbook->bids[i].amount = amount->valuedouble;
+                }
+            }
+        }
+    } else {
+        orderbook->bids_count = 0;
+        orderbook->bids = NULL;
+    }
+    
+    // Process asks
+    cJSON* asks = cJSON_GetObjectItemCaseSensitive(result, "asks");
+    if (cJSON_IsArray(asks)) {
+        int asks_count = cJSON_GetArraySize(asks);
+        orderbook->asks_count = asks_count;
+        orderbook->asks = (OrderBookEntry*)malloc(asks_count * sizeof(OrderBookEntry));
+        
+        for (int i = 0; i < asks_count; i++) {
+            cJSON* ask = cJSON_GetArrayItem(asks, i);
+            if (cJSON_IsArray(ask) && cJSON_GetArraySize(ask) >= 2) {
+                cJSON* price = cJSON_GetArrayItem(ask, 0);
+                cJSON* amount = cJSON_GetArrayItem(ask, 1);
+                
+                if (cJSON_IsNumber(price) && cJSON_IsNumber(amount)) {
+                    orderbook->asks[i].price = price->valuedouble;
+                    orderbook->asks[i].amount = amount->valuedouble;
+                }
+            }
+        }
+    } else {
+        orderbook->asks_count = 0;
+        orderbook->asks = NULL;
+    }
+    
+    // Get timestamp
+    cJSON* timestamp = cJSON_GetObjectItemCaseSensitive(result, "timestamp");
+    if (cJSON_IsNumber(timestamp)) {
+        time_t ts = (time_t)(timestamp->valuedouble / 1000);
+        struct tm* timeinfo = gmtime(&ts);
+        strftime(orderbook->timestamp, sizeof(orderbook->timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
+    } else {
+        orderbook->timestamp[0] = '\0';
     }
     
-    cJSON* json = cJSON_Parse(response);
+    cJSON_Delete(json);
+    return true;
+}
+
+// Parse a get_positions response
+bool deribit_parse_positions(const char* data, size_t length, Position** positions, int* positions_count) {
+    cJSON* json = cJSON_ParseWithLength(data, length);
     if (!json) {
         set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
-        free(response);
         return false;
     }
     
     cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
-    if (!cJSON_IsObject(result)) {
+    if (!cJSON_IsArray(result)) {
         set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
         cJSON_Delete(json);
-        free(response);
         return false;
     }
     
-    cJSON* token = cJSON_GetObjectItemCaseSensitive(result, "access_token");
-    if (!cJSON_IsString(token) || !token->valuestring) {
-        set_error(DERIBIT_ERROR_INTERNAL, "No access token in response");
-        cJSON_Delete(json);
-        free(response);
-        return false;
+    int count = cJSON_GetArraySize(result);
+    *positions_count = count;
+    
+    if (count > 0) {
+        *positions = (Position*)malloc(count * sizeof(Position));
+        
+        for (int i = 0; i < count; i++) {
+            cJSON* pos = cJSON_GetArrayItem(result, i);
+            
+            cJSON* instrument_name = cJSON_GetObjectItemCaseSensitive(pos, "instrument_name");
+            cJSON* size = cJSON_GetObjectItemCaseSensitive(pos, "size");
+            cJSON* average_price = cJSON_GetObjectItemCaseSensitive(pos, "average_price");
+            cJSON* mark_price = cJSON_GetObjectItemCaseSensitive(pos, "mark_price");
+            cJSON* floating_pl = cJSON_GetObjectItemCaseSensitive(pos, "floating_profit_loss");
+            cJSON* realized_pl = cJSON_GetObjectItemCaseSensitive(pos, "realized_profit_loss");
+            cJSON* last_update_timestamp = cJSON_GetObjectItemCaseSensitive(pos, "last_update_timestamp");
+            
+            Position* p = &(*positions)[i];
+            
+            if (cJSON_IsString(instrument_name) && instrument_name->valuestring) {
+                strncpy(p->instrument_name, instrument_name->valuestring, sizeof(p->instrument_name) - 1);
+            } else {
+                p->instrument_name[0] = '\0';
+            }
+            
+            p->size = cJSON_IsNumber(size) ? size->valuedouble : 0.0;
+            p->entry_price = cJSON_IsNumber(average_price) ? average_price->valuedouble : 0.0;
+            p->mark_price = cJSON_IsNumber(mark_price) ? mark_price->valuedouble : 0.0;
+            p->unrealized_pnl = cJSON_IsNumber(floating_pl) ? floating_pl->valuedouble : 0.0;
+            p->realized_pnl = cJSON_IsNumber(realized_pl) ? realized_pl->valuedouble : 0.0;
+            
+            if (cJSON_IsNumber(last_update_timestamp)) {
+    time_t ts = (time_t)(last_update_timestamp->valuedouble / 1000);
+    struct tm* timeinfo = gmtime(&ts);
+    if (timeinfo != NULL) {
+        // Manually build the timestamp string without using % formatting
+        char year[5], month[3], day[3], hour[3], minute[3], second[3];
+
+        // Convert to strings with leading zeroes manually
+        snprintf(year, sizeof(year), "%d", timeinfo->tm_year + 1900);
+        snprintf(month, sizeof(month), "%02d", timeinfo->tm_mon + 1);
+        snprintf(day, sizeof(day), "%02d", timeinfo->tm_mday);
+        snprintf(hour, sizeof(hour), "%02d", timeinfo->tm_hour);
+        snprintf(minute, sizeof(minute), "%02d", timeinfo->tm_min);
+        snprintf(second, sizeof(second), "%02d", timeinfo->tm_sec);
+
+        // Combine manually
+        snprintf(p->timestamp, sizeof(p->timestamp),
+                 "%s-%s-%s %s:%s:%s",
+                 year, month, day, hour, minute, second);
+    } else {
+        p->timestamp[0] = '\0';
+    }
+} else {
+    p->timestamp[0] = '\0';
+}
+
+        }
+    } else {
+        *positions = NULL;
     }
-    #define TOKEN_SIZE 128
-    strncpy(access_token, token->valuestring, TOKEN_SIZE - 1);
-    access_token[TOKEN_SIZE - 1] = '\0';
     
     cJSON_Delete(json);
-    free(response);
     return true;
 }
 
@@ -266,21 +1280,21 @@ void get_instruments(const char* currency, const char* kind, const char* access_
         "{\"currency\":\"%s\",\"kind\":\"%s\"}",
         currency, kind);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return;
     }
     
     // Print the response for debugging
-    printf("Instruments response: %s\n", response);
+    printf("Instruments response: %s\n", response->data);
     
-    free(response);
+    deribit_response_release(response);
 }
 
 // Get ticker
@@ -300,21 +1314,21 @@ void get_ticker(const char* instrument_name, const char* access_token) {
         "{\"instrument_name\":\"%s\"}",
         instrument_name);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return;
     }
     
     // Print the response for debugging
-    printf("Ticker response: %s\n", response);
+    printf("Ticker response: %s\n", response->data);
     
-    free(response);
+    deribit_response_release(response);
 }
 
 // Get trades
@@ -334,21 +1348,21 @@ void get_trades(const char* instrument_name, int count, const char* access_token
         "{\"instrument_name\":\"%s\",\"count\":%d}",
         instrument_name, count);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return;
     }
     
     // Print the response for debugging
-    printf("Trades response: %s\n", response);
+    printf("Trades response: %s\n", response->data);
     
-    free(response);
+    deribit_response_release(response);
 }
 
 // Get account summary
@@ -368,21 +1382,21 @@ void get_account_summary(const char* currency, const char* access_token) {
         "{\"currency\":\"%s\"}",
         currency);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return;
     }
     
     // Print the response for debugging
-    printf("Account summary response: %s\n", response);
+    printf("Account summary response: %s\n", response->data);
     
-    free(response);
+    deribit_response_release(response);
 }
 
 // Get orderbook
@@ -402,93 +1416,20 @@ bool get_orderbook(const char* instrument_name, int depth, const char* access_to
         "{\"instrument_name\":\"%s\",\"depth\":%d}",
         instrument_name, depth);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return false;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
-        return false;
-    }
-    
-    cJSON* json = cJSON_Parse(response);
-    if (!json) {
-        set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
-        free(response);
-        return false;
-    }
-    
-    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
-    if (!cJSON_IsObject(result)) {
-        set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
-        cJSON_Delete(json);
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return false;
     }
     
-    // Process bids
-    cJSON* bids = cJSON_GetObjectItemCaseSensitive(result, "bids");
-    if (cJSON_IsArray(bids)) {
-        int bids_count = cJSON_GetArraySize(bids);
-        orderbook->bids_count = bids_count;
-        orderbook->bids = (OrderBookEntry*)malloc(bids_count * sizeof(OrderBookEntry));
-        
-        for (int i = 0; i < bids_count; i++) {
-            cJSON* bid = cJSON_GetArrayItem(bids, i);
-            if (cJSON_IsArray(bid) && cJSON_GetArraySize(bid) >= 2) {
-                cJSON* price = cJSON_GetArrayItem(bid, 0);
-                cJSON* amount = cJSON_GetArrayItem(bid, 1);
-                
-                if (cJSON_IsNumber(price) && cJSON_IsNumber(amount)) {
-                    orderbook->bids[i].price = price->valuedouble;
-                    orderbook->bids[i].amount = amount->valuedouble;
-                }
-            }
-        }
-    } else {
-        orderbook->bids_count = 0;
-        orderbook->bids = NULL;
-    }
-    
-    // Process asks
-    cJSON* asks = cJSON_GetObjectItemCaseSensitive(result, "asks");
-    if (cJSON_IsArray(asks)) {
-        int asks_count = cJSON_GetArraySize(asks);
-        orderbook->asks_count = asks_count;
-        orderbook->asks = (OrderBookEntry*)malloc(asks_count * sizeof(OrderBookEntry));
-        
-        for (int i = 0; i < asks_count; i++) {
-            cJSON* ask = cJSON_GetArrayItem(asks, i);
-            if (cJSON_IsArray(ask) && cJSON_GetArraySize(ask) >= 2) {
-                cJSON* price = cJSON_GetArrayItem(ask, 0);
-                cJSON* amount = cJSON_GetArrayItem(ask, 1);
-                
-                if (cJSON_IsNumber(price) && cJSON_IsNumber(amount)) {
-                    orderbook->asks[i].price = price->valuedouble;
-                    orderbook->asks[i].amount = amount->valuedouble;
-                }
-            }
-        }
-    } else {
-        orderbook->asks_count = 0;
-        orderbook->asks = NULL;
-    }
-    
-    // Get timestamp
-    cJSON* timestamp = cJSON_GetObjectItemCaseSensitive(result, "timestamp");
-    if (cJSON_IsNumber(timestamp)) {
-        time_t ts = (time_t)(timestamp->valuedouble / 1000);
-        struct tm* timeinfo = gmtime(&ts);
-        strftime(orderbook->timestamp, sizeof(orderbook->timestamp), "%Y-%m-%d %H:%M:%S", timeinfo);
-    } else {
-        orderbook->timestamp[0] = '\0';
-    }
-    
-    cJSON_Delete(json);
-    free(response);
-    return true;
+    bool ok = deribit_parse_orderbook(response->data, response->size, orderbook);
+    deribit_response_release(response);
+    return ok;
 }
 
 // Get positions
@@ -508,95 +1449,18 @@ bool get_positions(const char* currency, const char* kind, const char* access_to
         "{\"currency\":\"%s\",\"kind\":\"%s\"}",
         currency, kind);
     
-    char* response = perform_request(url, post_data, access_token);
+    ResponseData* response = perform_request_pooled(url, post_data, access_token);
     if (!response) {
         set_error(DERIBIT_ERROR_NETWORK, "Failed to connect to Deribit API");
         return false;
     }
     
-    if (!parse_api_error(response)) {
-        free(response);
-        return false;
-    }
-    
-    cJSON* json = cJSON_Parse(response);
-    if (!json) {
-        set_error(DERIBIT_ERROR_INTERNAL, "Failed to parse JSON response");
-        free(response);
-        return false;
-    }
-    
-    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
-    if (!cJSON_IsArray(result)) {
-        set_error(DERIBIT_ERROR_INTERNAL, "Invalid API response format");
-        cJSON_Delete(json);
-        free(response);
+    if (!parse_api_error(response->data)) {
+        deribit_response_release(response);
         return false;
     }
     
-    int count = cJSON_GetArraySize(result);
-    *positions_count = count;
-    
-    if (count > 0) {
-        *positions = (Position*)malloc(count * sizeof(Position));
-        
-        for (int i = 0; i < count; i++) {
-            cJSON* pos = cJSON_GetArrayItem(result, i);
-            
-            cJSON* instrument_name = cJSON_GetObjectItemCaseSensitive(pos, "instrument_name");
-            cJSON* size = cJSON_GetObjectItemCaseSensitive(pos, "size");
-            cJSON* average_price = cJSON_GetObjectItemCaseSensitive(pos, "average_price");
-            cJSON* mark_price = cJSON_GetObjectItemCaseSensitive(pos, "mark_price");
-            cJSON* floating_pl = cJSON_GetObjectItemCaseSensitive(pos, "floating_profit_loss");
-            cJSON* realized_pl = cJSON_GetObjectItemCaseSensitive(pos, "realized_profit_loss");
-            cJSON* last_update_timestamp = cJSON_GetObjectItemCaseSensitive(pos, "last_update_timestamp");
-            
-            Position* p = &(*positions)[i];
-            
-            if (cJSON_IsString(instrument_name) && instrument_name->valuestring) {
-                strncpy(p->instrument_name, instrument_name->valuestring, sizeof(p->instrument_name) - 1);
-            } else {
-                p->instrument_name[0] = '\0';
-            }
-            
-            p->size = cJSON_IsNumber(size) ? size->valuedouble : 0.0;
-            p->entry_price = cJSON_IsNumber(average_price) ? average_price->valuedouble : 0.0;
-            p->mark_price = cJSON_IsNumber(mark_price) ? mark_price->valuedouble : 0.0;
-            p->unrealized_pnl = cJSON_IsNumber(floating_pl) ? floating_pl->valuedouble : 0.0;
-            p->realized_pnl = cJSON_IsNumber(realized_pl) ? realized_pl->valuedouble : 0.0;
-            
-            if (cJSON_IsNumber(last_update_timestamp)) {
-    time_t ts = (time_t)(last_update_timestamp->valuedouble / 1000);
-    struct tm* timeinfo = gmtime(&ts);
-    if (timeinfo != NULL) {
-        // Manually build the timestamp string without using % formatting
-        char year[5], month[3], day[3], hour[3], minute[3], second[3];
-
-        // Convert to strings with leading zeroes manually
-        snprintf(year, sizeof(year), "%d", timeinfo->tm_year + 1900);
-        snprintf(month, sizeof(month), "%02d", timeinfo->tm_mon + 1);
-        snprintf(day, sizeof(day), "%02d", timeinfo->tm_mday);
-        snprintf(hour, sizeof(hour), "%02d", timeinfo->tm_hour);
-        snprintf(minute, sizeof(minute), "%02d", timeinfo->tm_min);
-        snprintf(second, sizeof(second), "%02d", timeinfo->tm_sec);
-
-        // Combine manually
-        snprintf(p->timestamp, sizeof(p->timestamp),
-                 "%s-%s-%s %s:%s:%s",
-                 year, month, day, hour, minute, second);
-    } else {
-        p->timestamp[0] = '\0';
-    }
-} else {
-    p->timestamp[0] = '\0';
+    bool ok = deribit_parse_positions(response->data, response->size, positions, positions_count);
+    deribit_response_release(response);
+    return ok;
 }
-
-        }
-    } else {
-        *positions = NULL;
-    }
-    
-    cJSON_Delete(json);
-    free(response);
-    return true;
-}
\ No newline at end of file
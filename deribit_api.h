@@ -2,14 +2,81 @@
 #define DERIBIT_API_H
 #include "order.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
+
+#define DERIBIT_DEFAULT_BASE_URL "https://www.deribit.com"
+
+// Request transport
+typedef enum {
+    DERIBIT_TRANSPORT_MOCK,    // Canned responses, no network (default)
+    DERIBIT_TRANSPORT_HTTP     // libcurl, one persistent handle per thread
+} DeribitTransport;
+
+// Select transport
+void deribit_set_transport(DeribitTransport transport);
+
+// HTTP protocol for the HTTP transport
+typedef enum {
+    DERIBIT_HTTP_1_1,              // One request per connection at a time (default)
+    DERIBIT_HTTP_2,                // Negotiated via ALPN on https, HTTP/1.1 otherwise
+    DERIBIT_HTTP_2_PRIOR_KNOWLEDGE // Cleartext h2c without negotiation, for local stand-ins
+} DeribitHttpVersion;
+
+// Select the HTTP protocol. With HTTP/2, async requests share one connection
+// as concurrent streams and the repeated headers are HPACK-compressed; a
+// server found to lack HTTP/2 drops the client back to HTTP/1.1. Reads that
+// failed on the way are retried once; order entry is not.
+void deribit_set_http_version(DeribitHttpVersion version);
+
+// Protocol in use after any fallback, and the major version of the calling
+// thread's last response (1 or 2; 0 before the first)
+DeribitHttpVersion deribit_get_http_version(void);
+int deribit_last_http_version(void);
+
+// Point requests at another server, e.g. a local stand-in ("http://127.0.0.1:8080")
+bool deribit_set_base_url(const char* base_url);
+
+// Release the calling thread's connection handle
+void deribit_transport_thread_cleanup(void);
+
+// Release shared transport state (after all threads are done)
+void deribit_transport_cleanup(void);
+
+// Pooled receive buffer; data is NUL-terminated and valid until released
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} DeribitResponse;
+
+// Perform a JSON-RPC request into a pooled buffer; release with deribit_response_release
+DeribitResponse* perform_request_pooled(const char* url, const char* post_data, const char* access_token);
+
+// Return a buffer to the calling thread's pool
+void deribit_response_release(DeribitResponse* response);
+
+// Perform a JSON-RPC request; returns malloc'd response body, caller frees
 char* perform_request(const char* url, const char* post_data, const char* access_token);
 
-// Authentication functions
+// Size of every access/refresh token buffer
+#define DERIBIT_TOKEN_SIZE 1024
+
+// Authentication result; expires_in is in seconds
+typedef struct {
+    char access_token[DERIBIT_TOKEN_SIZE];
+    char refresh_token[DERIBIT_TOKEN_SIZE];
+    int expires_in;
+} DeribitAuthResult;
+
+// Authentication functions; access_token must hold DERIBIT_TOKEN_SIZE bytes
 bool get_access_token(const char* client_id, const char* client_secret, char* access_token);
+bool deribit_authenticate(const char* client_id, const char* client_secret, DeribitAuthResult* result);
+bool deribit_refresh_token(const char* refresh_token, DeribitAuthResult* result);
 
 // Market data functions
 void get_instruments(const char* currency, const char* kind, const char* access_token);
@@ -22,6 +89,19 @@ void get_account_summary(const char* currency, const char* access_token);
 bool get_orderbook(const char* instrument_name, int depth, const char* access_token, OrderBook* orderbook);
 bool get_positions(const char* currency, const char* kind, const char* access_token, Position** positions, int* positions_count);
 
+// Instrument reference data
+typedef struct {
+    char instrument_name[32];
+    double tick_size;
+    double min_trade_amount;
+    double contract_size;
+} DeribitInstrument;
+
+// Parse raw responses (e.g. from deribit_async_request); arrays are malloc'd, caller frees
+bool deribit_parse_instruments(const char* data, size_t length, DeribitInstrument** instruments, int* instruments_count);
+bool deribit_parse_orderbook(const char* data, size_t length, OrderBook* orderbook);
+bool deribit_parse_positions(const char* data, size_t length, Position** positions, int* positions_count);
+
 
 // Error handling
 typedef enum {
@@ -30,7 +110,9 @@ typedef enum {
     DERIBIT_ERROR_AUTH,
     DERIBIT_ERROR_PARAMS,
     DERIBIT_ERROR_RATE_LIMIT,
-    DERIBIT_ERROR_INTERNAL
+    DERIBIT_ERROR_INTERNAL,
+    DERIBIT_ERROR_CANCELLED,       // Async request abandoned by deribit_async_cancel or cleanup
+    DERIBIT_ERROR_BUSY             // Every async slot is in flight; poll and retry
 } DeribitErrorCode;
 
 typedef struct {
@@ -38,9 +120,39 @@ typedef struct {
     char message[256];
 } DeribitError;
 
-// Get last error
+// Get the calling thread's last error
 DeribitError get_last_error();
 
+// Asynchronous requests multiplexed on one event loop (driven by deribit_async_poll)
+typedef uint64_t DeribitRequestHandle;
+
+// response is NULL on failure; it is freed after the callback returns
+typedef void (*DeribitCompletionCallback)(DeribitRequestHandle handle, const char* response,
+                                          const DeribitError* error, void* user_data);
+
+// Initialize the async client with room for max_in_flight concurrent requests
+bool deribit_async_init(int max_in_flight);
+
+// Start a request; returns 0 if it could not be queued (see get_last_error:
+// DERIBIT_ERROR_BUSY when no slot is free, DERIBIT_ERROR_RATE_LIMIT when out of credits).
+// Under RATE_LIMIT_QUEUE a request over its pool's rate is held and sent by a later
+// deribit_async_poll; this call never waits
+DeribitRequestHandle deribit_async_request(const char* url, const char* post_data, const char* access_token,
+                                           DeribitCompletionCallback callback, void* user_data);
+
+// Drive transfers, waiting up to timeout_ms for activity; returns completions delivered
+int deribit_async_poll(int timeout_ms);
+
+// Abandon a request; its callback runs at once with DERIBIT_ERROR_CANCELLED so
+// it can release user_data
+bool deribit_async_cancel(DeribitRequestHandle handle);
+
+// Requests started and not yet completed
+int deribit_async_in_flight(void);
+
+// Release the async client; requests still in flight are cancelled
+void deribit_async_cleanup(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,164 @@
+// Order body encoding benchmark: builds private/buy bodies with the
+// request_encoder templates and with the snprintf formats they replaced, and
+// reports the cost per body.
+//
+// Usage: encoder_bench [--iterations 5000000] [--instrument BTC-PERPETUAL]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "request_encoder.h"
+
+#define PRICE_COUNT 64                 // Distinct prices cycled through, so no call is hoisted
+
+typedef struct {
+    long iterations;
+    const char* instrument;
+} BenchConfig;
+
+static char prices[PRICE_COUNT][32];
+static char amounts[PRICE_COUNT][32];
+static double price_values[PRICE_COUNT];
+static double amount_values[PRICE_COUNT];
+
+static volatile size_t sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_inputs(void) {
+    for (int i = 0; i < PRICE_COUNT; i++) {
+        price_values[i] = 25000.0 + i * 0.5;
+        amount_values[i] = 0.01 * (i + 1);
+        snprintf(prices[i], sizeof(prices[i]), "%.2f", price_values[i]);
+        snprintf(amounts[i], sizeof(amounts[i]), "%.6f", amount_values[i]);
+    }
+}
+
+static double bench_snprintf_text(const BenchConfig* config) {
+    char body[256];
+    size_t total = 0;
+    double start = now_ns();
+    for (long i = 0; i < config->iterations; i++) {
+        int k = (int)(i % PRICE_COUNT);
+        total += (size_t)snprintf(body, sizeof(body),
+            "{\"instrument_name\":\"%s\",\"amount\":%s,\"price\":%s,\"type\":\"limit\",\"post_only\":true}",
+            config->instrument, amounts[k], prices[k]);
+    }
+    double elapsed = now_ns() - start;
+    sink = total;
+    return elapsed / config->iterations;
+}
+
+static double bench_snprintf_values(const BenchConfig* config) {
+    char body[256];
+    size_t total = 0;
+    double start = now_ns();
+    for (long i = 0; i < config->iterations; i++) {
+        int k = (int)(i % PRICE_COUNT);
+        total += (size_t)snprintf(body, sizeof(body),
+            "{\"instrument_name\":\"%s\",\"amount\":%.6f,\"price\":%.6f,\"type\":\"limit\",\"post_only\":true}",
+            config->instrument, amount_values[k], price_values[k]);
+    }
+    double elapsed = now_ns() - start;
+    sink = total;
+    return elapsed / config->iterations;
+}
+
+static double bench_encoder_text(const BenchConfig* config) {
+    char body[256];
+    size_t total = 0;
+    double start = now_ns();
+    for (long i = 0; i < config->iterations; i++) {
+        int k = (int)(i % PRICE_COUNT);
+        // Cache lookup included, as order.c does per request
+        const PlaceTemplate* tmpl = request_template_for(config->instrument);
+        total += (size_t)request_encode_place(body, sizeof(body), tmpl, amounts[k], prices[k]);
+    }
+    double elapsed = now_ns() - start;
+    sink = total;
+    return elapsed / config->iterations;
+}
+
+static double bench_encoder_values(const BenchConfig* config) {
+    char body[256];
+    size_t total = 0;
+    double start = now_ns();
+    for (long i = 0; i < config->iterations; i++) {
+        int k = (int)(i % PRICE_COUNT);
+        const PlaceTemplate* tmpl = request_template_for(config->instrument);
+        total += (size_t)request_encode_place_values(body, sizeof(body), tmpl, amount_values[k], price_values[k], 6);
+    }
+    double elapsed = now_ns() - start;
+    sink = total;
+    return elapsed / config->iterations;
+}
+
+// Both paths must produce the same bytes for the comparison to mean anything
+static bool check_equivalence(const BenchConfig* config) {
+    const PlaceTemplate* tmpl = request_template_for(config->instrument);
+    if (!tmpl) {
+        return false;
+    }
+    for (int k = 0; k < PRICE_COUNT; k++) {
+        char expected[256];
+        char actual[256];
+        snprintf(expected, sizeof(expected),
+            "{\"instrument_name\":\"%s\",\"amount\":%s,\"price\":%s,\"type\":\"limit\",\"post_only\":true}",
+            config->instrument, amounts[k], prices[k]);
+        int length = request_encode_place(actual, sizeof(actual), tmpl, amounts[k], prices[k]);
+        if (length < 0 || (size_t)length != strlen(expected) || memcmp(actual, expected, (size_t)length) != 0) {
+            fprintf(stderr, "Encoder output differs from snprintf:\n  %s\n  %.*s\n", expected, length < 0 ? 0 : length, actual);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--iterations N] [--instrument NAME]\n", program);
+}
+
+static bool parse_args(int argc, char** argv, BenchConfig* config) {
+    config->iterations = 5000000;
+    config->instrument = "BTC-PERPETUAL";
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            return false;
+        }
+        if (strcmp(argv[i], "--iterations") == 0) {
+            config->iterations = atol(value);
+        } else if (strcmp(argv[i], "--instrument") == 0) {
+            config->instrument = value;
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return config->iterations > 0 && strlen(config->instrument) < REQUEST_INSTRUMENT_MAX;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+    fill_inputs();
+    if (!check_equivalence(&config)) {
+        return 1;
+    }
+
+    printf("Place body for %s, %ld iterations:\n", config.instrument, config.iterations);
+    printf("  snprintf, text fields:    %6.1f ns\n", bench_snprintf_text(&config));
+    printf("  encoder, text fields:     %6.1f ns\n", bench_encoder_text(&config));
+    printf("  snprintf, double fields:  %6.1f ns\n", bench_snprintf_values(&config));
+    printf("  encoder, double fields:   %6.1f ns\n", bench_encoder_values(&config));
+    return 0;
+}
@@ -1,12 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "C:\Users\sansk\goquant_assignment\include\deribit_api.h"
-#include "C:\Users\sansk\goquant_assignment\include\order.h"
+#include "deribit_api.h"
+#include "order.h"
+#include "token_manager.h"
+#include "bootstrap.h"
 
 #define CLIENT_ID "-8oxD0z5"
 #define CLIENT_SECRET "yrOhwkelwTUSLS57hW_0UWg-J0cnD9S_PJxBHWXkPoo"
-#define TOKEN_SIZE 1024
 
 void print_order(const Order* order) {
     printf("Order ID: %s\n", order->order_id);
@@ -60,6 +61,13 @@ void print_orderbook(const OrderBook* orderbook) {
     printf("------------------------------\n");
 }
 
+// Latest token from the token manager; read before every request so a
+// background refresh is picked up
+static const char* current_token(void) {
+    static char token[DERIBIT_TOKEN_SIZE];
+    return token_manager_get(token, sizeof(token)) ? token : "";
+}
+
 void print_error() {
     DeribitError error = get_last_error();
     printf("Error code: %d\n", error.code);
@@ -67,59 +75,32 @@ void print_error() {
 }
 
 int main() {
-    char access_token[TOKEN_SIZE] = {0};
     const char* instrument_name = "BTC-PERPETUAL";
 
-    // Step 1: Get access token
-    printf("Getting access token...\n");
-    if (!get_access_token(CLIENT_ID, CLIENT_SECRET, access_token)) {
-        printf("Failed to retrieve access token.\n");
+    // Steps 1-4: authenticate once, then fetch the orderbook, positions and
+    // open orders concurrently; the token manager keeps the token fresh
+    printf("Bootstrapping startup state...\n");
+    const char* currencies[] = {"BTC"};
+    const char* instruments[] = {instrument_name};
+    BootstrapConfig config = {CLIENT_ID, CLIENT_SECRET, currencies, 1, instruments, 1, 10, 0};
+    BootstrapState state;
+    if (!bootstrap_run(&config, &state)) {
+        printf("Failed to load startup state.\n");
         print_error();
         return 1;
     }
-    printf("Successfully retrieved access token.\n");
 
-    // Step 2: Get orderbook
-    printf("\nGetting orderbook for %s...\n", instrument_name);
-    OrderBook orderbook = {0};
-    if (!get_orderbook(instrument_name, 10, access_token, &orderbook)) {
-        printf("Failed to get orderbook.\n");
-        print_error();
-    } else {
-        print_orderbook(&orderbook);
-        // Free dynamically allocated bids and asks if allocated
-        if (orderbook.bids) free(orderbook.bids);
-        if (orderbook.asks) free(orderbook.asks);
-    }
+    printf("\nOrderbook for %s:\n", instrument_name);
+    print_orderbook(&state.books[0]);
 
-    // Step 3: Get positions
-    printf("\nGetting current positions...\n");
-    Position* positions = NULL;
-    int positions_count = 0;
-    if (!get_positions("BTC", "future", access_token, &positions, &positions_count)) {
-        printf("Failed to get positions.\n");
-        print_error();
-    } else {
-        printf("Found %d positions:\n", positions_count);
-        for (int i = 0; i < positions_count; i++) {
-            print_position(&positions[i]);
-        }
-        if (positions) free(positions);
+    printf("\nFound %d positions:\n", state.positions_count);
+    for (int i = 0; i < state.positions_count; i++) {
+        print_position(&state.positions[i]);
     }
 
-    // Step 4: Get open orders
-    printf("\nGetting open orders...\n");
-    Order* orders = NULL;
-    int orders_count = 0;
-    if (!get_open_orders(instrument_name, access_token, &orders, &orders_count)) {
-        printf("Failed to get open orders.\n");
-        print_error();
-    } else {
-        printf("Found %d open orders:\n", orders_count);
-        for (int i = 0; i < orders_count; i++) {
-            print_order(&orders[i]);
-        }
-        if (orders) free(orders);
+    printf("\nFound %d open orders:\n", state.open_orders_count);
+    for (int i = 0; i < state.open_orders_count; i++) {
+        print_order(&state.open_orders[i]);
     }
 
     // Step 5: Place a limit order
@@ -131,7 +112,7 @@ int main() {
     snprintf(price_str, sizeof(price_str), "%.2f", price_val);
     snprintf(amount_str, sizeof(amount_str), "%.6f", amount_val);
 
-    if (!place_order(instrument_name, price_str, amount_str, access_token, &new_order)) {
+    if (!place_order(instrument_name, price_str, amount_str, current_token(), &new_order)) {
         printf("Failed to place order.\n");
         print_error();
     } else {
@@ -142,7 +123,7 @@ int main() {
         printf("\nModifying the order...\n");
         Order modified_order = {0};
         snprintf(price_str, sizeof(price_str), "%.2f", price_val + 1000.0);
-        if (!modify_order(new_order.order_id, price_str, amount_str, access_token, &modified_order)) {
+        if (!modify_order(new_order.order_id, price_str, amount_str, current_token(), &modified_order)) {
             printf("Failed to modify order.\n");
             print_error();
         } else {
@@ -152,7 +133,7 @@ int main() {
 
         // Step 7: Cancel the order
         printf("\nCancelling the order...\n");
-        if (!cancel_order(new_order.order_id, access_token)) {
+        if (!cancel_order(new_order.order_id, current_token())) {
             printf("Failed to cancel order.\n");
             print_error();
         } else {
@@ -164,7 +145,7 @@ int main() {
     printf("\nGetting order history...\n");
     Order* history_orders = NULL;
     int history_count = 0;
-    if (!get_order_history(instrument_name, access_token, &history_orders, &history_count)) {
+    if (!get_order_history(instrument_name, current_token(), &history_orders, &history_count)) {
         printf("Failed to get order history.\n");
         print_error();
     } else {
@@ -175,6 +156,9 @@ int main() {
         if (history_orders) free(history_orders);
     }
 
+    bootstrap_state_free(&state);
+    deribit_async_cleanup();
+    token_manager_stop();
     printf("Program completed.\n");
     return 0;
 }
@@ -0,0 +1,386 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "market_data.h"
+
+static const char* skip_space(const char* p) {
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') {
+        p++;
+    }
+    return p;
+}
+
+// Value following "key": between p and end; key includes its quotes and colon
+static const char* find_value(const char* p, const char* end, const char* key) {
+    size_t key_length = strlen(key);
+    const char* found = memmem(p, (size_t)(end - p), key, key_length);
+    return found ? skip_space(found + key_length) : NULL;
+}
+
+static double number_value(const char* p, const char* end, const char* key) {
+    const char* value = find_value(p, end, key);
+    return value ? strtod(value, NULL) : 0.0;
+}
+
+static uint64_t integer_value(const char* p, const char* end, const char* key) {
+    const char* value = find_value(p, end, key);
+    return value ? strtoull(value, NULL, 10) : 0;
+}
+
+// Copy the string value of key into out; out is left untouched if absent
+static void string_value(const char* p, const char* end, const char* key, char* out, size_t size) {
+    const char* value = find_value(p, end, key);
+    if (!value || *value != '"') {
+        return;
+    }
+    const char* value_end = memchr(value + 1, '"', (size_t)(end - value - 1));
+    size_t length = value_end ? (size_t)(value_end - value - 1) : 0;
+    if (length < size) {
+        memcpy(out, value + 1, length);
+        out[length] = '\0';
+    }
+}
+
+static bool string_equals(const char* value, const char* expected) {
+    size_t length = strlen(expected);
+    return value && value[0] == '"' && strncmp(value + 1, expected, length) == 0 && value[length + 1] == '"';
+}
+
+const char* market_data_payload(const char* message) {
+    const char* params = message ? strstr(message, "\"params\":") : NULL;
+    const char* data = params ? strstr(params, "\"data\":") : NULL;
+    return data ? skip_space(data + 7) : NULL;
+}
+
+const char* market_data_result(const char* message) {
+    const char* result = message ? strstr(message, "\"result\":") : NULL;
+    return result ? skip_space(result + 9) : NULL;
+}
+
+MarketDataHeartbeat market_data_heartbeat(const char* message) {
+    if (!message || !strstr(message, "\"method\":\"heartbeat\"")) {
+        return MARKET_DATA_NOT_HEARTBEAT;
+    }
+    return strstr(message, "\"test_request\"") ? MARKET_DATA_TEST_REQUEST : MARKET_DATA_HEARTBEAT;
+}
+
+// Parse a level array, either [["new",price,amount],...] or [[price,amount],...].
+// Returns the position after it, NULL if malformed or over max.
+static const char* parse_levels(const char* p, BookLevelUpdate* levels, int max, int* count) {
+    *count = 0;
+    p = skip_space(p);
+    if (*p != '[') {
+        return NULL;
+    }
+    p = skip_space(p + 1);
+    while (*p != ']') {
+        if (*p != '[' || *count == max) {
+            return NULL;
+        }
+        BookLevelUpdate* level = &levels[(*count)++];
+        level->action = BOOK_ACTION_NEW;
+        p = skip_space(p + 1);
+        if (*p == '"') {
+            if (strncmp(p, "\"new\"", 5) == 0) {
+                p += 5;
+            } else if (strncmp(p, "\"change\"", 8) == 0) {
+                level->action = BOOK_ACTION_CHANGE;
+                p += 8;
+            } else if (strncmp(p, "\"delete\"", 8) == 0) {
+                level->action = BOOK_ACTION_DELETE;
+                p += 8;
+            } else {
+                return NULL;
+            }
+            p = skip_space(p);
+            if (*p != ',') {
+                return NULL;
+            }
+            p++;
+        }
+
+        char* end;
+        level->price = strtod(p, &end);
+        if (end == p) {
+            return NULL;
+        }
+        p = skip_space(end);
+        if (*p != ',') {
+            return NULL;
+        }
+        p = skip_space(p + 1);
+        level->amount = strtod(p, &end);
+        if (end == p) {
+            return NULL;
+        }
+        p = skip_space(end);
+        if (*p != ']') {
+            return NULL;
+        }
+        p = skip_space(p + 1);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        }
+    }
+    return p + 1;
+}
+
+bool market_data_decode_book(const char* payload, BookUpdate* update, BookLevelUpdate* levels, int max_levels) {
+    if (!payload || *payload != '{') {
+        return false;
+    }
+    const char* bids = strstr(payload, "\"bids\":");
+    const char* asks = strstr(payload, "\"asks\":");
+    if (!bids || !asks) {
+        return false;
+    }
+    const char* end = payload + strlen(payload);
+
+    const char* type = find_value(payload, end, "\"type\":");
+    update->snapshot = type && strncmp(type, "\"snapshot\"", 10) == 0;
+    update->timestamp = integer_value(payload, end, "\"timestamp\":");
+    update->change_id = integer_value(payload, end, "\"change_id\":");
+    update->prev_change_id = integer_value(payload, end, "\"prev_change_id\":");
+
+    int bids_count = 0;
+    int asks_count = 0;
+    if (!parse_levels(bids + 7, levels, max_levels, &bids_count) ||
+        !parse_levels(asks + 7, levels + bids_count, max_levels - bids_count, &asks_count)) {
+        return false;
+    }
+    update->bids = levels;
+    update->bids_count = bids_count;
+    update->asks = levels + bids_count;
+    update->asks_count = asks_count;
+    return true;
+}
+
+bool market_data_decode_ticker(const char* payload, TickerUpdate* ticker) {
+    if (!payload || *payload != '{') {
+        return false;
+    }
+    const char* end = payload + strlen(payload);
+    ticker->timestamp = integer_value(payload, end, "\"timestamp\":");
+    ticker->best_bid_price = number_value(payload, end, "\"best_bid_price\":");
+    ticker->best_bid_amount = number_value(payload, end, "\"best_bid_amount\":");
+    ticker->best_ask_price = number_value(payload, end, "\"best_ask_price\":");
+    ticker->best_ask_amount = number_value(payload, end, "\"best_ask_amount\":");
+    ticker->last_price = number_value(payload, end, "\"last_price\":");
+    ticker->mark_price = number_value(payload, end, "\"mark_price\":");
+    ticker->index_price = number_value(payload, end, "\"index_price\":");
+    return true;
+}
+
+int market_data_decode_trades(const char** cursor, TradeUpdate* trades, int max_trades) {
+    const char* p = *cursor ? skip_space(*cursor) : NULL;
+    if (!p) {
+        return 0;
+    }
+    if (*p == '[') {
+        p = skip_space(p + 1);
+    }
+
+    int count = 0;
+    while (*p == '{' && count < max_trades) {
+        // Trade objects are flat, so the first closing brace ends one
+        const char* end = strchr(p, '}');
+        if (!end) {
+            return -1;
+        }
+        TradeUpdate* trade = &trades[count++];
+        trade->trade_seq = integer_value(p, end, "\"trade_seq\":");
+        trade->timestamp = integer_value(p, end, "\"timestamp\":");
+        trade->price = number_value(p, end, "\"price\":");
+        trade->amount = number_value(p, end, "\"amount\":");
+        const char* direction = find_value(p, end, "\"direction\":");
+        trade->side = direction && strncmp(direction, "\"sell\"", 6) == 0 ? ORDER_SIDE_SELL : ORDER_SIDE_BUY;
+        trade->trade_id[0] = '\0';
+        string_value(p, end, "\"trade_id\":", trade->trade_id, sizeof(trade->trade_id));
+
+        p = skip_space(end + 1);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        }
+    }
+    if (*p == ']') {
+        *cursor = NULL;
+    } else if (*p == '{') {
+        *cursor = p;
+    } else {
+        return -1;
+    }
+    return count;
+}
+
+static void timestamp_value(const char* p, const char* end, const char* key, char* out, size_t size) {
+    const char* value = find_value(p, end, key);
+    if (value) {
+        time_t timestamp = (time_t)(strtoull(value, NULL, 10) / 1000);
+        struct tm timeinfo;
+        gmtime_r(&timestamp, &timeinfo);
+        strftime(out, size, "%Y-%m-%d %H:%M:%S", &timeinfo);
+    }
+}
+
+static void decode_order(const char* p, const char* end, Order* order) {
+    memset(order, 0, sizeof(*order));
+    string_value(p, end, "\"order_id\":", order->order_id, sizeof(order->order_id));
+    string_value(p, end, "\"instrument_name\":", order->instrument_name, sizeof(order->instrument_name));
+    order->price = number_value(p, end, "\"price\":");
+    order->amount = number_value(p, end, "\"amount\":");
+    order->side = string_equals(find_value(p, end, "\"direction\":"), "buy") ? ORDER_SIDE_BUY : ORDER_SIDE_SELL;
+
+    const char* type = find_value(p, end, "\"order_type\":");
+    if (string_equals(type, "market")) {
+        order->type = ORDER_TYPE_MARKET;
+    } else if (string_equals(type, "stop_limit")) {
+        order->type = ORDER_TYPE_STOP_LIMIT;
+    } else if (string_equals(type, "stop_market")) {
+        order->type = ORDER_TYPE_STOP_MARKET;
+    }
+
+    const char* state = find_value(p, end, "\"order_state\":");
+    if (string_equals(state, "filled")) {
+        order->status = ORDER_STATUS_FILLED;
+    } else if (string_equals(state, "rejected")) {
+        order->status = ORDER_STATUS_REJECTED;
+    } else if (string_equals(state, "cancelled")) {
+        order->status = ORDER_STATUS_CANCELLED;
+    } else if (string_equals(state, "untriggered")) {
+        order->status = ORDER_STATUS_UNTRIGGERED;
+    }
+
+    timestamp_value(p, end, "\"creation_timestamp\":", order->created_at, sizeof(order->created_at));
+    timestamp_value(p, end, "\"last_update_timestamp\":", order->last_update, sizeof(order->last_update));
+}
+
+int market_data_decode_orders(const char* payload, Order* orders, int max_orders) {
+    const char* p = payload;
+    if (!p) {
+        return -1;
+    }
+    bool array = *p == '[';
+    if (array) {
+        p = skip_space(p + 1);
+    }
+
+    int count = 0;
+    while (*p == '{') {
+        // Order objects are flat, so the first closing brace ends one
+        const char* end = strchr(p, '}');
+        if (!end) {
+            return -1;
+        }
+        // Past max_orders only count, so the caller can size a buffer
+        if (count < max_orders) {
+            decode_order(p, end, &orders[count]);
+        }
+        count++;
+        if (!array) {
+            return count;
+        }
+        p = skip_space(end + 1);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        }
+    }
+    return count > 0 || *p == ']' ? count : -1;
+}
+
+static bool dispatch_book(const MarketDataHandlers* handlers, uint32_t instrument_id, const char* instrument_name,
+                          const char* message, MarketDataScratch* scratch) {
+    BookUpdate update;
+    if (!handlers->on_book ||
+        !market_data_decode_book(market_data_payload(message), &update, scratch->levels, MARKET_DATA_MAX_LEVELS)) {
+        return false;
+    }
+    update.instrument_id = instrument_id;
+    update.instrument_name = instrument_name;
+    handlers->on_book(&update, handlers->user_data);
+    return true;
+}
+
+static bool dispatch_trades(const MarketDataHandlers* handlers, uint32_t instrument_id, const char* instrument_name,
+                            const char* message, MarketDataScratch* scratch) {
+    TradeBatch batch = {
+        .instrument_id = instrument_id,
+        .instrument_name = instrument_name,
+        .trades = scratch->trades
+    };
+    const char* cursor = market_data_payload(message);
+    if (!handlers->on_trades || !cursor) {
+        return false;
+    }
+    while (cursor) {
+        batch.count = market_data_decode_trades(&cursor, scratch->trades, MARKET_DATA_MAX_TRADES);
+        if (batch.count < 0) {
+            return false;
+        }
+        if (batch.count > 0) {
+            handlers->on_trades(&batch, handlers->user_data);
+        }
+    }
+    return true;
+}
+
+static bool dispatch_ticker(const MarketDataHandlers* handlers, uint32_t instrument_id, const char* instrument_name,
+                            const char* message, MarketDataScratch* scratch) {
+    (void)scratch;
+    TickerUpdate ticker;
+    if (!handlers->on_ticker || !market_data_decode_ticker(market_data_payload(message), &ticker)) {
+        return false;
+    }
+    ticker.instrument_id = instrument_id;
+    ticker.instrument_name = instrument_name;
+    handlers->on_ticker(&ticker, handlers->user_data);
+    return true;
+}
+
+static bool dispatch_orders(const MarketDataHandlers* handlers, uint32_t instrument_id, const char* instrument_name,
+                            const char* message, MarketDataScratch* scratch) {
+    (void)instrument_id;
+    (void)instrument_name;
+    const char* payload = market_data_payload(message);
+    int count = handlers->on_orders ? market_data_decode_orders(payload, scratch->orders, MARKET_DATA_MAX_ORDERS) : -1;
+    if (count < 0) {
+        return false;
+    }
+    Order* orders = scratch->orders;
+    if (count > MARKET_DATA_MAX_ORDERS) {
+        orders = malloc((size_t)count * sizeof(Order));
+        if (!orders) {
+            return false;
+        }
+        market_data_decode_orders(payload, orders, count);
+    }
+    handlers->on_orders(orders, count, handlers->user_data);
+    if (orders != scratch->orders) {
+        free(orders);
+    }
+    return true;
+}
+
+// Dispatch by SubscriptionType; NULL where the type has no decoder
+typedef bool (*MarketDataDispatch)(const MarketDataHandlers* handlers, uint32_t instrument_id,
+                                   const char* instrument_name, const char* message, MarketDataScratch* scratch);
+static const MarketDataDispatch typed_dispatch[SUBSCRIPTION_ANNOUNCEMENTS + 1] = {
+    [SUBSCRIPTION_BOOK] = dispatch_book,
+    [SUBSCRIPTION_TRADES] = dispatch_trades,
+    [SUBSCRIPTION_TICKER] = dispatch_ticker,
+    [SUBSCRIPTION_ORDER] = dispatch_orders
+};
+
+bool market_data_has_decoder(SubscriptionType type) {
+    return type >= 0 && type <= SUBSCRIPTION_ANNOUNCEMENTS && typed_dispatch[type];
+}
+
+bool market_data_dispatch(SubscriptionType type, const MarketDataHandlers* handlers, uint32_t instrument_id,
+                          const char* instrument_name, const char* message, MarketDataScratch* scratch) {
+    if (!market_data_has_decoder(type) || !handlers || !scratch) {
+        return false;
+    }
+    // Handlers may change the subscription they came from, so work on a copy
+    MarketDataHandlers bound = *handlers;
+    return typed_dispatch[type](&bound, instrument_id, instrument_name, message, scratch);
+}
@@ -0,0 +1,137 @@
+#ifndef MARKET_DATA_H
+#define MARKET_DATA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "order.h"
+#include "websocket_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Typed decoders for subscription notifications. They scan the message text
+// in place for the fields each channel carries, without building a JSON tree.
+
+#define MARKET_DATA_MAX_LEVELS 2048     // Bid plus ask level updates per book message
+#define MARKET_DATA_MAX_TRADES 256      // Trades handed over per callback
+#define MARKET_DATA_MAX_ORDERS 64       // Orders per user.orders message
+
+typedef enum {
+    BOOK_ACTION_NEW,
+    BOOK_ACTION_CHANGE,
+    BOOK_ACTION_DELETE
+} BookLevelAction;
+
+typedef struct {
+    BookLevelAction action;
+    double price;
+    double amount;
+} BookLevelUpdate;
+
+// book.* notification; levels are valid during the callback
+typedef struct {
+    uint32_t instrument_id;             // Subscription table id (subscription_table.h)
+    const char* instrument_name;
+    bool snapshot;
+    uint64_t timestamp;
+    uint64_t change_id;
+    uint64_t prev_change_id;            // 0 on snapshots
+    const BookLevelUpdate* bids;
+    int bids_count;
+    const BookLevelUpdate* asks;
+    int asks_count;
+} BookUpdate;
+
+typedef struct {
+    uint64_t trade_seq;
+    char trade_id[48];
+    uint64_t timestamp;
+    OrderSide side;                     // Taker side
+    double price;
+    double amount;
+} TradeUpdate;
+
+// trades.* notification, possibly split over several callbacks
+typedef struct {
+    uint32_t instrument_id;
+    const char* instrument_name;
+    const TradeUpdate* trades;
+    int count;
+} TradeBatch;
+
+// ticker.* notification; prices absent from the message are 0
+typedef struct {
+    uint32_t instrument_id;
+    const char* instrument_name;
+    uint64_t timestamp;
+    double best_bid_price;
+    double best_bid_amount;
+    double best_ask_price;
+    double best_ask_amount;
+    double last_price;
+    double mark_price;
+    double index_price;
+} TickerUpdate;
+
+// Handlers bound to a subscription; only the one matching its type is used
+typedef struct MarketDataHandlers {
+    void (*on_book)(const BookUpdate* update, void* user_data);
+    void (*on_trades)(const TradeBatch* batch, void* user_data);
+    void (*on_ticker)(const TickerUpdate* ticker, void* user_data);
+    void (*on_orders)(const Order* orders, int count, void* user_data);
+    void* user_data;
+} MarketDataHandlers;
+
+// Decode output space; dispatching threads each need their own
+typedef struct {
+    BookLevelUpdate levels[MARKET_DATA_MAX_LEVELS];
+    TradeUpdate trades[MARKET_DATA_MAX_TRADES];
+    Order orders[MARKET_DATA_MAX_ORDERS];
+} MarketDataScratch;
+
+// Whether subscriptions of this type can be decoded (book, trades, ticker, order)
+bool market_data_has_decoder(SubscriptionType type);
+
+// Decode a notification on a channel of the given type and call the matching
+// handler; false if that handler is unset or the message does not decode
+bool market_data_dispatch(SubscriptionType type, const MarketDataHandlers* handlers, uint32_t instrument_id,
+                          const char* instrument_name, const char* message, MarketDataScratch* scratch);
+
+// Start of the "data" value in a subscription notification, or NULL
+const char* market_data_payload(const char* message);
+
+// Start of the "result" value in a call response, or NULL; book and order
+// snapshots decode with the same functions as notifications
+const char* market_data_result(const char* message);
+
+typedef enum {
+    MARKET_DATA_NOT_HEARTBEAT,
+    MARKET_DATA_HEARTBEAT,             // Informational; nothing to do
+    MARKET_DATA_TEST_REQUEST           // The server wants a public/test call back
+} MarketDataHeartbeat;
+
+// Classify a "heartbeat" notification enabled by public/set_heartbeat
+MarketDataHeartbeat market_data_heartbeat(const char* message);
+
+// Decoders take the payload and fill everything except the instrument fields
+bool market_data_decode_book(const char* payload, BookUpdate* update, BookLevelUpdate* levels, int max_levels);
+bool market_data_decode_ticker(const char* payload, TickerUpdate* ticker);
+
+// Decode up to max_trades trades starting at *cursor (the payload on the first
+// call). Returns the count, -1 on malformed input; *cursor is NULL once the
+// array is exhausted.
+int market_data_decode_trades(const char** cursor, TradeUpdate* trades, int max_trades);
+
+// Decode a user.orders payload, one order or an array of them, into orders;
+// returns the count, -1 if malformed. A count above max_orders means only the
+// first max_orders were decoded; retry with a buffer that large. Timestamps
+// are formatted like the REST parsers in order.c.
+int market_data_decode_orders(const char* payload, Order* orders, int max_orders);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MARKET_DATA_H
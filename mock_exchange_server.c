@@ -0,0 +1,1245 @@
+// Local stand-in for the exchange: speaks the HTTP and WebSocket JSON-RPC
+// subset the client uses (auth, get_order_book, get_instruments, positions,
+// open orders, buy/sell/edit/cancel, subscriptions) and streams synthetic
+// book and trade notifications plus user.orders updates, so the client stack
+// can be benchmarked over real loopback sockets.
+//
+// Usage: mock_exchange_server [--port 8080] [--book-rate 20000] [--trade-rate 5000]
+//                             [--instruments 16] [--depth 10] [--seed 42] [--deflate 1]
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <zlib.h>
+#include <cJSON.h>
+#include "ws_frame.h"
+#include "sim_feed.h"
+
+#define MAX_EVENTS 256
+#define MAX_CONN_SUBSCRIPTIONS 64
+#define MAX_ORDERS 4096
+#define READ_CHUNK 65536
+#define MAX_HEADER_BYTES 16384
+#define MAX_BODY_BYTES (1024 * 1024)
+#define MAX_OUTBOUND (64 * 1024 * 1024)   // Slow consumers beyond this are dropped
+#define ACCESS_TOKEN "mock_access_token"
+#define BOOK_BASE_PRICE 25000.0
+#define BOOK_TICK_SIZE 0.5
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+typedef enum {
+    CONN_HTTP,
+    CONN_WEBSOCKET
+} ConnMode;
+
+typedef struct Connection {
+    int fd;
+    ConnMode mode;
+    bool authed;                  // WebSocket: public/auth succeeded on this connection
+    bool close_after_write;
+    bool want_write;              // EPOLLOUT registered
+    bool dirty;                   // Has output queued since the last flush
+    bool dead;
+    ByteBuffer in;
+    ByteBuffer out;
+    size_t out_offset;
+    ByteBuffer message;           // Fragmented WebSocket message being reassembled
+    WsOpcode message_opcode;
+    char subscriptions[MAX_CONN_SUBSCRIPTIONS][128];
+    int subscription_count;
+    uint64_t heartbeat_interval_ms;   // public/set_heartbeat, 0 if off
+    uint64_t next_heartbeat_ms;
+    bool test_request_pending;        // Sent a test_request, no public/test since
+    bool deflate;                     // permessage-deflate negotiated
+    z_stream deflater;                // Context kept across messages
+    struct Connection* next;
+} Connection;
+
+typedef struct {
+    bool in_use;
+    uint64_t id;
+    char instrument_name[64];
+    bool buy;
+    double price;
+    double amount;
+    const char* state;
+    uint64_t created_ms;
+    uint64_t updated_ms;
+} MockOrder;
+
+typedef struct {
+    int port;
+    double book_rate;
+    double trade_rate;
+    int instruments;
+    int depth;
+    uint64_t seed;
+    bool deflate;                 // Accept permessage-deflate offers
+} ServerConfig;
+
+typedef struct {
+    uint64_t connections;
+    uint64_t http_requests;
+    uint64_t ws_requests;
+    uint64_t notifications;
+    uint64_t bytes_out;
+    uint64_t dropped_slow;
+} ServerStats;
+
+static volatile sig_atomic_t running = 1;
+static int epoll_fd = -1;
+static Connection* connections = NULL;
+static int subscribed_connections = 0;
+static MockOrder orders[MAX_ORDERS];
+static uint64_t next_order_id = 1;
+static uint64_t change_id = 1;
+static SimFeed* feed = NULL;
+static bool accept_deflate = false;
+static ServerStats stats = {0};
+
+static void on_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Byte buffers
+static bool buffer_reserve(ByteBuffer* buffer, size_t extra) {
+    if (buffer->size + extra <= buffer->capacity) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->size + extra) {
+        capacity *= 2;
+    }
+    char* data = realloc(buffer->data, capacity);
+    if (!data) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool buffer_append(ByteBuffer* buffer, const void* data, size_t length) {
+    if (!buffer_reserve(buffer, length)) {
+        return false;
+    }
+    memcpy(buffer->data + buffer->size, data, length);
+    buffer->size += length;
+    return true;
+}
+
+static bool buffer_appendf(ByteBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t room = buffer->capacity - buffer->size;
+    int length = vsnprintf(buffer->data ? buffer->data + buffer->size : NULL, room, format, args);
+    va_end(args);
+    if (length < 0) {
+        return false;
+    }
+    if ((size_t)length >= room) {
+        if (!buffer_reserve(buffer, (size_t)length + 1)) {
+            return false;
+        }
+        va_start(args, format);
+        vsnprintf(buffer->data + buffer->size, (size_t)length + 1, format, args);
+        va_end(args);
+    }
+    buffer->size += (size_t)length;
+    return true;
+}
+
+static void buffer_consume(ByteBuffer* buffer, size_t length) {
+    if (length >= buffer->size) {
+        buffer->size = 0;
+        return;
+    }
+    memmove(buffer->data, buffer->data + length, buffer->size - length);
+    buffer->size -= length;
+}
+
+static void buffer_free(ByteBuffer* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+// Connections
+static void update_events(Connection* conn) {
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN | (conn->want_write ? EPOLLOUT : 0);
+    ev.data.ptr = conn;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+static void close_connection(Connection* conn) {
+    if (conn->dead) {
+        return;
+    }
+    conn->dead = true;
+    if (conn->mode == CONN_WEBSOCKET && conn->subscription_count > 0) {
+        subscribed_connections--;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+}
+
+static void reap_connections(void) {
+    Connection** link = &connections;
+    while (*link) {
+        Connection* conn = *link;
+        if (conn->dead) {
+            *link = conn->next;
+            buffer_free(&conn->in);
+            buffer_free(&conn->out);
+            buffer_free(&conn->message);
+            if (conn->deflate) {
+                deflateEnd(&conn->deflater);
+            }
+            free(conn);
+        } else {
+            link = &conn->next;
+        }
+    }
+}
+
+static void flush_connection(Connection* conn) {
+    conn->dirty = false;
+    while (conn->out_offset < conn->out.size) {
+        ssize_t sent = send(conn->fd, conn->out.data + conn->out_offset, conn->out.size - conn->out_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            close_connection(conn);
+            return;
+        }
+        conn->out_offset += (size_t)sent;
+        stats.bytes_out += (uint64_t)sent;
+    }
+
+    bool pending = conn->out_offset < conn->out.size;
+    if (!pending) {
+        conn->out.size = 0;
+        conn->out_offset = 0;
+        if (conn->close_after_write) {
+            close_connection(conn);
+            return;
+        }
+    } else if (conn->out_offset > conn->out.capacity / 2) {
+        buffer_consume(&conn->out, conn->out_offset);
+        conn->out_offset = 0;
+    }
+    if (pending != conn->want_write) {
+        conn->want_write = pending;
+        update_events(conn);
+    }
+}
+
+static void queue_output(Connection* conn, const void* data, size_t length) {
+    if (conn->out.size - conn->out_offset + length > MAX_OUTBOUND) {
+        stats.dropped_slow++;
+        close_connection(conn);
+        return;
+    }
+    if (!buffer_append(&conn->out, data, length)) {
+        close_connection(conn);
+        return;
+    }
+    conn->dirty = true;
+}
+
+// Compress one message on the connection's stream, flushed to a byte boundary
+// with the 00 00 ff ff flush marker dropped (RFC 7692 7.2.1)
+static bool compress_message(Connection* conn, const char* payload, size_t length, ByteBuffer* out) {
+    out->size = 0;
+    if (!buffer_reserve(out, deflateBound(&conn->deflater, length) + 16)) {
+        return false;
+    }
+    conn->deflater.next_in = (Bytef*)payload;
+    conn->deflater.avail_in = (uInt)length;
+    conn->deflater.next_out = (Bytef*)out->data;
+    conn->deflater.avail_out = (uInt)out->capacity;
+    if (deflate(&conn->deflater, Z_SYNC_FLUSH) != Z_OK || conn->deflater.avail_in != 0 || conn->deflater.avail_out == 0) {
+        return false;
+    }
+    out->size = out->capacity - conn->deflater.avail_out;
+    if (out->size >= 4) {
+        out->size -= 4;
+    }
+    return true;
+}
+
+static void queue_frame(Connection* conn, WsOpcode opcode, const char* payload, size_t length) {
+    static ByteBuffer compressed;
+    bool rsv1 = false;
+    if (conn->deflate && (opcode == WS_OP_TEXT || opcode == WS_OP_BINARY)) {
+        if (!compress_message(conn, payload, length, &compressed)) {
+            close_connection(conn);
+            return;
+        }
+        payload = compressed.data;
+        length = compressed.size;
+        rsv1 = true;
+    }
+    uint8_t header[WS_FRAME_MAX_HEADER];
+    size_t header_length = ws_frame_write_header(header, opcode, true, rsv1, length, NULL);
+    queue_output(conn, header, header_length);
+    if (length > 0 && !conn->dead) {
+        queue_output(conn, payload, length);
+    }
+}
+
+// Orders
+static MockOrder* find_order(const char* order_id) {
+    if (!order_id || strncmp(order_id, "MOCK-", 5) != 0) {
+        return NULL;
+    }
+    uint64_t id = strtoull(order_id + 5, NULL, 10);
+    MockOrder* order = &orders[id % MAX_ORDERS];
+    return order->in_use && order->id == id ? order : NULL;
+}
+
+static MockOrder* create_order(void) {
+    for (int attempt = 0; attempt < MAX_ORDERS; attempt++) {
+        uint64_t id = next_order_id++;
+        MockOrder* order = &orders[id % MAX_ORDERS];
+        if (!order->in_use) {
+            memset(order, 0, sizeof(*order));
+            order->in_use = true;
+            order->id = id;
+            return order;
+        }
+    }
+    return NULL;
+}
+
+static void append_order_json(ByteBuffer* out, const MockOrder* order) {
+    buffer_appendf(out,
+        "{\"order_id\":\"MOCK-%llu\",\"instrument_name\":\"%s\",\"direction\":\"%s\",\"price\":%.8g,"
+        "\"amount\":%.8g,\"filled_amount\":0,\"order_type\":\"limit\",\"order_state\":\"%s\",\"post_only\":true,"
+        "\"creation_timestamp\":%llu,\"last_update_timestamp\":%llu}",
+        (unsigned long long)order->id, order->instrument_name, order->buy ? "buy" : "sell", order->price,
+        order->amount, order->state, (unsigned long long)order->created_ms, (unsigned long long)order->updated_ms);
+}
+
+// JSON-RPC helpers
+static const char* param_string(const cJSON* params, const char* name) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(params, name);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+static bool param_number(const cJSON* params, const char* name, double* out) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(params, name);
+    if (cJSON_IsNumber(item)) {
+        *out = item->valuedouble;
+        return true;
+    }
+    if (cJSON_IsString(item)) {
+        char* end = NULL;
+        *out = strtod(item->valuestring, &end);
+        return end && end != item->valuestring && *end == '\0';
+    }
+    return false;
+}
+
+static void begin_response(ByteBuffer* out, const char* id_json) {
+    buffer_appendf(out, "{\"jsonrpc\":\"2.0\",\"id\":%s,", id_json);
+}
+
+static void end_response(ByteBuffer* out, uint64_t received_us) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t sent_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+    buffer_appendf(out, ",\"usIn\":%llu,\"usOut\":%llu,\"usDiff\":%llu,\"testnet\":true}",
+                   (unsigned long long)received_us, (unsigned long long)sent_us,
+                   (unsigned long long)(sent_us - received_us));
+}
+
+static bool error_response(ByteBuffer* out, int code, const char* message) {
+    buffer_appendf(out, "\"error\":{\"code\":%d,\"message\":\"%s\"}", code, message);
+    return false;
+}
+
+static bool channel_matches(const char* subscribed, const char* channel) {
+    // "book.X" also serves "book.X.100ms" and similar interval/depth variants
+    size_t length = strlen(channel);
+    return strncmp(subscribed, channel, length) == 0 && (subscribed[length] == '\0' || subscribed[length] == '.');
+}
+
+// user.orders.<instrument>.raw update to authenticated subscribers
+static void notify_order(const MockOrder* order) {
+    if (subscribed_connections == 0) {
+        return;
+    }
+    char channel[96];
+    snprintf(channel, sizeof(channel), "user.orders.%s.raw", order->instrument_name);
+    ByteBuffer body = {0};
+    for (Connection* conn = connections; conn; conn = conn->next) {
+        if (conn->dead || conn->mode != CONN_WEBSOCKET || !conn->authed) {
+            continue;
+        }
+        for (int i = 0; i < conn->subscription_count; i++) {
+            if (channel_matches(conn->subscriptions[i], channel)) {
+                if (body.size == 0) {
+                    buffer_appendf(&body, "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"%s\",\"data\":", channel);
+                    append_order_json(&body, order);
+                    buffer_appendf(&body, "}}");
+                }
+                queue_frame(conn, WS_OP_TEXT, body.data, body.size);
+                stats.notifications++;
+                break;
+            }
+        }
+    }
+    buffer_free(&body);
+}
+
+static bool handle_subscribe(Connection* conn, const cJSON* params, bool subscribe, ByteBuffer* out) {
+    const cJSON* channels = cJSON_GetObjectItemCaseSensitive(params, "channels");
+    if (!conn || conn->mode != CONN_WEBSOCKET) {
+        return error_response(out, 11050, "bad_request");
+    }
+    if (!cJSON_IsArray(channels)) {
+        return error_response(out, -32602, "Invalid params");
+    }
+
+    bool had_subscriptions = conn->subscription_count > 0;
+    buffer_appendf(out, "\"result\":[");
+    bool first = true;
+    const cJSON* channel;
+    cJSON_ArrayForEach(channel, channels) {
+        if (!cJSON_IsString(channel) || strlen(channel->valuestring) >= sizeof(conn->subscriptions[0])) {
+            continue;
+        }
+        int index = -1;
+        for (int i = 0; i < conn->subscription_count; i++) {
+            if (strcmp(conn->subscriptions[i], channel->valuestring) == 0) {
+                index = i;
+                break;
+            }
+        }
+        if (subscribe && index < 0) {
+            if (conn->subscription_count == MAX_CONN_SUBSCRIPTIONS) {
+                continue;
+            }
+            strcpy(conn->subscriptions[conn->subscription_count++], channel->valuestring);
+        } else if (!subscribe && index >= 0) {
+            conn->subscription_count--;
+            memmove(conn->subscriptions[index], conn->subscriptions[index + 1],
+                    (size_t)(conn->subscription_count - index) * sizeof(conn->subscriptions[0]));
+        } else if (!subscribe) {
+            continue;
+        }
+        buffer_appendf(out, "%s\"%s\"", first ? "" : ",", channel->valuestring);
+        first = false;
+    }
+    buffer_appendf(out, "]");
+
+    if (!had_subscriptions && conn->subscription_count > 0) {
+        subscribed_connections++;
+    } else if (had_subscriptions && conn->subscription_count == 0) {
+        subscribed_connections--;
+    }
+    return true;
+}
+
+static bool handle_order_book(const cJSON* params, ByteBuffer* out) {
+    const char* instrument = param_string(params, "instrument_name");
+    double depth_value = 5;
+    param_number(params, "depth", &depth_value);
+    int depth = (int)depth_value;
+    if (!instrument) {
+        return error_response(out, -32602, "Invalid params");
+    }
+    if (depth < 1) depth = 1;
+    if (depth > 1000) depth = 1000;
+
+    double best_bid = BOOK_BASE_PRICE - BOOK_TICK_SIZE;
+    double best_ask = BOOK_BASE_PRICE;
+    buffer_appendf(out, "\"result\":{\"instrument_name\":\"%s\",\"timestamp\":%llu,\"change_id\":%llu,"
+                   "\"best_bid_price\":%.8g,\"best_ask_price\":%.8g,\"bids\":[",
+                   instrument, (unsigned long long)now_ms(), (unsigned long long)change_id++, best_bid, best_ask);
+    for (int i = 0; i < depth; i++) {
+        buffer_appendf(out, "%s[%.8g,%.8g]", i ? "," : "", best_bid - i * BOOK_TICK_SIZE, 1.0 + (i % 5) * 0.5);
+    }
+    buffer_appendf(out, "],\"asks\":[");
+    for (int i = 0; i < depth; i++) {
+        buffer_appendf(out, "%s[%.8g,%.8g]", i ? "," : "", best_ask + i * BOOK_TICK_SIZE, 1.0 + ((i + 2) % 5) * 0.5);
+    }
+    buffer_appendf(out, "]}");
+    return true;
+}
+
+static bool handle_new_order(const cJSON* params, bool buy, ByteBuffer* out) {
+    const char* instrument = param_string(params, "instrument_name");
+    double amount = 0.0;
+    double price = 0.0;
+    if (!instrument || strlen(instrument) >= sizeof(orders[0].instrument_name) ||
+        !param_number(params, "amount", &amount) || amount <= 0.0 ||
+        !param_number(params, "price", &price) || price <= 0.0) {
+        return error_response(out, -32602, "Invalid params");
+    }
+
+    MockOrder* order = create_order();
+    if (!order) {
+        return error_response(out, 10028, "too_many_requests");
+    }
+    strcpy(order->instrument_name, instrument);
+    order->buy = buy;
+    order->price = price;
+    order->amount = amount;
+    order->state = "open";
+    order->created_ms = order->updated_ms = now_ms();
+    notify_order(order);
+
+    buffer_appendf(out, "\"result\":{\"order\":");
+    append_order_json(out, order);
+    buffer_appendf(out, ",\"trades\":[]}");
+    return true;
+}
+
+static bool handle_edit(const cJSON* params, ByteBuffer* out) {
+    MockOrder* order = find_order(param_string(params, "order_id"));
+    double amount = 0.0;
+    double price = 0.0;
+    if (!order) {
+        return error_response(out, 10004, "order_not_found");
+    }
+    if (!param_number(params, "amount", &amount) || amount <= 0.0 ||
+        !param_number(params, "price", &price) || price <= 0.0) {
+        return error_response(out, -32602, "Invalid params");
+    }
+
+    order->amount = amount;
+    order->price = price;
+    order->updated_ms = now_ms();
+    notify_order(order);
+    buffer_appendf(out, "\"result\":{\"order\":");
+    append_order_json(out, order);
+    buffer_appendf(out, ",\"trades\":[]}");
+    return true;
+}
+
+static bool handle_cancel(const cJSON* params, ByteBuffer* out) {
+    MockOrder* order = find_order(param_string(params, "order_id"));
+    if (!order) {
+        return error_response(out, 10004, "order_not_found");
+    }
+    order->state = "cancelled";
+    order->updated_ms = now_ms();
+    notify_order(order);
+    buffer_appendf(out, "\"result\":");
+    append_order_json(out, order);
+    order->in_use = false;
+    return true;
+}
+
+// Synthetic instruments are all treated as BTC-settled
+static bool currency_matches(const cJSON* params) {
+    const char* currency = param_string(params, "currency");
+    return currency && (strcmp(currency, "BTC") == 0 || strcmp(currency, "any") == 0);
+}
+
+static bool handle_instruments(const cJSON* params, ByteBuffer* out) {
+    buffer_appendf(out, "\"result\":[");
+    const char* name;
+    for (int i = 0; currency_matches(params) && (name = sim_feed_instrument_name(feed, i)) != NULL; i++) {
+        buffer_appendf(out, "%s{\"instrument_name\":\"%s\",\"kind\":\"future\",\"base_currency\":\"BTC\","
+                       "\"quote_currency\":\"USD\",\"settlement_period\":\"perpetual\",\"tick_size\":%.8g,"
+                       "\"min_trade_amount\":10,\"contract_size\":10,\"is_active\":true}",
+                       i ? "," : "", name, BOOK_TICK_SIZE);
+    }
+    buffer_appendf(out, "]");
+    return true;
+}
+
+// Open orders filtered by currency (by_currency) or instrument (by_instrument)
+static bool handle_open_orders(const cJSON* params, bool by_instrument, ByteBuffer* out) {
+    const char* instrument = param_string(params, "instrument_name");
+    if (by_instrument && !instrument) {
+        return error_response(out, -32602, "Invalid params");
+    }
+    bool all = !by_instrument && currency_matches(params);
+
+    buffer_appendf(out, "\"result\":[");
+    bool first = true;
+    for (int i = 0; i < MAX_ORDERS; i++) {
+        const MockOrder* order = &orders[i];
+        if (!order->in_use || strcmp(order->state, "open") != 0 ||
+            !(all || (by_instrument && strcmp(order->instrument_name, instrument) == 0))) {
+            continue;
+        }
+        buffer_appendf(out, first ? "" : ",");
+        append_order_json(out, order);
+        first = false;
+    }
+    buffer_appendf(out, "]");
+    return true;
+}
+
+// Dispatch one JSON-RPC request; conn is NULL for HTTP. Returns false if the
+// response is an error.
+static bool handle_rpc(Connection* conn, const cJSON* request, bool http_authed, ByteBuffer* out) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t received_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+
+    const cJSON* id = cJSON_GetObjectItemCaseSensitive(request, "id");
+    const cJSON* method_item = cJSON_GetObjectItemCaseSensitive(request, "method");
+    const cJSON* params = cJSON_GetObjectItemCaseSensitive(request, "params");
+
+    char id_json[64] = "null";
+    if (cJSON_IsNumber(id)) {
+        snprintf(id_json, sizeof(id_json), "%.0f", id->valuedouble);
+    } else if (cJSON_IsString(id) && strlen(id->valuestring) < sizeof(id_json) - 2 && !strpbrk(id->valuestring, "\"\\")) {
+        snprintf(id_json, sizeof(id_json), "\"%s\"", id->valuestring);
+    }
+    begin_response(out, id_json);
+
+    bool ok;
+    const char* method = cJSON_IsString(method_item) ? method_item->valuestring : "";
+    bool authed = conn ? conn->authed : http_authed;
+    if (strncmp(method, "private/", 8) == 0 && !authed) {
+        ok = error_response(out, 13009, "unauthorized");
+    } else if (strcmp(method, "public/auth") == 0) {
+        if (conn) {
+            conn->authed = true;
+        }
+        buffer_appendf(out, "\"result\":{\"access_token\":\"" ACCESS_TOKEN "\",\"expires_in\":900,"
+                       "\"refresh_token\":\"mock_refresh_token\",\"scope\":\"connection mainaccount\",\"token_type\":\"bearer\"}");
+        ok = true;
+    } else if (strcmp(method, "public/get_order_book") == 0) {
+        ok = handle_order_book(params, out);
+    } else if (strcmp(method, "public/get_instruments") == 0) {
+        ok = handle_instruments(params, out);
+    } else if (strcmp(method, "private/get_positions") == 0) {
+        buffer_appendf(out, "\"result\":[]");     // Orders never fill, so the account stays flat
+        ok = true;
+    } else if (strcmp(method, "private/get_open_orders_by_currency") == 0) {
+        ok = handle_open_orders(params, false, out);
+    } else if (strcmp(method, "private/get_open_orders_by_instrument") == 0) {
+        ok = handle_open_orders(params, true, out);
+    } else if (strcmp(method, "private/buy") == 0 || strcmp(method, "private/sell") == 0) {
+        ok = handle_new_order(params, method[8] == 'b', out);
+    } else if (strcmp(method, "private/edit") == 0) {
+        ok = handle_edit(params, out);
+    } else if (strcmp(method, "private/cancel") == 0) {
+        ok = handle_cancel(params, out);
+    } else if (strcmp(method, "public/subscribe") == 0 || strcmp(method, "private/subscribe") == 0) {
+        ok = handle_subscribe(conn, params, true, out);
+    } else if (strcmp(method, "public/unsubscribe") == 0 || strcmp(method, "private/unsubscribe") == 0) {
+        ok = handle_subscribe(conn, params, false, out);
+    } else if (strcmp(method, "public/get_time") == 0) {
+        buffer_appendf(out, "\"result\":%llu", (unsigned long long)now_ms());
+        ok = true;
+    } else if (strcmp(method, "public/test") == 0) {
+        if (conn) {
+            conn->test_request_pending = false;
+        }
+        buffer_appendf(out, "\"result\":{\"version\":\"mock\"}");
+        ok = true;
+    } else if (strcmp(method, "public/set_heartbeat") == 0 || strcmp(method, "public/disable_heartbeat") == 0) {
+        double interval = 0;
+        if (method[7] == 's' && (!param_number(params, "interval", &interval) || interval <= 0)) {
+            ok = error_response(out, -32602, "Invalid params");
+        } else {
+            if (conn) {
+                conn->heartbeat_interval_ms = (uint64_t)(interval * 1000);
+                conn->next_heartbeat_ms = now_ms() + conn->heartbeat_interval_ms;
+                conn->test_request_pending = false;
+            }
+            buffer_appendf(out, "\"result\":\"ok\"");
+            ok = true;
+        }
+    } else {
+        ok = error_response(out, -32601, "Method not found");
+    }
+
+    end_response(out, received_us);
+    return ok;
+}
+
+// HTTP
+static bool header_value(const char* headers, size_t length, const char* name, char* out, size_t out_size) {
+    size_t name_length = strlen(name);
+    const char* line = headers;
+    const char* end = headers + length;
+    while (line < end) {
+        const char* eol = memmem(line, (size_t)(end - line), "\r\n", 2);
+        if (!eol) {
+            eol = end;
+        }
+        if ((size_t)(eol - line) > name_length && strncasecmp(line, name, name_length) == 0 && line[name_length] == ':') {
+            const char* value = line + name_length + 1;
+            while (value < eol && (*value == ' ' || *value == '\t')) {
+                value++;
+            }
+            size_t value_length = (size_t)(eol - value);
+            if (value_length >= out_size) {
+                value_length = out_size - 1;
+            }
+            memcpy(out, value, value_length);
+            out[value_length] = '\0';
+            return true;
+        }
+        line = eol + 2;
+    }
+    return false;
+}
+
+// GET /api/v2/public/get_order_book?instrument_name=X&depth=5
+static cJSON* request_from_target(const char* target) {
+    const char* path = strstr(target, "/api/v2/");
+    if (!path) {
+        return NULL;
+    }
+    path += strlen("/api/v2/");
+
+    cJSON* request = cJSON_CreateObject();
+    cJSON* params = cJSON_CreateObject();
+    const char* query = strchr(path, '?');
+    size_t method_length = query ? (size_t)(query - path) : strlen(path);
+    char method[128];
+    if (method_length >= sizeof(method)) {
+        method_length = sizeof(method) - 1;
+    }
+    memcpy(method, path, method_length);
+    method[method_length] = '\0';
+    cJSON_AddStringToObject(request, "method", method);
+    cJSON_AddNumberToObject(request, "id", 0);
+
+    while (query && *query) {
+        query++;
+        const char* eq = strchr(query, '=');
+        const char* amp = strchr(query, '&');
+        if (!eq || (amp && amp < eq)) {
+            query = amp;
+            continue;
+        }
+        char key[64];
+        char value[256];
+        size_t key_length = (size_t)(eq - query);
+        size_t value_length = amp ? (size_t)(amp - eq - 1) : strlen(eq + 1);
+        if (key_length < sizeof(key) && value_length < sizeof(value)) {
+            memcpy(key, query, key_length);
+            key[key_length] = '\0';
+            memcpy(value, eq + 1, value_length);
+            value[value_length] = '\0';
+            cJSON_AddStringToObject(params, key, value);
+        }
+        query = amp;
+    }
+    cJSON_AddItemToObject(request, "params", params);
+    return request;
+}
+
+static void send_http_response(Connection* conn, int status, const char* reason, const ByteBuffer* body, bool keep_alive) {
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+        "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n%s\r\n",
+        status, reason, body ? body->size : 0, keep_alive ? "" : "Connection: close\r\n");
+    queue_output(conn, header, (size_t)length);
+    if (body && body->size > 0 && !conn->dead) {
+        queue_output(conn, body->data, body->size);
+    }
+    if (!keep_alive) {
+        conn->close_after_write = true;
+    }
+}
+
+static bool upgrade_websocket(Connection* conn, const char* headers, size_t length) {
+    char key[128];
+    if (!header_value(headers, length, "Sec-WebSocket-Key", key, sizeof(key))) {
+        return false;
+    }
+    char accept[WS_ACCEPT_KEY_SIZE];
+    ws_frame_accept_key(key, accept);
+
+    // Offers are accepted without parameters: 15-bit window, context takeover
+    char extensions[256];
+    if (accept_deflate && header_value(headers, length, "Sec-WebSocket-Extensions", extensions, sizeof(extensions)) &&
+        strstr(extensions, "permessage-deflate") &&
+        deflateInit2(&conn->deflater, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+        conn->deflate = true;
+    }
+
+    char response[320];
+    int response_length = snprintf(response, sizeof(response),
+        "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: %s\r\n%s\r\n", accept,
+        conn->deflate ? "Sec-WebSocket-Extensions: permessage-deflate\r\n" : "");
+    queue_output(conn, response, (size_t)response_length);
+    conn->mode = CONN_WEBSOCKET;
+    return true;
+}
+
+// Handle complete HTTP requests in conn->in; returns false to stop reading
+static bool process_http(Connection* conn) {
+    while (conn->mode == CONN_HTTP && !conn->dead && !conn->close_after_write) {
+        char* end = memmem(conn->in.data, conn->in.size, "\r\n\r\n", 4);
+        if (!end) {
+            if (conn->in.size > MAX_HEADER_BYTES) {
+                send_http_response(conn, 431, "Request Header Fields Too Large", NULL, false);
+            }
+            return true;
+        }
+        size_t header_length = (size_t)(end - conn->in.data) + 4;
+
+        // Request line: METHOD target HTTP/1.x
+        char method[16] = {0};
+        char target[1024] = {0};
+        char version[16] = {0};
+        char request_line[sizeof(target) + 64];
+        const char* line_end = memmem(conn->in.data, header_length, "\r\n", 2);
+        size_t line_length = (size_t)(line_end - conn->in.data);
+        if (line_length >= sizeof(request_line)) {
+            send_http_response(conn, 414, "URI Too Long", NULL, false);
+            return false;
+        }
+        memcpy(request_line, conn->in.data, line_length);
+        request_line[line_length] = '\0';
+        if (sscanf(request_line, "%15s %1023s %15s", method, target, version) != 3) {
+            send_http_response(conn, 400, "Bad Request", NULL, false);
+            return false;
+        }
+
+        const char* headers = line_end + 2;
+        size_t headers_length = header_length - (size_t)(headers - conn->in.data);
+        char value[1024];
+        size_t content_length = 0;
+        if (header_value(headers, headers_length, "Content-Length", value, sizeof(value))) {
+            content_length = (size_t)strtoull(value, NULL, 10);
+        }
+        if (content_length > MAX_BODY_BYTES) {
+            send_http_response(conn, 413, "Payload Too Large", NULL, false);
+            return false;
+        }
+        if (conn->in.size < header_length + content_length) {
+            return true;
+        }
+
+        bool keep_alive = strcmp(version, "HTTP/1.0") != 0;
+        if (header_value(headers, headers_length, "Connection", value, sizeof(value))) {
+            if (strcasestr(value, "close")) keep_alive = false;
+            if (strcasestr(value, "keep-alive")) keep_alive = true;
+        }
+
+        if (header_value(headers, headers_length, "Upgrade", value, sizeof(value)) && strcasecmp(value, "websocket") == 0) {
+            bool upgraded = strcmp(method, "GET") == 0 && upgrade_websocket(conn, headers, headers_length);
+            buffer_consume(&conn->in, header_length + content_length);
+            if (!upgraded) {
+                send_http_response(conn, 400, "Bad Request", NULL, false);
+                return false;
+            }
+            return true;
+        }
+
+        bool http_authed = header_value(headers, headers_length, "Authorization", value, sizeof(value)) &&
+                           strcmp(value, "Bearer " ACCESS_TOKEN) == 0;
+
+        cJSON* request = content_length > 0
+            ? cJSON_ParseWithLength(conn->in.data + header_length, content_length)
+            : request_from_target(target);
+        buffer_consume(&conn->in, header_length + content_length);
+        stats.http_requests++;
+
+        ByteBuffer body = {0};
+        if (!request) {
+            begin_response(&body, "null");
+            error_response(&body, -32700, "Parse error");
+            buffer_appendf(&body, "}");
+            send_http_response(conn, 400, "Bad Request", &body, keep_alive);
+        } else {
+            bool ok = handle_rpc(NULL, request, http_authed, &body);
+            send_http_response(conn, ok ? 200 : 400, ok ? "OK" : "Bad Request", &body, keep_alive);
+            cJSON_Delete(request);
+        }
+        buffer_free(&body);
+    }
+    return true;
+}
+
+// WebSocket
+static void handle_ws_message(Connection* conn, const char* data, size_t length) {
+    stats.ws_requests++;
+    ByteBuffer body = {0};
+    cJSON* request = cJSON_ParseWithLength(data, length);
+    if (!request) {
+        begin_response(&body, "null");
+        error_response(&body, -32700, "Parse error");
+        buffer_appendf(&body, "}");
+    } else {
+        handle_rpc(conn, request, false, &body);
+        cJSON_Delete(request);
+    }
+    queue_frame(conn, WS_OP_TEXT, body.data, body.size);
+    buffer_free(&body);
+}
+
+static void process_websocket(Connection* conn) {
+    size_t offset = 0;
+    while (!conn->dead && !conn->close_after_write) {
+        WsFrameHeader header;
+        uint8_t* frame = (uint8_t*)conn->in.data + offset;
+        size_t available = conn->in.size - offset;
+        int parsed = ws_frame_parse_header(frame, available, &header);
+        if (parsed < 0 || (parsed > 0 && (!header.masked || header.payload_length > MAX_BODY_BYTES))) {
+            close_connection(conn);
+            return;
+        }
+        if (parsed == 0 || available - header.header_length < header.payload_length) {
+            break;
+        }
+
+        char* payload = (char*)frame + header.header_length;
+        size_t payload_length = (size_t)header.payload_length;
+        ws_frame_apply_mask((uint8_t*)payload, payload_length, header.mask, 0);
+        offset += header.header_length + payload_length;
+
+        switch (header.opcode) {
+            case WS_OP_TEXT:
+            case WS_OP_BINARY:
+                if (header.fin) {
+                    handle_ws_message(conn, payload, payload_length);
+                } else {
+                    conn->message.size = 0;
+                    conn->message_opcode = header.opcode;
+                    buffer_append(&conn->message, payload, payload_length);
+                }
+                break;
+            case WS_OP_CONTINUATION:
+                if (conn->message.size + payload_length > MAX_BODY_BYTES) {
+                    close_connection(conn);
+                    return;
+                }
+                buffer_append(&conn->message, payload, payload_length);
+                if (header.fin) {
+                    handle_ws_message(conn, conn->message.data, conn->message.size);
+                    conn->message.size = 0;
+                }
+                break;
+            case WS_OP_PING:
+                queue_frame(conn, WS_OP_PONG, payload, payload_length);
+                break;
+            case WS_OP_PONG:
+                break;
+            case WS_OP_CLOSE:
+                queue_frame(conn, WS_OP_CLOSE, payload, payload_length >= 2 ? 2 : 0);
+                conn->close_after_write = true;
+                break;
+        }
+    }
+    if (!conn->dead) {
+        buffer_consume(&conn->in, offset);
+    }
+}
+
+// Deribit-style heartbeats: a test_request every interval, and the connection
+// is dropped if the previous one went unanswered
+static void send_heartbeats(void) {
+    uint64_t now = now_ms();
+    for (Connection* conn = connections; conn; conn = conn->next) {
+        if (conn->dead || conn->heartbeat_interval_ms == 0 || now < conn->next_heartbeat_ms) {
+            continue;
+        }
+        if (conn->test_request_pending) {
+            printf("Heartbeat not answered, closing connection\n");
+            close_connection(conn);
+            continue;
+        }
+        static const char test_request[] =
+            "{\"jsonrpc\":\"2.0\",\"method\":\"heartbeat\",\"params\":{\"type\":\"test_request\"}}";
+        queue_frame(conn, WS_OP_TEXT, test_request, sizeof(test_request) - 1);
+        if (!conn->dead) {
+            flush_connection(conn);
+        }
+        conn->test_request_pending = true;
+        conn->next_heartbeat_ms = now + conn->heartbeat_interval_ms;
+    }
+}
+
+static void read_connection(Connection* conn) {
+    for (;;) {
+        if (!buffer_reserve(&conn->in, READ_CHUNK)) {
+            close_connection(conn);
+            return;
+        }
+        ssize_t received = recv(conn->fd, conn->in.data + conn->in.size, conn->in.capacity - conn->in.size, 0);
+        if (received > 0) {
+            conn->in.size += (size_t)received;
+            continue;
+        }
+        if (received == 0) {
+            close_connection(conn);
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close_connection(conn);
+            return;
+        }
+        break;
+    }
+
+    if (conn->mode == CONN_HTTP && !process_http(conn)) {
+        flush_connection(conn);
+        return;
+    }
+    if (conn->mode == CONN_WEBSOCKET) {
+        process_websocket(conn);
+    }
+    if (!conn->dead) {
+        flush_connection(conn);
+    }
+}
+
+static void accept_connections(int listen_fd) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection* conn = calloc(1, sizeof(Connection));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->mode = CONN_HTTP;
+
+        struct epoll_event ev = {0};
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            free(conn);
+            continue;
+        }
+        conn->next = connections;
+        connections = conn;
+        stats.connections++;
+    }
+}
+
+// Fan each generated notification out to the connections subscribed to its channel
+static void on_feed_message(const WebSocketMessage* message) {
+    uint8_t header[WS_FRAME_MAX_HEADER];
+    size_t header_length = 0;
+    for (Connection* conn = connections; conn; conn = conn->next) {
+        if (conn->dead || conn->mode != CONN_WEBSOCKET || conn->subscription_count == 0) {
+            continue;
+        }
+        for (int i = 0; i < conn->subscription_count; i++) {
+            if (channel_matches(conn->subscriptions[i], message->channel)) {
+                if (conn->deflate) {
+                    queue_frame(conn, WS_OP_TEXT, message->data, message->length);
+                    stats.notifications++;
+                    break;
+                }
+                if (header_length == 0) {
+                    header_length = ws_frame_write_header(header, WS_OP_TEXT, true, false, message->length, NULL);
+                }
+                queue_output(conn, header, header_length);
+                if (!conn->dead) {
+                    queue_output(conn, message->data, message->length);
+                }
+                stats.notifications++;
+                break;
+            }
+        }
+    }
+}
+
+static int create_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 512) < 0) {
+        perror("bind/listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [--port 8080] [--book-rate 20000] [--trade-rate 5000]\n"
+        "          [--instruments 16] [--depth 10] [--seed 42] [--deflate 1]\n", program);
+}
+
+static bool parse_args(int argc, char** argv, ServerConfig* config) {
+    config->port = 8080;
+    config->book_rate = 20000.0;
+    config->trade_rate = 5000.0;
+    config->instruments = 16;
+    config->depth = 10;
+    config->seed = 42;
+    config->deflate = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (strcmp(argv[i - 1], "--port") == 0) {
+            config->port = atoi(value);
+        } else if (strcmp(argv[i - 1], "--book-rate") == 0) {
+            config->book_rate = atof(value);
+        } else if (strcmp(argv[i - 1], "--trade-rate") == 0) {
+            config->trade_rate = atof(value);
+        } else if (strcmp(argv[i - 1], "--instruments") == 0) {
+            config->instruments = atoi(value);
+        } else if (strcmp(argv[i - 1], "--depth") == 0) {
+            config->depth = atoi(value);
+        } else if (strcmp(argv[i - 1], "--seed") == 0) {
+            config->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(argv[i - 1], "--deflate") == 0) {
+            config->deflate = atoi(value) != 0;
+        } else {
+            return false;
+        }
+    }
+    return config->port > 0 && config->port < 65536 && config->book_rate >= 0.0 && config->trade_rate >= 0.0 &&
+           config->book_rate + config->trade_rate > 0.0 && config->instruments > 0 && config->depth > 0;
+}
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    accept_deflate = config.deflate;
+
+    SimFeedConfig feed_config;
+    sim_feed_default_config(&feed_config);
+    feed_config.instrument_count = config.instruments;
+    feed_config.depth = config.depth;
+    feed_config.messages_per_sec = config.book_rate + config.trade_rate;
+    feed_config.trade_ratio = config.trade_rate / feed_config.messages_per_sec;
+    feed_config.ticker_ratio = 0.0;
+    feed_config.max_burst = feed_config.messages_per_sec / 50 > 256 ? (int)(feed_config.messages_per_sec / 50) : 256;
+    feed_config.seed = config.seed;
+    feed = sim_feed_create(&feed_config);
+    if (!feed) {
+        fprintf(stderr, "Failed to create market data generator\n");
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = create_listener(config.port);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (listen_fd < 0 || epoll_fd < 0) {
+        sim_feed_destroy(feed);
+        return 1;
+    }
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+
+    printf("Mock exchange listening on 127.0.0.1:%d (%d instruments, book %.0f/s, trades %.0f/s)\n",
+           config.port, config.instruments, config.book_rate, config.trade_rate);
+    printf("Channels: book.<instrument>, trades.<instrument>, instruments %s .. %s\n",
+           sim_feed_instrument_name(feed, 0), sim_feed_instrument_name(feed, config.instruments - 1));
+    fflush(stdout);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (running) {
+        int count = epoll_wait(epoll_fd, events, MAX_EVENTS, subscribed_connections > 0 ? 1 : 100);
+        for (int i = 0; i < count; i++) {
+            Connection* conn = events[i].data.ptr;
+            if (!conn) {
+                accept_connections(listen_fd);
+                continue;
+            }
+            if (conn->dead) {
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                read_connection(conn);
+            }
+            if (!conn->dead && (events[i].events & EPOLLOUT)) {
+                flush_connection(conn);
+            }
+        }
+
+        send_heartbeats();
+        if (subscribed_connections > 0) {
+            sim_feed_poll(feed, on_feed_message);
+            for (Connection* conn = connections; conn; conn = conn->next) {
+                if (conn->dirty && !conn->dead) {
+                    flush_connection(conn);
+                }
+            }
+        }
+        reap_connections();
+    }
+
+    printf("\nConnections: %llu, HTTP requests: %llu, WebSocket requests: %llu\n",
+           (unsigned long long)stats.connections, (unsigned long long)stats.http_requests,
+           (unsigned long long)stats.ws_requests);
+    printf("Notifications: %llu, bytes sent: %llu, slow consumers dropped: %llu\n",
+           (unsigned long long)stats.notifications, (unsigned long long)stats.bytes_out,
+           (unsigned long long)stats.dropped_slow);
+
+    for (Connection* conn = connections; conn; conn = conn->next) {
+        close_connection(conn);
+    }
+    reap_connections();
+    close(epoll_fd);
+    close(listen_fd);
+    sim_feed_destroy(feed);
+    return 0;
+}
@@ -3,9 +3,12 @@
 #include <string.h>
 #include <cJSON.h>
 #include "order.h"
-#include "C:\Users\sansk\goquant_assignment\include\deribit_api.h"
+#include "request_encoder.h"
+#include "websocket_client.h"
+#include "token_manager.h"
+#include "deribit_api.h"
 #include <time.h>
-char* api_request(const char* url, const char* post_data, const char* access_token);
+DeribitResponse* api_request(const char* url, const char* post_data, const char* access_token);
 
 
 // Callback functions
@@ -210,36 +213,59 @@ static void parse_position_from_json(cJSON* json_position, Position* position) {
     }
 }
 
+// buy/sell/edit nest the order under "order" next to its trades; cancel returns it bare
+static cJSON* order_object(cJSON* result) {
+    cJSON* order = cJSON_GetObjectItemCaseSensitive(result, "order");
+    return cJSON_IsObject(order) ? order : result;
+}
+
+// Request bodies shared by the blocking and async variants; -1 if a field is invalid or too long
+static int build_place_body(char* post_data, size_t size, const char* symbol, const char* price, const char* amount) {
+    const PlaceTemplate* tmpl = request_template_for(symbol);
+    if (!tmpl) {
+        return -1;
+    }
+    return request_encode_place(post_data, size, tmpl, amount, price);
+}
+
+static int build_cancel_body(char* post_data, size_t size, const char* order_id) {
+    return request_encode_cancel(post_data, size, order_id);
+}
+
+static int build_modify_body(char* post_data, size_t size, const char* order_id, const char* new_price, const char* new_amount) {
+    return request_encode_modify(post_data, size, order_id, new_amount, new_price);
+}
+
 // Place a new order
 bool place_order(const char* symbol, const char* price, const char* amount, const char* access_token, Order* out_order) {
     char url[256];
     char post_data[512];
     
     snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/private/buy");
-    snprintf(post_data, sizeof(post_data), 
-        "{\"instrument_name\":\"%s\",\"amount\":%s,\"price\":%s,\"type\":\"limit\",\"post_only\":true}", 
-        symbol, amount, price);
+    if (build_place_body(post_data, sizeof(post_data), symbol, price, amount) < 0) {
+        return false;
+    }
     
-    char* response = api_request(url, post_data, access_token);
+    DeribitResponse* response = api_request(url, post_data, access_token);
     if (!response) {
         return false;
     }
     
-    cJSON* json = cJSON_Parse(response);
+    cJSON* json = cJSON_ParseWithLength(response->data, response->size);
     if (!json) {
-        free(response);
+        deribit_response_release(response);
         return false;
     }
     
     bool success = false;
     cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
     if (cJSON_IsObject(result) && out_order) {
-        parse_order_from_json(result, out_order);
+        parse_order_from_json(order_object(result), out_order);
         success = true;
     }
     
     cJSON_Delete(json);
-    free(response);
+    deribit_response_release(response);
     return success;
 }
 
@@ -249,16 +275,18 @@ bool cancel_order(const char* order_id, const char* access_token) {
     char post_data[512];
     
     snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/private/cancel");
-    snprintf(post_data, sizeof(post_data), "{\"order_id\":\"%s\"}", order_id);
+    if (build_cancel_body(post_data, sizeof(post_data), order_id) < 0) {
+        return false;
+    }
     
-    char* response = api_request(url, post_data, access_token);
+    DeribitResponse* response = api_request(url, post_data, access_token);
     if (!response) {
         return false;
     }
     
-    cJSON* json = cJSON_Parse(response);
+    cJSON* json = cJSON_ParseWithLength(response->data, response->size);
     if (!json) {
-        free(response);
+        deribit_response_release(response);
         return false;
     }
     
@@ -269,7 +297,7 @@ bool cancel_order(const char* order_id, const char* access_token) {
     }
     
     cJSON_Delete(json);
-    free(response);
+    deribit_response_release(response);
     return success;
 }
 
@@ -279,49 +307,186 @@ bool modify_order(const char* order_id, const char* new_price, const char* new_a
     char post_data[512];
     
     snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/private/edit");
-    snprintf(post_data, sizeof(post_data), 
-        "{\"order_id\":\"%s\",\"amount\":%s,\"price\":%s}", 
-        order_id, new_amount, new_price);
+    if (build_modify_body(post_data, sizeof(post_data), order_id, new_price, new_amount) < 0) {
+        return false;
+    }
     
-    char* response = api_request(url, post_data, access_token);
+    DeribitResponse* response = api_request(url, post_data, access_token);
     if (!response) {
         return false;
     }
     
-    cJSON* json = cJSON_Parse(response);
+    cJSON* json = cJSON_ParseWithLength(response->data, response->size);
     if (!json) {
-        free(response);
+        deribit_response_release(response);
         return false;
     }
     
     bool success = false;
     cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
     if (cJSON_IsObject(result) && out_order) {
-        parse_order_from_json(result, out_order);
+        parse_order_from_json(order_object(result), out_order);
         success = true;
     }
     
     cJSON_Delete(json);
-    free(response);
+    deribit_response_release(response);
     return success;
 }
 
-// Get open orders
-bool get_open_orders(const char* symbol, const char* access_token, Order** out_orders, int* out_count) {
-    char url[256];
+// Async order entry
+typedef enum {
+    ORDER_REQUEST_PLACE,
+    ORDER_REQUEST_CANCEL,
+    ORDER_REQUEST_MODIFY
+} OrderRequestKind;
+
+typedef struct {
+    OrderRequestKind kind;
+    OrderCompletionCallback callback;
+    void* user_data;
+} OrderRequestContext;
+
+// Same response handling as the blocking functions
+static bool parse_order_result(const char* response, size_t length, OrderRequestKind kind, Order* order) {
+    bool success = false;
+    cJSON* json = cJSON_ParseWithLength(response, length);
+    if (json) {
+        cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
+        if (cJSON_IsObject(result)) {
+            if (kind != ORDER_REQUEST_CANCEL) {
+                parse_order_from_json(order_object(result), order);
+            }
+            success = true;
+        }
+        cJSON_Delete(json);
+    }
+    return success;
+}
+
+static void finish_order_request(OrderRequestContext* ctx, uint64_t handle, const char* response, size_t length) {
+    Order order = {0};
+    bool success = response && parse_order_result(response, length, ctx->kind, &order);
+
+    if (ctx->callback) {
+        ctx->callback(handle, success, success && ctx->kind != ORDER_REQUEST_CANCEL ? &order : NULL, ctx->user_data);
+    }
+    free(ctx);
+}
+
+static void on_order_response(DeribitRequestHandle handle, const char* response, const DeribitError* error, void* user_data) {
+    (void)error;
+    finish_order_request((OrderRequestContext*)user_data, handle, response, response ? strlen(response) : 0);
+}
+
+static void on_ws_order_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    finish_order_request((OrderRequestContext*)user_data, request_id, response, length);
+}
+
+static OrderRequestContext* create_order_context(OrderRequestKind kind, OrderCompletionCallback callback, void* user_data) {
+    OrderRequestContext* ctx = malloc(sizeof(OrderRequestContext));
+    if (ctx) {
+        ctx->kind = kind;
+        ctx->callback = callback;
+        ctx->user_data = user_data;
+    }
+    return ctx;
+}
+
+static uint64_t submit_order_request(OrderRequestKind kind, const char* url, const char* post_data, const char* access_token,
+                                     OrderCompletionCallback callback, void* user_data) {
+    OrderRequestContext* ctx = create_order_context(kind, callback, user_data);
+    if (!ctx) {
+        return 0;
+    }
+
+    DeribitRequestHandle handle = deribit_async_request(url, post_data, access_token, on_order_response, ctx);
+    if (!handle) {
+        free(ctx);
+    }
+    return handle;
+}
+
+static uint64_t submit_ws_order_request(OrderRequestKind kind, const char* method, const char* params,
+                                        OrderCompletionCallback callback, void* user_data) {
+    OrderRequestContext* ctx = create_order_context(kind, callback, user_data);
+    if (!ctx) {
+        return 0;
+    }
+
+    uint64_t request_id = websocket_call(method, params, on_ws_order_response, ctx);
+    if (!request_id) {
+        free(ctx);
+    }
+    return request_id;
+}
+
+uint64_t place_order_async(const char* symbol, const char* price, const char* amount, const char* access_token,
+                           OrderCompletionCallback callback, void* user_data) {
     char post_data[512];
-    
-    snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/private/get_open_orders_by_instrument");
-    snprintf(post_data, sizeof(post_data), "{\"instrument_name\":\"%s\"}", symbol);
-    
-    char* response = api_request(url, post_data, access_token);
-    if (!response) {
-        return false;
+    if (build_place_body(post_data, sizeof(post_data), symbol, price, amount) < 0) {
+        return 0;
     }
-    
-    cJSON* json = cJSON_Parse(response);
+    return submit_order_request(ORDER_REQUEST_PLACE, "https://www.deribit.com/api/v2/private/buy",
+                                post_data, access_token, callback, user_data);
+}
+
+uint64_t cancel_order_async(const char* order_id, const char* access_token,
+                            OrderCompletionCallback callback, void* user_data) {
+    char post_data[512];
+    if (build_cancel_body(post_data, sizeof(post_data), order_id) < 0) {
+        return 0;
+    }
+    return submit_order_request(ORDER_REQUEST_CANCEL, "https://www.deribit.com/api/v2/private/cancel",
+                                post_data, access_token, callback, user_data);
+}
+
+uint64_t modify_order_async(const char* order_id, const char* new_price, const char* new_amount, const char* access_token,
+                            OrderCompletionCallback callback, void* user_data) {
+    char post_data[512];
+    if (build_modify_body(post_data, sizeof(post_data), order_id, new_price, new_amount) < 0) {
+        return 0;
+    }
+    return submit_order_request(ORDER_REQUEST_MODIFY, "https://www.deribit.com/api/v2/private/edit",
+                                post_data, access_token, callback, user_data);
+}
+
+// Order entry over the WebSocket JSON-RPC channel
+uint64_t place_order_ws(const char* symbol, const char* price, const char* amount,
+                        OrderCompletionCallback callback, void* user_data) {
+    char params[512];
+    if (build_place_body(params, sizeof(params), symbol, price, amount) < 0) {
+        return 0;
+    }
+    return submit_ws_order_request(ORDER_REQUEST_PLACE, "private/buy", params, callback, user_data);
+}
+
+uint64_t cancel_order_ws(const char* order_id, OrderCompletionCallback callback, void* user_data) {
+    char params[512];
+    if (build_cancel_body(params, sizeof(params), order_id) < 0) {
+        return 0;
+    }
+    // Cancels skip write coalescing
+    uint64_t request_id = submit_ws_order_request(ORDER_REQUEST_CANCEL, "private/cancel", params, callback, user_data);
+    if (request_id) {
+        websocket_flush();
+    }
+    return request_id;
+}
+
+uint64_t modify_order_ws(const char* order_id, const char* new_price, const char* new_amount,
+                         OrderCompletionCallback callback, void* user_data) {
+    char params[512];
+    if (build_modify_body(params, sizeof(params), order_id, new_price, new_amount) < 0) {
+        return 0;
+    }
+    return submit_ws_order_request(ORDER_REQUEST_MODIFY, "private/edit", params, callback, user_data);
+}
+
+// Parse a response whose result is an array of orders
+bool parse_order_list(const char* data, size_t length, Order** out_orders, int* out_count) {
+    cJSON* json = cJSON_ParseWithLength(data, length);
     if (!json) {
-        free(response);
         return false;
     }
     
@@ -332,20 +497,37 @@ bool get_open_orders(const char* symbol, const char* access_token, Order** out_o
         *out_count = count;
         
         if (count > 0) {
-            *out_orders = malloc(count * sizeof(Order));
-            for (int i = 0; i < count; i++) {
+            *out_orders = calloc(count, sizeof(Order));
+            for (int i = 0; *out_orders && i < count; i++) {
                 cJSON* order = cJSON_GetArrayItem(result, i);
                 parse_order_from_json(order, &(*out_orders)[i]);
             }
+            success = *out_orders != NULL;
         } else {
             *out_orders = NULL;
+            success = true;
         }
-        
-        success = true;
     }
     
     cJSON_Delete(json);
-    free(response);
+    return success;
+}
+
+// Get open orders
+bool get_open_orders(const char* symbol, const char* access_token, Order** out_orders, int* out_count) {
+    char url[256];
+    char post_data[512];
+    
+    snprintf(url, sizeof(url), "https://www.deribit.com/api/v2/private/get_open_orders_by_instrument");
+    snprintf(post_data, sizeof(post_data), "{\"instrument_name\":\"%s\"}", symbol);
+    
+    DeribitResponse* response = api_request(url, post_data, access_token);
+    if (!response) {
+        return false;
+    }
+    
+    bool success = parse_order_list(response->data, response->size, out_orders, out_count);
+    deribit_response_release(response);
     return success;
 }
 
@@ -359,48 +541,22 @@ bool get_order_history(const char* symbol, const char* access_token, Order** out
         "{\"instrument_name\":\"%s\",\"count\":20,\"include_old\":true}", 
         symbol);
     
-    char* response = api_request(url, post_data, access_token);
+    DeribitResponse* response = api_request(url, post_data, access_token);
     if (!response) {
         return false;
     }
     
-    cJSON* json = cJSON_Parse(response);
-    if (!json) {
-        free(response);
-        return false;
-    }
-    
-    bool success = false;
-    cJSON* result = cJSON_GetObjectItemCaseSensitive(json, "result");
-    if (cJSON_IsArray(result)) {
-        int count = cJSON_GetArraySize(result);
-        *out_count = count;
-        
-        if (count > 0) {
-            *out_orders = malloc(count * sizeof(Order));
-            for (int i = 0; i < count; i++) {
-                cJSON* order = cJSON_GetArrayItem(result, i);
-                parse_order_from_json(order, &(*out_orders)[i]);
-            }
-        } else {
-            *out_orders = NULL;
-        }
-        
-        success = true;
-    }
-    
-    cJSON_Delete(json);
-    free(response);
+    bool success = parse_order_list(response->data, response->size, out_orders, out_count);
+    deribit_response_release(response);
     return success;
 }
 
 //5
 // Simple helpers
 void get_orderbook_simple(const char* symbol) {
-    char access_token[1024] = {0};
-    
-    // First get access token using default credentials
-    if (!get_access_token(NULL, NULL, access_token)) {
+    // Cached token, kept fresh by the token manager
+    char access_token[DERIBIT_TOKEN_SIZE];
+    if (!token_manager_get(access_token, sizeof(access_token))) {
         printf("Failed to get access token\n");
         return;
     }
@@ -450,9 +606,6 @@ void get_positions_simple(const char* access_token) {
 }
 
 // Helper function to make API requests through deribit_api.h
-char* api_request(const char* url, const char* post_data, const char* access_token) {
-    // This function should use the appropriate function from deribit_api.h
-    // This is a placeholder - you need to implement it according to your deribit_api.h
-    // For example, it might call something like:
-    return perform_request(url, post_data, access_token);
+DeribitResponse* api_request(const char* url, const char* post_data, const char* access_token) {
+    return perform_request_pooled(url, post_data, access_token);
 }
\ No newline at end of file
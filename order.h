@@ -3,6 +3,7 @@
 
 #include <stdbool.h>  // Required for bool
 #include <stddef.h>   // Required for size_t
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +78,30 @@ bool modify_order(const char* order_id, const char* new_price, const char* new_a
 bool get_open_orders(const char* symbol, const char* access_token, Order** out_orders, int* out_count);
 bool get_order_history(const char* symbol, const char* access_token, Order** out_orders, int* out_count);
 
+// Parse a raw response whose result is an array of orders; *out_orders is malloc'd
+bool parse_order_list(const char* data, size_t length, Order** out_orders, int* out_count);
+
+// Asynchronous order entry on the deribit_async event loop; returns a request
+// handle (0 on failure) and calls back from deribit_async_poll. order is NULL
+// on failure and for cancels.
+typedef void (*OrderCompletionCallback)(uint64_t handle, bool success, const Order* order, void* user_data);
+
+uint64_t place_order_async(const char* symbol, const char* price, const char* amount, const char* access_token,
+                           OrderCompletionCallback callback, void* user_data);
+uint64_t cancel_order_async(const char* order_id, const char* access_token,
+                            OrderCompletionCallback callback, void* user_data);
+uint64_t modify_order_async(const char* order_id, const char* new_price, const char* new_amount, const char* access_token,
+                            OrderCompletionCallback callback, void* user_data);
+
+// The same order entry as JSON-RPC calls on the open, authenticated WebSocket
+// (websocket_client.h); returns the request id (0 on failure) and calls back
+// from websocket_process_events
+uint64_t place_order_ws(const char* symbol, const char* price, const char* amount,
+                        OrderCompletionCallback callback, void* user_data);
+uint64_t cancel_order_ws(const char* order_id, OrderCompletionCallback callback, void* user_data);
+uint64_t modify_order_ws(const char* order_id, const char* new_price, const char* new_amount,
+                         OrderCompletionCallback callback, void* user_data);
+
 // Optional helpers
 void get_orderbook_simple(const char* symbol);
 void get_positions_simple(const char* access_token);
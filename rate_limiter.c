@@ -0,0 +1,244 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "rate_limiter.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+// Exchange defaults: non-matching requests cost 500 of 50,000 credits refilled
+// at 10,000/s; order entry has its own pool of 20 requests refilled at 5/s
+#define NON_MATCHING_MAX_CREDITS 50000
+#define NON_MATCHING_REFILL 10000
+#define NON_MATCHING_COST 500
+#define MATCHING_MAX_CREDITS 20000
+#define MATCHING_REFILL 5000
+#define MATCHING_COST 1000
+#define MATCHING_CANCEL_RESERVE 2000
+
+#define POOL_INIT(max_credits, refill, reserve) \
+    { 0, NS_PER_SEC / (refill), (uint64_t)(max_credits) * (NS_PER_SEC / (refill)), \
+      (uint64_t)(reserve) * (NS_PER_SEC / (refill)), 0, 0, 0 }
+
+static RateLimiter pools[RATE_POOL_COUNT] = {
+    POOL_INIT(NON_MATCHING_MAX_CREDITS, NON_MATCHING_REFILL, 0),
+    POOL_INIT(MATCHING_MAX_CREDITS, MATCHING_REFILL, MATCHING_CANCEL_RESERVE)
+};
+// Settings are read with atomic loads on every admission, from any thread
+static bool limits_enabled = true;
+static RateLimitPolicy limit_policy = RATE_LIMIT_REJECT;
+static uint64_t limit_max_wait_ns = 0;
+static bool pools_in_use = false;       // Set by the first admission; pools are fixed from then on
+
+// Endpoints that differ from the non-matching default; prefix entries cover
+// method families such as private/cancel_all_by_instrument
+typedef struct {
+    const char* method;
+    bool prefix;
+    RateLimitPool pool;
+    uint32_t cost;
+    RateLimitPriority priority;
+} EndpointCost;
+
+static const EndpointCost endpoint_costs[] = {
+    {"private/buy", false, RATE_POOL_MATCHING, MATCHING_COST, RATE_PRIORITY_NORMAL},
+    {"private/sell", false, RATE_POOL_MATCHING, MATCHING_COST, RATE_PRIORITY_NORMAL},
+    {"private/edit", true, RATE_POOL_MATCHING, MATCHING_COST, RATE_PRIORITY_NORMAL},
+    {"private/close_position", false, RATE_POOL_MATCHING, MATCHING_COST, RATE_PRIORITY_NORMAL},
+    {"private/cancel", true, RATE_POOL_MATCHING, MATCHING_COST, RATE_PRIORITY_CANCEL},
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t tolerance_for(const RateLimiter* limiter, RateLimitPriority priority) {
+    return priority == RATE_PRIORITY_CANCEL ? limiter->tolerance_ns : limiter->tolerance_ns - limiter->reserve_ns;
+}
+
+bool rate_limiter_init(RateLimiter* limiter, uint32_t max_credits, uint32_t refill_per_sec, uint32_t reserve_credits) {
+    if (!limiter || max_credits == 0 || refill_per_sec == 0 || refill_per_sec > NS_PER_SEC ||
+        reserve_credits >= max_credits) {
+        return false;
+    }
+    memset(limiter, 0, sizeof(*limiter));
+    limiter->interval_ns = NS_PER_SEC / refill_per_sec;
+    limiter->tolerance_ns = (uint64_t)max_credits * limiter->interval_ns;
+    limiter->reserve_ns = (uint64_t)reserve_credits * limiter->interval_ns;
+    return true;
+}
+
+// Advance the arrival time by cost if the result stays within tolerance + slack;
+// returns how far past tolerance the booked slot is, or RATE_LIMIT_NEVER
+static uint64_t book_slot(RateLimiter* limiter, uint32_t cost, RateLimitPriority priority, uint64_t slack_ns) {
+    uint64_t increment = (uint64_t)cost * limiter->interval_ns;
+    uint64_t tolerance = tolerance_for(limiter, priority);
+    if (increment > tolerance) {
+        return RATE_LIMIT_NEVER;
+    }
+
+    uint64_t now = now_ns();
+    uint64_t tat = __atomic_load_n(&limiter->tat_ns, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t next = (tat > now ? tat : now) + increment;
+        if (next - now > tolerance + slack_ns) {
+            return RATE_LIMIT_NEVER;
+        }
+        if (__atomic_compare_exchange_n(&limiter->tat_ns, &tat, next, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return next - now > tolerance ? next - now - tolerance : 0;
+        }
+    }
+}
+
+uint64_t rate_limiter_try_acquire(RateLimiter* limiter, uint32_t cost, RateLimitPriority priority) {
+    if (book_slot(limiter, cost, priority, 0) == 0) {
+        __atomic_fetch_add(&limiter->granted, 1, __ATOMIC_RELAXED);
+        return RATE_LIMIT_GRANTED;
+    }
+    __atomic_fetch_add(&limiter->rejected, 1, __ATOMIC_RELAXED);
+
+    // Wait estimate from a fresh look at the arrival time
+    uint64_t increment = (uint64_t)cost * limiter->interval_ns;
+    uint64_t tolerance = tolerance_for(limiter, priority);
+    if (increment > tolerance) {
+        return RATE_LIMIT_NEVER;
+    }
+    uint64_t now = now_ns();
+    uint64_t tat = __atomic_load_n(&limiter->tat_ns, __ATOMIC_RELAXED);
+    uint64_t next = (tat > now ? tat : now) + increment;
+    return next - now > tolerance ? next - now - tolerance : 1;
+}
+
+uint64_t rate_limiter_reserve(RateLimiter* limiter, uint32_t cost, RateLimitPriority priority, uint64_t max_wait_ns) {
+    uint64_t delay = book_slot(limiter, cost, priority, max_wait_ns);
+    if (delay == RATE_LIMIT_NEVER) {
+        __atomic_fetch_add(&limiter->rejected, 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(delay ? &limiter->queued : &limiter->granted, 1, __ATOMIC_RELAXED);
+    }
+    return delay;
+}
+
+void rate_limiter_release(RateLimiter* limiter, uint32_t cost) {
+    uint64_t increment = (uint64_t)cost * limiter->interval_ns;
+    uint64_t now = now_ns();
+    uint64_t tat = __atomic_load_n(&limiter->tat_ns, __ATOMIC_RELAXED);
+    for (;;) {
+        if (tat <= now) {
+            return;                     // Already refilled; nothing to give back
+        }
+        uint64_t next = tat - now > increment ? tat - increment : now;
+        if (__atomic_compare_exchange_n(&limiter->tat_ns, &tat, next, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+uint32_t rate_limiter_remaining(const RateLimiter* limiter, RateLimitPriority priority) {
+    uint64_t now = now_ns();
+    uint64_t tat = __atomic_load_n(&limiter->tat_ns, __ATOMIC_RELAXED);
+    uint64_t used = tat > now ? tat - now : 0;
+    uint64_t tolerance = tolerance_for(limiter, priority);
+    return used >= tolerance ? 0 : (uint32_t)((tolerance - used) / limiter->interval_ns);
+}
+
+void rate_limit_endpoint(const char* method, RateLimitPool* pool, uint32_t* cost, RateLimitPriority* priority) {
+    *pool = RATE_POOL_NON_MATCHING;
+    *cost = NON_MATCHING_COST;
+    *priority = RATE_PRIORITY_NORMAL;
+    if (!method) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(endpoint_costs) / sizeof(endpoint_costs[0]); i++) {
+        const EndpointCost* entry = &endpoint_costs[i];
+        bool match = entry->prefix ? strncmp(method, entry->method, strlen(entry->method)) == 0
+                                   : strcmp(method, entry->method) == 0;
+        if (match) {
+            *pool = entry->pool;
+            *cost = entry->cost;
+            *priority = entry->priority;
+            return;
+        }
+    }
+}
+
+bool rate_limit_configure(RateLimitPool pool, uint32_t max_credits, uint32_t refill_per_sec, uint32_t reserve_credits) {
+    if (pool < 0 || pool >= RATE_POOL_COUNT) {
+        return false;
+    }
+    // Reinitializing would race with the CAS on tat_ns in admitting threads
+    if (__atomic_load_n(&pools_in_use, __ATOMIC_ACQUIRE)) {
+        printf("Rate limit pools can only be configured before the first request\n");
+        return false;
+    }
+    return rate_limiter_init(&pools[pool], max_credits, refill_per_sec, reserve_credits);
+}
+
+void rate_limit_set_policy(RateLimitPolicy policy, uint64_t max_wait_ns) {
+    __atomic_store_n(&limit_max_wait_ns, max_wait_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&limit_policy, policy, __ATOMIC_RELAXED);
+}
+
+void rate_limit_set_enabled(bool enabled) {
+    __atomic_store_n(&limits_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+uint64_t rate_limit_book(const char* method) {
+    if (!__atomic_load_n(&pools_in_use, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&pools_in_use, true, __ATOMIC_RELEASE);
+    }
+    if (!__atomic_load_n(&limits_enabled, __ATOMIC_RELAXED)) {
+        return RATE_LIMIT_GRANTED;
+    }
+
+    RateLimitPool pool;
+    uint32_t cost;
+    RateLimitPriority priority;
+    rate_limit_endpoint(method, &pool, &cost, &priority);
+
+    if (__atomic_load_n(&limit_policy, __ATOMIC_RELAXED) == RATE_LIMIT_REJECT) {
+        return rate_limiter_try_acquire(&pools[pool], cost, priority) == RATE_LIMIT_GRANTED ? RATE_LIMIT_GRANTED : RATE_LIMIT_NEVER;
+    }
+    return rate_limiter_reserve(&pools[pool], cost, priority, __atomic_load_n(&limit_max_wait_ns, __ATOMIC_RELAXED));
+}
+
+void rate_limit_refund(const char* method) {
+    if (!__atomic_load_n(&limits_enabled, __ATOMIC_RELAXED)) {
+        return;
+    }
+    RateLimitPool pool;
+    uint32_t cost;
+    RateLimitPriority priority;
+    rate_limit_endpoint(method, &pool, &cost, &priority);
+    rate_limiter_release(&pools[pool], cost);
+}
+
+bool rate_limit_admit(const char* method) {
+    uint64_t delay = rate_limit_book(method);
+    if (delay == RATE_LIMIT_NEVER) {
+        return false;
+    }
+    if (delay > 0) {
+        struct timespec ts = {(time_t)(delay / NS_PER_SEC), (long)(delay % NS_PER_SEC)};
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+    return true;
+}
+
+uint32_t rate_limit_remaining(RateLimitPool pool, RateLimitPriority priority) {
+    if (pool < 0 || pool >= RATE_POOL_COUNT) {
+        return 0;
+    }
+    return rate_limiter_remaining(&pools[pool], priority);
+}
+
+const RateLimiter* rate_limit_pool(RateLimitPool pool) {
+    if (pool < 0 || pool >= RATE_POOL_COUNT) {
+        return NULL;
+    }
+    return &pools[pool];
+}
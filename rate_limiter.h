@@ -0,0 +1,94 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Client-side request credits, modeled on the exchange's accounting: a pool
+// holds up to max_credits, refills at a steady rate, and each endpoint costs
+// a fixed number of credits. Implemented as GCRA over one atomic timestamp,
+// so checks are lock-free and take nanoseconds.
+
+#define RATE_LIMIT_GRANTED 0
+#define RATE_LIMIT_NEVER UINT64_MAX
+
+// Who may spend the reserved credits
+typedef enum {
+    RATE_PRIORITY_NORMAL,     // New orders, edits, market data
+    RATE_PRIORITY_CANCEL      // Cancels may dig into the reserve
+} RateLimitPriority;
+
+typedef struct {
+    uint64_t tat_ns;          // Theoretical arrival time; the only mutable state
+    uint64_t interval_ns;     // Refill time for one credit
+    uint64_t tolerance_ns;    // max_credits worth of refill time
+    uint64_t reserve_ns;      // Held back from RATE_PRIORITY_NORMAL
+    uint64_t granted;
+    uint64_t rejected;
+    uint64_t queued;
+} RateLimiter;
+
+// Configure a limiter; the pool starts full
+bool rate_limiter_init(RateLimiter* limiter, uint32_t max_credits, uint32_t refill_per_sec, uint32_t reserve_credits);
+
+// Take cost credits now if available. Returns RATE_LIMIT_GRANTED, or the
+// nanoseconds until the request would fit.
+uint64_t rate_limiter_try_acquire(RateLimiter* limiter, uint32_t cost, RateLimitPriority priority);
+
+// Book the next slot for cost credits if it is at most max_wait_ns away.
+// Returns the delay before the request may be sent, or RATE_LIMIT_NEVER.
+uint64_t rate_limiter_reserve(RateLimiter* limiter, uint32_t cost, RateLimitPriority priority, uint64_t max_wait_ns);
+
+// Give back cost credits booked for a request that was never sent
+void rate_limiter_release(RateLimiter* limiter, uint32_t cost);
+
+// Credits that could be spent right now at this priority
+uint32_t rate_limiter_remaining(const RateLimiter* limiter, RateLimitPriority priority);
+
+// Exchange pools: order entry goes to the matching engine, everything else does not
+typedef enum {
+    RATE_POOL_NON_MATCHING,
+    RATE_POOL_MATCHING,
+    RATE_POOL_COUNT
+} RateLimitPool;
+
+// What to do when a request does not fit
+typedef enum {
+    RATE_LIMIT_REJECT,        // Fail locally with DERIBIT_ERROR_RATE_LIMIT
+    RATE_LIMIT_QUEUE          // Hold the request until its booked slot, up to max_wait_ns
+} RateLimitPolicy;
+
+// Endpoint cost and pool for a JSON-RPC method ("private/buy")
+void rate_limit_endpoint(const char* method, RateLimitPool* pool, uint32_t* cost, RateLimitPriority* priority);
+
+// Client-wide limiters, defaulting to the exchange's standard account limits.
+// Pools can only be configured before the first admission; false after that.
+// Policy and enable switches may change at any time, from any thread.
+bool rate_limit_configure(RateLimitPool pool, uint32_t max_credits, uint32_t refill_per_sec, uint32_t reserve_credits);
+void rate_limit_set_policy(RateLimitPolicy policy, uint64_t max_wait_ns);
+void rate_limit_set_enabled(bool enabled);
+
+// Check a method against its pool before sending; waits under RATE_LIMIT_QUEUE.
+// Returns false if the request must not be sent. Blocking callers only.
+bool rate_limit_admit(const char* method);
+
+// Same check without waiting, for event loops: RATE_LIMIT_GRANTED to send now,
+// the nanoseconds to hold the request before sending it, or RATE_LIMIT_NEVER
+uint64_t rate_limit_book(const char* method);
+
+// Return the credits of a booked request that could not be sent after all
+void rate_limit_refund(const char* method);
+
+// Credits left in a pool, and the pool's limiter for statistics
+uint32_t rate_limit_remaining(RateLimitPool pool, RateLimitPriority priority);
+const RateLimiter* rate_limit_pool(RateLimitPool pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RATE_LIMITER_H
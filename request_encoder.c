@@ -0,0 +1,303 @@
+#include <string.h>
+#include <math.h>
+#include "request_encoder.h"
+
+#define TEMPLATE_CACHE_SIZE 32
+#define DECIMAL_MAX_PLACES 9
+
+static const char PLACE_HEAD[] = "{\"instrument_name\":\"";
+static const char AMOUNT_FIELD[] = "\",\"amount\":";
+static const char PLACE_PRICE[] = ",\"price\":";
+static const char PLACE_TAIL[] = ",\"type\":\"limit\",\"post_only\":true}";
+static const char ORDER_ID_HEAD[] = "{\"order_id\":\"";
+static const char CANCEL_TAIL[] = "\"}";
+static const char MODIFY_TAIL[] = "}";
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t POWERS_OF_TEN[DECIMAL_MAX_PLACES + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+    1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL
+};
+
+// Output cursor; a failed write poisons it so callers check once at the end
+typedef struct {
+    char* out;
+    size_t size;
+    size_t len;
+    bool failed;
+} Writer;
+
+static void put(Writer* w, const char* data, size_t len) {
+    if (w->failed || len > w->size - w->len) {
+        w->failed = true;
+        return;
+    }
+    memcpy(w->out + w->len, data, len);
+    w->len += len;
+}
+
+static int finish(Writer* w) {
+    // Leave room for the terminator so bodies can go straight to libcurl
+    if (w->failed || w->len >= w->size) {
+        if (w->size > 0) {
+            w->out[0] = '\0';
+        }
+        return -1;
+    }
+    w->out[w->len] = '\0';
+    return (int)w->len;
+}
+
+// Digits of value right-aligned in a 20-byte scratch buffer; returns the start
+static char* format_uint(char* end, uint64_t value) {
+    char* p = end;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[pair];
+        p[1] = DIGIT_PAIRS[pair + 1];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[pair];
+        p[1] = DIGIT_PAIRS[pair + 1];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
+}
+
+static void put_uint(Writer* w, uint64_t value) {
+    char scratch[20];
+    char* start = format_uint(scratch + sizeof(scratch), value);
+    put(w, start, (size_t)(scratch + sizeof(scratch) - start));
+}
+
+static void put_decimal(Writer* w, double value, int decimals) {
+    if (decimals < 0 || decimals > DECIMAL_MAX_PLACES || !isfinite(value)) {
+        w->failed = true;
+        return;
+    }
+
+    // Fixed point keeps the output exact and free of exponent notation
+    double scaled = fabs(value) * (double)POWERS_OF_TEN[decimals];
+    if (scaled >= 9007199254740992.0) {
+        w->failed = true;
+        return;
+    }
+    uint64_t units = (uint64_t)llround(scaled);
+    uint64_t whole = units / POWERS_OF_TEN[decimals];
+    uint64_t frac = units % POWERS_OF_TEN[decimals];
+
+    if (value < 0.0 && units != 0) {
+        put(w, "-", 1);
+    }
+    put_uint(w, whole);
+    if (frac == 0) {
+        return;
+    }
+
+    // Drop trailing zeros, then left-pad the remaining fraction digits
+    int places = decimals;
+    while (frac % 10 == 0) {
+        frac /= 10;
+        places--;
+    }
+    char scratch[DECIMAL_MAX_PLACES + 1];
+    char* end = scratch + sizeof(scratch);
+    char* start = format_uint(end, frac);
+    while (end - start < places) {
+        *--start = '0';
+    }
+    *--start = '.';
+    put(w, start, (size_t)(end - start));
+}
+
+// JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static size_t number_text_length(const char* text) {
+    const char* p = text;
+    if (*p == '-') {
+        p++;
+    }
+    if (*p == '0') {
+        p++;
+    } else if (*p >= '1' && *p <= '9') {
+        while (*p >= '0' && *p <= '9') p++;
+    } else {
+        return 0;
+    }
+    if (*p == '.') {
+        p++;
+        if (!(*p >= '0' && *p <= '9')) return 0;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') p++;
+        if (!(*p >= '0' && *p <= '9')) return 0;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    return *p == '\0' ? (size_t)(p - text) : 0;
+}
+
+static void put_number_text(Writer* w, const char* text) {
+    size_t len = text ? number_text_length(text) : 0;
+    if (len == 0) {
+        w->failed = true;
+        return;
+    }
+    put(w, text, len);
+}
+
+// String contents with JSON escaping
+static void put_escaped(Writer* w, const char* text) {
+    static const char HEX[] = "0123456789abcdef";
+    const char* run = text;
+    const char* p = text;
+    for (; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, run, (size_t)(p - run));
+        if (c == '"' || c == '\\') {
+            char escape[2] = {'\\', (char)c};
+            put(w, escape, 2);
+        } else {
+            char escape[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xf]};
+            put(w, escape, 6);
+        }
+        run = p + 1;
+    }
+    put(w, run, (size_t)(p - run));
+}
+
+bool request_template_compile(PlaceTemplate* tmpl, const char* instrument_name) {
+    if (!tmpl || !instrument_name || instrument_name[0] == '\0' ||
+        strlen(instrument_name) >= sizeof(tmpl->instrument_name)) {
+        return false;
+    }
+
+    Writer w = {tmpl->head, sizeof(tmpl->head), 0, false};
+    put(&w, PLACE_HEAD, sizeof(PLACE_HEAD) - 1);
+    put_escaped(&w, instrument_name);
+    put(&w, AMOUNT_FIELD, sizeof(AMOUNT_FIELD) - 1);
+    if (finish(&w) < 0) {
+        return false;
+    }
+
+    strcpy(tmpl->instrument_name, instrument_name);
+    tmpl->head_len = w.len;
+    return true;
+}
+
+const PlaceTemplate* request_template_for(const char* instrument_name) {
+    static __thread PlaceTemplate cache[TEMPLATE_CACHE_SIZE];
+    static __thread int cache_count = 0;
+    static __thread int next_evict = 0;
+
+    if (!instrument_name) {
+        return NULL;
+    }
+    for (int i = 0; i < cache_count; i++) {
+        if (strcmp(cache[i].instrument_name, instrument_name) == 0) {
+            return &cache[i];
+        }
+    }
+
+    int slot;
+    if (cache_count < TEMPLATE_CACHE_SIZE) {
+        slot = cache_count;
+    } else {
+        slot = next_evict;
+        next_evict = (next_evict + 1) % TEMPLATE_CACHE_SIZE;
+    }
+    PlaceTemplate compiled;
+    if (!request_template_compile(&compiled, instrument_name)) {
+        return NULL;
+    }
+    cache[slot] = compiled;
+    if (slot == cache_count) {
+        cache_count++;
+    }
+    return &cache[slot];
+}
+
+int request_encode_uint(char* out, size_t size, uint64_t value) {
+    Writer w = {out, size, 0, false};
+    put_uint(&w, value);
+    return w.failed ? -1 : (int)w.len;
+}
+
+int request_encode_decimal(char* out, size_t size, double value, int decimals) {
+    Writer w = {out, size, 0, false};
+    put_decimal(&w, value, decimals);
+    return w.failed ? -1 : (int)w.len;
+}
+
+int request_encode_number_text(char* out, size_t size, const char* text) {
+    Writer w = {out, size, 0, false};
+    put_number_text(&w, text);
+    return w.failed ? -1 : (int)w.len;
+}
+
+int request_encode_place(char* out, size_t size, const PlaceTemplate* tmpl, const char* amount, const char* price) {
+    Writer w = {out, size, 0, !tmpl};
+    if (tmpl) {
+        put(&w, tmpl->head, tmpl->head_len);
+    }
+    put_number_text(&w, amount);
+    put(&w, PLACE_PRICE, sizeof(PLACE_PRICE) - 1);
+    put_number_text(&w, price);
+    put(&w, PLACE_TAIL, sizeof(PLACE_TAIL) - 1);
+    return finish(&w);
+}
+
+int request_encode_place_values(char* out, size_t size, const PlaceTemplate* tmpl, double amount, double price, int decimals) {
+    Writer w = {out, size, 0, !tmpl};
+    if (tmpl) {
+        put(&w, tmpl->head, tmpl->head_len);
+    }
+    put_decimal(&w, amount, decimals);
+    put(&w, PLACE_PRICE, sizeof(PLACE_PRICE) - 1);
+    put_decimal(&w, price, decimals);
+    put(&w, PLACE_TAIL, sizeof(PLACE_TAIL) - 1);
+    return finish(&w);
+}
+
+int request_encode_cancel(char* out, size_t size, const char* order_id) {
+    Writer w = {out, size, 0, !order_id};
+    put(&w, ORDER_ID_HEAD, sizeof(ORDER_ID_HEAD) - 1);
+    if (order_id) {
+        put_escaped(&w, order_id);
+    }
+    put(&w, CANCEL_TAIL, sizeof(CANCEL_TAIL) - 1);
+    return finish(&w);
+}
+
+int request_encode_modify(char* out, size_t size, const char* order_id, const char* amount, const char* price) {
+    Writer w = {out, size, 0, !order_id};
+    put(&w, ORDER_ID_HEAD, sizeof(ORDER_ID_HEAD) - 1);
+    if (order_id) {
+        put_escaped(&w, order_id);
+    }
+    put(&w, AMOUNT_FIELD, sizeof(AMOUNT_FIELD) - 1);
+    put_number_text(&w, amount);
+    put(&w, PLACE_PRICE, sizeof(PLACE_PRICE) - 1);
+    put_number_text(&w, price);
+    put(&w, MODIFY_TAIL, sizeof(MODIFY_TAIL) - 1);
+    return finish(&w);
+}
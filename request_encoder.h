@@ -0,0 +1,50 @@
+#ifndef REQUEST_ENCODER_H
+#define REQUEST_ENCODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Order request bodies built from precompiled templates instead of snprintf.
+// Literal parts are copied with memcpy, the instrument name is escaped once per
+// template, and numbers go through a dedicated encoder. Every encode function
+// returns the body length, or -1 if the output does not fit or a field is invalid.
+
+#define REQUEST_INSTRUMENT_MAX 64
+#define REQUEST_TEMPLATE_HEAD_MAX 160
+
+// Place template: {"instrument_name":"<escaped>","amount":<amount>,"price":<price>,"type":"limit","post_only":true}
+typedef struct {
+    char instrument_name[REQUEST_INSTRUMENT_MAX];
+    char head[REQUEST_TEMPLATE_HEAD_MAX];   // Everything up to the amount value
+    size_t head_len;
+} PlaceTemplate;
+
+// Compile a template for one instrument
+bool request_template_compile(PlaceTemplate* tmpl, const char* instrument_name);
+
+// Template for an instrument from the calling thread's cache, compiled on first use
+const PlaceTemplate* request_template_for(const char* instrument_name);
+
+// Number encoders; return characters written (no terminator), -1 if it does not fit
+int request_encode_uint(char* out, size_t size, uint64_t value);
+int request_encode_decimal(char* out, size_t size, double value, int decimals);
+
+// Copy a JSON number given as text, rejecting anything that is not one
+int request_encode_number_text(char* out, size_t size, const char* text);
+
+// Order bodies; amount and price are JSON number text as passed to place_order
+int request_encode_place(char* out, size_t size, const PlaceTemplate* tmpl, const char* amount, const char* price);
+int request_encode_place_values(char* out, size_t size, const PlaceTemplate* tmpl, double amount, double price, int decimals);
+int request_encode_cancel(char* out, size_t size, const char* order_id);
+int request_encode_modify(char* out, size_t size, const char* order_id, const char* amount, const char* price);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REQUEST_ENCODER_H
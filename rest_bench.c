@@ -0,0 +1,204 @@
+// REST order-entry burst benchmark: fires bursts of private requests (new
+// quotes plus cancels of the previous burst's quotes) on the async client and
+// reports burst completion latency, to compare HTTP/1.1 against HTTP/2.
+//
+// Usage: rest_bench [--url http://127.0.0.1:8080] [--http 1.1|2|h2c]
+//                   [--burst 32] [--bursts 200] [--instrument SYN0000-PERPETUAL]
+//
+// The mock exchange speaks HTTP/1.1 only; for HTTP/2 put an h2 proxy in front,
+// e.g. nghttpx --frontend='127.0.0.1,8443;no-tls' --backend='127.0.0.1,8080'
+// and run with --url http://127.0.0.1:8443 --http h2c.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "deribit_api.h"
+#include "rate_limiter.h"
+
+#define MAX_BURST 1024
+
+typedef struct {
+    const char* url;
+    DeribitHttpVersion version;
+    int burst;
+    int bursts;
+    const char* instrument;
+} BenchConfig;
+
+typedef struct {
+    int outstanding;
+    int errors;
+    int http2_responses;
+    char order_ids[MAX_BURST][64];   // Quotes placed this burst, cancelled in the next
+    int order_count;
+} BurstState;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void on_complete(DeribitRequestHandle handle, const char* response, const DeribitError* error, void* user_data) {
+    (void)handle;
+    (void)error;
+    BurstState* state = user_data;
+    state->outstanding--;
+    if (!response || strstr(response, "\"error\"")) {
+        state->errors++;
+        return;
+    }
+    if (deribit_last_http_version() == 2) {
+        state->http2_responses++;
+    }
+
+    const char* id = strstr(response, "\"order_id\":\"");
+    if (id && strstr(response, "\"order_state\":\"open\"") && state->order_count < MAX_BURST) {
+        id += strlen("\"order_id\":\"");
+        const char* end = strchr(id, '"');
+        if (end && (size_t)(end - id) < sizeof(state->order_ids[0])) {
+            memcpy(state->order_ids[state->order_count], id, (size_t)(end - id));
+            state->order_ids[state->order_count][end - id] = '\0';
+            state->order_count++;
+        }
+    }
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--url URL] [--http 1.1|2|h2c] [--burst N] [--bursts N] [--instrument NAME]\n", program);
+}
+
+static bool parse_args(int argc, char** argv, BenchConfig* config) {
+    config->url = "http://127.0.0.1:8080";
+    config->version = DERIBIT_HTTP_1_1;
+    config->burst = 32;
+    config->bursts = 200;
+    config->instrument = "SYN0000-PERPETUAL";
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) {
+            return false;
+        }
+        if (strcmp(argv[i], "--url") == 0) {
+            config->url = value;
+        } else if (strcmp(argv[i], "--http") == 0) {
+            if (strcmp(value, "1.1") == 0) {
+                config->version = DERIBIT_HTTP_1_1;
+            } else if (strcmp(value, "2") == 0) {
+                config->version = DERIBIT_HTTP_2;
+            } else if (strcmp(value, "h2c") == 0) {
+                config->version = DERIBIT_HTTP_2_PRIOR_KNOWLEDGE;
+            } else {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--burst") == 0) {
+            config->burst = atoi(value);
+        } else if (strcmp(argv[i], "--bursts") == 0) {
+            config->bursts = atoi(value);
+        } else if (strcmp(argv[i], "--instrument") == 0) {
+            config->instrument = value;
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return config->burst > 0 && config->burst <= MAX_BURST && config->bursts > 0;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    deribit_set_transport(DERIBIT_TRANSPORT_HTTP);
+    deribit_set_http_version(config.version);
+    rate_limit_set_enabled(false);
+    if (!deribit_set_base_url(config.url) || !deribit_async_init(config.burst)) {
+        fprintf(stderr, "Failed to initialize the client\n");
+        return 1;
+    }
+
+    DeribitAuthResult auth;
+    if (!deribit_authenticate("bench", "bench", &auth)) {
+        fprintf(stderr, "Authentication failed: %s\n", get_last_error().message);
+        return 1;
+    }
+
+    BurstState* state = calloc(1, sizeof(BurstState));
+    char (*pending_cancels)[64] = calloc(MAX_BURST, sizeof(*pending_cancels));
+    double* burst_us = calloc((size_t)config.bursts, sizeof(double));
+    if (!state || !pending_cancels || !burst_us) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    const char* buy_url = "https://www.deribit.com/api/v2/private/buy";
+    const char* cancel_url = "https://www.deribit.com/api/v2/private/cancel";
+    int cancel_count = 0;
+    int requests = 0;
+    int submit_failures = 0;
+    double start = now_us();
+
+    for (int b = 0; b < config.bursts; b++) {
+        // Cancel last burst's quotes and re-quote in the same burst
+        state->order_count = 0;
+        double burst_start = now_us();
+        for (int i = 0; i < config.burst; i++) {
+            char post_data[256];
+            const char* url;
+            if (i < cancel_count) {
+                snprintf(post_data, sizeof(post_data), "{\"order_id\":\"%s\"}", pending_cancels[i]);
+                url = cancel_url;
+            } else {
+                snprintf(post_data, sizeof(post_data),
+                         "{\"instrument_name\":\"%s\",\"amount\":10,\"type\":\"limit\",\"price\":%.1f}",
+                         config.instrument, 24000.0 - (i % 50) * 0.5);
+                url = buy_url;
+            }
+            if (deribit_async_request(url, post_data, auth.access_token, on_complete, state)) {
+                state->outstanding++;
+                requests++;
+            } else {
+                submit_failures++;
+            }
+        }
+        while (state->outstanding > 0) {
+            deribit_async_poll(100);
+        }
+        burst_us[b] = now_us() - burst_start;
+
+        // Cancel about half of each burst next time round
+        cancel_count = state->order_count < config.burst / 2 ? state->order_count : config.burst / 2;
+        memcpy(pending_cancels, state->order_ids, (size_t)cancel_count * sizeof(pending_cancels[0]));
+    }
+
+    double elapsed_us = now_us() - start;
+    qsort(burst_us, (size_t)config.bursts, sizeof(double), compare_double);
+
+    const char* names[] = {"HTTP/1.1", "HTTP/2 (ALPN)", "HTTP/2 (prior knowledge)"};
+    printf("Protocol requested: %s, in use: %s, HTTP/2 responses: %d\n", names[config.version],
+           names[deribit_get_http_version()], state->http2_responses);
+    printf("Requests: %d in %d bursts of %d, errors: %d, not sent: %d\n",
+           requests, config.bursts, config.burst, state->errors, submit_failures);
+    printf("Throughput: %.0f req/s\n", requests / (elapsed_us / 1e6));
+    printf("Burst completion: p50 %.0f us, p90 %.0f us, p99 %.0f us, max %.0f us\n",
+           burst_us[config.bursts / 2], burst_us[config.bursts * 9 / 10],
+           burst_us[config.bursts * 99 / 100], burst_us[config.bursts - 1]);
+
+    free(burst_us);
+    free(pending_cancels);
+    free(state);
+    deribit_async_cleanup();
+    deribit_transport_cleanup();
+    return 0;
+}
@@ -0,0 +1,607 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sim_book.h"
+
+// Queue-position model for simulated post_only orders.
+// Market levels are kept sorted per side; every event touches only the
+// level it refers to (binary search) and the own orders resting there.
+
+#define SIM_AMOUNT_EPSILON 1e-12
+
+static int64_t to_ticks(const SimBook* book, double price) {
+    return (int64_t)llround(price / book->tick_size);
+}
+
+static int64_t level_key(OrderSide side, int64_t ticks) {
+    return side == ORDER_SIDE_BUY ? -ticks : ticks;
+}
+
+static double key_to_price(const SimBook* book, OrderSide side, int64_t key) {
+    int64_t ticks = side == ORDER_SIDE_BUY ? -key : key;
+    return (double)ticks * book->tick_size;
+}
+
+static SimBookSide* book_side(SimBook* book, OrderSide side) {
+    return side == ORDER_SIDE_BUY ? &book->bids : &book->asks;
+}
+
+// Binary search; returns index or -1 and the insertion point in *pos
+static int find_level(const SimBookSide* s, int64_t key, int* pos) {
+    int lo = 0;
+    int hi = s->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (s->levels[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (pos) {
+        *pos = lo;
+    }
+    if (lo < s->count && s->levels[lo].key == key) {
+        return lo;
+    }
+    return -1;
+}
+
+static int insert_level(SimBookSide* s, int pos, int64_t key) {
+    if (s->count == s->capacity) {
+        int new_capacity = s->capacity ? s->capacity * 2 : 64;
+        SimLevel* levels = realloc(s->levels, new_capacity * sizeof(SimLevel));
+        if (!levels) {
+            fprintf(stderr, "Failed to allocate memory for book levels\n");
+            return -1;
+        }
+        s->levels = levels;
+        s->capacity = new_capacity;
+    }
+    memmove(&s->levels[pos + 1], &s->levels[pos], (s->count - pos) * sizeof(SimLevel));
+    SimLevel* level = &s->levels[pos];
+    level->key = key;
+    level->amount = 0.0;
+    level->traded_pending = 0.0;
+    level->own_head = -1;
+    level->own_tail = -1;
+    s->count++;
+    return pos;
+}
+
+static void remove_level(SimBookSide* s, int index) {
+    memmove(&s->levels[index], &s->levels[index + 1], (s->count - index - 1) * sizeof(SimLevel));
+    s->count--;
+}
+
+// Drop a level once it has neither market volume nor own orders; returns true if removed
+static bool prune_level(SimBookSide* s, int index) {
+    SimLevel* level = &s->levels[index];
+    if (level->amount <= SIM_AMOUNT_EPSILON && level->own_head < 0) {
+        remove_level(s, index);
+        return true;
+    }
+    return false;
+}
+
+static int alloc_order(SimBook* book) {
+    if (book->free_head < 0) {
+        int old_capacity = book->orders_capacity;
+        int new_capacity = old_capacity ? old_capacity * 2 : 64;
+        SimOrder* orders = realloc(book->orders, new_capacity * sizeof(SimOrder));
+        if (!orders) {
+            fprintf(stderr, "Failed to allocate memory for simulated orders\n");
+            return -1;
+        }
+        for (int i = old_capacity; i < new_capacity; i++) {
+            orders[i].active = false;
+            orders[i].next = i + 1 < new_capacity ? i + 1 : -1;
+        }
+        book->orders = orders;
+        book->orders_capacity = new_capacity;
+        book->free_head = old_capacity;
+    }
+    int slot = book->free_head;
+    book->free_head = book->orders[slot].next;
+    return slot;
+}
+
+static void release_order(SimBook* book, int slot) {
+    book->orders[slot].active = false;
+    book->orders[slot].next = book->free_head;
+    book->free_head = slot;
+}
+
+static int slot_from_id(const SimBook* book, uint64_t order_id) {
+    int slot = (int)(order_id & 0xffffffffu);
+    if (order_id == 0 || slot >= book->orders_capacity) {
+        return -1;
+    }
+    const SimOrder* o = &book->orders[slot];
+    if (!o->active || o->order_id != order_id) {
+        return -1;
+    }
+    return slot;
+}
+
+static void link_order(SimBook* book, SimLevel* level, int slot) {
+    SimOrder* o = &book->orders[slot];
+    o->next = -1;
+    o->prev = level->own_tail;
+    if (level->own_tail >= 0) {
+        book->orders[level->own_tail].next = slot;
+    } else {
+        level->own_head = slot;
+    }
+    level->own_tail = slot;
+}
+
+static void unlink_order(SimBook* book, SimLevel* level, int slot) {
+    SimOrder* o = &book->orders[slot];
+    if (o->prev >= 0) {
+        book->orders[o->prev].next = o->next;
+    } else {
+        level->own_head = o->next;
+    }
+    if (o->next >= 0) {
+        book->orders[o->next].prev = o->prev;
+    } else {
+        level->own_tail = o->prev;
+    }
+}
+
+// Fill an own order; unlinks and frees it when complete
+static void fill_order(SimBook* book, SimLevel* level, int slot, double price, double amount) {
+    SimOrder* o = &book->orders[slot];
+    o->filled += amount;
+    double remaining = o->amount - o->filled;
+    if (remaining < SIM_AMOUNT_EPSILON) {
+        remaining = 0.0;
+    }
+
+    if (book->fill_cb) {
+        SimFill fill = {
+            .order_id = o->order_id,
+            .instrument_id = book->instrument_id,
+            .side = o->side,
+            .price = price,
+            .amount = amount,
+            .remaining = remaining,
+            .is_maker = true
+        };
+        book->fill_cb(&fill, book->fill_user_data);
+    }
+
+    if (remaining == 0.0) {
+        unlink_order(book, level, slot);
+        release_order(book, slot);
+    }
+}
+
+// Trade of `volume` at exactly this level: walk our orders front to back,
+// consuming market volume ahead of each before it reaches us
+static void consume_at_level(SimBook* book, SimLevel* level, double price, double volume) {
+    double budget = volume;
+    double market_consumed = 0.0;
+    int slot = level->own_head;
+
+    while (slot >= 0) {
+        SimOrder* o = &book->orders[slot];
+        int next = o->next;
+
+        double gap = o->queue_ahead - market_consumed;
+        if (gap < 0.0) {
+            gap = 0.0;
+        }
+        double take = budget < gap ? budget : gap;
+        market_consumed += take;
+        budget -= take;
+        o->queue_ahead -= market_consumed;
+        if (o->queue_ahead < SIM_AMOUNT_EPSILON) {
+            o->queue_ahead = 0.0;
+        }
+
+        if (budget <= SIM_AMOUNT_EPSILON) {
+            // Orders further back only see the market volume consumed so far
+            for (int s = next; s >= 0; s = book->orders[s].next) {
+                SimOrder* behind = &book->orders[s];
+                behind->queue_ahead -= market_consumed;
+                if (behind->queue_ahead < SIM_AMOUNT_EPSILON) {
+                    behind->queue_ahead = 0.0;
+                }
+            }
+            break;
+        }
+
+        double open = o->amount - o->filled;
+        double fill = budget < open ? budget : open;
+        budget -= fill;
+        fill_order(book, level, slot, price, fill);
+        slot = next;
+    }
+
+    // The real trade consumed real market volume; the next delta will show it
+    level->traded_pending += volume;
+}
+
+// Trade printed through our price: everything resting here would have traded
+static void sweep_level(SimBook* book, SimLevel* level, double price) {
+    int slot = level->own_head;
+    while (slot >= 0) {
+        SimOrder* o = &book->orders[slot];
+        int next = o->next;
+        o->queue_ahead = 0.0;
+        fill_order(book, level, slot, price, o->amount - o->filled);
+        slot = next;
+    }
+}
+
+// Displayed size fell from old_amount to new_amount; move our queue position
+static void apply_decrease(SimBook* book, SimLevel* level, double old_amount, double new_amount) {
+    double decrease = old_amount - new_amount;
+    double traded = level->traded_pending < decrease ? level->traded_pending : decrease;
+    double cancelled = decrease - traded;
+    double base = old_amount - traded;
+
+    for (int slot = level->own_head; slot >= 0; slot = book->orders[slot].next) {
+        SimOrder* o = &book->orders[slot];
+        double qa = o->queue_ahead;
+
+        if (cancelled > SIM_AMOUNT_EPSILON) {
+            switch (book->queue_model) {
+                case SIM_QUEUE_PESSIMISTIC:
+                    break;
+                case SIM_QUEUE_PROPORTIONAL:
+                    if (base > SIM_AMOUNT_EPSILON) {
+                        qa -= cancelled * (qa / base);
+                    }
+                    break;
+                case SIM_QUEUE_OPTIMISTIC:
+                    qa -= cancelled;
+                    break;
+            }
+        }
+
+        if (qa > new_amount) {
+            qa = new_amount;
+        }
+        if (qa < SIM_AMOUNT_EPSILON) {
+            qa = 0.0;
+        }
+        o->queue_ahead = qa;
+    }
+}
+
+bool sim_book_init(SimBook* book, int instrument_id, double tick_size) {
+    if (!book || tick_size <= 0.0) {
+        return false;
+    }
+
+    memset(book, 0, sizeof(*book));
+    book->instrument_id = instrument_id;
+    book->tick_size = tick_size;
+    book->queue_model = SIM_QUEUE_PROPORTIONAL;
+    book->free_head = -1;
+    book->next_serial = 1;
+    return true;
+}
+
+void sim_book_free(SimBook* book) {
+    if (!book) {
+        return;
+    }
+    free(book->bids.levels);
+    free(book->asks.levels);
+    free(book->orders);
+    free(book->sweep_levels);
+    memset(book, 0, sizeof(*book));
+    book->free_head = -1;
+}
+
+void sim_book_set_queue_model(SimBook* book, SimQueueModel model) {
+    book->queue_model = model;
+}
+
+void sim_book_set_fill_callback(SimBook* book, SimFillCallback callback, void* user_data) {
+    book->fill_cb = callback;
+    book->fill_user_data = user_data;
+}
+
+void sim_book_set_fill_batch_callback(SimBook* book, SimFillBatchCallback callback, void* user_data) {
+    book->batch_cb = callback;
+    book->batch_user_data = user_data;
+}
+
+static void apply_snapshot_side(SimBook* book, OrderSide side, const OrderBookEntry* entries, int count) {
+    SimBookSide* s = book_side(book, side);
+
+    for (int i = 0; i < s->count; i++) {
+        s->levels[i].amount = 0.0;
+        s->levels[i].traded_pending = 0.0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int64_t key = level_key(side, to_ticks(book, entries[i].price));
+        int pos;
+        int index = find_level(s, key, &pos);
+        if (index < 0) {
+            index = insert_level(s, pos, key);
+            if (index < 0) {
+                continue;
+            }
+        }
+        s->levels[index].amount = entries[i].amount;
+    }
+
+    for (int i = 0; i < s->count; ) {
+        SimLevel* level = &s->levels[i];
+        for (int slot = level->own_head; slot >= 0; slot = book->orders[slot].next) {
+            if (book->orders[slot].queue_ahead > level->amount) {
+                book->orders[slot].queue_ahead = level->amount;
+            }
+        }
+        if (!prune_level(s, i)) {
+            i++;
+        }
+    }
+}
+
+void sim_book_apply_snapshot(SimBook* book, const OrderBook* snapshot) {
+    if (!book || !snapshot) {
+        return;
+    }
+    apply_snapshot_side(book, ORDER_SIDE_BUY, snapshot->bids, snapshot->bids ? snapshot->bids_count : 0);
+    apply_snapshot_side(book, ORDER_SIDE_SELL, snapshot->asks, snapshot->asks ? snapshot->asks_count : 0);
+}
+
+void sim_book_apply_delta(SimBook* book, OrderSide side, double price, double new_amount) {
+    if (!book) {
+        return;
+    }
+    if (new_amount < 0.0) {
+        new_amount = 0.0;
+    }
+
+    SimBookSide* s = book_side(book, side);
+    int64_t key = level_key(side, to_ticks(book, price));
+    int pos;
+    int index = find_level(s, key, &pos);
+
+    if (index < 0) {
+        if (new_amount > SIM_AMOUNT_EPSILON) {
+            index = insert_level(s, pos, key);
+            if (index >= 0) {
+                s->levels[index].amount = new_amount;
+            }
+        }
+        return;
+    }
+
+    SimLevel* level = &s->levels[index];
+    if (new_amount < level->amount && level->own_head >= 0) {
+        apply_decrease(book, level, level->amount, new_amount);
+    }
+    level->amount = new_amount;
+    level->traded_pending = 0.0;
+    prune_level(s, index);
+}
+
+void sim_book_apply_trade(SimBook* book, OrderSide aggressor_side, double price, double amount) {
+    if (!book || amount <= 0.0) {
+        return;
+    }
+
+    // A sell aggressor hits resting bids and vice versa
+    OrderSide resting = aggressor_side == ORDER_SIDE_SELL ? ORDER_SIDE_BUY : ORDER_SIDE_SELL;
+    SimBookSide* s = book_side(book, resting);
+    int64_t trade_key = level_key(resting, to_ticks(book, price));
+
+    int i = 0;
+    while (i < s->count && s->levels[i].key <= trade_key) {
+        SimLevel* level = &s->levels[i];
+        if (level->own_head >= 0) {
+            double level_price = key_to_price(book, resting, level->key);
+            if (level->key < trade_key) {
+                sweep_level(book, level, level_price);
+            } else {
+                consume_at_level(book, level, level_price, amount);
+            }
+        } else if (level->key == trade_key) {
+            level->traded_pending += amount;
+        }
+        if (!prune_level(s, i)) {
+            i++;
+        }
+    }
+}
+
+uint64_t sim_book_place_post_only(SimBook* book, OrderSide side, double price, double amount) {
+    if (!book || amount <= 0.0) {
+        return 0;
+    }
+
+    int64_t ticks = to_ticks(book, price);
+
+    // post_only: reject instead of taking liquidity
+    const SimBookSide* opposite = side == ORDER_SIDE_BUY ? &book->asks : &book->bids;
+    if (opposite->count > 0) {
+        int64_t best = side == ORDER_SIDE_BUY ? opposite->levels[0].key : -opposite->levels[0].key;
+        if ((side == ORDER_SIDE_BUY && ticks >= best) || (side == ORDER_SIDE_SELL && ticks <= best)) {
+            return 0;
+        }
+    }
+
+    SimBookSide* s = book_side(book, side);
+    int64_t key = level_key(side, ticks);
+    int pos;
+    int index = find_level(s, key, &pos);
+    if (index < 0) {
+        index = insert_level(s, pos, key);
+        if (index < 0) {
+            return 0;
+        }
+    }
+
+    int slot = alloc_order(book);
+    if (slot < 0) {
+        prune_level(s, index);
+        return 0;
+    }
+
+    SimLevel* level = &s->levels[index];
+    SimOrder* o = &book->orders[slot];
+    o->order_id = ((uint64_t)book->next_serial++ << 32) | (uint32_t)slot;
+    o->side = side;
+    o->price_ticks = ticks;
+    o->amount = amount;
+    o->filled = 0.0;
+    o->queue_ahead = level->amount;  // Everything already displayed is ahead of us
+    o->active = true;
+    link_order(book, level, slot);
+
+    return o->order_id;
+}
+
+// Room for one fill per level, so a sweep never stops half way on allocation
+static bool reserve_sweep_levels(SimBook* book, int count) {
+    if (count <= book->sweep_capacity) {
+        return true;
+    }
+    int new_capacity = book->sweep_capacity ? book->sweep_capacity : 16;
+    while (new_capacity < count) {
+        new_capacity *= 2;
+    }
+    SimFillLevel* levels = realloc(book->sweep_levels, new_capacity * sizeof(SimFillLevel));
+    if (!levels) {
+        fprintf(stderr, "Failed to allocate memory for sweep fills\n");
+        return false;
+    }
+    book->sweep_levels = levels;
+    book->sweep_capacity = new_capacity;
+    return true;
+}
+
+double sim_book_execute_market(SimBook* book, OrderSide side, double amount, uint64_t* out_order_id) {
+    // Also rejects NaN
+    if (!book || !(amount > 0.0)) {
+        return 0.0;
+    }
+
+    OrderSide resting = side == ORDER_SIDE_BUY ? ORDER_SIDE_SELL : ORDER_SIDE_BUY;
+    SimBookSide* s = book_side(book, resting);
+    if (!reserve_sweep_levels(book, s->count)) {
+        return -1.0;
+    }
+    // Never a resting slot, so cancels and lookups reject it
+    uint64_t order_id = ((uint64_t)book->next_serial++ << 32) | 0xffffffffu;
+
+    double remaining = amount;
+    double notional = 0.0;
+    int level_count = 0;
+    int i = 0;
+
+    while (i < s->count && remaining > SIM_AMOUNT_EPSILON) {
+        SimLevel* level = &s->levels[i];
+        double take = remaining < level->amount ? remaining : level->amount;
+        if (take <= SIM_AMOUNT_EPSILON) {
+            i++;
+            continue;
+        }
+
+        double price = key_to_price(book, resting, level->key);
+        book->sweep_levels[level_count].price = price;
+        book->sweep_levels[level_count].amount = take;
+        level_count++;
+        remaining -= take;
+        notional += take * price;
+
+        // Market volume is gone until the next delta; our own orders here move up
+        level->amount -= take;
+        for (int slot = level->own_head; slot >= 0; slot = book->orders[slot].next) {
+            SimOrder* o = &book->orders[slot];
+            o->queue_ahead = o->queue_ahead > take ? o->queue_ahead - take : 0.0;
+        }
+        if (!prune_level(s, i)) {
+            i++;
+        }
+    }
+
+    double filled = amount - remaining;
+    if (book->batch_cb) {
+        SimFillBatch batch = {
+            .order_id = order_id,
+            .instrument_id = book->instrument_id,
+            .side = side,
+            .requested = amount,
+            .filled = filled,
+            .avg_price = filled > 0.0 ? notional / filled : 0.0,
+            .levels = book->sweep_levels,
+            .level_count = level_count
+        };
+        book->batch_cb(&batch, book->batch_user_data);
+    }
+
+    if (out_order_id) {
+        *out_order_id = order_id;
+    }
+    return filled;
+}
+
+bool sim_book_cancel(SimBook* book, uint64_t order_id) {
+    if (!book) {
+        return false;
+    }
+
+    int slot = slot_from_id(book, order_id);
+    if (slot < 0) {
+        return false;
+    }
+
+    SimOrder* o = &book->orders[slot];
+    SimBookSide* s = book_side(book, o->side);
+    int index = find_level(s, level_key(o->side, o->price_ticks), NULL);
+    if (index >= 0) {
+        unlink_order(book, &s->levels[index], slot);
+        prune_level(s, index);
+    }
+    release_order(book, slot);
+    return true;
+}
+
+bool sim_book_get_order(const SimBook* book, uint64_t order_id, SimOrder* out_order) {
+    if (!book || !out_order) {
+        return false;
+    }
+
+    int slot = slot_from_id(book, order_id);
+    if (slot < 0) {
+        return false;
+    }
+    *out_order = book->orders[slot];
+    return true;
+}
+
+static bool best_of(const SimBook* book, OrderSide side, double* price, double* amount) {
+    const SimBookSide* s = side == ORDER_SIDE_BUY ? &book->bids : &book->asks;
+    for (int i = 0; i < s->count; i++) {
+        if (s->levels[i].amount > SIM_AMOUNT_EPSILON) {
+            if (price) {
+                *price = key_to_price(book, side, s->levels[i].key);
+            }
+            if (amount) {
+                *amount = s->levels[i].amount;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool sim_book_best_bid(const SimBook* book, double* price, double* amount) {
+    return book ? best_of(book, ORDER_SIDE_BUY, price, amount) : false;
+}
+
+bool sim_book_best_ask(const SimBook* book, double* price, double* amount) {
+    return book ? best_of(book, ORDER_SIDE_SELL, price, amount) : false;
+}
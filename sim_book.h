@@ -0,0 +1,142 @@
+#ifndef SIM_BOOK_H
+#define SIM_BOOK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "order.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// How a drop in displayed size at our price is split between volume
+// ahead of and behind our resting orders
+typedef enum {
+    SIM_QUEUE_PESSIMISTIC,   // Cancels come from behind us
+    SIM_QUEUE_PROPORTIONAL,  // Cancels are spread evenly through the level
+    SIM_QUEUE_OPTIMISTIC     // Cancels come from in front of us
+} SimQueueModel;
+
+// Simulated resting order
+typedef struct {
+    uint64_t order_id;
+    OrderSide side;
+    int64_t price_ticks;
+    double amount;
+    double filled;
+    double queue_ahead;      // Market volume still ahead of us at this price
+    int next;                // Next own order at the same level (FIFO), -1 if last
+    int prev;
+    bool active;
+} SimOrder;
+
+// Aggregated price level; amount is market volume only, our orders are virtual
+typedef struct {
+    int64_t key;             // Price in ticks, negated on the bid side
+    double amount;
+    double traded_pending;   // Traded volume not yet reflected by a book delta
+    int own_head;            // Own orders resting here, -1 if none
+    int own_tail;
+} SimLevel;
+
+typedef struct {
+    SimLevel* levels;        // Sorted best first
+    int count;
+    int capacity;
+} SimBookSide;
+
+// Fill of a simulated order
+typedef struct {
+    uint64_t order_id;
+    int instrument_id;
+    OrderSide side;
+    double price;
+    double amount;
+    double remaining;
+    bool is_maker;
+} SimFill;
+
+// Called from inside the book update; must not modify the book
+typedef void (*SimFillCallback)(const SimFill* fill, void* user_data);
+
+// One price level taken by an aggressing order
+typedef struct {
+    double price;
+    double amount;
+} SimFillLevel;
+
+// All fills of one aggressing order, reported once
+typedef struct {
+    uint64_t order_id;
+    int instrument_id;
+    OrderSide side;
+    double requested;
+    double filled;
+    double avg_price;
+    const SimFillLevel* levels;  // Valid only during the callback
+    int level_count;
+} SimFillBatch;
+
+typedef void (*SimFillBatchCallback)(const SimFillBatch* batch, void* user_data);
+
+// Simulated book for one instrument
+typedef struct {
+    int instrument_id;
+    double tick_size;
+    SimQueueModel queue_model;
+    SimBookSide bids;
+    SimBookSide asks;
+    SimOrder* orders;
+    int orders_capacity;
+    int free_head;
+    uint32_t next_serial;
+    SimFillCallback fill_cb;
+    void* fill_user_data;
+    SimFillBatchCallback batch_cb;
+    void* batch_user_data;
+    SimFillLevel* sweep_levels;  // Scratch for the batch being built
+    int sweep_capacity;
+} SimBook;
+
+// Initialize / release a simulated book
+bool sim_book_init(SimBook* book, int instrument_id, double tick_size);
+void sim_book_free(SimBook* book);
+
+// Set queue model and fill callback
+void sim_book_set_queue_model(SimBook* book, SimQueueModel model);
+void sim_book_set_fill_callback(SimBook* book, SimFillCallback callback, void* user_data);
+void sim_book_set_fill_batch_callback(SimBook* book, SimFillBatchCallback callback, void* user_data);
+
+// Replace market levels with a snapshot, keeping our resting orders
+void sim_book_apply_snapshot(SimBook* book, const OrderBook* snapshot);
+
+// Apply a book change: new total displayed amount at price (0 deletes the level)
+void sim_book_apply_delta(SimBook* book, OrderSide side, double price, double new_amount);
+
+// Apply a public trade; aggressor_side is the taker direction
+void sim_book_apply_trade(SimBook* book, OrderSide aggressor_side, double price, double amount);
+
+// Rest a post_only order; returns 0 if it would cross the book
+uint64_t sim_book_place_post_only(SimBook* book, OrderSide side, double price, double amount);
+
+// Sweep the opposite side with a market order, taking market volume level by
+// level; reports one SimFillBatch and returns the amount filled (rest is cancelled).
+// An amount that is not positive reports nothing and returns 0; -1 if the fill
+// report could not be allocated, with the book untouched.
+double sim_book_execute_market(SimBook* book, OrderSide side, double amount, uint64_t* out_order_id);
+
+// Cancel a resting order
+bool sim_book_cancel(SimBook* book, uint64_t order_id);
+
+// Look up a resting order (queue_ahead, filled, ...)
+bool sim_book_get_order(const SimBook* book, uint64_t order_id, SimOrder* out_order);
+
+// Best prices, false if the side is empty
+bool sim_book_best_bid(const SimBook* book, double* price, double* amount);
+bool sim_book_best_ask(const SimBook* book, double* price, double* amount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_BOOK_H
@@ -0,0 +1,689 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "sim_engine.h"
+
+#define SIM_CACHE_LINE 64
+#define SIM_DEFAULT_RING_CAPACITY 4096
+#define SIM_PUBLISH_BATCH 32
+#define SIM_SPIN_LIMIT 1024
+
+// Counter on its own cache line so driver and worker do not false-share
+typedef struct {
+    uint64_t value;
+    char pad[SIM_CACHE_LINE - sizeof(uint64_t)];
+} SimPaddedCounter;
+
+typedef struct {
+    int instrument_id;
+    SimBook book;
+} SimShardBook;
+
+typedef struct {
+    SimEngine* engine;
+    pthread_t thread;
+
+    // Driver -> worker ring
+    SimInput* in_ring;
+    uint64_t in_mask;
+    SimPaddedCounter in_tail;        // Written by driver
+    SimPaddedCounter in_head;        // Written by worker
+
+    // Worker -> driver ring
+    SimOutput* out_ring;
+    uint64_t out_mask;
+    SimPaddedCounter out_tail;       // Written by worker
+    SimPaddedCounter out_head;       // Written by driver
+    SimPaddedCounter processed_seq;  // Last input fully handled by worker
+
+    // Driver-private
+    uint64_t in_tail_local;
+    uint64_t last_submitted_seq;
+    SimOutput* staged;
+    size_t staged_start;
+    size_t staged_count;
+    size_t staged_capacity;
+
+    // Worker-private
+    SimShardBook* books;
+    int book_count;
+    uint64_t out_tail_local;
+    const SimInput* current;
+} SimShard;
+
+struct SimEngine {
+    SimShard* shards;
+    int shard_count;
+    uint64_t next_seq;
+    int running;
+    bool started;
+    bool echo_market_data;
+
+    // Virtual clock and latency paths (driver-private)
+    uint64_t now_ns;
+    SimLatencyModel order_path;
+    SimLatencyModel market_data_path;
+    bool has_order_path;
+    bool has_market_data_path;
+
+    // Orders in flight to the exchange, in arrival order
+    SimInput* pending;
+    size_t pending_start;
+    size_t pending_count;
+    size_t pending_capacity;
+    uint64_t last_arrival_ns;
+
+    // Outputs in flight to the caller, in delivery order
+    SimOutput* outbound;
+    size_t outbound_start;
+    size_t outbound_count;
+    size_t outbound_capacity;
+    uint64_t last_deliver_ns;
+};
+
+static uint64_t round_up_pow2(uint64_t v) {
+    uint64_t p = 1;
+    while (p < v) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static SimBook* shard_find_book(SimShard* shard, int instrument_id) {
+    int lo = 0;
+    int hi = shard->book_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int id = shard->books[mid].instrument_id;
+        if (id == instrument_id) {
+            return &shard->books[mid].book;
+        }
+        if (id < instrument_id) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+// Worker side: append an output, waiting for the driver if the ring is full;
+// false if the engine stopped first
+static bool shard_emit(SimShard* shard, const SimOutput* output) {
+    while (shard->out_tail_local - __atomic_load_n(&shard->out_head.value, __ATOMIC_ACQUIRE) > shard->out_mask) {
+        __atomic_store_n(&shard->out_tail.value, shard->out_tail_local, __ATOMIC_RELEASE);
+        if (!__atomic_load_n(&shard->engine->running, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        sched_yield();
+    }
+    shard->out_ring[shard->out_tail_local & shard->out_mask] = *output;
+    shard->out_tail_local++;
+    return true;
+}
+
+static void shard_on_fill(const SimFill* fill, void* user_data) {
+    SimShard* shard = (SimShard*)user_data;
+    SimOutput output = {
+        .type = SIM_OUTPUT_FILL,
+        .seq = shard->current->seq,
+        .instrument_id = fill->instrument_id,
+        .order_id = fill->order_id,
+        .client_tag = 0,
+        .fill = *fill,
+        .side = fill->side,
+        .price = fill->price,
+        .amount = fill->amount,
+        .exchange_ts_ns = shard->current->ts_ns
+    };
+    shard_emit(shard, &output);
+}
+
+static void shard_on_fill_batch(const SimFillBatch* batch, void* user_data) {
+    SimShard* shard = (SimShard*)user_data;
+    SimOutput output = {
+        .type = batch->filled > 0.0 ? SIM_OUTPUT_FILL_BATCH : SIM_OUTPUT_REJECT,
+        .seq = shard->current->seq,
+        .instrument_id = batch->instrument_id,
+        .order_id = batch->order_id,
+        .client_tag = shard->current->client_tag,
+        .side = batch->side,
+        .price = batch->avg_price,
+        .amount = batch->filled,
+        .requested = batch->requested,
+        .worst_price = batch->level_count > 0 ? batch->levels[batch->level_count - 1].price : 0.0,
+        .level_count = batch->level_count,
+        .exchange_ts_ns = shard->current->ts_ns
+    };
+
+    // The book's scratch is reused by the next sweep; the output carries its
+    // own copy until the caller has seen it
+    SimFillLevel* levels = NULL;
+    if (batch->level_count > 0) {
+        levels = malloc(batch->level_count * sizeof(SimFillLevel));
+        if (levels) {
+            memcpy(levels, batch->levels, batch->level_count * sizeof(SimFillLevel));
+        } else {
+            fprintf(stderr, "Failed to allocate memory for sweep fills\n");
+        }
+    }
+    output.levels = levels;
+    if (!shard_emit(shard, &output)) {
+        free(levels);
+    }
+}
+
+// Level fills still owned by outputs that will never be delivered
+static void free_output_levels(const SimOutput* outputs, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        free((void*)outputs[i].levels);
+    }
+}
+
+static void shard_process(SimShard* shard, const SimInput* input) {
+    shard->current = input;
+    SimBook* book = shard_find_book(shard, input->instrument_id);
+
+    SimOutput output = {0};
+    output.seq = input->seq;
+    output.instrument_id = input->instrument_id;
+    output.client_tag = input->client_tag;
+    output.side = input->side;
+    output.price = input->price;
+    output.amount = input->amount;
+    output.exchange_ts_ns = input->ts_ns;
+    bool echo = shard->engine->echo_market_data;
+
+    switch (input->type) {
+        case SIM_INPUT_BOOK_DELTA:
+            if (book) {
+                sim_book_apply_delta(book, input->side, input->price, input->amount);
+            }
+            if (echo) {
+                output.type = SIM_OUTPUT_BOOK_DELTA;
+                shard_emit(shard, &output);
+            }
+            break;
+        case SIM_INPUT_TRADE:
+            // Public trade prints before the fills it causes
+            if (echo) {
+                output.type = SIM_OUTPUT_TRADE;
+                shard_emit(shard, &output);
+            }
+            if (book) {
+                sim_book_apply_trade(book, input->side, input->price, input->amount);
+            }
+            break;
+        case SIM_INPUT_PLACE:
+            output.order_id = book ? sim_book_place_post_only(book, input->side, input->price, input->amount) : 0;
+            output.type = output.order_id ? SIM_OUTPUT_ACK : SIM_OUTPUT_REJECT;
+            shard_emit(shard, &output);
+            break;
+        case SIM_INPUT_MARKET:
+            // Exactly one answer: the book reports a fill batch (a reject when
+            // nothing fills) unless the order never reaches the sweep
+            if (!book || !(input->amount > 0.0) ||
+                sim_book_execute_market(book, input->side, input->amount, NULL) < 0.0) {
+                output.type = SIM_OUTPUT_REJECT;
+                shard_emit(shard, &output);
+            }
+            break;
+        case SIM_INPUT_CANCEL:
+            output.order_id = input->order_id;
+            output.type = (book && sim_book_cancel(book, input->order_id)) ? SIM_OUTPUT_CANCELLED : SIM_OUTPUT_REJECT;
+            shard_emit(shard, &output);
+            break;
+    }
+}
+
+static void* shard_main(void* arg) {
+    SimShard* shard = (SimShard*)arg;
+    uint64_t head = shard->in_head.value;
+    int idle = 0;
+
+    while (__atomic_load_n(&shard->engine->running, __ATOMIC_ACQUIRE)) {
+        uint64_t tail = __atomic_load_n(&shard->in_tail.value, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (++idle >= SIM_SPIN_LIMIT) {
+                idle = 0;
+                sched_yield();
+            }
+            continue;
+        }
+        idle = 0;
+
+        uint64_t last_seq = 0;
+        while (head != tail) {
+            const SimInput* input = &shard->in_ring[head & shard->in_mask];
+            shard_process(shard, input);
+            last_seq = input->seq;
+            head++;
+        }
+
+        // Outputs become visible before the watermark that makes them final
+        __atomic_store_n(&shard->out_tail.value, shard->out_tail_local, __ATOMIC_RELEASE);
+        __atomic_store_n(&shard->in_head.value, head, __ATOMIC_RELEASE);
+        __atomic_store_n(&shard->processed_seq.value, last_seq, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+SimEngine* sim_engine_create(int shard_count, int ring_capacity) {
+    if (shard_count <= 0) {
+        return NULL;
+    }
+
+    SimEngine* engine = calloc(1, sizeof(SimEngine));
+    if (!engine) {
+        return NULL;
+    }
+    engine->shards = calloc(shard_count, sizeof(SimShard));
+    if (!engine->shards) {
+        free(engine);
+        return NULL;
+    }
+    engine->shard_count = shard_count;
+
+    uint64_t capacity = round_up_pow2(ring_capacity > 0 ? (uint64_t)ring_capacity : SIM_DEFAULT_RING_CAPACITY);
+    for (int i = 0; i < shard_count; i++) {
+        SimShard* shard = &engine->shards[i];
+        shard->engine = engine;
+        shard->in_ring = malloc(capacity * sizeof(SimInput));
+        shard->out_ring = malloc(capacity * sizeof(SimOutput));
+        shard->in_mask = capacity - 1;
+        shard->out_mask = capacity - 1;
+        if (!shard->in_ring || !shard->out_ring) {
+            fprintf(stderr, "Failed to allocate memory for engine rings\n");
+            sim_engine_destroy(engine);
+            return NULL;
+        }
+    }
+    return engine;
+}
+
+int sim_engine_shard_of(const SimEngine* engine, int instrument_id) {
+    return (int)((uint32_t)instrument_id % (uint32_t)engine->shard_count);
+}
+
+bool sim_engine_add_instrument(SimEngine* engine, int instrument_id, double tick_size, SimQueueModel model) {
+    if (!engine || engine->started) {
+        return false;
+    }
+
+    SimShard* shard = &engine->shards[sim_engine_shard_of(engine, instrument_id)];
+    if (shard_find_book(shard, instrument_id)) {
+        return false;
+    }
+
+    SimShardBook* books = realloc(shard->books, (shard->book_count + 1) * sizeof(SimShardBook));
+    if (!books) {
+        return false;
+    }
+    shard->books = books;
+
+    int pos = shard->book_count;
+    while (pos > 0 && books[pos - 1].instrument_id > instrument_id) {
+        books[pos] = books[pos - 1];
+        pos--;
+    }
+
+    books[pos].instrument_id = instrument_id;
+    if (!sim_book_init(&books[pos].book, instrument_id, tick_size)) {
+        memmove(&books[pos], &books[pos + 1], (shard->book_count - pos) * sizeof(SimShardBook));
+        return false;
+    }
+    sim_book_set_queue_model(&books[pos].book, model);
+    sim_book_set_fill_callback(&books[pos].book, shard_on_fill, shard);
+    sim_book_set_fill_batch_callback(&books[pos].book, shard_on_fill_batch, shard);
+    shard->book_count++;
+    return true;
+}
+
+bool sim_engine_start(SimEngine* engine) {
+    if (!engine || engine->started) {
+        return false;
+    }
+
+    __atomic_store_n(&engine->running, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < engine->shard_count; i++) {
+        if (pthread_create(&engine->shards[i].thread, NULL, shard_main, &engine->shards[i]) != 0) {
+            fprintf(stderr, "Failed to start engine shard %d\n", i);
+            __atomic_store_n(&engine->running, 0, __ATOMIC_RELEASE);
+            for (int j = 0; j < i; j++) {
+                pthread_join(engine->shards[j].thread, NULL);
+            }
+            return false;
+        }
+    }
+    engine->started = true;
+    return true;
+}
+
+void sim_engine_stop(SimEngine* engine) {
+    if (!engine || !engine->started) {
+        return;
+    }
+    __atomic_store_n(&engine->running, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < engine->shard_count; i++) {
+        pthread_join(engine->shards[i].thread, NULL);
+    }
+    engine->started = false;
+}
+
+void sim_engine_destroy(SimEngine* engine) {
+    if (!engine) {
+        return;
+    }
+    sim_engine_stop(engine);
+    for (int i = 0; i < engine->shard_count; i++) {
+        SimShard* shard = &engine->shards[i];
+        for (int j = 0; j < shard->book_count; j++) {
+            sim_book_free(&shard->books[j].book);
+        }
+        free(shard->books);
+        free(shard->in_ring);
+        if (shard->out_ring) {
+            for (uint64_t head = shard->out_head.value; head != shard->out_tail.value; head++) {
+                free((void*)shard->out_ring[head & shard->out_mask].levels);
+            }
+        }
+        free(shard->out_ring);
+        free_output_levels(shard->staged, shard->staged_start, shard->staged_count);
+        free(shard->staged);
+    }
+    free(engine->pending);
+    free_output_levels(engine->outbound, engine->outbound_start, engine->outbound_count);
+    free(engine->outbound);
+    free(engine->shards);
+    free(engine);
+}
+
+static void publish_inputs(SimShard* shard) {
+    if (shard->in_tail.value != shard->in_tail_local) {
+        __atomic_store_n(&shard->in_tail.value, shard->in_tail_local, __ATOMIC_RELEASE);
+    }
+}
+
+// Driver side: move worker outputs into the shard's staging buffer
+static void collect_outputs(SimShard* shard) {
+    uint64_t head = shard->out_head.value;
+    uint64_t tail = __atomic_load_n(&shard->out_tail.value, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return;
+    }
+
+    size_t needed = shard->staged_count + (size_t)(tail - head);
+    if (needed > shard->staged_capacity) {
+        if (shard->staged_start > 0) {
+            memmove(shard->staged, &shard->staged[shard->staged_start],
+                    (shard->staged_count - shard->staged_start) * sizeof(SimOutput));
+            shard->staged_count -= shard->staged_start;
+            shard->staged_start = 0;
+            needed = shard->staged_count + (size_t)(tail - head);
+        }
+        if (needed > shard->staged_capacity) {
+            size_t capacity = shard->staged_capacity ? shard->staged_capacity : 1024;
+            while (capacity < needed) {
+                capacity *= 2;
+            }
+            SimOutput* staged = realloc(shard->staged, capacity * sizeof(SimOutput));
+            if (!staged) {
+                fprintf(stderr, "Failed to allocate memory for engine outputs\n");
+                return;
+            }
+            shard->staged = staged;
+            shard->staged_capacity = capacity;
+        }
+    }
+
+    for (; head != tail; head++) {
+        shard->staged[shard->staged_count++] = shard->out_ring[head & shard->out_mask];
+    }
+    __atomic_store_n(&shard->out_head.value, head, __ATOMIC_RELEASE);
+}
+
+void sim_engine_set_latency(SimEngine* engine, const SimLatencyModel* order_path, const SimLatencyModel* market_data_path) {
+    if (!engine) {
+        return;
+    }
+    engine->has_order_path = order_path != NULL;
+    if (order_path) {
+        engine->order_path = *order_path;
+    }
+    engine->has_market_data_path = market_data_path != NULL;
+    if (market_data_path) {
+        engine->market_data_path = *market_data_path;
+    }
+}
+
+void sim_engine_set_echo_market_data(SimEngine* engine, bool enabled) {
+    if (engine && !engine->started) {
+        engine->echo_market_data = enabled;
+    }
+}
+
+// Grow a driver-side FIFO, compacting consumed entries first
+static bool reserve_fifo(void** items, size_t item_size, size_t* start, size_t* count, size_t* capacity) {
+    if (*count < *capacity) {
+        return true;
+    }
+    if (*start > 0) {
+        memmove(*items, (char*)*items + *start * item_size, (*count - *start) * item_size);
+        *count -= *start;
+        *start = 0;
+        return true;
+    }
+    size_t new_capacity = *capacity ? *capacity * 2 : 1024;
+    void* grown = realloc(*items, new_capacity * item_size);
+    if (!grown) {
+        fprintf(stderr, "Failed to allocate memory for engine queue\n");
+        return false;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static uint64_t submit_to_shard(SimEngine* engine, const SimInput* input, uint64_t ts_ns) {
+    SimShard* shard = &engine->shards[sim_engine_shard_of(engine, input->instrument_id)];
+    while (shard->in_tail_local - __atomic_load_n(&shard->in_head.value, __ATOMIC_ACQUIRE) > shard->in_mask) {
+        publish_inputs(shard);
+        collect_outputs(shard);
+        sched_yield();
+    }
+
+    SimInput* slot = &shard->in_ring[shard->in_tail_local & shard->in_mask];
+    *slot = *input;
+    slot->seq = ++engine->next_seq;
+    slot->ts_ns = ts_ns;
+    shard->last_submitted_seq = slot->seq;
+    shard->in_tail_local++;
+
+    if (shard->in_tail_local - shard->in_tail.value >= SIM_PUBLISH_BATCH) {
+        publish_inputs(shard);
+    }
+    return slot->seq;
+}
+
+// Hand orders that have reached the exchange by now_ns to their shards
+static void release_pending(SimEngine* engine, uint64_t now_ns) {
+    while (engine->pending_start < engine->pending_count) {
+        const SimInput* order = &engine->pending[engine->pending_start];
+        if (order->ts_ns > now_ns) {
+            break;
+        }
+        submit_to_shard(engine, order, order->ts_ns);
+        engine->pending_start++;
+    }
+    if (engine->pending_start == engine->pending_count) {
+        engine->pending_start = 0;
+        engine->pending_count = 0;
+    }
+}
+
+void sim_engine_advance(SimEngine* engine, uint64_t now_ns) {
+    if (!engine) {
+        return;
+    }
+    if (now_ns > engine->now_ns) {
+        engine->now_ns = now_ns;
+    }
+    if (engine->started) {
+        release_pending(engine, engine->now_ns);
+    }
+}
+
+uint64_t sim_engine_now(const SimEngine* engine) {
+    return engine ? engine->now_ns : 0;
+}
+
+uint64_t sim_engine_submit(SimEngine* engine, const SimInput* input) {
+    if (!engine || !input || !engine->started) {
+        return 0;
+    }
+
+    // Events cannot happen in the past of the virtual clock
+    sim_engine_advance(engine, input->ts_ns);
+    return submit_to_shard(engine, input, engine->now_ns);
+}
+
+bool sim_engine_send_order(SimEngine* engine, const SimInput* input) {
+    if (!engine || !input || !engine->started) {
+        return false;
+    }
+    if (input->type != SIM_INPUT_PLACE && input->type != SIM_INPUT_MARKET && input->type != SIM_INPUT_CANCEL) {
+        return false;
+    }
+    if (!reserve_fifo((void**)&engine->pending, sizeof(SimInput), &engine->pending_start,
+                      &engine->pending_count, &engine->pending_capacity)) {
+        return false;
+    }
+
+    uint64_t sent = input->ts_ns > engine->now_ns ? input->ts_ns : engine->now_ns;
+    uint64_t arrival = sent + (engine->has_order_path ? sim_latency_sample(&engine->order_path) : 0);
+    // One connection: no overtaking
+    if (arrival < engine->last_arrival_ns) {
+        arrival = engine->last_arrival_ns;
+    }
+    engine->last_arrival_ns = arrival;
+
+    SimInput* order = &engine->pending[engine->pending_count++];
+    *order = *input;
+    order->ts_ns = arrival;
+
+    release_pending(engine, engine->now_ns);
+    return true;
+}
+
+// Merge staged outputs with seq <= safe_seq across shards in sequence order.
+// Each input lives on exactly one shard, so ties never cross shards.
+static void merge_outputs(SimEngine* engine, uint64_t safe_seq) {
+    for (;;) {
+        SimShard* best = NULL;
+        uint64_t best_seq = 0;
+        for (int i = 0; i < engine->shard_count; i++) {
+            SimShard* shard = &engine->shards[i];
+            if (shard->staged_start == shard->staged_count) {
+                continue;
+            }
+            uint64_t seq = shard->staged[shard->staged_start].seq;
+            if (seq <= safe_seq && (!best || seq < best_seq)) {
+                best = shard;
+                best_seq = seq;
+            }
+        }
+        if (!best) {
+            break;
+        }
+        while (best->staged_start < best->staged_count && best->staged[best->staged_start].seq == best_seq) {
+            if (!reserve_fifo((void**)&engine->outbound, sizeof(SimOutput), &engine->outbound_start,
+                              &engine->outbound_count, &engine->outbound_capacity)) {
+                return;
+            }
+            SimOutput* output = &engine->outbound[engine->outbound_count++];
+            *output = best->staged[best->staged_start++];
+
+            uint64_t deliver = output->exchange_ts_ns;
+            if (engine->has_market_data_path) {
+                deliver += sim_latency_sample(&engine->market_data_path);
+            }
+            if (deliver < engine->last_deliver_ns) {
+                deliver = engine->last_deliver_ns;
+            }
+            engine->last_deliver_ns = deliver;
+            output->deliver_ts_ns = deliver;
+        }
+        if (best->staged_start == best->staged_count) {
+            best->staged_start = 0;
+            best->staged_count = 0;
+        }
+    }
+}
+
+// Hand the caller every merged output whose delivery time has come
+static int deliver_due(SimEngine* engine, SimOutputCallback callback, void* user_data) {
+    int delivered = 0;
+    while (engine->outbound_start < engine->outbound_count) {
+        const SimOutput* output = &engine->outbound[engine->outbound_start];
+        if (output->deliver_ts_ns > engine->now_ns) {
+            break;
+        }
+        if (callback) {
+            callback(output, user_data);
+        }
+        free((void*)output->levels);
+        engine->outbound_start++;
+        delivered++;
+    }
+    if (engine->outbound_start == engine->outbound_count) {
+        engine->outbound_start = 0;
+        engine->outbound_count = 0;
+    }
+    return delivered;
+}
+
+int sim_engine_poll(SimEngine* engine, SimOutputCallback callback, void* user_data) {
+    if (!engine || !engine->started) {
+        return 0;
+    }
+
+    // Read watermarks before collecting so every output at or below them is staged
+    uint64_t safe_seq = UINT64_MAX;
+    for (int i = 0; i < engine->shard_count; i++) {
+        SimShard* shard = &engine->shards[i];
+        publish_inputs(shard);
+        uint64_t processed = __atomic_load_n(&shard->processed_seq.value, __ATOMIC_ACQUIRE);
+        if (processed != shard->last_submitted_seq && processed < safe_seq) {
+            safe_seq = processed;
+        }
+    }
+    for (int i = 0; i < engine->shard_count; i++) {
+        collect_outputs(&engine->shards[i]);
+    }
+
+    merge_outputs(engine, safe_seq);
+    return deliver_due(engine, callback, user_data);
+}
+
+int sim_engine_drain(SimEngine* engine, SimOutputCallback callback, void* user_data) {
+    if (!engine || !engine->started) {
+        return 0;
+    }
+
+    for (int i = 0; i < engine->shard_count; i++) {
+        SimShard* shard = &engine->shards[i];
+        publish_inputs(shard);
+        while (__atomic_load_n(&shard->processed_seq.value, __ATOMIC_ACQUIRE) != shard->last_submitted_seq) {
+            collect_outputs(shard);
+            sched_yield();
+        }
+    }
+    for (int i = 0; i < engine->shard_count; i++) {
+        collect_outputs(&engine->shards[i]);
+    }
+
+    merge_outputs(engine, UINT64_MAX);
+    return deliver_due(engine, callback, user_data);
+}
@@ -0,0 +1,122 @@
+#ifndef SIM_ENGINE_H
+#define SIM_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sim_book.h"
+#include "sim_latency.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated matching engine sharded by instrument across worker threads.
+// Each shard owns its books and orders; the driver thread talks to shards
+// through single-producer/single-consumer rings only.
+//
+// Time is virtual: inputs carry the time they happen at their source, orders
+// reach the shards after the order-path latency, and everything the exchange
+// publishes reaches the caller after the market-data-path latency.
+
+// Input event types
+typedef enum {
+    SIM_INPUT_BOOK_DELTA,    // price/amount: new displayed amount at level
+    SIM_INPUT_TRADE,         // side: aggressor direction
+    SIM_INPUT_PLACE,         // post_only limit order
+    SIM_INPUT_MARKET,        // Market order sweeping the opposite side
+    SIM_INPUT_CANCEL
+} SimInputType;
+
+typedef struct {
+    SimInputType type;
+    int instrument_id;
+    OrderSide side;
+    double price;
+    double amount;
+    uint64_t order_id;       // SIM_INPUT_CANCEL
+    uint64_t client_tag;     // Echoed in outputs for SIM_INPUT_PLACE
+    uint64_t seq;            // Assigned by sim_engine_submit
+    uint64_t ts_ns;          // Virtual time at the source (exchange, or strategy send time)
+} SimInput;
+
+// Output event types
+typedef enum {
+    SIM_OUTPUT_ACK,
+    SIM_OUTPUT_REJECT,
+    SIM_OUTPUT_CANCELLED,
+    SIM_OUTPUT_FILL,
+    SIM_OUTPUT_FILL_BATCH,   // All fills of one market order
+    SIM_OUTPUT_BOOK_DELTA,   // Market data echo, see sim_engine_set_echo_market_data
+    SIM_OUTPUT_TRADE
+} SimOutputType;
+
+typedef struct {
+    SimOutputType type;
+    uint64_t seq;            // Input event that produced this output
+    int instrument_id;
+    uint64_t order_id;
+    uint64_t client_tag;
+    SimFill fill;            // SIM_OUTPUT_FILL
+    OrderSide side;          // Market data echoes; fill batch: price is the average,
+    double price;            // amount the filled total
+    double amount;
+    double requested;        // SIM_OUTPUT_FILL_BATCH
+    double worst_price;
+    const SimFillLevel* levels;  // Fill batch: one fill per level taken, best first; valid only
+    int level_count;             // during the callback, NULL if the copy could not be allocated
+    uint64_t exchange_ts_ns; // When the exchange handled the input (usIn)
+    uint64_t deliver_ts_ns;  // When the caller sees it (usOut + wire time)
+} SimOutput;
+
+typedef void (*SimOutputCallback)(const SimOutput* output, void* user_data);
+
+typedef struct SimEngine SimEngine;
+
+// Create engine with shard_count workers; ring_capacity is rounded up to a power of two
+SimEngine* sim_engine_create(int shard_count, int ring_capacity);
+
+// Register an instrument (before sim_engine_start)
+bool sim_engine_add_instrument(SimEngine* engine, int instrument_id, double tick_size, SimQueueModel model);
+
+// Start / stop worker threads
+bool sim_engine_start(SimEngine* engine);
+void sim_engine_stop(SimEngine* engine);
+void sim_engine_destroy(SimEngine* engine);
+
+// Shard owning an instrument
+int sim_engine_shard_of(const SimEngine* engine, int instrument_id);
+
+// Latency models for the order path (strategy -> exchange) and the market-data
+// path (exchange -> strategy); NULL means zero latency. Models are copied.
+void sim_engine_set_latency(SimEngine* engine, const SimLatencyModel* order_path, const SimLatencyModel* market_data_path);
+
+// Also publish book deltas and trades as outputs, delayed like any other output
+void sim_engine_set_echo_market_data(SimEngine* engine, bool enabled);
+
+// Queue an exchange-side event at input->ts_ns; returns its sequence number, 0 on error.
+// Orders that arrive at or before that time are released to the shards first.
+uint64_t sim_engine_submit(SimEngine* engine, const SimInput* input);
+
+// Send an order from the strategy at input->ts_ns; it reaches the exchange after
+// the order-path latency, in send order
+bool sim_engine_send_order(SimEngine* engine, const SimInput* input);
+
+// Move the virtual clock forward, releasing orders that have arrived
+void sim_engine_advance(SimEngine* engine, uint64_t now_ns);
+
+// Current virtual time
+uint64_t sim_engine_now(const SimEngine* engine);
+
+// Deliver outputs that are final and due at the current virtual time,
+// in input sequence order; returns count
+int sim_engine_poll(SimEngine* engine, SimOutputCallback callback, void* user_data);
+
+// Wait for all submitted inputs to be processed, then deliver every output
+// due at the current virtual time
+int sim_engine_drain(SimEngine* engine, SimOutputCallback callback, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_ENGINE_H
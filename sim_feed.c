@@ -0,0 +1,416 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sim_feed.h"
+
+#define SIM_FEED_BUFFER_SIZE 16384
+
+typedef struct {
+    char name[32];
+    char book_channel[128];
+    char trades_channel[128];
+    char ticker_channel[128];
+    double mid;                  // In ticks
+    int64_t best_bid;            // In ticks; best ask is one tick above
+    double* bid_amounts;         // Index 0 is the best level
+    double* ask_amounts;
+    uint64_t change_id;
+    uint64_t trade_seq;
+    int64_t last_price;
+} SimFeedInstrument;
+
+struct SimFeed {
+    SimFeedConfig config;
+    SimFeedInstrument* instruments;
+    uint64_t rng_state;
+    bool stressed;
+    struct timespec start;
+    uint64_t paced;              // Messages accounted for by sim_feed_poll
+    uint64_t batch_ts_ms;        // One wall-clock read per batch
+    SimFeedStats stats;
+    char buffer[SIM_FEED_BUFFER_SIZE];
+};
+
+// xorshift64* generator
+static uint64_t next_random(SimFeed* feed) {
+    uint64_t x = feed->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    feed->rng_state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+static double next_uniform(SimFeed* feed) {
+    return ((double)(next_random(feed) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double next_normal(SimFeed* feed) {
+    double u1 = next_uniform(feed);
+    double u2 = next_uniform(feed);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// Resting size per level, 0.1 to ~10 in steps of 0.1
+static double next_amount(SimFeed* feed) {
+    double amount = floor(exp(next_normal(feed) * 0.8) * 10.0) / 10.0;
+    return amount < 0.1 ? 0.1 : amount;
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+static double price_of(const SimFeed* feed, int64_t ticks) {
+    return (double)ticks * feed->config.tick_size;
+}
+
+void sim_feed_default_config(SimFeedConfig* config) {
+    if (!config) {
+        return;
+    }
+    config->instrument_count = 16;
+    config->depth = 10;
+    config->messages_per_sec = 100000.0;
+    config->max_burst = 4096;
+    config->base_price = 25000.0;
+    config->tick_size = 0.5;
+    config->calm_volatility = 0.3;
+    config->stressed_volatility = 2.0;
+    config->regime_switch_prob = 0.0005;
+    config->trade_ratio = 0.15;
+    config->ticker_ratio = 0.10;
+    config->seed = 42;
+}
+
+SimFeed* sim_feed_create(const SimFeedConfig* config) {
+    if (!config || config->instrument_count <= 0 || config->depth <= 0 ||
+        config->tick_size <= 0.0 || config->messages_per_sec <= 0.0) {
+        return NULL;
+    }
+
+    SimFeed* feed = calloc(1, sizeof(SimFeed));
+    if (!feed) {
+        return NULL;
+    }
+    feed->config = *config;
+    if (feed->config.max_burst <= 0) {
+        feed->config.max_burst = 4096;
+    }
+    feed->rng_state = config->seed ? config->seed : 42;
+
+    feed->instruments = calloc(config->instrument_count, sizeof(SimFeedInstrument));
+    if (!feed->instruments) {
+        free(feed);
+        return NULL;
+    }
+
+    for (int i = 0; i < config->instrument_count; i++) {
+        SimFeedInstrument* inst = &feed->instruments[i];
+        snprintf(inst->name, sizeof(inst->name), "SYN%04d-PERPETUAL", i);
+        // Same names websocket_build_channel_name produces with no interval/depth
+        snprintf(inst->book_channel, sizeof(inst->book_channel), "book.%s", inst->name);
+        snprintf(inst->trades_channel, sizeof(inst->trades_channel), "trades.%s", inst->name);
+        snprintf(inst->ticker_channel, sizeof(inst->ticker_channel), "ticker.%s", inst->name);
+
+        inst->mid = config->base_price / config->tick_size + 0.5;
+        inst->best_bid = (int64_t)floor(inst->mid - 0.5);
+        inst->last_price = inst->best_bid;
+        inst->bid_amounts = malloc(config->depth * sizeof(double));
+        inst->ask_amounts = malloc(config->depth * sizeof(double));
+        if (!inst->bid_amounts || !inst->ask_amounts) {
+            sim_feed_destroy(feed);
+            return NULL;
+        }
+        for (int k = 0; k < config->depth; k++) {
+            inst->bid_amounts[k] = next_amount(feed);
+            inst->ask_amounts[k] = next_amount(feed);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &feed->start);
+    return feed;
+}
+
+void sim_feed_destroy(SimFeed* feed) {
+    if (!feed) {
+        return;
+    }
+    if (feed->instruments) {
+        for (int i = 0; i < feed->config.instrument_count; i++) {
+            free(feed->instruments[i].bid_amounts);
+            free(feed->instruments[i].ask_amounts);
+        }
+        free(feed->instruments);
+    }
+    free(feed);
+}
+
+// Bounded message writer; sets overflow instead of truncating
+typedef struct {
+    char* data;
+    size_t size;
+    size_t length;
+    bool overflow;
+} FeedWriter;
+
+static void writef(FeedWriter* w, const char* format, ...) {
+    if (w->overflow) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(w->data + w->length, w->size - w->length, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= w->size - w->length) {
+        w->overflow = true;
+        return;
+    }
+    w->length += (size_t)n;
+}
+
+static void write_level(FeedWriter* w, bool* first, const char* action, double price, double amount) {
+    writef(w, "%s[\"%s\",%.10g,%.1f]", *first ? "" : ",", action, price, amount);
+    *first = false;
+}
+
+static void shift_levels(double* amounts, int depth, int shift) {
+    // shift > 0 moves levels deeper (index grows), shift < 0 towards the top
+    if (shift > 0) {
+        memmove(&amounts[shift], &amounts[0], (depth - shift) * sizeof(double));
+    } else if (shift < 0) {
+        memmove(&amounts[0], &amounts[-shift], (depth + shift) * sizeof(double));
+    }
+}
+
+static void build_book(SimFeed* feed, SimFeedInstrument* inst, FeedWriter* w) {
+    int depth = feed->config.depth;
+    double vol = feed->stressed ? feed->config.stressed_volatility : feed->config.calm_volatility;
+    inst->mid += vol * next_normal(feed);
+    int64_t new_bid = (int64_t)floor(inst->mid - 0.5);
+    int64_t shift = new_bid - inst->best_bid;
+    if (shift > depth) {
+        shift = depth;
+        inst->mid = (double)(inst->best_bid + shift) + 0.5;
+        new_bid = inst->best_bid + shift;
+    } else if (shift < -depth) {
+        shift = -depth;
+        inst->mid = (double)(inst->best_bid + shift) + 0.5;
+        new_bid = inst->best_bid + shift;
+    }
+
+    uint64_t prev_change_id = inst->change_id++;
+    writef(w, "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"%s\","
+              "\"data\":{\"type\":\"change\",\"timestamp\":%llu,\"prev_change_id\":%llu,\"instrument_name\":\"%s\","
+              "\"change_id\":%llu,",
+           inst->book_channel, (unsigned long long)feed->batch_ts_ms, (unsigned long long)prev_change_id,
+           inst->name, (unsigned long long)inst->change_id);
+
+    int64_t old_bid = inst->best_bid;
+    int64_t old_ask = old_bid + 1;
+    int64_t new_ask = new_bid + 1;
+    int s = (int)shift;
+    bool first = true;
+
+    if (s == 0) {
+        // Size change at a random level
+        bool bid_side = next_random(feed) & 1;
+        int level = (int)(next_random(feed) % (uint64_t)depth);
+        double* amounts = bid_side ? inst->bid_amounts : inst->ask_amounts;
+        amounts[level] = next_amount(feed);
+        int64_t ticks = bid_side ? old_bid - level : old_ask + level;
+        writef(w, "\"bids\":[");
+        if (bid_side) {
+            write_level(w, &first, "change", price_of(feed, ticks), amounts[level]);
+        }
+        writef(w, "],\"asks\":[");
+        first = true;
+        if (!bid_side) {
+            write_level(w, &first, "change", price_of(feed, ticks), amounts[level]);
+        }
+        writef(w, "]}}}");
+        return;
+    }
+
+    // Mid moved: levels falling off one end are deleted, new ones appear at the other
+    writef(w, "\"bids\":[");
+    if (s > 0) {
+        for (int k = 0; k < s; k++) {
+            write_level(w, &first, "delete", price_of(feed, old_bid - (depth - 1) + k), 0.0);
+        }
+        shift_levels(inst->bid_amounts, depth, s);
+        for (int k = 0; k < s; k++) {
+            inst->bid_amounts[k] = next_amount(feed);
+            write_level(w, &first, "new", price_of(feed, new_bid - k), inst->bid_amounts[k]);
+        }
+    } else {
+        for (int k = 0; k < -s; k++) {
+            write_level(w, &first, "delete", price_of(feed, old_bid - k), 0.0);
+        }
+        shift_levels(inst->bid_amounts, depth, s);
+        for (int k = depth + s; k < depth; k++) {
+            inst->bid_amounts[k] = next_amount(feed);
+            write_level(w, &first, "new", price_of(feed, new_bid - k), inst->bid_amounts[k]);
+        }
+    }
+
+    writef(w, "],\"asks\":[");
+    first = true;
+    if (s > 0) {
+        for (int k = 0; k < s; k++) {
+            write_level(w, &first, "delete", price_of(feed, old_ask + k), 0.0);
+        }
+        shift_levels(inst->ask_amounts, depth, -s);
+        for (int k = depth - s; k < depth; k++) {
+            inst->ask_amounts[k] = next_amount(feed);
+            write_level(w, &first, "new", price_of(feed, new_ask + k), inst->ask_amounts[k]);
+        }
+    } else {
+        for (int k = 0; k < -s; k++) {
+            write_level(w, &first, "delete", price_of(feed, old_ask + (depth - 1) - k), 0.0);
+        }
+        shift_levels(inst->ask_amounts, depth, -s);
+        for (int k = 0; k < -s; k++) {
+            inst->ask_amounts[k] = next_amount(feed);
+            write_level(w, &first, "new", price_of(feed, new_ask + k), inst->ask_amounts[k]);
+        }
+    }
+    writef(w, "]}}}");
+
+    inst->best_bid = new_bid;
+}
+
+static void build_trade(SimFeed* feed, SimFeedInstrument* inst, FeedWriter* w) {
+    bool buy = next_random(feed) & 1;
+    int64_t ticks = buy ? inst->best_bid + 1 : inst->best_bid;
+    double* top = buy ? &inst->ask_amounts[0] : &inst->bid_amounts[0];
+    double amount = floor(next_uniform(feed) * (*top) * 10.0) / 10.0;
+    if (amount < 0.1) {
+        amount = 0.1;
+    }
+    *top = *top > amount + 0.1 ? *top - amount : 0.1;
+
+    int tick_direction = ticks > inst->last_price ? 0 : (ticks < inst->last_price ? 2 : (buy ? 1 : 3));
+    inst->last_price = ticks;
+    inst->trade_seq++;
+
+    writef(w, "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"%s\","
+              "\"data\":[{\"trade_seq\":%llu,\"trade_id\":\"%s-%llu\",\"timestamp\":%llu,\"tick_direction\":%d,"
+              "\"price\":%.10g,\"mark_price\":%.10g,\"instrument_name\":\"%s\",\"index_price\":%.10g,"
+              "\"direction\":\"%s\",\"amount\":%.1f}]}}",
+           inst->trades_channel, (unsigned long long)inst->trade_seq, inst->name,
+           (unsigned long long)inst->trade_seq, (unsigned long long)feed->batch_ts_ms, tick_direction,
+           price_of(feed, ticks), inst->mid * feed->config.tick_size, inst->name,
+           inst->mid * feed->config.tick_size, buy ? "buy" : "sell", amount);
+}
+
+static void build_ticker(SimFeed* feed, SimFeedInstrument* inst, FeedWriter* w) {
+    writef(w, "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"%s\","
+              "\"data\":{\"timestamp\":%llu,\"instrument_name\":\"%s\",\"best_bid_price\":%.10g,"
+              "\"best_bid_amount\":%.1f,\"best_ask_price\":%.10g,\"best_ask_amount\":%.1f,"
+              "\"last_price\":%.10g,\"mark_price\":%.10g,\"index_price\":%.10g}}}",
+           inst->ticker_channel, (unsigned long long)feed->batch_ts_ms, inst->name,
+           price_of(feed, inst->best_bid), inst->bid_amounts[0],
+           price_of(feed, inst->best_bid + 1), inst->ask_amounts[0],
+           price_of(feed, inst->last_price), inst->mid * feed->config.tick_size,
+           inst->mid * feed->config.tick_size);
+}
+
+static void emit_one(SimFeed* feed, WebSocketMessageCallback callback) {
+    if (next_uniform(feed) < feed->config.regime_switch_prob) {
+        feed->stressed = !feed->stressed;
+        feed->stats.regime_switches++;
+    }
+
+    SimFeedInstrument* inst = &feed->instruments[next_random(feed) % (uint64_t)feed->config.instrument_count];
+    FeedWriter w = { feed->buffer, sizeof(feed->buffer), 0, false };
+    const char* channel;
+
+    double u = next_uniform(feed);
+    if (u < feed->config.trade_ratio) {
+        build_trade(feed, inst, &w);
+        channel = inst->trades_channel;
+        feed->stats.trade_messages++;
+    } else if (u < feed->config.trade_ratio + feed->config.ticker_ratio) {
+        build_ticker(feed, inst, &w);
+        channel = inst->ticker_channel;
+        feed->stats.ticker_messages++;
+    } else {
+        build_book(feed, inst, &w);
+        channel = inst->book_channel;
+        feed->stats.book_messages++;
+    }
+
+    if (w.overflow) {
+        fprintf(stderr, "Synthetic message exceeded %d bytes, dropped\n", SIM_FEED_BUFFER_SIZE);
+        return;
+    }
+    feed->stats.bytes += w.length;
+
+    if (callback) {
+        WebSocketMessage msg = {
+            .type = WS_MESSAGE_TEXT,
+            .data = feed->buffer,
+            .length = w.length
+        };
+        snprintf(msg.channel, sizeof(msg.channel), "%s", channel);
+        callback(&msg);
+    }
+}
+
+int sim_feed_generate(SimFeed* feed, int count, WebSocketMessageCallback callback) {
+    if (!feed || count <= 0) {
+        return 0;
+    }
+    feed->batch_ts_ms = now_ms();
+    for (int i = 0; i < count; i++) {
+        emit_one(feed, callback);
+    }
+    return count;
+}
+
+int sim_feed_poll(SimFeed* feed, WebSocketMessageCallback callback) {
+    if (!feed) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (double)(now.tv_sec - feed->start.tv_sec) + (double)(now.tv_nsec - feed->start.tv_nsec) / 1e9;
+    uint64_t due = (uint64_t)(elapsed * feed->config.messages_per_sec);
+    if (due <= feed->paced) {
+        return 0;
+    }
+
+    // A consumer more than a second behind loses the backlog instead of bursting forever
+    uint64_t backlog = due - feed->paced;
+    if (backlog > (uint64_t)feed->config.messages_per_sec) {
+        feed->paced = due - (uint64_t)feed->config.max_burst;
+        backlog = (uint64_t)feed->config.max_burst;
+    }
+
+    int count = backlog > (uint64_t)feed->config.max_burst ? feed->config.max_burst : (int)backlog;
+    feed->paced += (uint64_t)count;
+    return sim_feed_generate(feed, count, callback);
+}
+
+const char* sim_feed_instrument_name(const SimFeed* feed, int index) {
+    if (!feed || index < 0 || index >= feed->config.instrument_count) {
+        return NULL;
+    }
+    return feed->instruments[index].name;
+}
+
+SimFeedStats sim_feed_get_stats(const SimFeed* feed) {
+    SimFeedStats stats = {0};
+    if (feed) {
+        stats = feed->stats;
+        stats.stressed = feed->stressed;
+    }
+    return stats;
+}
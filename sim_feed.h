@@ -0,0 +1,65 @@
+#ifndef SIM_FEED_H
+#define SIM_FEED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ws_message.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Synthetic market data generator for load testing. Emits Deribit-style
+// book, trades and ticker subscription notifications into a
+// WebSocketMessageCallback at a configurable rate.
+
+typedef struct {
+    int instrument_count;
+    int depth;                   // Levels per side
+    double messages_per_sec;     // Aggregate target rate
+    int max_burst;               // Cap per sim_feed_poll call
+    double base_price;
+    double tick_size;
+    double calm_volatility;      // Mid move std dev per update, in ticks
+    double stressed_volatility;
+    double regime_switch_prob;   // Per update
+    double trade_ratio;          // Share of messages that are trades
+    double ticker_ratio;         // Share of messages that are tickers
+    uint64_t seed;
+} SimFeedConfig;
+
+typedef struct {
+    uint64_t book_messages;
+    uint64_t trade_messages;
+    uint64_t ticker_messages;
+    uint64_t bytes;
+    uint64_t regime_switches;
+    bool stressed;
+} SimFeedStats;
+
+typedef struct SimFeed SimFeed;
+
+// Fill config with defaults (16 instruments, depth 10, 100k msg/s)
+void sim_feed_default_config(SimFeedConfig* config);
+
+// Create / destroy a generator
+SimFeed* sim_feed_create(const SimFeedConfig* config);
+void sim_feed_destroy(SimFeed* feed);
+
+// Emit exactly count messages now; returns count emitted
+int sim_feed_generate(SimFeed* feed, int count, WebSocketMessageCallback callback);
+
+// Emit the messages due at the configured rate since the last call
+int sim_feed_poll(SimFeed* feed, WebSocketMessageCallback callback);
+
+// Instrument name by index
+const char* sim_feed_instrument_name(const SimFeed* feed, int index);
+
+// Get statistics
+SimFeedStats sim_feed_get_stats(const SimFeed* feed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_FEED_H
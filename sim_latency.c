@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sim_latency.h"
+
+#define SIM_LATENCY_DEFAULT_SEED 0x9e3779b97f4a7c15ULL
+
+// xorshift64* generator
+static uint64_t next_random(SimLatencyModel* model) {
+    uint64_t x = model->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    model->rng_state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+// Uniform in (0, 1)
+static double next_uniform(SimLatencyModel* model) {
+    return ((double)(next_random(model) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static void reset_model(SimLatencyModel* model, SimLatencyKind kind) {
+    memset(model, 0, sizeof(*model));
+    model->kind = kind;
+    model->rng_state = SIM_LATENCY_DEFAULT_SEED;
+}
+
+void sim_latency_fixed(SimLatencyModel* model, uint64_t latency_ns) {
+    reset_model(model, SIM_LATENCY_FIXED);
+    model->base_ns = latency_ns;
+}
+
+void sim_latency_lognormal(SimLatencyModel* model, uint64_t floor_ns, uint64_t median_ns, double sigma) {
+    reset_model(model, SIM_LATENCY_LOGNORMAL);
+    model->base_ns = floor_ns;
+    model->mu = log(median_ns > 0 ? (double)median_ns : 1.0);
+    model->sigma = sigma > 0.0 ? sigma : 0.0;
+}
+
+bool sim_latency_histogram(SimLatencyModel* model, const uint64_t* upper_ns, const double* weights, int count) {
+    if (!model || !upper_ns || !weights || count <= 0 || count > SIM_LATENCY_MAX_BUCKETS) {
+        return false;
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        if (weights[i] < 0.0 || (i > 0 && upper_ns[i] <= upper_ns[i - 1])) {
+            return false;
+        }
+        total += weights[i];
+    }
+    if (total <= 0.0) {
+        return false;
+    }
+
+    reset_model(model, SIM_LATENCY_HISTOGRAM);
+    double cumulative = 0.0;
+    for (int i = 0; i < count; i++) {
+        cumulative += weights[i];
+        model->bucket_upper_ns[i] = upper_ns[i];
+        model->bucket_cdf[i] = cumulative / total;
+    }
+    model->bucket_cdf[count - 1] = 1.0;
+    model->bucket_count = count;
+    return true;
+}
+
+void sim_latency_seed(SimLatencyModel* model, uint64_t seed) {
+    model->rng_state = seed ? seed : SIM_LATENCY_DEFAULT_SEED;
+}
+
+uint64_t sim_latency_sample(SimLatencyModel* model) {
+    uint64_t value = model->base_ns;
+
+    switch (model->kind) {
+        case SIM_LATENCY_FIXED:
+            break;
+        case SIM_LATENCY_LOGNORMAL: {
+            // Box-Muller; one normal per draw keeps the stream simple to reproduce
+            double u1 = next_uniform(model);
+            double u2 = next_uniform(model);
+            double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+            value += (uint64_t)llround(exp(model->mu + model->sigma * z));
+            break;
+        }
+        case SIM_LATENCY_HISTOGRAM: {
+            double u = next_uniform(model);
+            int lo = 0;
+            int hi = model->bucket_count - 1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (model->bucket_cdf[mid] < u) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            uint64_t lower = lo > 0 ? model->bucket_upper_ns[lo - 1] : 0;
+            uint64_t width = model->bucket_upper_ns[lo] - lower;
+            value += lower + (uint64_t)(next_uniform(model) * (double)width);
+            break;
+        }
+    }
+
+    model->samples++;
+    model->total_ns += value;
+    if (value > model->max_ns) {
+        model->max_ns = value;
+    }
+    return value;
+}
+
+double sim_latency_mean_ns(const SimLatencyModel* model) {
+    return model->samples ? (double)model->total_ns / (double)model->samples : 0.0;
+}
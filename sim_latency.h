@@ -0,0 +1,55 @@
+#ifndef SIM_LATENCY_H
+#define SIM_LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIM_LATENCY_MAX_BUCKETS 64
+
+// Latency distribution types
+typedef enum {
+    SIM_LATENCY_FIXED,
+    SIM_LATENCY_LOGNORMAL,
+    SIM_LATENCY_HISTOGRAM
+} SimLatencyKind;
+
+// Latency model on the virtual clock (nanoseconds); sampling is deterministic per seed
+typedef struct {
+    SimLatencyKind kind;
+    uint64_t base_ns;                                 // Fixed value, or floor added to every sample
+    double mu;                                        // Lognormal: ln(median_ns)
+    double sigma;
+    uint64_t bucket_upper_ns[SIM_LATENCY_MAX_BUCKETS];
+    double bucket_cdf[SIM_LATENCY_MAX_BUCKETS];
+    int bucket_count;
+    uint64_t rng_state;
+
+    // Statistics over samples drawn
+    uint64_t samples;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} SimLatencyModel;
+
+// Configure a model
+void sim_latency_fixed(SimLatencyModel* model, uint64_t latency_ns);
+void sim_latency_lognormal(SimLatencyModel* model, uint64_t floor_ns, uint64_t median_ns, double sigma);
+bool sim_latency_histogram(SimLatencyModel* model, const uint64_t* upper_ns, const double* weights, int count);
+
+// Reseed the generator (models start with a fixed seed)
+void sim_latency_seed(SimLatencyModel* model, uint64_t seed);
+
+// Draw one latency sample
+uint64_t sim_latency_sample(SimLatencyModel* model);
+
+// Mean of samples drawn so far
+double sim_latency_mean_ns(const SimLatencyModel* model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_LATENCY_H
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include "subscription_table.h"
+
+#define SUBSCRIPTION_MIN_CAPACITY 16
+
+uint64_t subscription_channel_hash(const char* channel, size_t length) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)channel[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Slot arrays stay at most half full
+static uint32_t slot_count_for(uint32_t capacity) {
+    uint32_t slots = SUBSCRIPTION_MIN_CAPACITY;
+    while (slots < capacity * 2) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+static bool rebuild_slots(int32_t** slots, uint32_t* mask, uint32_t capacity, const uint64_t* hashes, size_t stride, uint32_t count) {
+    uint32_t slot_count = slot_count_for(capacity);
+    int32_t* rebuilt = calloc(slot_count, sizeof(int32_t));
+    if (!rebuilt) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t hash = *(const uint64_t*)((const char*)hashes + i * stride);
+        uint32_t slot = (uint32_t)hash & (slot_count - 1);
+        while (rebuilt[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        rebuilt[slot] = (int32_t)i + 1;
+    }
+    free(*slots);
+    *slots = rebuilt;
+    *mask = slot_count - 1;
+    return true;
+}
+
+static bool grow_entries(SubscriptionTable* table, uint32_t capacity) {
+    Subscription* entries = realloc(table->entries, capacity * sizeof(Subscription));
+    if (!entries) {
+        return false;
+    }
+    table->entries = entries;
+    table->capacity = capacity;
+    return rebuild_slots(&table->slots, &table->slot_mask, capacity, &entries[0].hash, sizeof(Subscription), table->count);
+}
+
+static bool grow_instruments(SubscriptionTable* table, uint32_t capacity) {
+    char (*names)[SUBSCRIPTION_INSTRUMENT_SIZE] = realloc(table->instruments, capacity * sizeof(*names));
+    if (!names) {
+        return false;
+    }
+    table->instruments = names;
+    uint64_t* hashes = realloc(table->instrument_hashes, capacity * sizeof(uint64_t));
+    if (!hashes) {
+        return false;
+    }
+    table->instrument_hashes = hashes;
+    table->instrument_capacity = capacity;
+    return rebuild_slots(&table->instrument_slots, &table->instrument_slot_mask, capacity,
+                         hashes, sizeof(uint64_t), table->instrument_count);
+}
+
+bool subscription_table_init(SubscriptionTable* table, uint32_t expected) {
+    memset(table, 0, sizeof(*table));
+    uint32_t capacity = expected > SUBSCRIPTION_MIN_CAPACITY ? expected : SUBSCRIPTION_MIN_CAPACITY;
+    if (!grow_entries(table, capacity) || !grow_instruments(table, capacity)) {
+        subscription_table_free(table);
+        return false;
+    }
+    return true;
+}
+
+void subscription_table_free(SubscriptionTable* table) {
+    free(table->entries);
+    free(table->slots);
+    free(table->instruments);
+    free(table->instrument_hashes);
+    free(table->instrument_slots);
+    memset(table, 0, sizeof(*table));
+}
+
+void subscription_table_clear(SubscriptionTable* table) {
+    if (table->slots) {
+        memset(table->slots, 0, (table->slot_mask + 1) * sizeof(int32_t));
+    }
+    table->count = 0;
+}
+
+// Slot holding the channel, or -1
+static int64_t find_slot(const SubscriptionTable* table, uint64_t hash, const char* channel, size_t length) {
+    if (!table->slots) {
+        return -1;
+    }
+    uint32_t slot = (uint32_t)hash & table->slot_mask;
+    while (table->slots[slot] != 0) {
+        const Subscription* entry = &table->entries[table->slots[slot] - 1];
+        if (entry->hash == hash && strncmp(entry->channel, channel, length) == 0 && entry->channel[length] == '\0') {
+            return slot;
+        }
+        slot = (slot + 1) & table->slot_mask;
+    }
+    return -1;
+}
+
+Subscription* subscription_table_find(const SubscriptionTable* table, const char* channel, size_t length) {
+    if (!table || !channel || length >= SUBSCRIPTION_CHANNEL_SIZE) {
+        return NULL;
+    }
+    int64_t slot = find_slot(table, subscription_channel_hash(channel, length), channel, length);
+    return slot < 0 ? NULL : &table->entries[table->slots[slot] - 1];
+}
+
+// The instrument is the name after the channel kind: book.BTC-PERPETUAL.100ms,
+// user.orders.BTC-PERPETUAL.raw, deribit_price_index.btc_usd
+static uint32_t channel_instrument_id(SubscriptionTable* table, const char* channel) {
+    const char* name = strncmp(channel, "user.", 5) == 0 ? channel + 5 : channel;
+    name = strchr(name, '.');
+    if (!name) {
+        return SUBSCRIPTION_NO_INSTRUMENT;
+    }
+    name++;
+    const char* end = strchr(name, '.');
+    size_t length = end ? (size_t)(end - name) : strlen(name);
+    return length > 0 ? subscription_table_instrument_id(table, name, length) : SUBSCRIPTION_NO_INSTRUMENT;
+}
+
+Subscription* subscription_table_add(SubscriptionTable* table, const char* channel, bool* added) {
+    size_t length = channel ? strlen(channel) : 0;
+    if (added) {
+        *added = false;
+    }
+    if (!table || length == 0 || length >= SUBSCRIPTION_CHANNEL_SIZE) {
+        return NULL;
+    }
+    uint64_t hash = subscription_channel_hash(channel, length);
+    int64_t found = find_slot(table, hash, channel, length);
+    if (found >= 0) {
+        return &table->entries[table->slots[found] - 1];
+    }
+    if (table->count == table->capacity && !grow_entries(table, table->capacity ? table->capacity * 2 : SUBSCRIPTION_MIN_CAPACITY)) {
+        return NULL;
+    }
+
+    Subscription* entry = &table->entries[table->count];
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->channel, channel, length + 1);
+    entry->hash = hash;
+    entry->instrument_id = channel_instrument_id(table, channel);
+
+    uint32_t slot = (uint32_t)hash & table->slot_mask;
+    while (table->slots[slot] != 0) {
+        slot = (slot + 1) & table->slot_mask;
+    }
+    table->slots[slot] = (int32_t)table->count + 1;
+    table->count++;
+    if (added) {
+        *added = true;
+    }
+    return entry;
+}
+
+bool subscription_table_remove(SubscriptionTable* table, const char* channel) {
+    size_t length = channel ? strlen(channel) : 0;
+    if (!table || length >= SUBSCRIPTION_CHANNEL_SIZE) {
+        return false;
+    }
+    int64_t found = find_slot(table, subscription_channel_hash(channel, length), channel, length);
+    if (found < 0) {
+        return false;
+    }
+    uint32_t index = (uint32_t)table->slots[found] - 1;
+
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    uint32_t hole = (uint32_t)found;
+    uint32_t slot = hole;
+    table->slots[hole] = 0;
+    for (;;) {
+        slot = (slot + 1) & table->slot_mask;
+        if (table->slots[slot] == 0) {
+            break;
+        }
+        uint32_t home = (uint32_t)table->entries[table->slots[slot] - 1].hash & table->slot_mask;
+        // Move the entry back unless its home lies cyclically in (hole, slot]
+        bool stays = hole <= slot ? (home > hole && home <= slot) : (home > hole || home <= slot);
+        if (!stays) {
+            table->slots[hole] = table->slots[slot];
+            table->slots[slot] = 0;
+            hole = slot;
+        }
+    }
+
+    // Keep the array dense: the last entry takes the freed index
+    uint32_t last = table->count - 1;
+    if (index != last) {
+        table->entries[index] = table->entries[last];
+        uint32_t moved = (uint32_t)table->entries[index].hash & table->slot_mask;
+        while (table->slots[moved] != (int32_t)last + 1) {
+            moved = (moved + 1) & table->slot_mask;
+        }
+        table->slots[moved] = (int32_t)index + 1;
+    }
+    table->count--;
+    return true;
+}
+
+Subscription* subscription_table_at(const SubscriptionTable* table, uint32_t index) {
+    return table && index < table->count ? &table->entries[index] : NULL;
+}
+
+uint32_t subscription_table_instrument_id(SubscriptionTable* table, const char* instrument, size_t length) {
+    if (!table || !instrument || length == 0 || length >= SUBSCRIPTION_INSTRUMENT_SIZE) {
+        return SUBSCRIPTION_NO_INSTRUMENT;
+    }
+    if (!table->instrument_slots && !grow_instruments(table, SUBSCRIPTION_MIN_CAPACITY)) {
+        return SUBSCRIPTION_NO_INSTRUMENT;
+    }
+    uint64_t hash = subscription_channel_hash(instrument, length);
+    uint32_t slot = (uint32_t)hash & table->instrument_slot_mask;
+    while (table->instrument_slots[slot] != 0) {
+        uint32_t id = (uint32_t)table->instrument_slots[slot] - 1;
+        if (table->instrument_hashes[id] == hash && strncmp(table->instruments[id], instrument, length) == 0 &&
+            table->instruments[id][length] == '\0') {
+            return id;
+        }
+        slot = (slot + 1) & table->instrument_slot_mask;
+    }
+
+    if (table->instrument_count == table->instrument_capacity) {
+        if (!grow_instruments(table, table->instrument_capacity * 2)) {
+            return SUBSCRIPTION_NO_INSTRUMENT;
+        }
+        slot = (uint32_t)hash & table->instrument_slot_mask;
+        while (table->instrument_slots[slot] != 0) {
+            slot = (slot + 1) & table->instrument_slot_mask;
+        }
+    }
+    uint32_t id = table->instrument_count++;
+    memcpy(table->instruments[id], instrument, length);
+    table->instruments[id][length] = '\0';
+    table->instrument_hashes[id] = hash;
+    table->instrument_slots[slot] = (int32_t)id + 1;
+    return id;
+}
+
+void subscription_track_sequence(Subscription* sub, const char* message) {
+    if (strncmp(sub->channel, "book.", 5) != 0) {
+        return;
+    }
+    const char* change = strstr(message, "\"change_id\":");
+    if (!change) {
+        return;
+    }
+    const char* prev = strstr(message, "\"prev_change_id\":");
+    if (prev && sub->last_sequence != 0 && strtoull(prev + 17, NULL, 10) != sub->last_sequence) {
+        sub->sequence_gaps++;
+    }
+    sub->last_sequence = strtoull(change + 12, NULL, 10);
+}
+
+const char* subscription_table_instrument_name(const SubscriptionTable* table, uint32_t instrument_id) {
+    return table && instrument_id < table->instrument_count ? table->instruments[instrument_id] : NULL;
+}
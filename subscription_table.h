@@ -0,0 +1,86 @@
+#ifndef SUBSCRIPTION_TABLE_H
+#define SUBSCRIPTION_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "websocket_client.h"
+#include "market_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Subscribed channels in a dense array indexed by an open-addressing hash
+// table, so subscribe, unsubscribe and lookup by channel name are O(1) and
+// there is no fixed channel limit. Instrument names found in channel names
+// are interned to small dense ids that stay stable for the table's lifetime.
+
+#define SUBSCRIPTION_CHANNEL_SIZE 128
+#define SUBSCRIPTION_INSTRUMENT_SIZE 64
+#define SUBSCRIPTION_NO_INSTRUMENT UINT32_MAX
+
+// Per-channel state
+typedef struct {
+    char channel[SUBSCRIPTION_CHANNEL_SIZE];
+    uint64_t hash;
+    uint32_t instrument_id;             // SUBSCRIPTION_NO_INSTRUMENT if the channel names none
+    WebSocketMessageCallback handler;   // NULL to use the connection's message callback
+    bool typed;                         // Decoded and sent to typed_handlers instead
+    SubscriptionType type;              // Selects the decoder when typed
+    MarketDataHandlers typed_handlers;
+    uint64_t last_sequence;             // change_id of the last book update
+    uint64_t sequence_gaps;             // Book updates whose prev_change_id did not match
+    uint64_t messages;
+} Subscription;
+
+typedef struct {
+    Subscription* entries;              // Dense, in no particular order
+    uint32_t count;
+    uint32_t capacity;
+    int32_t* slots;                     // Index into entries plus one; 0 when empty
+    uint32_t slot_mask;
+
+    char (*instruments)[SUBSCRIPTION_INSTRUMENT_SIZE];
+    uint64_t* instrument_hashes;
+    uint32_t instrument_count;
+    uint32_t instrument_capacity;
+    int32_t* instrument_slots;
+    uint32_t instrument_slot_mask;
+} SubscriptionTable;
+
+// Size the table for expected channels; it grows past that as needed
+bool subscription_table_init(SubscriptionTable* table, uint32_t expected);
+void subscription_table_free(SubscriptionTable* table);
+
+// Drop every subscription; instrument ids are kept
+void subscription_table_clear(SubscriptionTable* table);
+
+// Entry pointers stay valid only until the next add or remove
+Subscription* subscription_table_find(const SubscriptionTable* table, const char* channel, size_t length);
+
+// Find or create the entry for channel; *added tells which. NULL if the name
+// is too long or memory runs out.
+Subscription* subscription_table_add(SubscriptionTable* table, const char* channel, bool* added);
+
+bool subscription_table_remove(SubscriptionTable* table, const char* channel);
+
+// Dense index access for iteration, 0 <= index < count
+Subscription* subscription_table_at(const SubscriptionTable* table, uint32_t index);
+
+// Intern an instrument name; SUBSCRIPTION_NO_INSTRUMENT if it cannot be stored
+uint32_t subscription_table_instrument_id(SubscriptionTable* table, const char* instrument, size_t length);
+const char* subscription_table_instrument_name(const SubscriptionTable* table, uint32_t instrument_id);
+
+// Record a book notification's change_id, counting a gap when its
+// prev_change_id does not match; other channels are ignored
+void subscription_track_sequence(Subscription* sub, const char* message);
+
+// FNV-1a over the channel name
+uint64_t subscription_channel_hash(const char* channel, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SUBSCRIPTION_TABLE_H
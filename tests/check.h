@@ -0,0 +1,20 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// Minimal assertions for the standalone test programs run by ctest: failures
+// are printed and counted, and CHECK_RESULT() becomes the exit status.
+
+static int check_failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        check_failures++; \
+    } \
+} while (0)
+
+#define CHECK_RESULT() (check_failures == 0 ? 0 : (printf("%d check(s) failed\n", check_failures), 1))
+
+#endif // CHECK_H
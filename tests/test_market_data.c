@@ -0,0 +1,244 @@
+// market_data: typed decoders and dispatch on notifications captured from the
+// Deribit v2 API (book, trades, ticker, user.orders), plus heartbeats and the
+// paths that split or grow past the scratch buffers
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "market_data.h"
+
+static const char* BOOK_SNAPSHOT =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"book.BTC-PERPETUAL.100ms\","
+    "\"data\":{\"type\":\"snapshot\",\"timestamp\":1554373962454,\"instrument_name\":\"BTC-PERPETUAL\","
+    "\"change_id\":297217,\"bids\":[[\"new\",5042.34,30.0],[\"new\",5041.94,20.0]],"
+    "\"asks\":[[\"new\",5042.64,40.0],[\"new\",5043.3,40.0]]}}}";
+
+static const char* BOOK_CHANGE =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"book.BTC-PERPETUAL.100ms\","
+    "\"data\":{\"type\":\"change\",\"timestamp\":1554373911330,\"prev_change_id\":297217,"
+    "\"instrument_name\":\"BTC-PERPETUAL\",\"change_id\":297218,"
+    "\"bids\":[[\"delete\",5042.34,0.0],[\"change\",5041.94,10.0]],\"asks\":[]}}}";
+
+// Grouped books carry plain [price, amount] pairs
+static const char* BOOK_GROUPED =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"book.BTC-PERPETUAL.none.10.100ms\","
+    "\"data\":{\"timestamp\":1554375447971,\"instrument_name\":\"BTC-PERPETUAL\",\"change_id\":297246,"
+    "\"bids\":[[5049.25,20.0],[5048.5,10.0]],\"asks\":[[5050.4,40.0]]}}}";
+
+static const char* TRADES =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"trades.BTC-PERPETUAL.raw\","
+    "\"data\":[{\"trade_seq\":30289432,\"trade_id\":\"48079254\",\"timestamp\":1590484156350,\"tick_direction\":0,"
+    "\"price\":8950.0,\"mark_price\":8948.9,\"liquidation\":\"M\",\"instrument_name\":\"BTC-PERPETUAL\","
+    "\"index_price\":8955.88,\"direction\":\"sell\",\"amount\":10.0},"
+    "{\"trade_seq\":30289433,\"trade_id\":\"48079255\",\"timestamp\":1590484156351,\"tick_direction\":1,"
+    "\"price\":8951.5,\"mark_price\":8948.9,\"instrument_name\":\"BTC-PERPETUAL\","
+    "\"index_price\":8955.88,\"direction\":\"buy\",\"amount\":5.0}]}}";
+
+static const char* TICKER =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"ticker.BTC-PERPETUAL.raw\","
+    "\"data\":{\"timestamp\":1623060194301,\"stats\":{\"volume_usd\":284061480,\"volume\":7598.2,"
+    "\"price_change\":-1.29,\"low\":35620,\"high\":37894},\"state\":\"open\",\"settlement_price\":36897.76,"
+    "\"open_interest\":502097590,\"min_price\":36051.78,\"max_price\":37150.97,\"mark_price\":36601.24,"
+    "\"last_price\":36585,\"instrument_name\":\"BTC-PERPETUAL\",\"index_price\":36592.66,"
+    "\"funding_8h\":0.0000188,\"estimated_delivery_price\":36592.66,\"current_funding\":0,"
+    "\"best_bid_price\":36583.5,\"best_bid_amount\":1300,\"best_ask_price\":36584,\"best_ask_amount\":1200}}}";
+
+static const char* ORDER =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"user.orders.BTC-PERPETUAL.raw\","
+    "\"data\":{\"time_in_force\":\"good_til_cancelled\",\"replaced\":false,\"reduce_only\":false,"
+    "\"price\":10502.52,\"post_only\":false,\"original_order_type\":\"market\",\"order_type\":\"limit\","
+    "\"order_state\":\"open\",\"order_id\":\"5\",\"max_show\":200,\"last_update_timestamp\":1581507423789,"
+    "\"label\":\"\",\"is_liquidation\":false,\"instrument_name\":\"BTC-PERPETUAL\",\"filled_amount\":0,"
+    "\"direction\":\"buy\",\"creation_timestamp\":1581507423789,\"commission\":0,\"average_price\":0,"
+    "\"api\":false,\"amount\":200}}}";
+
+static MarketDataScratch scratch;
+
+static void test_book(void) {
+    BookUpdate update;
+    CHECK(market_data_decode_book(market_data_payload(BOOK_SNAPSHOT), &update, scratch.levels, MARKET_DATA_MAX_LEVELS));
+    CHECK(update.snapshot);
+    CHECK(update.timestamp == 1554373962454ULL);
+    CHECK(update.change_id == 297217);
+    CHECK(update.prev_change_id == 0);
+    CHECK(update.bids_count == 2 && update.asks_count == 2);
+    CHECK(update.bids[0].action == BOOK_ACTION_NEW && update.bids[0].price == 5042.34 && update.bids[0].amount == 30.0);
+    CHECK(update.asks[1].price == 5043.3 && update.asks[1].amount == 40.0);
+
+    CHECK(market_data_decode_book(market_data_payload(BOOK_CHANGE), &update, scratch.levels, MARKET_DATA_MAX_LEVELS));
+    CHECK(!update.snapshot);
+    CHECK(update.prev_change_id == 297217 && update.change_id == 297218);
+    CHECK(update.bids_count == 2 && update.asks_count == 0);
+    CHECK(update.bids[0].action == BOOK_ACTION_DELETE);
+    CHECK(update.bids[1].action == BOOK_ACTION_CHANGE && update.bids[1].amount == 10.0);
+
+    CHECK(market_data_decode_book(market_data_payload(BOOK_GROUPED), &update, scratch.levels, MARKET_DATA_MAX_LEVELS));
+    CHECK(update.bids_count == 2 && update.asks_count == 1);
+    CHECK(update.bids[1].price == 5048.5 && update.asks[0].amount == 40.0);
+
+    // More levels than the buffer holds, and malformed arrays, are refused
+    CHECK(!market_data_decode_book(market_data_payload(BOOK_SNAPSHOT), &update, scratch.levels, 3));
+    CHECK(!market_data_decode_book("{\"bids\":[[\"moved\",1,2]],\"asks\":[]}", &update, scratch.levels, 8));
+    CHECK(!market_data_decode_book("{\"bids\":[[1]],\"asks\":[]}", &update, scratch.levels, 8));
+    CHECK(!market_data_decode_book("{\"type\":\"snapshot\"}", &update, scratch.levels, 8));
+}
+
+static void test_trades(void) {
+    TradeUpdate trades[4];
+    const char* cursor = market_data_payload(TRADES);
+    CHECK(market_data_decode_trades(&cursor, trades, 4) == 2);
+    CHECK(cursor == NULL);
+    CHECK(trades[0].trade_seq == 30289432);
+    CHECK(strcmp(trades[0].trade_id, "48079254") == 0);
+    CHECK(trades[0].timestamp == 1590484156350ULL);
+    CHECK(trades[0].side == ORDER_SIDE_SELL);
+    CHECK(trades[0].price == 8950.0);          // Not mark_price or index_price
+    CHECK(trades[0].amount == 10.0);
+    CHECK(trades[1].side == ORDER_SIDE_BUY && trades[1].price == 8951.5);
+
+    // A full buffer leaves the cursor on the next trade
+    cursor = market_data_payload(TRADES);
+    CHECK(market_data_decode_trades(&cursor, trades, 1) == 1);
+    CHECK(cursor != NULL);
+    CHECK(market_data_decode_trades(&cursor, trades, 1) == 1);
+    CHECK(cursor == NULL);
+    CHECK(trades[0].trade_seq == 30289433);
+
+    cursor = "[{\"trade_seq\":1,\"price\":1.0";
+    CHECK(market_data_decode_trades(&cursor, trades, 4) == -1);
+}
+
+static void test_ticker(void) {
+    TickerUpdate ticker;
+    CHECK(market_data_decode_ticker(market_data_payload(TICKER), &ticker));
+    CHECK(ticker.timestamp == 1623060194301ULL);
+    CHECK(ticker.best_bid_price == 36583.5 && ticker.best_bid_amount == 1300);
+    CHECK(ticker.best_ask_price == 36584 && ticker.best_ask_amount == 1200);
+    CHECK(ticker.last_price == 36585);
+    CHECK(ticker.mark_price == 36601.24);
+    CHECK(ticker.index_price == 36592.66);
+}
+
+static void test_orders(void) {
+    Order orders[2];
+    CHECK(market_data_decode_orders(market_data_payload(ORDER), orders, 2) == 1);
+    CHECK(strcmp(orders[0].order_id, "5") == 0);
+    CHECK(strcmp(orders[0].instrument_name, "BTC-PERPETUAL") == 0);
+    CHECK(orders[0].type == ORDER_TYPE_LIMIT);              // Not original_order_type
+    CHECK(orders[0].status == ORDER_STATUS_OPEN);
+    CHECK(orders[0].side == ORDER_SIDE_BUY);
+    CHECK(orders[0].price == 10502.52);                     // Not average_price
+    CHECK(orders[0].amount == 200);                         // Not filled_amount
+    CHECK(strcmp(orders[0].created_at, "2020-02-12 11:37:03") == 0);
+
+    const char* list = "[{\"order_id\":\"a\",\"order_state\":\"filled\",\"direction\":\"sell\"},"
+                       "{\"order_id\":\"b\",\"order_state\":\"cancelled\",\"order_type\":\"stop_market\"},"
+                       "{\"order_id\":\"c\",\"order_state\":\"untriggered\"}]";
+    CHECK(market_data_decode_orders(list, orders, 2) == 3);  // Counts past the buffer
+    CHECK(orders[0].status == ORDER_STATUS_FILLED && orders[0].side == ORDER_SIDE_SELL);
+    CHECK(orders[1].status == ORDER_STATUS_CANCELLED && orders[1].type == ORDER_TYPE_STOP_MARKET);
+    CHECK(market_data_decode_orders("[]", orders, 2) == 0);
+    CHECK(market_data_decode_orders("[{\"order_id\":\"a\"", orders, 2) == -1);
+}
+
+static void test_heartbeat_and_result(void) {
+    CHECK(market_data_heartbeat("{\"jsonrpc\":\"2.0\",\"method\":\"heartbeat\",\"params\":{\"type\":\"test_request\"}}") ==
+          MARKET_DATA_TEST_REQUEST);
+    CHECK(market_data_heartbeat("{\"jsonrpc\":\"2.0\",\"method\":\"heartbeat\",\"params\":{\"type\":\"heartbeat\"}}") ==
+          MARKET_DATA_HEARTBEAT);
+    CHECK(market_data_heartbeat(TICKER) == MARKET_DATA_NOT_HEARTBEAT);
+
+    const char* response = "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":{\"timestamp\":1,\"change_id\":9,"
+                           "\"bids\":[[100.5,1.0]],\"asks\":[[101.0,2.0]]},\"usIn\":1,\"usOut\":2}";
+    BookUpdate update;
+    CHECK(market_data_decode_book(market_data_result(response), &update, scratch.levels, MARKET_DATA_MAX_LEVELS));
+    CHECK(update.change_id == 9 && update.bids[0].price == 100.5 && update.asks[0].amount == 2.0);
+}
+
+typedef struct {
+    int calls;
+    int items;
+    uint64_t last_seq;
+    const char* instrument_name;
+} Received;
+
+static void on_trades(const TradeBatch* batch, void* user_data) {
+    Received* received = user_data;
+    received->calls++;
+    received->items += batch->count;
+    received->last_seq = batch->trades[batch->count - 1].trade_seq;
+    received->instrument_name = batch->instrument_name;
+}
+
+static void on_orders(const Order* orders, int count, void* user_data) {
+    Received* received = user_data;
+    received->calls++;
+    received->items += count;
+    received->last_seq = strtoull(orders[count - 1].order_id, NULL, 10);
+}
+
+static void on_book(const BookUpdate* update, void* user_data) {
+    Received* received = user_data;
+    received->calls++;
+    received->items += update->bids_count + update->asks_count;
+    received->instrument_name = update->instrument_name;
+}
+
+// Notification with count flat objects in its data array
+static char* build_array(const char* channel, const char* format, int count) {
+    size_t size = 256 + (size_t)count * 128;
+    char* message = malloc(size);
+    size_t length = (size_t)snprintf(message, size,
+        "{\"jsonrpc\":\"2.0\",\"method\":\"subscription\",\"params\":{\"channel\":\"%s\",\"data\":[", channel);
+    for (int i = 0; i < count; i++) {
+        length += (size_t)snprintf(message + length, size - length, "%s", i ? "," : "");
+        length += (size_t)snprintf(message + length, size - length, format, i + 1);
+    }
+    snprintf(message + length, size - length, "]}}");
+    return message;
+}
+
+static void test_dispatch(void) {
+    Received received = {0};
+    MarketDataHandlers handlers = {.on_book = on_book, .on_trades = on_trades, .on_orders = on_orders, .user_data = &received};
+
+    CHECK(market_data_dispatch(SUBSCRIPTION_BOOK, &handlers, 3, "BTC-PERPETUAL", BOOK_SNAPSHOT, &scratch));
+    CHECK(received.calls == 1 && received.items == 4);
+    CHECK(strcmp(received.instrument_name, "BTC-PERPETUAL") == 0);
+
+    // No decoder, or no handler for the type: the caller falls back to raw delivery
+    CHECK(!market_data_has_decoder(SUBSCRIPTION_PORTFOLIO));
+    CHECK(!market_data_dispatch(SUBSCRIPTION_PORTFOLIO, &handlers, 3, "BTC-PERPETUAL", TICKER, &scratch));
+    CHECK(!market_data_dispatch(SUBSCRIPTION_TICKER, &handlers, 3, "BTC-PERPETUAL", TICKER, &scratch));
+
+    // Trades beyond the scratch buffer arrive over several callbacks
+    int trade_count = MARKET_DATA_MAX_TRADES * 2 + 10;
+    char* trades = build_array("trades.BTC-PERPETUAL.raw",
+        "{\"trade_seq\":%d,\"trade_id\":\"t\",\"price\":1.5,\"direction\":\"buy\",\"amount\":1}", trade_count);
+    memset(&received, 0, sizeof(received));
+    CHECK(market_data_dispatch(SUBSCRIPTION_TRADES, &handlers, 3, "BTC-PERPETUAL", trades, &scratch));
+    CHECK(received.calls == 3 && received.items == trade_count);
+    CHECK(received.last_seq == (uint64_t)trade_count);
+    free(trades);
+
+    // An order snapshot beyond the scratch buffer arrives whole
+    int order_count = MARKET_DATA_MAX_ORDERS + 36;
+    char* orders = build_array("user.orders.BTC-PERPETUAL.raw",
+        "{\"order_id\":\"%d\",\"order_state\":\"open\",\"direction\":\"buy\",\"amount\":1}", order_count);
+    memset(&received, 0, sizeof(received));
+    CHECK(market_data_dispatch(SUBSCRIPTION_ORDER, &handlers, 3, "BTC-PERPETUAL", orders, &scratch));
+    CHECK(received.calls == 1 && received.items == order_count);
+    CHECK(received.last_seq == (uint64_t)order_count);
+    free(orders);
+}
+
+int main(void) {
+    test_book();
+    test_trades();
+    test_ticker();
+    test_orders();
+    test_heartbeat_and_result();
+    test_dispatch();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,163 @@
+// rate_limiter: GCRA admission, the cancel reserve, queueing within a wait
+// budget, refunds, refill over time and the endpoint cost table
+
+#include <stdint.h>
+#include <time.h>
+#include "check.h"
+#include "rate_limiter.h"
+
+#define NS_PER_MS 1000000ULL
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static void test_init(void) {
+    RateLimiter limiter;
+    CHECK(!rate_limiter_init(&limiter, 0, 1, 0));
+    CHECK(!rate_limiter_init(&limiter, 10, 0, 0));
+    CHECK(!rate_limiter_init(&limiter, 10, 1, 10));     // Reserve must leave something for normal traffic
+    CHECK(rate_limiter_init(&limiter, 10, 1, 2));
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) == 8);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_CANCEL) == 10);
+}
+
+// One credit per second, so nothing refills while the checks run
+static void test_admit_and_reject(void) {
+    RateLimiter limiter;
+    rate_limiter_init(&limiter, 10, 1, 2);
+
+    for (int i = 0; i < 8; i++) {
+        CHECK(rate_limiter_try_acquire(&limiter, 1, RATE_PRIORITY_NORMAL) == RATE_LIMIT_GRANTED);
+    }
+    uint64_t wait = rate_limiter_try_acquire(&limiter, 1, RATE_PRIORITY_NORMAL);
+    CHECK(wait != RATE_LIMIT_GRANTED && wait != RATE_LIMIT_NEVER);
+    CHECK(wait <= 1000 * NS_PER_MS);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) == 0);
+
+    // Cancels may spend the reserve
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_CANCEL) == 2);
+    CHECK(rate_limiter_try_acquire(&limiter, 2, RATE_PRIORITY_CANCEL) == RATE_LIMIT_GRANTED);
+    CHECK(rate_limiter_try_acquire(&limiter, 1, RATE_PRIORITY_CANCEL) != RATE_LIMIT_GRANTED);
+
+    // A cost larger than the whole pool can never be admitted
+    CHECK(rate_limiter_try_acquire(&limiter, 11, RATE_PRIORITY_CANCEL) == RATE_LIMIT_NEVER);
+
+    CHECK(limiter.granted == 9);
+    CHECK(limiter.rejected == 3);
+}
+
+static void test_queue(void) {
+    RateLimiter limiter;
+    rate_limiter_init(&limiter, 2, 1, 0);
+    CHECK(rate_limiter_reserve(&limiter, 2, RATE_PRIORITY_NORMAL, 0) == 0);
+
+    // Each further credit is booked a second after the previous one
+    uint64_t first = rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 3000 * NS_PER_MS);
+    uint64_t second = rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 3000 * NS_PER_MS);
+    CHECK(first > 900 * NS_PER_MS && first <= 1000 * NS_PER_MS);
+    CHECK(second > 1900 * NS_PER_MS && second <= 2000 * NS_PER_MS);
+
+    // Beyond the wait budget the request is refused and nothing is booked
+    CHECK(rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 500 * NS_PER_MS) == RATE_LIMIT_NEVER);
+    uint64_t third = rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 3000 * NS_PER_MS);
+    CHECK(third > 2900 * NS_PER_MS && third <= 3000 * NS_PER_MS);
+
+    CHECK(limiter.granted == 1);
+    CHECK(limiter.queued == 3);
+    CHECK(limiter.rejected == 1);
+}
+
+static void test_release(void) {
+    RateLimiter limiter;
+    rate_limiter_init(&limiter, 2, 1, 0);
+    CHECK(rate_limiter_reserve(&limiter, 2, RATE_PRIORITY_NORMAL, 0) == 0);
+    uint64_t held = rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 3000 * NS_PER_MS);
+    CHECK(held > 900 * NS_PER_MS && held <= 1000 * NS_PER_MS);
+
+    // Giving back the held booking frees its slot for the next request
+    rate_limiter_release(&limiter, 1);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) == 0);
+    CHECK(rate_limiter_reserve(&limiter, 1, RATE_PRIORITY_NORMAL, 3000 * NS_PER_MS) <= 1000 * NS_PER_MS);
+
+    // Never refills past a full pool
+    rate_limiter_release(&limiter, 1);
+    rate_limiter_release(&limiter, 10);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) == 2);
+}
+
+static void test_refill(void) {
+    RateLimiter limiter;
+    rate_limiter_init(&limiter, 5, 1000, 0);
+    for (int i = 0; i < 5; i++) {
+        CHECK(rate_limiter_try_acquire(&limiter, 1, RATE_PRIORITY_NORMAL) == RATE_LIMIT_GRANTED);
+    }
+    CHECK(rate_limiter_try_acquire(&limiter, 1, RATE_PRIORITY_NORMAL) != RATE_LIMIT_GRANTED);
+    sleep_ms(3);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) >= 2);
+    CHECK(rate_limiter_try_acquire(&limiter, 2, RATE_PRIORITY_NORMAL) == RATE_LIMIT_GRANTED);
+    sleep_ms(10);
+    CHECK(rate_limiter_remaining(&limiter, RATE_PRIORITY_NORMAL) == 5);   // Never above the pool size
+}
+
+static void test_endpoints(void) {
+    RateLimitPool pool;
+    uint32_t cost;
+    RateLimitPriority priority;
+
+    rate_limit_endpoint("private/buy", &pool, &cost, &priority);
+    CHECK(pool == RATE_POOL_MATCHING && priority == RATE_PRIORITY_NORMAL);
+    rate_limit_endpoint("private/edit_by_label", &pool, &cost, &priority);
+    CHECK(pool == RATE_POOL_MATCHING && priority == RATE_PRIORITY_NORMAL);
+    rate_limit_endpoint("private/cancel_all_by_instrument", &pool, &cost, &priority);
+    CHECK(pool == RATE_POOL_MATCHING && priority == RATE_PRIORITY_CANCEL);
+    rate_limit_endpoint("private/buyer", &pool, &cost, &priority);
+    CHECK(pool == RATE_POOL_NON_MATCHING);
+    rate_limit_endpoint("public/get_order_book", &pool, &cost, &priority);
+    CHECK(pool == RATE_POOL_NON_MATCHING && priority == RATE_PRIORITY_NORMAL);
+}
+
+static void test_admit(void) {
+    // Two orders' worth, one of them held for cancels; 10 ms per order to refill
+    CHECK(rate_limit_configure(RATE_POOL_MATCHING, 2000, 100000, 1000));
+    rate_limit_set_policy(RATE_LIMIT_REJECT, 0);
+    CHECK(rate_limit_admit("private/buy"));
+    CHECK(!rate_limit_configure(RATE_POOL_MATCHING, 4000, 100000, 1000));  // Fixed once in use
+    CHECK(!rate_limit_admit("private/sell"));
+    CHECK(rate_limit_admit("private/cancel"));
+    CHECK(rate_limit_admit("public/ticker"));          // Separate pool
+
+    rate_limit_set_enabled(false);
+    CHECK(rate_limit_admit("private/buy"));
+    rate_limit_set_enabled(true);
+
+    // Booking never waits; it reports the delay the caller must hold for
+    rate_limit_set_policy(RATE_LIMIT_QUEUE, 50 * NS_PER_MS);
+    uint64_t delay = rate_limit_book("private/buy");
+    CHECK(delay != RATE_LIMIT_GRANTED && delay != RATE_LIMIT_NEVER);
+    rate_limit_refund("private/buy");
+
+    // Queued admission sleeps until the booked slot
+    uint64_t start = now_ns();
+    CHECK(rate_limit_admit("private/buy"));
+    CHECK(now_ns() - start >= 5 * NS_PER_MS);
+    rate_limit_set_policy(RATE_LIMIT_REJECT, 0);
+}
+
+int main(void) {
+    test_init();
+    test_admit_and_reject();
+    test_queue();
+    test_release();
+    test_refill();
+    test_endpoints();
+    test_admit();
+    return CHECK_RESULT();
+}
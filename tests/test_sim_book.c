@@ -0,0 +1,159 @@
+// sim_book: queue position after deltas and trades under each queue model,
+// fills once the queue ahead is gone, multi-level market sweeps and market
+// orders that must not reach the book
+
+#include <math.h>
+#include <stdint.h>
+#include "check.h"
+#include "sim_book.h"
+
+#define TICK 0.5
+
+static bool near(double a, double b) {
+    return fabs(a - b) < 1e-9;
+}
+
+typedef struct {
+    int fills;
+    double filled;
+    double last_price;
+} FillLog;
+
+static void on_fill(const SimFill* fill, void* user_data) {
+    FillLog* log = user_data;
+    log->fills++;
+    log->filled += fill->amount;
+    log->last_price = fill->price;
+}
+
+typedef struct {
+    int batches;
+    SimFillBatch batch;
+    SimFillLevel levels[8];
+} BatchLog;
+
+static void on_batch(const SimFillBatch* batch, void* user_data) {
+    BatchLog* log = user_data;
+    log->batches++;
+    log->batch = *batch;
+    for (int i = 0; i < batch->level_count && i < 8; i++) {
+        log->levels[i] = batch->levels[i];
+    }
+}
+
+// 10 displayed ahead of our order, 4 more joining behind it; a trade of 2
+// then a delta down to 10 leaves 2 cancelled out of the 12 still resting
+static double queue_ahead_after_cancels(SimQueueModel model) {
+    SimBook book;
+    sim_book_init(&book, 1, TICK);
+    sim_book_set_queue_model(&book, model);
+
+    sim_book_apply_delta(&book, ORDER_SIDE_BUY, 100.0, 10.0);
+    uint64_t id = sim_book_place_post_only(&book, ORDER_SIDE_BUY, 100.0, 1.0);
+    CHECK(id != 0);
+    sim_book_apply_delta(&book, ORDER_SIDE_BUY, 100.0, 14.0);
+
+    SimOrder order;
+    CHECK(sim_book_get_order(&book, id, &order));
+    CHECK(near(order.queue_ahead, 10.0));
+
+    sim_book_apply_trade(&book, ORDER_SIDE_SELL, 100.0, 2.0);
+    CHECK(sim_book_get_order(&book, id, &order));
+    CHECK(near(order.queue_ahead, 8.0));
+
+    sim_book_apply_delta(&book, ORDER_SIDE_BUY, 100.0, 10.0);
+    CHECK(sim_book_get_order(&book, id, &order));
+    sim_book_free(&book);
+    return order.queue_ahead;
+}
+
+static void test_queue_models(void) {
+    CHECK(near(queue_ahead_after_cancels(SIM_QUEUE_PESSIMISTIC), 8.0));
+    CHECK(near(queue_ahead_after_cancels(SIM_QUEUE_PROPORTIONAL), 8.0 - 2.0 * 8.0 / 12.0));
+    CHECK(near(queue_ahead_after_cancels(SIM_QUEUE_OPTIMISTIC), 6.0));
+}
+
+static void test_fill_after_queue(void) {
+    SimBook book;
+    FillLog log = {0};
+    sim_book_init(&book, 1, TICK);
+    sim_book_set_fill_callback(&book, on_fill, &log);
+
+    sim_book_apply_delta(&book, ORDER_SIDE_SELL, 101.0, 3.0);
+    uint64_t id = sim_book_place_post_only(&book, ORDER_SIDE_SELL, 101.0, 2.0);
+    CHECK(sim_book_place_post_only(&book, ORDER_SIDE_BUY, 101.0, 1.0) == 0);   // Would cross
+
+    // The first 3 traded are the market volume ahead of us
+    sim_book_apply_trade(&book, ORDER_SIDE_BUY, 101.0, 3.0);
+    CHECK(log.fills == 0);
+    sim_book_apply_trade(&book, ORDER_SIDE_BUY, 101.0, 1.5);
+    CHECK(log.fills == 1 && near(log.filled, 1.5) && near(log.last_price, 101.0));
+
+    // A print through our price fills the rest
+    sim_book_apply_trade(&book, ORDER_SIDE_BUY, 101.5, 0.1);
+    CHECK(log.fills == 2 && near(log.filled, 2.0));
+    SimOrder order;
+    CHECK(!sim_book_get_order(&book, id, &order));
+    sim_book_free(&book);
+}
+
+static void test_sweep(void) {
+    SimBook book;
+    BatchLog log = {0};
+    sim_book_init(&book, 1, TICK);
+    sim_book_set_fill_batch_callback(&book, on_batch, &log);
+
+    sim_book_apply_delta(&book, ORDER_SIDE_SELL, 101.0, 1.0);
+    sim_book_apply_delta(&book, ORDER_SIDE_SELL, 101.5, 2.0);
+    sim_book_apply_delta(&book, ORDER_SIDE_SELL, 102.0, 3.0);
+
+    uint64_t id = 0;
+    CHECK(near(sim_book_execute_market(&book, ORDER_SIDE_BUY, 4.0, &id), 4.0));
+    CHECK(id != 0);
+    CHECK(log.batches == 1);
+    CHECK(log.batch.order_id == id);
+    CHECK(near(log.batch.requested, 4.0) && near(log.batch.filled, 4.0));
+    CHECK(near(log.batch.avg_price, (101.0 + 2 * 101.5 + 102.0) / 4.0));
+    CHECK(log.batch.level_count == 3);
+    CHECK(near(log.levels[0].price, 101.0) && near(log.levels[0].amount, 1.0));
+    CHECK(near(log.levels[1].price, 101.5) && near(log.levels[1].amount, 2.0));
+    CHECK(near(log.levels[2].price, 102.0) && near(log.levels[2].amount, 1.0));   // Worst
+
+    double price;
+    double amount;
+    CHECK(sim_book_best_ask(&book, &price, &amount));
+    CHECK(near(price, 102.0) && near(amount, 2.0));
+
+    // More than the book holds: the rest is cancelled
+    CHECK(near(sim_book_execute_market(&book, ORDER_SIDE_BUY, 5.0, NULL), 2.0));
+    CHECK(log.batches == 2 && near(log.batch.filled, 2.0) && log.batch.level_count == 1);
+    CHECK(!sim_book_best_ask(&book, &price, &amount));
+    sim_book_free(&book);
+}
+
+static void test_market_without_amount(void) {
+    SimBook book;
+    BatchLog log = {0};
+    sim_book_init(&book, 1, TICK);
+    sim_book_set_fill_batch_callback(&book, on_batch, &log);
+    sim_book_apply_delta(&book, ORDER_SIDE_BUY, 100.0, 5.0);
+
+    CHECK(sim_book_execute_market(&book, ORDER_SIDE_SELL, 0.0, NULL) == 0.0);
+    CHECK(sim_book_execute_market(&book, ORDER_SIDE_SELL, -1.0, NULL) == 0.0);
+    CHECK(sim_book_execute_market(&book, ORDER_SIDE_SELL, NAN, NULL) == 0.0);
+    CHECK(log.batches == 0);
+
+    double price;
+    double amount;
+    CHECK(sim_book_best_bid(&book, &price, &amount));
+    CHECK(near(amount, 5.0));
+    sim_book_free(&book);
+}
+
+int main(void) {
+    test_queue_models();
+    test_fill_after_queue();
+    test_sweep();
+    test_market_without_amount();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,168 @@
+// sim_engine: the merged output sequence does not depend on the shard count,
+// and every market order gets exactly one answer
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "check.h"
+#include "sim_engine.h"
+
+#define INSTRUMENTS 4
+#define MAX_RECORDS 1024
+#define MAX_MARKETS 64
+
+typedef struct {
+    SimOutputType type;
+    uint64_t seq;
+    int instrument_id;
+    uint64_t order_id;
+    uint64_t client_tag;
+    OrderSide side;
+    double price;
+    double amount;
+    int level_count;
+    double level_total;       // Sum of the level fills, must match amount
+} Record;
+
+typedef struct {
+    Record records[MAX_RECORDS];
+    int count;
+    uint64_t markets[MAX_MARKETS];
+    int market_count;
+} Run;
+
+static void on_output(const SimOutput* output, void* user_data) {
+    Run* run = user_data;
+    if (run->count == MAX_RECORDS) {
+        return;
+    }
+    Record* r = &run->records[run->count++];
+    memset(r, 0, sizeof(*r));
+    r->type = output->type;
+    r->seq = output->seq;
+    r->instrument_id = output->instrument_id;
+    r->order_id = output->order_id;
+    r->client_tag = output->client_tag;
+    r->side = output->side;
+    r->price = output->price;
+    r->amount = output->amount;
+    r->level_count = output->level_count;
+    if (output->type == SIM_OUTPUT_FILL_BATCH && output->levels) {
+        for (int i = 0; i < output->level_count; i++) {
+            r->level_total += output->levels[i].amount;
+        }
+    }
+}
+
+static void submit(SimEngine* engine, Run* run, SimInputType type, int instrument_id, OrderSide side,
+                   double price, double amount, uint64_t ts_ns) {
+    SimInput input = {
+        .type = type,
+        .instrument_id = instrument_id,
+        .side = side,
+        .price = price,
+        .amount = amount,
+        .client_tag = ts_ns,
+        .ts_ns = ts_ns
+    };
+    uint64_t seq = sim_engine_submit(engine, &input);
+    CHECK(seq != 0);
+    if (type == SIM_INPUT_MARKET && run->market_count < MAX_MARKETS) {
+        run->markets[run->market_count++] = seq;
+    }
+}
+
+static void run_scenario(int shard_count, Run* run) {
+    memset(run, 0, sizeof(*run));
+    SimEngine* engine = sim_engine_create(shard_count, 64);
+    CHECK(engine != NULL);
+    if (!engine) {
+        return;
+    }
+    for (int id = 1; id <= INSTRUMENTS; id++) {
+        CHECK(sim_engine_add_instrument(engine, id, 0.5, SIM_QUEUE_PROPORTIONAL));
+    }
+    sim_engine_set_echo_market_data(engine, true);
+    CHECK(sim_engine_start(engine));
+
+    uint64_t ts = 1000;
+    for (int round = 0; round < 3; round++) {
+        for (int id = 1; id <= INSTRUMENTS; id++) {
+            double mid = 100.0 * id + round;
+            submit(engine, run, SIM_INPUT_BOOK_DELTA, id, ORDER_SIDE_BUY, mid - 0.5, 5.0, ts++);
+            submit(engine, run, SIM_INPUT_BOOK_DELTA, id, ORDER_SIDE_SELL, mid + 0.5, 2.0, ts++);
+            submit(engine, run, SIM_INPUT_BOOK_DELTA, id, ORDER_SIDE_SELL, mid + 1.0, 3.0, ts++);
+            submit(engine, run, SIM_INPUT_PLACE, id, ORDER_SIDE_BUY, mid - 0.5, 1.0, ts++);
+            submit(engine, run, SIM_INPUT_TRADE, id, ORDER_SIDE_SELL, mid - 0.5, 5.5, ts++);
+            submit(engine, run, SIM_INPUT_MARKET, id, ORDER_SIDE_BUY, 0.0, 4.0, ts++);
+            submit(engine, run, SIM_INPUT_MARKET, id, ORDER_SIDE_SELL, 0.0, 0.0, ts++);
+            submit(engine, run, SIM_INPUT_MARKET, id, ORDER_SIDE_SELL, 0.0, NAN, ts++);
+            submit(engine, run, SIM_INPUT_BOOK_DELTA, id, ORDER_SIDE_SELL, mid + 1.0, 0.0, ts++);
+            submit(engine, run, SIM_INPUT_BOOK_DELTA, id, ORDER_SIDE_BUY, mid - 0.5, 0.0, ts++);
+        }
+        // Nothing resting on the bid any more; the book answers with a reject
+        submit(engine, run, SIM_INPUT_MARKET, 1, ORDER_SIDE_SELL, 0.0, 1.0, ts++);
+        submit(engine, run, SIM_INPUT_MARKET, 99, ORDER_SIDE_BUY, 0.0, 1.0, ts++);   // Unknown instrument
+        submit(engine, run, SIM_INPUT_CANCEL, 2, ORDER_SIDE_BUY, 0.0, 0.0, ts++);
+    }
+
+    sim_engine_drain(engine, on_output, run);
+    sim_engine_destroy(engine);
+}
+
+// The rejected NaN order echoes its amount back
+static bool same_value(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static bool same_record(const Record* a, const Record* b) {
+    return a->type == b->type && a->seq == b->seq && a->instrument_id == b->instrument_id &&
+           a->order_id == b->order_id && a->client_tag == b->client_tag && a->side == b->side &&
+           same_value(a->price, b->price) && same_value(a->amount, b->amount) &&
+           a->level_count == b->level_count && a->level_total == b->level_total;
+}
+
+static void test_shard_count_invariance(void) {
+    static Run single;
+    static Run sharded;
+    run_scenario(1, &single);
+    run_scenario(3, &sharded);
+
+    CHECK(single.count > 0 && single.count < MAX_RECORDS);
+    CHECK(single.count == sharded.count);
+    int mismatches = 0;
+    for (int i = 0; i < single.count && i < sharded.count; i++) {
+        mismatches += !same_record(&single.records[i], &sharded.records[i]);
+    }
+    CHECK(mismatches == 0);
+
+    // Merged in input order
+    for (int i = 1; i < single.count; i++) {
+        CHECK(single.records[i - 1].seq <= single.records[i].seq);
+    }
+
+    // One fill batch or reject per market order; batches list every level
+    int batches = 0;
+    for (int m = 0; m < single.market_count; m++) {
+        int answers = 0;
+        for (int i = 0; i < single.count; i++) {
+            const Record* r = &single.records[i];
+            if (r->seq != single.markets[m]) {
+                continue;
+            }
+            if (r->type == SIM_OUTPUT_FILL_BATCH) {
+                batches++;
+                CHECK(r->level_count == 2);
+                CHECK(fabs(r->level_total - r->amount) < 1e-9);
+            }
+            answers += r->type == SIM_OUTPUT_FILL_BATCH || r->type == SIM_OUTPUT_REJECT;
+        }
+        CHECK(answers == 1);
+    }
+    CHECK(batches == 3 * INSTRUMENTS);
+}
+
+int main(void) {
+    test_shard_count_invariance();
+    return CHECK_RESULT();
+}
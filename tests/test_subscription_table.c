@@ -0,0 +1,207 @@
+// subscription_table: add/find/remove against a reference model, the probe
+// invariant after backward-shift deletion, instrument interning and book
+// sequence tracking
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "subscription_table.h"
+
+#define NAME_COUNT 600
+
+static char names[NAME_COUNT][SUBSCRIPTION_CHANNEL_SIZE];
+static bool present[NAME_COUNT];
+
+// Every occupied slot must be reachable from its home slot without crossing
+// an empty one, and every entry must be referenced by exactly one slot
+static bool table_consistent(const SubscriptionTable* table) {
+    uint32_t slot_count = table->slot_mask + 1;
+    uint32_t referenced = 0;
+    for (uint32_t slot = 0; slot < slot_count; slot++) {
+        if (table->slots[slot] == 0) {
+            continue;
+        }
+        uint32_t index = (uint32_t)table->slots[slot] - 1;
+        if (index >= table->count) {
+            return false;
+        }
+        referenced++;
+        for (uint32_t probe = (uint32_t)table->entries[index].hash & table->slot_mask; probe != slot;
+             probe = (probe + 1) & table->slot_mask) {
+            if (table->slots[probe] == 0) {
+                return false;
+            }
+        }
+    }
+    return referenced == table->count;
+}
+
+static bool matches_model(const SubscriptionTable* table) {
+    uint32_t expected = 0;
+    for (int i = 0; i < NAME_COUNT; i++) {
+        Subscription* sub = subscription_table_find(table, names[i], strlen(names[i]));
+        if ((sub != NULL) != present[i] || (sub && strcmp(sub->channel, names[i]) != 0)) {
+            return false;
+        }
+        expected += present[i];
+    }
+    return table->count == expected;
+}
+
+static void test_model(void) {
+    SubscriptionTable table;
+    CHECK(subscription_table_init(&table, 4));
+    for (int i = 0; i < NAME_COUNT; i++) {
+        snprintf(names[i], sizeof(names[i]), "book.SYN%04d-PERPETUAL.100ms", i);
+        present[i] = false;
+    }
+
+    // Random adds and removes through several growths; long probe runs make
+    // backward shifts wrap around the end of the slot array
+    unsigned int seed = 12345;
+    bool consistent = true;
+    bool model = true;
+    for (int step = 0; step < 20000; step++) {
+        int i = rand_r(&seed) % NAME_COUNT;
+        if (rand_r(&seed) % 3 != 0) {
+            bool added = false;
+            Subscription* sub = subscription_table_add(&table, names[i], &added);
+            CHECK(sub != NULL);
+            CHECK(added == !present[i]);
+            present[i] = true;
+        } else {
+            CHECK(subscription_table_remove(&table, names[i]) == present[i]);
+            present[i] = false;
+        }
+        if (step % 97 == 0) {
+            consistent &= table_consistent(&table);
+            model &= matches_model(&table);
+        }
+    }
+    CHECK(consistent);
+    CHECK(model);
+
+    // Draining the table in random order leaves no stale slot behind
+    for (int step = 0; step < NAME_COUNT; step++) {
+        int i = (step * 7919) % NAME_COUNT;
+        CHECK(subscription_table_remove(&table, names[i]) == present[i]);
+        present[i] = false;
+        consistent &= table_consistent(&table);
+    }
+    CHECK(consistent);
+    CHECK(table.count == 0);
+    for (uint32_t slot = 0; slot <= table.slot_mask; slot++) {
+        CHECK(table.slots[slot] == 0);
+    }
+    subscription_table_free(&table);
+}
+
+// Entries colliding on their home slot: removing the head of the run must
+// pull the others back so they are still found
+static void test_collisions(void) {
+    SubscriptionTable table;
+    CHECK(subscription_table_init(&table, 16));
+    uint32_t mask = table.slot_mask;
+
+    char colliding[6][SUBSCRIPTION_CHANNEL_SIZE];
+    int found = 0;
+    uint32_t home = 0;
+    for (int i = 0; found < 6 && i < 100000; i++) {
+        char name[SUBSCRIPTION_CHANNEL_SIZE];
+        snprintf(name, sizeof(name), "trades.X%d.raw", i);
+        uint32_t slot = (uint32_t)subscription_channel_hash(name, strlen(name)) & mask;
+        if (found == 0) {
+            home = slot;
+        }
+        if (slot == home) {
+            strcpy(colliding[found++], name);
+        }
+    }
+    CHECK(found == 6);
+    for (int i = 0; i < found; i++) {
+        CHECK(subscription_table_add(&table, colliding[i], NULL) != NULL);
+    }
+    CHECK(subscription_table_remove(&table, colliding[0]));
+    CHECK(subscription_table_remove(&table, colliding[3]));
+    CHECK(table_consistent(&table));
+    for (int i = 0; i < found; i++) {
+        bool expected = i != 0 && i != 3;
+        CHECK((subscription_table_find(&table, colliding[i], strlen(colliding[i])) != NULL) == expected);
+    }
+    CHECK(!subscription_table_remove(&table, colliding[0]));
+    subscription_table_free(&table);
+}
+
+static void test_lookup_and_limits(void) {
+    SubscriptionTable table;
+    CHECK(subscription_table_init(&table, 0));
+
+    // Lookup takes a length, so a channel can be matched inside a message
+    const char* message = "\"channel\":\"ticker.BTC-PERPETUAL.raw\",\"data\"";
+    CHECK(subscription_table_add(&table, "ticker.BTC-PERPETUAL.raw", NULL) != NULL);
+    CHECK(subscription_table_find(&table, message + 11, 24) != NULL);
+    CHECK(subscription_table_find(&table, message + 11, 23) == NULL);
+
+    char long_name[SUBSCRIPTION_CHANNEL_SIZE + 1];
+    memset(long_name, 'a', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    CHECK(subscription_table_add(&table, long_name, NULL) == NULL);
+    CHECK(subscription_table_add(&table, "", NULL) == NULL);
+
+    subscription_table_clear(&table);
+    CHECK(table.count == 0);
+    CHECK(subscription_table_find(&table, "ticker.BTC-PERPETUAL.raw", 24) == NULL);
+    subscription_table_free(&table);
+}
+
+static void test_instruments(void) {
+    SubscriptionTable table;
+    CHECK(subscription_table_init(&table, 0));
+
+    Subscription* book = subscription_table_add(&table, "book.BTC-PERPETUAL.100ms", NULL);
+    uint32_t btc = book->instrument_id;
+    CHECK(strcmp(subscription_table_instrument_name(&table, btc), "BTC-PERPETUAL") == 0);
+    CHECK(subscription_table_add(&table, "user.orders.BTC-PERPETUAL.raw", NULL)->instrument_id == btc);
+    CHECK(strcmp(subscription_table_instrument_name(&table,
+        subscription_table_add(&table, "deribit_price_index.btc_usd", NULL)->instrument_id), "btc_usd") == 0);
+    CHECK(subscription_table_add(&table, "announcements", NULL)->instrument_id == SUBSCRIPTION_NO_INSTRUMENT);
+
+    // Ids survive the channels that introduced them and table growth
+    subscription_table_remove(&table, "book.BTC-PERPETUAL.100ms");
+    for (int i = 0; i < 100; i++) {
+        char name[SUBSCRIPTION_CHANNEL_SIZE];
+        snprintf(name, sizeof(name), "book.SYN%04d-PERPETUAL.100ms", i);
+        subscription_table_add(&table, name, NULL);
+    }
+    CHECK(subscription_table_instrument_id(&table, "BTC-PERPETUAL", 13) == btc);
+    CHECK(strcmp(subscription_table_instrument_name(&table, btc), "BTC-PERPETUAL") == 0);
+    subscription_table_free(&table);
+}
+
+static void test_sequence(void) {
+    SubscriptionTable table;
+    CHECK(subscription_table_init(&table, 0));
+    Subscription* sub = subscription_table_add(&table, "book.BTC-PERPETUAL.100ms", NULL);
+
+    subscription_track_sequence(sub, "{\"type\":\"snapshot\",\"change_id\":100}");
+    subscription_track_sequence(sub, "{\"prev_change_id\":100,\"change_id\":101}");
+    CHECK(sub->sequence_gaps == 0);
+    subscription_track_sequence(sub, "{\"prev_change_id\":105,\"change_id\":106}");
+    CHECK(sub->sequence_gaps == 1);
+    CHECK(sub->last_sequence == 106);
+
+    Subscription* trades = subscription_table_add(&table, "trades.BTC-PERPETUAL.raw", NULL);
+    subscription_track_sequence(trades, "{\"prev_change_id\":1,\"change_id\":2}");
+    CHECK(trades->last_sequence == 0);
+    subscription_table_free(&table);
+}
+
+int main(void) {
+    test_model();
+    test_collisions();
+    test_lookup_and_limits();
+    test_instruments();
+    test_sequence();
+    return CHECK_RESULT();
+}
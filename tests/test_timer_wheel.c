@@ -0,0 +1,202 @@
+// timer_wheel: firing times, timers more than a full turn out sharing slots
+// with near ones, large jumps, re-arming and cancelling from callbacks, and
+// the epoll timeout bound
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "check.h"
+#include "timer_wheel.h"
+
+#define TICK_MS 10
+#define TURN_MS ((uint64_t)TIMER_WHEEL_SLOTS * TICK_MS)
+
+typedef struct {
+    int fired;
+    uint64_t fired_at;
+    uint64_t expected_at;
+    bool early;
+    TimerWheel* wheel;
+    Timer* other;              // Cancelled by the callback when set
+    uint64_t rearm_ms;         // Re-armed this far ahead when non-zero
+} Probe;
+
+static void on_timer(Timer* timer, uint64_t now_ms, void* user_data) {
+    Probe* probe = user_data;
+    probe->fired++;
+    probe->fired_at = now_ms;
+    probe->early |= now_ms < timer->expires_ms;
+    if (probe->other) {
+        timer_wheel_cancel(probe->wheel, probe->other);
+    }
+    if (probe->rearm_ms) {
+        timer_wheel_schedule(probe->wheel, timer, now_ms + probe->rearm_ms);
+    }
+}
+
+static void test_fires_when_due(void) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 1000);
+    Probe probe = {0};
+    Timer timer;
+    timer_init(&timer, on_timer, &probe);
+    CHECK(!timer_armed(&timer));
+
+    timer_wheel_schedule(&wheel, &timer, 1015);     // Mid-tick
+    CHECK(timer_armed(&timer));
+    CHECK(timer_wheel_advance(&wheel, 1010) == 0);
+    CHECK(timer_wheel_advance(&wheel, 1014) == 0);
+    CHECK(timer_wheel_advance(&wheel, 1015) == 1);
+    CHECK(probe.fired == 1 && !timer_armed(&timer));
+    CHECK(wheel.armed == 0);
+
+    // Already expired: fires on the next advance
+    timer_wheel_schedule(&wheel, &timer, 500);
+    CHECK(timer_wheel_advance(&wheel, 1016) == 1);
+
+    timer_wheel_schedule(&wheel, &timer, 2000);
+    timer_wheel_cancel(&wheel, &timer);
+    timer_wheel_cancel(&wheel, &timer);              // Idempotent
+    CHECK(timer_wheel_advance(&wheel, 3000) == 0);
+    CHECK(probe.fired == 2 && wheel.armed == 0);
+}
+
+// A timer several turns out lands in a slot the wheel passes many times;
+// it must be skipped on each pass and fire only when due
+static void test_beyond_one_turn(void) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 0);
+    Probe near = {0};
+    Probe far = {0};
+    Timer near_timer;
+    Timer far_timer;
+    timer_init(&near_timer, on_timer, &near);
+    timer_init(&far_timer, on_timer, &far);
+
+    uint64_t far_at = 3 * TURN_MS + 50;
+    timer_wheel_schedule(&wheel, &far_timer, far_at);
+    timer_wheel_schedule(&wheel, &near_timer, 50);  // Same slot, three turns earlier
+
+    for (uint64_t now = TICK_MS; now <= 4 * TURN_MS; now += TICK_MS) {
+        timer_wheel_advance(&wheel, now);
+        if (now < far_at) {
+            CHECK(far.fired == 0);
+        }
+    }
+    CHECK(near.fired == 1 && near.fired_at == 50);
+    CHECK(far.fired == 1 && far.fired_at == far_at);
+}
+
+// Advancing by more than a turn at once fires everything due, once
+static void test_large_jump(void) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 0);
+    Probe probes[TIMER_WHEEL_SLOTS];
+    Timer timers[TIMER_WHEEL_SLOTS];
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        probes[i] = (Probe){0};
+        timer_init(&timers[i], on_timer, &probes[i]);
+        timer_wheel_schedule(&wheel, &timers[i], (uint64_t)i * TICK_MS * 3 + 1);
+    }
+    uint64_t now = 2 * TURN_MS;
+    int fired = timer_wheel_advance(&wheel, now);
+    int due = 0;
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        bool should = (uint64_t)i * TICK_MS * 3 + 1 <= now;
+        due += should;
+        CHECK(probes[i].fired == (should ? 1 : 0));
+    }
+    CHECK(fired == due);
+    CHECK(timer_wheel_advance(&wheel, 4 * TURN_MS) == TIMER_WHEEL_SLOTS - due);
+    CHECK(wheel.armed == 0);
+}
+
+static void test_callbacks(void) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 0);
+
+    // Re-arming into the slot being scanned waits for the next advance
+    Probe periodic = {.wheel = &wheel, .rearm_ms = 1};
+    Timer periodic_timer;
+    timer_init(&periodic_timer, on_timer, &periodic);
+    timer_wheel_schedule(&wheel, &periodic_timer, 5);
+    CHECK(timer_wheel_advance(&wheel, 5) == 1);
+    CHECK(timer_armed(&periodic_timer));
+    CHECK(timer_wheel_advance(&wheel, 6) == 1);
+    CHECK(periodic.fired == 2);
+    timer_wheel_cancel(&wheel, &periodic_timer);
+
+    // Two timers due in the same advance, each cancelling the other: whichever
+    // runs first must stop the second
+    Timer first_timer;
+    Timer second_timer;
+    Probe first = {.wheel = &wheel, .other = &second_timer};
+    Probe second = {.wheel = &wheel, .other = &first_timer};
+    timer_init(&first_timer, on_timer, &first);
+    timer_init(&second_timer, on_timer, &second);
+    timer_wheel_schedule(&wheel, &first_timer, 20);
+    timer_wheel_schedule(&wheel, &second_timer, 20);
+    CHECK(timer_wheel_advance(&wheel, 20) == 1);
+    CHECK(first.fired + second.fired == 1);
+    CHECK(!timer_armed(&first_timer) && !timer_armed(&second_timer) && wheel.armed == 0);
+}
+
+static void test_timeout(void) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 0);
+    CHECK(timer_wheel_timeout_ms(&wheel, 0, 100) == 100);
+
+    Probe probe = {0};
+    Timer timer;
+    Timer far_timer;
+    timer_init(&timer, on_timer, &probe);
+    timer_init(&far_timer, on_timer, &probe);
+    timer_wheel_schedule(&wheel, &far_timer, TURN_MS + 30);   // Shares the slot of tick 3
+    CHECK(timer_wheel_timeout_ms(&wheel, 0, 100) == 100);
+    timer_wheel_schedule(&wheel, &timer, 42);
+    CHECK(timer_wheel_timeout_ms(&wheel, 0, 100) == 42);
+    CHECK(timer_wheel_timeout_ms(&wheel, 0, 20) == 20);
+    CHECK(timer_wheel_timeout_ms(&wheel, 50, 100) == 0);
+}
+
+// Random timers and advances against a model: each fires exactly once, at
+// the first advance at or past its expiry
+static void test_random(void) {
+    enum { COUNT = 2000 };
+    static Probe probes[COUNT];
+    static Timer timers[COUNT];
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, TICK_MS, 0);
+    unsigned int seed = 42;
+    uint64_t now = 0;
+    for (int i = 0; i < COUNT; i++) {
+        probes[i] = (Probe){0};
+        probes[i].expected_at = (uint64_t)(rand_r(&seed) % (int)(5 * TURN_MS));
+        timer_init(&timers[i], on_timer, &probes[i]);
+        timer_wheel_schedule(&wheel, &timers[i], probes[i].expected_at);
+    }
+
+    bool exact = true;
+    while (wheel.armed > 0) {
+        uint64_t previous = now;
+        now += (uint64_t)(rand_r(&seed) % (int)(TURN_MS / 2)) + 1;
+        timer_wheel_advance(&wheel, now);
+        for (int i = 0; i < COUNT; i++) {
+            bool due = probes[i].expected_at <= now;
+            bool newly_due = due && probes[i].expected_at > previous;
+            exact &= probes[i].fired == (due ? 1 : 0);
+            exact &= !newly_due || probes[i].fired_at == now;
+            exact &= !probes[i].early;
+        }
+    }
+    CHECK(exact);
+}
+
+int main(void) {
+    test_fires_when_due();
+    test_beyond_one_turn();
+    test_large_jump();
+    test_callbacks();
+    test_timeout();
+    test_random();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,125 @@
+// ws_frame: header encode/decode round trips, partial and malformed headers,
+// payload masking and the handshake accept key
+
+#include <stdint.h>
+#include <string.h>
+#include "check.h"
+#include "ws_frame.h"
+
+static void test_header_round_trip(void) {
+    const uint64_t lengths[] = {0, 1, 125, 126, 127, 0xffff, 0x10000, 0x100000000ULL};
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (int masked = 0; masked < 2; masked++) {
+            uint8_t buffer[WS_FRAME_MAX_HEADER];
+            size_t written = ws_frame_write_header(buffer, WS_OP_BINARY, masked == 0, masked == 1,
+                                                   lengths[i], masked ? mask : NULL);
+            size_t expected = (lengths[i] < 126 ? 2 : lengths[i] <= 0xffff ? 4 : 10) + (masked ? 4 : 0);
+            CHECK(written == expected);
+
+            WsFrameHeader header;
+            CHECK(ws_frame_parse_header(buffer, written, &header) == 1);
+            CHECK(header.header_length == written);
+            CHECK(header.payload_length == lengths[i]);
+            CHECK(header.opcode == WS_OP_BINARY);
+            CHECK(header.fin == (masked == 0));
+            CHECK(header.rsv1 == (masked == 1));
+            CHECK(header.masked == (masked == 1));
+            CHECK(!masked || memcmp(header.mask, mask, 4) == 0);
+
+            // Every strict prefix asks for more bytes
+            for (size_t prefix = 0; prefix < written; prefix++) {
+                CHECK(ws_frame_parse_header(buffer, prefix, &header) == 0);
+            }
+        }
+    }
+}
+
+static void test_protocol_errors(void) {
+    WsFrameHeader header;
+
+    const uint8_t rsv2[] = {0xa1, 0x00};                    // FIN, RSV2, text
+    CHECK(ws_frame_parse_header(rsv2, sizeof(rsv2), &header) == -1);
+
+    const uint8_t reserved_opcode[] = {0x83, 0x00};
+    CHECK(ws_frame_parse_header(reserved_opcode, sizeof(reserved_opcode), &header) == -1);
+
+    const uint8_t fragmented_ping[] = {0x09, 0x00};         // Control frames must not be fragmented
+    CHECK(ws_frame_parse_header(fragmented_ping, sizeof(fragmented_ping), &header) == -1);
+
+    const uint8_t long_close[] = {0x88, 126, 0x00, 126};    // Control payloads are at most 125 bytes
+    CHECK(ws_frame_parse_header(long_close, sizeof(long_close), &header) == -1);
+
+    const uint8_t huge[] = {0x82, 127, 0x80, 0, 0, 0, 0, 0, 0, 0};
+    CHECK(ws_frame_parse_header(huge, sizeof(huge), &header) == -1);
+
+    const uint8_t max_ping[] = {0x89, 125};
+    CHECK(ws_frame_parse_header(max_ping, sizeof(max_ping), &header) == 1);
+}
+
+static void naive_mask(uint8_t* data, size_t length, const uint8_t mask[4], size_t offset) {
+    for (size_t i = 0; i < length; i++) {
+        data[i] ^= mask[(offset + i) % 4];
+    }
+}
+
+static void test_masking(void) {
+    const uint8_t mask[4] = {0xa5, 0x3c, 0x0f, 0xf0};
+    uint8_t original[64];
+    for (size_t i = 0; i < sizeof(original); i++) {
+        original[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    // The word-at-a-time path matches byte-wise XOR at every length and offset
+    for (size_t length = 0; length <= sizeof(original); length++) {
+        for (size_t offset = 0; offset < 8; offset++) {
+            uint8_t fast[64];
+            uint8_t slow[64];
+            memcpy(fast, original, length);
+            memcpy(slow, original, length);
+            ws_frame_apply_mask(fast, length, mask, offset);
+            naive_mask(slow, length, mask, offset);
+            CHECK(memcmp(fast, slow, length) == 0);
+
+            ws_frame_apply_mask(fast, length, mask, offset);
+            CHECK(memcmp(fast, original, length) == 0);
+        }
+    }
+
+    // Unmasking in pieces, as reads arrive, equals unmasking the whole payload
+    uint8_t whole[64];
+    uint8_t pieces[64];
+    memcpy(whole, original, sizeof(whole));
+    memcpy(pieces, original, sizeof(pieces));
+    ws_frame_apply_mask(whole, sizeof(whole), mask, 0);
+    const size_t cuts[] = {0, 3, 4, 13, 30, 31, 64};
+    for (size_t i = 0; i + 1 < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        ws_frame_apply_mask(pieces + cuts[i], cuts[i + 1] - cuts[i], mask, cuts[i]);
+    }
+    CHECK(memcmp(whole, pieces, sizeof(whole)) == 0);
+}
+
+static void test_handshake(void) {
+    // RFC 6455 section 1.3
+    char accept[WS_ACCEPT_KEY_SIZE];
+    ws_frame_accept_key("dGhlIHNhbXBsZSBub25jZQ==", accept);
+    CHECK(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+
+    // RFC 4648 section 10
+    const char* inputs[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* outputs[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        char encoded[16];
+        ws_frame_base64((const uint8_t*)inputs[i], strlen(inputs[i]), encoded);
+        CHECK(strcmp(encoded, outputs[i]) == 0);
+    }
+}
+
+int main(void) {
+    test_header_round_trip();
+    test_protocol_errors();
+    test_masking();
+    test_handshake();
+    return CHECK_RESULT();
+}
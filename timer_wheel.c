@@ -0,0 +1,116 @@
+#include <string.h>
+#include "timer_wheel.h"
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static void link_timer(Timer** head, Timer* timer) {
+    timer->next = *head;
+    if (*head) {
+        (*head)->prev_next = &timer->next;
+    }
+    *head = timer;
+    timer->prev_next = head;
+}
+
+static void unlink_timer(Timer* timer) {
+    *timer->prev_next = timer->next;
+    if (timer->next) {
+        timer->next->prev_next = timer->prev_next;
+    }
+    timer->next = NULL;
+    timer->prev_next = NULL;
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint32_t tick_ms, uint64_t now_ms) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->current_tick = now_ms / wheel->tick_ms;
+}
+
+void timer_init(Timer* timer, TimerCallback callback, void* user_data) {
+    memset(timer, 0, sizeof(*timer));
+    timer->callback = callback;
+    timer->user_data = user_data;
+}
+
+bool timer_armed(const Timer* timer) {
+    return timer->prev_next != NULL;
+}
+
+void timer_wheel_schedule(TimerWheel* wheel, Timer* timer, uint64_t expires_ms) {
+    timer_wheel_cancel(wheel, timer);
+    uint64_t tick = expires_ms / wheel->tick_ms;
+    if (tick < wheel->current_tick) {
+        tick = wheel->current_tick;
+    }
+    timer->expires_ms = expires_ms;
+    link_timer(&wheel->slots[tick & TIMER_WHEEL_MASK], timer);
+    wheel->armed++;
+}
+
+void timer_wheel_cancel(TimerWheel* wheel, Timer* timer) {
+    if (timer->prev_next) {
+        unlink_timer(timer);
+        wheel->armed--;
+    }
+}
+
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms) {
+    uint64_t now_tick = now_ms / wheel->tick_ms;
+    if (wheel->armed == 0 || now_tick < wheel->current_tick) {
+        if (now_tick > wheel->current_tick) {
+            wheel->current_tick = now_tick;
+        }
+        return 0;
+    }
+
+    // Move due timers to a private list first, so callbacks can re-arm into
+    // the slots being scanned
+    uint64_t first = wheel->current_tick;
+    if (now_tick - first >= TIMER_WHEEL_SLOTS) {
+        first = now_tick - TIMER_WHEEL_SLOTS + 1;
+    }
+    Timer* due = NULL;
+    for (uint64_t tick = first; tick <= now_tick; tick++) {
+        Timer** link = &wheel->slots[tick & TIMER_WHEEL_MASK];
+        while (*link) {
+            Timer* timer = *link;
+            if (timer->expires_ms <= now_ms) {
+                unlink_timer(timer);
+                link_timer(&due, timer);
+            } else {
+                link = &timer->next;
+            }
+        }
+    }
+    wheel->current_tick = now_tick;
+
+    int fired = 0;
+    while (due) {
+        Timer* timer = due;
+        unlink_timer(timer);
+        wheel->armed--;
+        timer->callback(timer, now_ms, timer->user_data);
+        fired++;
+    }
+    return fired;
+}
+
+int timer_wheel_timeout_ms(const TimerWheel* wheel, uint64_t now_ms, int max_ms) {
+    if (wheel->armed == 0 || max_ms <= 0) {
+        return max_ms;
+    }
+    uint64_t earliest = now_ms + (uint64_t)max_ms;
+    uint64_t last = earliest / wheel->tick_ms;
+    if (last - wheel->current_tick >= TIMER_WHEEL_SLOTS) {
+        last = wheel->current_tick + TIMER_WHEEL_SLOTS - 1;
+    }
+    for (uint64_t tick = wheel->current_tick; tick <= last; tick++) {
+        for (const Timer* timer = wheel->slots[tick & TIMER_WHEEL_MASK]; timer; timer = timer->next) {
+            if (timer->expires_ms < earliest) {
+                earliest = timer->expires_ms;
+            }
+        }
+    }
+    return earliest <= now_ms ? 0 : (int)(earliest - now_ms);
+}
@@ -0,0 +1,59 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hashed timing wheel for connection housekeeping (pings, liveness and
+// heartbeat deadlines). Timers are embedded in their owner, so arming,
+// re-arming and cancelling are O(1) with no allocation. A timer lands in the
+// slot of its expiry tick; ones further out than a full turn share the slot
+// and are skipped until due. Single-threaded: one wheel per event loop.
+
+#define TIMER_WHEEL_SLOTS 256           // Power of two
+
+typedef struct Timer Timer;
+
+// Runs from timer_wheel_advance; may re-arm or cancel any timer, itself included
+typedef void (*TimerCallback)(Timer* timer, uint64_t now_ms, void* user_data);
+
+struct Timer {
+    Timer* next;
+    Timer** prev_next;                  // Pointer that links to this timer; NULL when idle
+    uint64_t expires_ms;
+    TimerCallback callback;
+    void* user_data;
+};
+
+typedef struct {
+    Timer* slots[TIMER_WHEEL_SLOTS];
+    uint32_t tick_ms;
+    uint64_t current_tick;              // Last tick advanced to; its slot is scanned again
+    uint32_t armed;
+} TimerWheel;
+
+void timer_wheel_init(TimerWheel* wheel, uint32_t tick_ms, uint64_t now_ms);
+
+void timer_init(Timer* timer, TimerCallback callback, void* user_data);
+bool timer_armed(const Timer* timer);
+
+// Arm (or move) a timer; expiries in the past fire on the next advance
+void timer_wheel_schedule(TimerWheel* wheel, Timer* timer, uint64_t expires_ms);
+void timer_wheel_cancel(TimerWheel* wheel, Timer* timer);
+
+// Fire every timer due by now_ms; returns how many fired
+int timer_wheel_advance(TimerWheel* wheel, uint64_t now_ms);
+
+// Milliseconds until the next timer is due, capped at max_ms, for bounding
+// epoll_wait; only the slots within max_ms are looked at
+int timer_wheel_timeout_ms(const TimerWheel* wheel, uint64_t now_ms, int max_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMER_WHEEL_H
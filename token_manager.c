@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "deribit_api.h"
+#include "token_manager.h"
+
+#define DEFAULT_REFRESH_MARGIN 60
+#define MIN_REFRESH_DELAY 1
+#define MAX_RETRY_DELAY 30
+
+// Seqlock: the refresher makes token_sequence odd while it rewrites the token;
+// readers copy it out and retry if the sequence moved. Zero means no token yet.
+static char current_token[DERIBIT_TOKEN_SIZE];
+static uint32_t token_sequence = 0;
+static int64_t token_expires_at = 0;
+
+static char manager_client_id[256];
+static char manager_client_secret[256];
+static char manager_refresh_token[DERIBIT_TOKEN_SIZE];
+static int manager_margin = DEFAULT_REFRESH_MARGIN;
+
+static pthread_t refresh_thread;
+static pthread_mutex_t manager_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t manager_wakeup;
+static bool thread_running = false;
+static bool stop_requested = false;
+static bool refresh_requested = false;
+
+static uint64_t refresh_count = 0;
+static uint64_t failure_count = 0;
+
+static int64_t wall_seconds(void) {
+    return (int64_t)time(NULL);
+}
+
+// A token that expires within the refresh margin would be renewed in a tight loop
+static bool check_lifetime(const DeribitAuthResult* auth, char* reason, size_t reason_size) {
+    if (auth->expires_in <= manager_margin) {
+        snprintf(reason, reason_size, "token lifetime %d s is within the %d s refresh margin",
+                 auth->expires_in, manager_margin);
+        return false;
+    }
+    return true;
+}
+
+// Replace the current token under the seqlock
+static void publish_token(const DeribitAuthResult* auth) {
+    uint32_t sequence = __atomic_load_n(&token_sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&token_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    snprintf(current_token, sizeof(current_token), "%s", auth->access_token);
+    __atomic_store_n(&token_sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    if (auth->refresh_token[0]) {
+        snprintf(manager_refresh_token, sizeof(manager_refresh_token), "%s", auth->refresh_token);
+    }
+    __atomic_store_n(&token_expires_at, wall_seconds() + auth->expires_in, __ATOMIC_RELAXED);
+}
+
+// Renew with the refresh token, falling back to the client credentials
+static bool renew_token(char* reason, size_t reason_size) {
+    DeribitAuthResult auth;
+    bool ok = manager_refresh_token[0] && deribit_refresh_token(manager_refresh_token, &auth);
+    if (!ok) {
+        ok = deribit_authenticate(manager_client_id, manager_client_secret, &auth);
+    }
+    if (!ok) {
+        snprintf(reason, reason_size, "%s", get_last_error().message);
+        return false;
+    }
+    if (!check_lifetime(&auth, reason, reason_size)) {
+        return false;
+    }
+    publish_token(&auth);
+    return true;
+}
+
+// Seconds to wait before the next refresh of a token expiring at expires_at
+static int refresh_delay(int64_t expires_at) {
+    int64_t delay = expires_at - manager_margin - wall_seconds();
+    return delay < MIN_REFRESH_DELAY ? MIN_REFRESH_DELAY : (int)delay;
+}
+
+static void* refresh_loop(void* arg) {
+    (void)arg;
+    int delay = refresh_delay(__atomic_load_n(&token_expires_at, __ATOMIC_RELAXED));
+    int retry_delay = MIN_REFRESH_DELAY;
+
+    pthread_mutex_lock(&manager_lock);
+    while (!stop_requested) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += delay;
+        while (!stop_requested && !refresh_requested) {
+            if (pthread_cond_timedwait(&manager_wakeup, &manager_lock, &deadline) != 0) {
+                break;
+            }
+        }
+        if (stop_requested) {
+            break;
+        }
+        refresh_requested = false;
+        pthread_mutex_unlock(&manager_lock);
+
+        char reason[256];
+        bool ok = renew_token(reason, sizeof(reason));
+        if (ok) {
+            __atomic_fetch_add(&refresh_count, 1, __ATOMIC_RELAXED);
+            delay = refresh_delay(__atomic_load_n(&token_expires_at, __ATOMIC_RELAXED));
+            retry_delay = MIN_REFRESH_DELAY;
+        } else {
+            __atomic_fetch_add(&failure_count, 1, __ATOMIC_RELAXED);
+            printf("Token refresh failed: %s (retrying in %d s)\n", reason, retry_delay);
+            delay = retry_delay;
+            retry_delay = retry_delay * 2 > MAX_RETRY_DELAY ? MAX_RETRY_DELAY : retry_delay * 2;
+        }
+
+        pthread_mutex_lock(&manager_lock);
+    }
+    pthread_mutex_unlock(&manager_lock);
+
+    deribit_transport_thread_cleanup();
+    return NULL;
+}
+
+bool token_manager_start(const char* client_id, const char* client_secret, int refresh_margin_sec) {
+    if (!client_id || !client_secret ||
+        strlen(client_id) >= sizeof(manager_client_id) || strlen(client_secret) >= sizeof(manager_client_secret)) {
+        printf("Invalid token manager credentials\n");
+        return false;
+    }
+    if (thread_running) {
+        return true;
+    }
+
+    strcpy(manager_client_id, client_id);
+    strcpy(manager_client_secret, client_secret);
+    manager_refresh_token[0] = '\0';
+    manager_margin = refresh_margin_sec > 0 ? refresh_margin_sec : DEFAULT_REFRESH_MARGIN;
+
+    DeribitAuthResult auth;
+    if (!deribit_authenticate(client_id, client_secret, &auth)) {
+        return false;
+    }
+    char reason[256];
+    if (!check_lifetime(&auth, reason, sizeof(reason))) {
+        printf("Token manager not started: %s\n", reason);
+        return false;
+    }
+    publish_token(&auth);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&manager_wakeup, &attr);
+    pthread_condattr_destroy(&attr);
+
+    stop_requested = false;
+    refresh_requested = false;
+    if (pthread_create(&refresh_thread, NULL, refresh_loop, NULL) != 0) {
+        printf("Failed to start token refresh thread\n");
+        pthread_cond_destroy(&manager_wakeup);
+        return false;
+    }
+    thread_running = true;
+    return true;
+}
+
+bool token_manager_get(char* token, size_t size) {
+    if (!token || size == 0) {
+        return false;
+    }
+    for (;;) {
+        uint32_t before = __atomic_load_n(&token_sequence, __ATOMIC_ACQUIRE);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;                     // Refresh in progress
+        }
+        size_t length = strnlen(current_token, sizeof(current_token));
+        bool fits = length < size;
+        if (fits) {
+            memcpy(token, current_token, length);
+            token[length] = '\0';
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&token_sequence, __ATOMIC_RELAXED) == before) {
+            return fits;
+        }
+    }
+}
+
+int64_t token_manager_expires_in(void) {
+    return __atomic_load_n(&token_expires_at, __ATOMIC_RELAXED) - wall_seconds();
+}
+
+void token_manager_refresh_now(void) {
+    if (!thread_running) {
+        return;
+    }
+    pthread_mutex_lock(&manager_lock);
+    refresh_requested = true;
+    pthread_cond_signal(&manager_wakeup);
+    pthread_mutex_unlock(&manager_lock);
+}
+
+void token_manager_stop(void) {
+    if (!thread_running) {
+        return;
+    }
+    pthread_mutex_lock(&manager_lock);
+    stop_requested = true;
+    pthread_cond_signal(&manager_wakeup);
+    pthread_mutex_unlock(&manager_lock);
+
+    pthread_join(refresh_thread, NULL);
+    pthread_cond_destroy(&manager_wakeup);
+    thread_running = false;
+}
+
+void token_manager_get_stats(TokenManagerStats* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->refreshes = __atomic_load_n(&refresh_count, __ATOMIC_RELAXED);
+    stats->failures = __atomic_load_n(&failure_count, __ATOMIC_RELAXED);
+    stats->expires_at = __atomic_load_n(&token_expires_at, __ATOMIC_RELAXED);
+}
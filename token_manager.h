@@ -0,0 +1,44 @@
+#ifndef TOKEN_MANAGER_H
+#define TOKEN_MANAGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Process-wide access token cache. A background thread refreshes the token
+// refresh_margin_sec before it expires, so request paths never authenticate.
+
+typedef struct {
+    uint64_t refreshes;       // Successful refreshes after the initial login
+    uint64_t failures;        // Failed refresh attempts
+    int64_t expires_at;       // Wall-clock expiry of the current token (seconds)
+} TokenManagerStats;
+
+// Authenticate once and start the refresh thread
+bool token_manager_start(const char* client_id, const char* client_secret, int refresh_margin_sec);
+
+// Copy the current token into token (DERIBIT_TOKEN_SIZE bytes is always
+// enough). Lock-free; call it per request so a refresh is picked up. Returns
+// false before a successful start or if size is too small.
+bool token_manager_get(char* token, size_t size);
+
+// Seconds until the current token expires (negative once expired)
+int64_t token_manager_expires_in(void);
+
+// Wake the refresh thread to renew immediately (e.g. after an auth error)
+void token_manager_refresh_now(void);
+
+// Stop the refresh thread; the last token remains readable
+void token_manager_stop(void);
+
+void token_manager_get_stats(TokenManagerStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TOKEN_MANAGER_H
@@ -2,12 +2,52 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 #include "websocket_client.h"
+#include "ws_conn.h"
+#include "timer_wheel.h"
+#include "subscription_table.h"
+#include "market_data.h"
+#include "sim_feed.h"
+#include "request_encoder.h"
+#include "rate_limiter.h"
+#include "deribit_api.h"
 
-// Simple implementation without actual network functionality
-// Mock implementation for demonstration purposes
+#define WS_MAX_PENDING_CALLS 256     // Power of two; slot is request_id % size
+#define WS_CALL_ID_BASE (1ULL << 32) // Above the int ids used with websocket_send_request
+#define WS_TEST_REPLY_ID (WS_CALL_ID_BASE - 1)  // Answers to heartbeat test_requests
+#define WS_TEST_REPLY "{\"jsonrpc\":\"2.0\",\"id\":4294967295,\"method\":\"public/test\",\"params\":{}}"
+#define WS_DEFAULT_CONNECT_TIMEOUT_MS 10000
+#define WS_DEFAULT_CALL_TIMEOUT_MS 10000
+#define WS_CLOSE_WAIT_MS 1000
+#define WS_MAX_EVENTS 8
+#define WS_POLL_MAX_WAIT_MS 100      // websocket_poll wakes at least this often for timers
+#define WS_RESYNC_BOOK_DEPTH 100
+#define WS_TIMER_TICK_MS 10
+#define WS_KEEPALIVE_MISSES 3        // Silent ping intervals before the connection is declared dead
+#define WS_HEARTBEAT_MISSES 2        // Likewise for server heartbeat intervals
+#define WS_MAX_NOTIFICATIONS 8       // Connect/close callbacks deferred in one dispatch
+
+// The mock transport simulates the connection and its messages; the network
+// transport runs a WsConn (ws_conn.h) on a private epoll instance
 
 // Internal state variables
+static WebSocketTransport transport = WS_TRANSPORT_MOCK;
+static WsConn* connection = NULL;
+static int epoll_fd = -1;
+static int connect_timeout_ms = WS_DEFAULT_CONNECT_TIMEOUT_MS;
+static int call_timeout_ms = WS_DEFAULT_CALL_TIMEOUT_MS;
+static int keepalive_interval_ms = 0;
+static int heartbeat_interval_s = 0;
+static TimerWheel timers;                   // Keep-alive and call deadlines, advanced by the event loop
+static WebSocketReceivePolicy receive_policy = { WS_RECEIVE_BLOCKING, 50, 0, 0 };
+static WebSocketReceiveStats receive_stats[WS_RECEIVE_BUSY_POLL + 1];
+static uint64_t messages_received = 0;
+static bool write_coalescing = false;
+static bool compression = false;
 static WebSocketStatus current_status = WS_STATUS_DISCONNECTED;
 static WebSocketConnectCallback connect_cb = NULL;
 static WebSocketMessageCallback message_cb = NULL;
@@ -18,13 +58,347 @@ static bool auto_reconnect = false;
 static int max_retries = 5;
 static int retry_delay_ms = 1000;
 static int max_delay_ms = 30000;
-static int subscription_count = 0;
-static char subscriptions[32][128] = {0};  // Store up to 32 subscriptions
+static char auth_token[DERIBIT_TOKEN_SIZE] = {0};  // Refresh token, replayed after a reconnect
+static bool closing_by_user = false;
+static int reconnect_attempt = 0;
+static uint64_t reconnect_at_ms = 0;        // Next attempt; 0 if none is scheduled
+static uint64_t disconnected_at_ms = 0;     // Start of the current recovery; 0 if none
+static int resync_pending = 0;              // Snapshot calls outstanding
+static int last_close_code = 0;
+static char last_close_reason[128] = {0};
+static WebSocketReconnectStats reconnect_stats;
+static SubscriptionTable subscriptions;    // Grows on first use
+static SimFeed* synthetic_feed = NULL;
+
+// Outstanding websocket_call requests, matched to replies by id
+typedef struct {
+    uint64_t request_id;             // 0 when free
+    WebSocketResponseCallback callback;
+    void* user_data;
+    Timer deadline;                  // Fails the call if no reply arrives in time
+    Timer send_timer;                // Sends a request held for its rate limit slot
+    char* held_request;              // Request text not yet sent; NULL once it is out
+    char method[64];                 // Pool the held request's credits were booked against
+} PendingCall;
+
+static PendingCall pending_calls[WS_MAX_PENDING_CALLS];
+static int pending_call_count = 0;
+static uint64_t next_call_id = WS_CALL_ID_BASE;
+
+// Mock server side: ids whose replies arrive on the next websocket_process_events
+static uint64_t mock_replies[WS_MAX_PENDING_CALLS];
+static int mock_reply_head = 0;
+static int mock_reply_count = 0;
+
+// A subscription being set up, and the unsubscribe calls in flight
+typedef struct {
+    WebSocketSubscriptionCallback callback;
+    char channel[128];
+    bool typed;
+    SubscriptionType type;
+    MarketDataHandlers handlers;
+} SubscribeContext;
+
+static MarketDataScratch decode_scratch;  // Typed decoding output
+
+static void fail_pending_calls();
+static void deliver_incoming(const char* data, size_t length);
+static void restore_session();
+
+static uint64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Both transports share the wheel; it starts on first use
+static void init_timers() {
+    if (timers.tick_ms == 0) {
+        timer_wheel_init(&timers, WS_TIMER_TICK_MS, monotonic_ms());
+    }
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Message and response callbacks run inside connection code and may
+// disconnect, reconnect or clean up the client. While a dispatch is in
+// progress the connection is only retired, and destroyed once the event loop
+// has control again; connect and close callbacks are held until then too.
+typedef struct {
+    bool connect;                    // connect_cb, else close_cb
+    bool success;
+    int code;
+    char reason[128];
+} Notification;
+
+static int dispatch_depth = 0;
+static WsConn* dispatching = NULL;          // Connection whose code may be on the stack
+static WsConn* retired = NULL;              // Released mid-dispatch
+static Notification notifications[WS_MAX_NOTIFICATIONS];
+static int notification_count = 0;
+
+static void deliver_notification(const Notification* notification) {
+    if (notification->connect) {
+        if (connect_cb) {
+            connect_cb(notification->success, notification->reason);
+        }
+    } else if (close_cb) {
+        close_cb(notification->code, notification->reason);
+    }
+}
+
+static void notify(bool connect, bool success, int code, const char* reason) {
+    Notification notification = { connect, success, code, "" };
+    snprintf(notification.reason, sizeof(notification.reason), "%s", reason ? reason : "");
+    if (dispatch_depth == 0) {
+        deliver_notification(&notification);
+    } else if (notification_count < WS_MAX_NOTIFICATIONS) {
+        notifications[notification_count++] = notification;
+    }
+}
+
+static void begin_dispatch() {
+    if (dispatch_depth++ == 0) {
+        dispatching = connection;
+    }
+}
+
+static void end_dispatch() {
+    if (--dispatch_depth > 0) {
+        return;
+    }
+    dispatching = NULL;
+    if (retired) {
+        ws_conn_destroy(retired);
+        retired = NULL;
+    }
+    // Callbacks may connect or disconnect again, raising new notifications
+    Notification pending[WS_MAX_NOTIFICATIONS];
+    int count = notification_count;
+    memcpy(pending, notifications, (size_t)count * sizeof(Notification));
+    notification_count = 0;
+    for (int i = 0; i < count; i++) {
+        deliver_notification(&pending[i]);
+    }
+}
+
+void websocket_set_transport(WebSocketTransport new_transport) {
+    transport = new_transport;
+}
+
+// Handlers ignore a connection retired earlier in the same dispatch
+static void on_conn_open(WsConn* conn, void* user_data) {
+    (void)user_data;
+    if (conn != connection) {
+        return;
+    }
+    current_status = WS_STATUS_CONNECTED;
+    printf("Connected to: %s\n", current_url);
+    if (heartbeat_interval_s > 0) {
+        char params[32];
+        snprintf(params, sizeof(params), "{\"interval\":%d}", heartbeat_interval_s);
+        websocket_call("public/set_heartbeat", params, NULL, NULL);
+    }
+    if (disconnected_at_ms != 0) {
+        restore_session();
+        return;
+    }
+    notify(true, true, 0, "Connected successfully");
+}
+
+static void on_conn_message(WsConn* conn, WsOpcode opcode, const char* data, size_t length, void* user_data) {
+    (void)user_data;
+    if (conn != connection) {
+        return;
+    }
+    messages_received++;
+    if (opcode == WS_OP_TEXT) {
+        deliver_incoming(data, length);
+    } else if (message_cb) {
+        WebSocketMessage msg = {
+            .type = WS_MESSAGE_BINARY,
+            .data = (char*)data,
+            .length = length
+        };
+        message_cb(&msg);
+    }
+}
+
+static void on_conn_error(WsConn* conn, const char* error, void* user_data) {
+    (void)user_data;
+    if (conn != connection) {
+        return;
+    }
+    printf("WebSocket error: %s\n", error);
+    if (error_cb) {
+        error_cb(error);
+    }
+}
+
+// Stop recovering and report the loss the way a plain close would
+static void abandon_recovery() {
+    printf("Reconnect failed after %d attempts\n", reconnect_attempt);
+    disconnected_at_ms = 0;
+    reconnect_at_ms = 0;
+    current_status = WS_STATUS_ERROR;
+    subscription_table_clear(&subscriptions);
+    notify(false, false, last_close_code, last_close_reason);
+}
+
+// Jittered exponential backoff: the first attempt is immediate, later ones
+// wait a random time in [d/2, d], d doubling from retry_delay_ms to max_delay_ms
+static void schedule_reconnect() {
+    if (reconnect_attempt >= max_retries) {
+        abandon_recovery();
+        return;
+    }
+    uint64_t delay = 0;
+    if (reconnect_attempt > 0) {
+        uint64_t ceiling = retry_delay_ms > 0 ? (uint64_t)retry_delay_ms : 1;
+        for (int i = 1; i < reconnect_attempt && ceiling < (uint64_t)max_delay_ms; i++) {
+            ceiling *= 2;
+        }
+        if (max_delay_ms > 0 && ceiling > (uint64_t)max_delay_ms) {
+            ceiling = (uint64_t)max_delay_ms;
+        }
+        delay = ceiling / 2 + (uint64_t)rand() % (ceiling / 2 + 1);
+    }
+    reconnect_attempt++;
+    reconnect_at_ms = monotonic_ms() + delay;
+    printf("Reconnect attempt %d of %d in %llums\n", reconnect_attempt, max_retries, (unsigned long long)delay);
+}
+
+static void on_conn_close(WsConn* conn, int code, const char* reason, void* user_data) {
+    (void)user_data;
+    if (conn != connection) {
+        return;
+    }
+    WebSocketStatus previous = current_status;
+    last_close_code = code;
+    snprintf(last_close_reason, sizeof(last_close_reason), "%s", reason);
+
+    // Subscriptions stay in the table while recovering; they are replayed
+    if (auto_reconnect && !closing_by_user && (previous == WS_STATUS_CONNECTED || disconnected_at_ms != 0)) {
+        if (disconnected_at_ms == 0) {
+            printf("Connection lost (%d %s), reconnecting\n", code, reason);
+            disconnected_at_ms = monotonic_ms();
+            reconnect_attempt = 0;
+            reconnect_stats.disconnects++;
+        } else {
+            reconnect_stats.failed_attempts++;
+        }
+        current_status = WS_STATUS_CONNECTING;
+        resync_pending = 0;
+        fail_pending_calls();
+        schedule_reconnect();
+        return;
+    }
+
+    current_status = code == 1000 ? WS_STATUS_DISCONNECTED : WS_STATUS_ERROR;
+    subscription_table_clear(&subscriptions);
+    if (previous == WS_STATUS_CONNECTING && disconnected_at_ms == 0) {
+        notify(true, false, code, reason);
+    } else {
+        notify(false, false, code, reason);
+    }
+    fail_pending_calls();
+}
+
+// Dispatch socket readiness to the connection for up to timeout_ms; returns
+// the number of events
+static int pump_events(int timeout_ms) {
+    struct epoll_event events[WS_MAX_EVENTS];
+    int count = epoll_wait(epoll_fd, events, WS_MAX_EVENTS, timeout_ms);
+    begin_dispatch();
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.ptr == connection) {
+            ws_conn_handle_events(connection, events[i].events);
+        }
+    }
+    ws_conn_check_timeout(connection);
+    timer_wheel_advance(&timers, monotonic_ms());
+    ws_conn_flush(connection);
+    end_dispatch();
+    return count;
+}
+
+// No traffic at all for this long means the connection is dead; 0 if neither
+// pings nor server heartbeats are enabled
+static int liveness_timeout_ms() {
+    int timeout = keepalive_interval_ms > 0 ? keepalive_interval_ms * WS_KEEPALIVE_MISSES : 0;
+    int heartbeat = heartbeat_interval_s * 1000 * WS_HEARTBEAT_MISSES;
+    if (heartbeat > 0 && (timeout == 0 || heartbeat < timeout)) {
+        timeout = heartbeat;
+    }
+    return timeout;
+}
+
+static void release_connection() {
+    if (connection && connection == dispatching) {
+        retired = connection;
+    } else {
+        ws_conn_destroy(connection);
+    }
+    connection = NULL;
+}
+
+static bool network_connect(const char* url) {
+    if (epoll_fd < 0) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            return false;
+        }
+        init_timers();
+    }
+    release_connection();
+
+    WsConnHandlers handlers = {
+        .on_open = on_conn_open,
+        .on_message = on_conn_message,
+        .on_close = on_conn_close,
+        .on_error = on_conn_error
+    };
+    connection = ws_conn_create(&handlers, NULL);
+    if (!connection) {
+        return false;
+    }
+    ws_conn_set_busy_poll(connection, receive_policy.socket_busy_poll_us);
+    ws_conn_set_receive_timestamps(connection, true);
+    ws_conn_set_coalescing(connection, write_coalescing);
+    ws_conn_set_compression(connection, compression);
+    ws_conn_set_keepalive(connection, &timers, keepalive_interval_ms, liveness_timeout_ms());
+    current_status = WS_STATUS_CONNECTING;
+    if (!ws_conn_open(connection, url, epoll_fd, connect_timeout_ms)) {
+        current_status = WS_STATUS_ERROR;
+        release_connection();
+        return false;
+    }
+    return true;
+}
+
+// Make the scheduled reconnect attempt once due; runs from the event loop,
+// never from connection handlers
+static void check_reconnect(uint64_t now_ms) {
+    if (reconnect_at_ms == 0 || now_ms < reconnect_at_ms) {
+        return;
+    }
+    reconnect_at_ms = 0;
+    if (!network_connect(current_url)) {
+        current_status = WS_STATUS_CONNECTING;
+        reconnect_stats.failed_attempts++;
+        schedule_reconnect();
+    }
+}
 
 bool websocket_init() {
     printf("WebSocket client initialized\n");
+    init_timers();
     current_status = WS_STATUS_DISCONNECTED;
-    subscription_count = 0;
+    subscription_table_clear(&subscriptions);
     return true;
 }
 
@@ -43,16 +417,21 @@ bool websocket_connect(const char* url,
     error_cb = error_callback;
     close_cb = close_callback;
     strncpy(current_url, url, sizeof(current_url) - 1);
+    reconnect_at_ms = 0;
+    disconnected_at_ms = 0;
+    reconnect_attempt = 0;
     
+    printf("Connecting to: %s\n", url);
+    if (transport == WS_TRANSPORT_NETWORK) {
+        return network_connect(url);
+    }
+
     // Simulate connection
     current_status = WS_STATUS_CONNECTING;
-    printf("Connecting to: %s\n", url);
     
     // Simulate successful connection
     current_status = WS_STATUS_CONNECTED;
-    if (connect_cb) {
-        connect_cb(true, "Connected successfully");
-    }
+    notify(true, true, 0, "Connected successfully");
     
     return true;
 }
@@ -62,6 +441,9 @@ bool websocket_send(const char* message) {
         printf("Cannot send: Not connected\n");
         return false;
     }
+    if (transport == WS_TRANSPORT_NETWORK) {
+        return ws_conn_send(connection, WS_OP_TEXT, message, strlen(message));
+    }
     
     printf("Sending text message: %s\n", message);
     return true;
@@ -72,6 +454,9 @@ bool websocket_send_binary(const unsigned char* data, size_t length) {
         printf("Cannot send binary: Not connected\n");
         return false;
     }
+    if (transport == WS_TRANSPORT_NETWORK) {
+        return ws_conn_send(connection, WS_OP_BINARY, data, length);
+    }
     
     printf("Sending binary message of length %zu\n", length);
     return true;
@@ -92,32 +477,650 @@ bool websocket_send_request(const char* method, const char* params, int request_
     return websocket_send(request);
 }
 
-bool websocket_subscribe_with_params(const SubscriptionRequest* request, 
-                                   WebSocketSubscriptionCallback callback) {
+static bool append_text(char* out, size_t size, size_t* len, const char* text, size_t text_len) {
+    if (text_len >= size - *len) {
+        return false;
+    }
+    memcpy(out + *len, text, text_len);
+    *len += text_len;
+    out[*len] = '\0';
+    return true;
+}
+
+static PendingCall* pending_call_slot(uint64_t request_id) {
+    return &pending_calls[request_id & (WS_MAX_PENDING_CALLS - 1)];
+}
+
+// Remove a call from the table and report it; response NULL means it failed
+static void complete_call(PendingCall* call, const char* response, size_t length) {
+    uint64_t request_id = call->request_id;
+    WebSocketResponseCallback callback = call->callback;
+    void* user_data = call->user_data;
+    call->request_id = 0;
+    pending_call_count--;
+    timer_wheel_cancel(&timers, &call->deadline);
+    if (call->held_request) {
+        // Never sent, so its credits go back to the pool
+        timer_wheel_cancel(&timers, &call->send_timer);
+        rate_limit_refund(call->method);
+        free(call->held_request);
+        call->held_request = NULL;
+    }
+    if (callback) {
+        callback(request_id, response, length, user_data);
+    }
+}
+
+static void on_call_deadline(Timer* timer, uint64_t now_ms, void* user_data) {
+    (void)timer;
+    (void)now_ms;
+    PendingCall* call = user_data;
+    printf("Request %llu timed out\n", (unsigned long long)call->request_id);
+    complete_call(call, NULL, 0);
+}
+
+static void fail_pending_calls() {
+    for (int i = 0; i < WS_MAX_PENDING_CALLS && pending_call_count > 0; i++) {
+        if (pending_calls[i].request_id != 0) {
+            complete_call(&pending_calls[i], NULL, 0);
+        }
+    }
+    mock_reply_head = 0;
+    mock_reply_count = 0;
+}
+
+// Mock transport: the server answers every call with a plain success
+static void queue_mock_reply(uint64_t request_id) {
+    mock_replies[(mock_reply_head + mock_reply_count) & (WS_MAX_PENDING_CALLS - 1)] = request_id;
+    mock_reply_count++;
+}
+
+static void on_call_send(Timer* timer, uint64_t now_ms, void* user_data) {
+    (void)timer;
+    (void)now_ms;
+    PendingCall* call = user_data;
+    char* request = call->held_request;
+    call->held_request = NULL;
+    bool sent = websocket_send(request);
+    free(request);
+    if (!sent) {
+        rate_limit_refund(call->method);
+        complete_call(call, NULL, 0);
+    } else if (transport != WS_TRANSPORT_NETWORK) {
+        queue_mock_reply(call->request_id);
+    }
+}
+
+uint64_t websocket_call(const char* method, const char* params,
+                        WebSocketResponseCallback callback, void* user_data) {
+    if (!method || !params || current_status != WS_STATUS_CONNECTED) {
+        return 0;
+    }
+
+    if (pending_call_count >= WS_MAX_PENDING_CALLS) {
+        printf("Cannot send request: too many pending calls\n");
+        return 0;
+    }
+    // Skip ids whose slot is still held by a slower call; ids are never reused
+    PendingCall* call = pending_call_slot(next_call_id);
+    while (call->request_id != 0) {
+        call = pending_call_slot(++next_call_id);
+    }
+    uint64_t request_id = next_call_id++;
+
+    // Batch calls such as a full resubscribe outgrow the stack buffer
+    char stack_request[1024];
+    size_t size = strlen(method) + strlen(params) + 64;
+    char* request = size <= sizeof(stack_request) ? stack_request : malloc(size);
+    if (!request) {
+        return 0;
+    }
+    if (request == stack_request) {
+        size = sizeof(stack_request);
+    }
+    char id_text[24];
+    size_t len = 0;
+    int id_len = request_encode_uint(id_text, sizeof(id_text), request_id);
+    bool built = id_len >= 0 &&
+        append_text(request, size, &len, "{\"jsonrpc\":\"2.0\",\"id\":", 22) &&
+        append_text(request, size, &len, id_text, (size_t)id_len) &&
+        append_text(request, size, &len, ",\"method\":\"", 11) &&
+        append_text(request, size, &len, method, strlen(method)) &&
+        append_text(request, size, &len, "\",\"params\":", 11) &&
+        append_text(request, size, &len, params, strlen(params)) &&
+        append_text(request, size, &len, "}", 1);
+    if (!built) {
+        printf("Cannot send request: too long\n");
+        if (request != stack_request) {
+            free(request);
+        }
+        return 0;
+    }
+
+    // Credits are booked only once the text is ready to go. This runs inside
+    // the event loop, so a request over its pool's rate is held on the timer
+    // wheel until its slot instead of sleeping here
+    uint64_t delay = rate_limit_book(method);
+    char* held = NULL;
+    bool sent = false;
+    if (delay == RATE_LIMIT_NEVER) {
+        printf("Cannot send request: request credits exhausted\n");
+    } else if (delay == RATE_LIMIT_GRANTED) {
+        sent = websocket_send(request);
+        if (!sent) {
+            rate_limit_refund(method);
+        }
+    } else if (strlen(method) >= sizeof(call->method)) {
+        rate_limit_refund(method);
+        printf("Cannot send request: method name too long\n");
+    } else {
+        if (request == stack_request) {
+            held = malloc(len + 1);
+            if (held) {
+                memcpy(held, request, len + 1);
+            }
+        } else {
+            held = request;             // Ownership moves to the call
+            request = stack_request;
+        }
+        sent = held != NULL;
+        if (!sent) {
+            rate_limit_refund(method);
+        }
+    }
+    if (request != stack_request) {
+        free(request);
+    }
+    if (!sent) {
+        return 0;
+    }
+
+    uint64_t now_ms = monotonic_ms();
+    uint64_t send_at_ms = now_ms + (held ? (delay + 999999) / 1000000 : 0);
+    call->request_id = request_id;
+    call->callback = callback;
+    call->user_data = user_data;
+    call->held_request = held;
+    pending_call_count++;
+    init_timers();
+    timer_init(&call->deadline, on_call_deadline, call);
+    timer_wheel_schedule(&timers, &call->deadline, send_at_ms + (uint64_t)call_timeout_ms);
+    if (held) {
+        strcpy(call->method, method);
+        timer_init(&call->send_timer, on_call_send, call);
+        timer_wheel_schedule(&timers, &call->send_timer, send_at_ms);
+        return request_id;
+    }
+    if (transport != WS_TRANSPORT_NETWORK) {
+        queue_mock_reply(request_id);
+    }
+    return request_id;
+}
+
+bool websocket_cancel_call(uint64_t request_id) {
+    PendingCall* call = pending_call_slot(request_id);
+    if (request_id == 0 || call->request_id != request_id) {
+        return false;
+    }
+    complete_call(call, NULL, 0);
+    return true;
+}
+
+int websocket_pending_calls() {
+    return pending_call_count;
+}
+
+void websocket_set_call_timeout(int timeout_ms) {
+    call_timeout_ms = timeout_ms > 0 ? timeout_ms : WS_DEFAULT_CALL_TIMEOUT_MS;
+}
+
+void websocket_set_write_coalescing(bool enabled) {
+    write_coalescing = enabled;
+    if (connection) {
+        ws_conn_set_coalescing(connection, enabled);
+    }
+}
+
+bool websocket_flush() {
+    if (transport != WS_TRANSPORT_NETWORK) {
+        return current_status == WS_STATUS_CONNECTED;
+    }
+    return ws_conn_flush(connection);
+}
+
+void websocket_get_write_stats(WebSocketWriteStats* out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    WsConnWriteStats stats;
+    if (connection) {
+        ws_conn_get_write_stats(connection, &stats);
+        out->frames = stats.frames;
+        out->writes = stats.writes;
+        out->bytes = stats.bytes;
+        out->writes_saved = stats.writes_saved;
+    }
+}
+
+void websocket_set_compression(bool enabled) {
+    compression = enabled;
+}
+
+void websocket_get_compression_stats(WebSocketCompressionStats* out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    WsConnCompressionStats stats;
+    if (connection) {
+        ws_conn_get_compression_stats(connection, &stats);
+        out->negotiated = ws_conn_compression_active(connection);
+        out->messages = stats.messages;
+        out->compressed_bytes = stats.compressed_bytes;
+        out->inflated_bytes = stats.inflated_bytes;
+        out->inflate_ns = stats.inflate_ns;
+    }
+}
+
+// Replies to websocket_call go to their callback; notifications to their
+// channel's typed handler, its raw handler or the message callback
+static void deliver_incoming(const char* data, size_t length) {
+    if (!strstr(data, "\"method\":\"subscription\"")) {
+        const char* id_field = strstr(data, "\"id\":");
+        if (id_field) {
+            uint64_t request_id = strtoull(id_field + 5, NULL, 10);
+            if (request_id == WS_TEST_REPLY_ID) {
+                return;
+            }
+            PendingCall* call = pending_call_slot(request_id);
+            if (request_id != 0 && call->request_id == request_id) {
+                complete_call(call, data, length);
+                return;
+            }
+        }
+    }
+
+    WebSocketMessage msg = {
+        .type = WS_MESSAGE_TEXT,
+        .data = (char*)data,
+        .length = length
+    };
+    WebSocketMessageCallback handler = message_cb;
+
+    // Subscription notifications carry their channel in params
+    const char* channel = strstr(data, "\"channel\":\"");
+    if (channel) {
+        channel += 11;
+        const char* end = strchr(channel, '"');
+        size_t channel_length = end ? (size_t)(end - channel) : 0;
+        if (channel_length < sizeof(msg.channel)) {
+            memcpy(msg.channel, channel, channel_length);
+            msg.channel[channel_length] = '\0';
+            Subscription* sub = subscription_table_find(&subscriptions, channel, channel_length);
+            if (sub) {
+                sub->messages++;
+                subscription_track_sequence(sub, data);
+                // Messages the decoder rejects fall back to the raw callbacks
+                if (sub->typed && market_data_dispatch(sub->type, &sub->typed_handlers, sub->instrument_id,
+                        subscription_table_instrument_name(&subscriptions, sub->instrument_id), data, &decode_scratch)) {
+                    return;
+                }
+                if (sub->handler) {
+                    handler = sub->handler;
+                }
+            }
+        }
+    } else {
+        // Heartbeats are the engine's business, never the application's
+        MarketDataHeartbeat heartbeat = market_data_heartbeat(data);
+        // Sent straight out: an answer must not wait on request credits or a call slot
+        if (heartbeat == MARKET_DATA_TEST_REQUEST) {
+            websocket_send(WS_TEST_REPLY);
+        }
+        if (heartbeat != MARKET_DATA_NOT_HEARTBEAT) {
+            return;
+        }
+    }
+    if (handler) {
+        handler(&msg);
+    }
+}
+
+// Record a confirmed subscription and bind its typed handlers, if any
+static bool add_subscription(const SubscribeContext* request) {
+    Subscription* sub = subscription_table_add(&subscriptions, request->channel, NULL);
+    if (!sub) {
+        return false;
+    }
+    if (request->typed) {
+        sub->typed = true;
+        sub->type = request->type;
+        sub->typed_handlers = request->handlers;
+    }
+    return true;
+}
+
+// The server lists the channels it accepted in the result array
+static void on_subscribe_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    (void)request_id;
+    (void)length;
+    SubscribeContext* ctx = user_data;
+    char quoted[132];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", ctx->channel);
+    const char* result = response ? strstr(response, "\"result\":[") : NULL;
+    bool success = result && strstr(result, quoted) && add_subscription(ctx);
+    printf("%s to: %s\n", success ? "Subscribed" : "Subscription failed", ctx->channel);
+    if (ctx->callback) {
+        ctx->callback(ctx->channel, success);
+    }
+    free(ctx);
+}
+
+static void on_unsubscribe_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    (void)request_id;
+    (void)response;
+    (void)length;
+    free(user_data);
+}
+
+// Send public/subscribe or public/unsubscribe; user channels need the private method
+static bool send_subscription_call(const SubscribeContext* request, bool subscribe) {
+    SubscribeContext* ctx = malloc(sizeof(SubscribeContext));
+    if (!ctx) {
+        return false;
+    }
+    *ctx = *request;
+    const char* channel = ctx->channel;
+
+    char method[32];
+    char params[192];
+    snprintf(method, sizeof(method), "%s/%s", strncmp(channel, "user.", 5) == 0 ? "private" : "public",
+             subscribe ? "subscribe" : "unsubscribe");
+    snprintf(params, sizeof(params), "{\"channels\":[\"%s\"]}", channel);
+    if (websocket_call(method, params, subscribe ? on_subscribe_response : on_unsubscribe_response, ctx) == 0) {
+        free(ctx);
+        return false;
+    }
+    return true;
+}
+
+static void mark_recovered() {
+    if (disconnected_at_ms == 0) {
+        return;
+    }
+    uint64_t elapsed = monotonic_ms() - disconnected_at_ms;
+    disconnected_at_ms = 0;
+    reconnect_stats.reconnects++;
+    reconnect_stats.last_recovery_ms = elapsed;
+    reconnect_stats.total_recovery_ms += elapsed;
+    if (elapsed > reconnect_stats.max_recovery_ms) {
+        reconnect_stats.max_recovery_ms = elapsed;
+    }
+    printf("Recovered %u subscriptions in %llums\n", subscriptions.count, (unsigned long long)elapsed);
+    notify(true, true, 0, "Reconnected");
+}
+
+// Hand a book or open-orders snapshot to the subscription's typed handler
+static void apply_snapshot(const Subscription* sub, const char* result) {
+    MarketDataHandlers handlers = sub->typed_handlers;
+    const char* instrument = subscription_table_instrument_name(&subscriptions, sub->instrument_id);
+    if (sub->type == SUBSCRIPTION_BOOK) {
+        BookUpdate update;
+        if (market_data_decode_book(result, &update, decode_scratch.levels, MARKET_DATA_MAX_LEVELS)) {
+            update.snapshot = true;
+            update.prev_change_id = 0;
+            update.instrument_id = sub->instrument_id;
+            update.instrument_name = instrument;
+            handlers.on_book(&update, handlers.user_data);
+        }
+    } else {
+        // A snapshot must arrive whole; larger ones get their own buffer
+        int count = market_data_decode_orders(result, decode_scratch.orders, MARKET_DATA_MAX_ORDERS);
+        Order* orders = decode_scratch.orders;
+        if (count > MARKET_DATA_MAX_ORDERS) {
+            orders = malloc((size_t)count * sizeof(Order));
+            if (orders) {
+                market_data_decode_orders(result, orders, count);
+            }
+        }
+        if (count >= 0 && orders) {
+            handlers.on_orders(orders, count, handlers.user_data);
+        } else {
+            printf("Open orders resync failed: %s\n", instrument);
+        }
+        if (orders != decode_scratch.orders) {
+            free(orders);
+        }
+    }
+}
+
+static void on_resync_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    (void)request_id;
+    (void)length;
+    char* channel = user_data;
+    // No response: the connection dropped again and recovery starts over, or,
+    // still connected, the snapshot timed out and is skipped
+    if (response || current_status == WS_STATUS_CONNECTED) {
+        const Subscription* sub = subscription_table_find(&subscriptions, channel, strlen(channel));
+        const char* result = response ? market_data_result(response) : NULL;
+        if (sub && result) {
+            apply_snapshot(sub, result);
+        }
+        if (--resync_pending == 0) {
+            mark_recovered();
+        }
+    }
+    free(channel);
+}
+
+// Request the snapshot a typed book or user.orders subscription missed while down
+static bool send_resync(const Subscription* sub) {
+    const char* instrument = subscription_table_instrument_name(&subscriptions, sub->instrument_id);
+    const char* method;
+    char params[160];
+    if (!sub->typed || !instrument) {
+        return false;
+    }
+    if (sub->type == SUBSCRIPTION_BOOK && sub->typed_handlers.on_book) {
+        method = "public/get_order_book";
+        snprintf(params, sizeof(params), "{\"instrument_name\":\"%s\",\"depth\":%d}", instrument, WS_RESYNC_BOOK_DEPTH);
+    } else if (sub->type == SUBSCRIPTION_ORDER && sub->typed_handlers.on_orders) {
+        method = "private/get_open_orders_by_instrument";
+        snprintf(params, sizeof(params), "{\"instrument_name\":\"%s\"}", instrument);
+    } else {
+        return false;
+    }
+    char* channel = strdup(sub->channel);
+    if (!channel || websocket_call(method, params, on_resync_response, channel) == 0) {
+        free(channel);
+        return false;
+    }
+    return true;
+}
+
+static void on_resubscribe_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    (void)request_id;
+    (void)length;
+    (void)user_data;
+    if (!response) {
+        // Still connected means the call timed out; retry through recovery
+        if (current_status == WS_STATUS_CONNECTED && connection) {
+            ws_conn_close(connection, 1000, "Resubscribe timed out");
+        }
+        return;
+    }
+    // Drop channels the server no longer accepts; removal moves the last
+    // entry into the freed index, so walk backwards
+    const char* result = strstr(response, "\"result\":[");
+    for (uint32_t i = subscriptions.count; i-- > 0;) {
+        char channel[SUBSCRIPTION_CHANNEL_SIZE];
+        char quoted[SUBSCRIPTION_CHANNEL_SIZE + 2];
+        snprintf(channel, sizeof(channel), "%s", subscription_table_at(&subscriptions, i)->channel);
+        snprintf(quoted, sizeof(quoted), "\"%s\"", channel);
+        if (!result || !strstr(result, quoted)) {
+            printf("Resubscribe failed: %s\n", channel);
+            subscription_table_remove(&subscriptions, channel);
+        }
+    }
+
+    resync_pending = 0;
+    for (uint32_t i = 0; i < subscriptions.count; i++) {
+        if (send_resync(subscription_table_at(&subscriptions, i))) {
+            resync_pending++;
+        }
+    }
+    if (resync_pending == 0) {
+        mark_recovered();
+    }
+}
+
+// Resubscribe every channel in one call; private ones only once the session
+// is authenticated again, otherwise they are dropped
+static void resubscribe(bool authenticated) {
+    for (uint32_t i = subscriptions.count; !authenticated && i-- > 0;) {
+        char channel[SUBSCRIPTION_CHANNEL_SIZE];
+        snprintf(channel, sizeof(channel), "%s", subscription_table_at(&subscriptions, i)->channel);
+        if (strncmp(channel, "user.", 5) == 0) {
+            printf("Resubscribe failed: %s (not authenticated)\n", channel);
+            subscription_table_remove(&subscriptions, channel);
+        }
+    }
+    if (subscriptions.count == 0) {
+        mark_recovered();
+        return;
+    }
+
+    char* params = malloc((size_t)subscriptions.count * (SUBSCRIPTION_CHANNEL_SIZE + 3) + 16);
+    if (!params) {
+        ws_conn_close(connection, 1000, "Out of memory");
+        return;
+    }
+    bool private_channels = false;
+    size_t length = (size_t)sprintf(params, "{\"channels\":[");
+    for (uint32_t i = 0; i < subscriptions.count; i++) {
+        Subscription* sub = subscription_table_at(&subscriptions, i);
+        sub->last_sequence = 0;      // The stream restarts; no gap against the old one
+        private_channels |= strncmp(sub->channel, "user.", 5) == 0;
+        length += (size_t)sprintf(params + length, "%s\"%s\"", i ? "," : "", sub->channel);
+    }
+    sprintf(params + length, "]}");
+
+    // private/subscribe also takes public channels
+    uint64_t request_id = websocket_call(private_channels ? "private/subscribe" : "public/subscribe", params,
+                                         on_resubscribe_response, NULL);
+    free(params);
+    if (request_id == 0) {
+        // Retry through the normal recovery path
+        ws_conn_close(connection, 1000, "Resubscribe failed");
+    }
+}
+
+// Deribit rotates the refresh token on every grant; keep the new one for the
+// next reconnect. False if the reply is an error.
+static bool store_refresh_token(const char* response) {
+    const char* result = strstr(response, "\"result\":");
+    const char* token = result ? strstr(result, "\"refresh_token\":\"") : NULL;
+    if (!token) {
+        return false;
+    }
+    token += 17;
+    const char* end = strchr(token, '"');
+    if (!end || (size_t)(end - token) >= sizeof(auth_token)) {
+        return false;
+    }
+    memcpy(auth_token, token, (size_t)(end - token));
+    auth_token[end - token] = '\0';
+    return true;
+}
+
+// user_data is non-NULL while restoring a session
+static void on_auth_response(uint64_t request_id, const char* response, size_t length, void* user_data) {
+    (void)request_id;
+    (void)length;
+    bool restoring = user_data != NULL;
+    if (!response) {
+        // Still connected means the call timed out; retry through recovery
+        if (restoring && current_status == WS_STATUS_CONNECTED && connection) {
+            ws_conn_close(connection, 1000, "Authentication timed out");
+        }
+        return;
+    }
+    bool authenticated = store_refresh_token(response);
+    printf(authenticated ? "Authenticated\n" : "Authentication failed\n");
+    if (restoring) {
+        resubscribe(authenticated);
+    }
+}
+
+static bool send_auth(bool restoring) {
+    char params[DERIBIT_TOKEN_SIZE + 64];
+    snprintf(params, sizeof(params), "{\"grant_type\":\"refresh_token\",\"refresh_token\":\"%s\"}", auth_token);
+    return websocket_call("public/auth", params, on_auth_response, restoring ? (void*)1 : NULL) != 0;
+}
+
+// Reconnected: replay authentication, then every subscription in one call
+static void restore_session() {
+    reconnect_attempt = 0;
+    if (!auth_token[0]) {
+        resubscribe(false);
+    } else if (!send_auth(true)) {
+        ws_conn_close(connection, 1000, "Authentication failed");
+    }
+}
+
+static void deliver_mock_replies() {
+    // Only the replies queued so far; callbacks may issue new calls
+    int count = mock_reply_count;
+    for (int i = 0; i < count; i++) {
+        uint64_t request_id = mock_replies[mock_reply_head];
+        mock_reply_head = (mock_reply_head + 1) & (WS_MAX_PENDING_CALLS - 1);
+        mock_reply_count--;
+
+        char reply[256];
+        int len = snprintf(reply, sizeof(reply),
+            "{\"jsonrpc\":\"2.0\",\"id\":%llu,\"result\":{\"success\":true},"
+            "\"usIn\":1234567890,\"usOut\":1234567891,\"usDiff\":1,\"testnet\":true}",
+            (unsigned long long)request_id);
+        deliver_incoming(reply, (size_t)len);
+    }
+}
+
+static bool subscribe_channel(const SubscriptionRequest* request, const MarketDataHandlers* handlers,
+                              WebSocketSubscriptionCallback callback) {
     if (!request || current_status != WS_STATUS_CONNECTED) {
         return false;
     }
     
-    char channel[128] = {0};
-    websocket_build_channel_name(channel, sizeof(channel), 
+    SubscribeContext binding = {0};
+    binding.callback = callback;
+    binding.typed = handlers != NULL;
+    binding.type = request->type;
+    if (handlers) {
+        binding.handlers = *handlers;
+    }
+    char* channel = binding.channel;
+    websocket_build_channel_name(channel, sizeof(binding.channel), 
                                request->type, request->instrument_name,
                                request->interval, request->depth);
     
-    // Check if already subscribed
-    for (int i = 0; i < subscription_count; i++) {
-        if (strcmp(subscriptions[i], channel) == 0) {
-            printf("Already subscribed to: %s\n", channel);
-            if (callback) {
-                callback(channel, true);
-            }
-            return true;
+    // Check if already subscribed; a typed subscribe rebinds the handlers
+    if (websocket_is_subscribed(channel)) {
+        printf("Already subscribed to: %s\n", channel);
+        if (handlers) {
+            add_subscription(&binding);
+        }
+        if (callback) {
+            callback(channel, true);
         }
+        return true;
+    }
+    if (transport == WS_TRANSPORT_NETWORK) {
+        return send_subscription_call(&binding, true);
     }
     
     // Add to subscriptions
-    if (subscription_count < 32) {
-        strncpy(subscriptions[subscription_count], channel, sizeof(subscriptions[0]) - 1);
-        subscription_count++;
+    if (add_subscription(&binding)) {
         printf("Subscribed to: %s\n", channel);
         
         // Simulate subscription success
@@ -142,6 +1145,19 @@ bool websocket_subscribe_with_params(const SubscriptionRequest* request,
     return false;
 }
 
+bool websocket_subscribe_with_params(const SubscriptionRequest* request, 
+                                   WebSocketSubscriptionCallback callback) {
+    return subscribe_channel(request, NULL, callback);
+}
+
+bool websocket_subscribe_typed(const SubscriptionRequest* request, const MarketDataHandlers* handlers,
+                               WebSocketSubscriptionCallback callback) {
+    if (!request || !handlers || !market_data_has_decoder(request->type)) {
+        return false;
+    }
+    return subscribe_channel(request, handlers, callback);
+}
+
 bool websocket_subscribe(const char* channel, WebSocketSubscriptionCallback callback) {
     if (!channel || current_status != WS_STATUS_CONNECTED) {
         return false;
@@ -160,45 +1176,48 @@ bool websocket_unsubscribe(const char* channel) {
         return false;
     }
     
-    // Find and remove subscription
-    for (int i = 0; i < subscription_count; i++) {
-        if (strcmp(subscriptions[i], channel) == 0) {
-            // Remove by shifting remaining elements
-            for (int j = i; j < subscription_count - 1; j++) {
-                strcpy(subscriptions[j], subscriptions[j + 1]);
-            }
-            subscription_count--;
-            printf("Unsubscribed from: %s\n", channel);
-            return true;
+    if (subscription_table_remove(&subscriptions, channel)) {
+        printf("Unsubscribed from: %s\n", channel);
+        if (transport == WS_TRANSPORT_NETWORK) {
+            SubscribeContext request = {0};
+            strncpy(request.channel, channel, sizeof(request.channel) - 1);
+            send_subscription_call(&request, false);
         }
+        return true;
     }
     
     printf("Not subscribed to: %s\n", channel);
     return false;
 }
 
-bool websocket_authenticate(const char* access_token) {
-    if (!access_token || current_status != WS_STATUS_CONNECTED) {
+bool websocket_authenticate(const char* refresh_token) {
+    if (!refresh_token || !refresh_token[0] || current_status != WS_STATUS_CONNECTED ||
+        strlen(refresh_token) >= sizeof(auth_token)) {
         return false;
     }
-    
-    printf("Authenticating with token: %s\n", access_token);
-    
-    // Simulate authentication request
-    char params[1024];
-    snprintf(params, sizeof(params), 
-            "{\"grant_type\":\"client_credentials\",\"client_id\":\"%s\",\"client_secret\":\"%s\"}",
-            "mock_client_id", "mock_client_secret");
-    
-    return websocket_send_request("public/auth", params, 42);
+    printf("Authenticating\n");
+    snprintf(auth_token, sizeof(auth_token), "%s", refresh_token);
+    return send_auth(false);
 }
 
 bool websocket_reconnect() {
+    printf("Attempting reconnection to: %s\n", current_url);
+    if (transport == WS_TRANSPORT_NETWORK && current_status == WS_STATUS_CONNECTED && disconnected_at_ms == 0) {
+        // Same recovery as after a loss, starting at once
+        ws_conn_close(connection, 1000, "Reconnecting");
+        release_connection();
+        disconnected_at_ms = monotonic_ms();
+        reconnect_attempt = 0;
+        reconnect_stats.disconnects++;
+        current_status = WS_STATUS_CONNECTING;
+        fail_pending_calls();
+        schedule_reconnect();
+        check_reconnect(monotonic_ms());
+        return true;
+    }
     if (current_status == WS_STATUS_CONNECTED) {
         websocket_disconnect();
     }
-    
-    printf("Attempting reconnection to: %s\n", current_url);
     return websocket_connect(current_url, connect_cb, message_cb, error_cb, close_cb);
 }
 
@@ -211,23 +1230,66 @@ void websocket_set_auto_reconnect(bool enabled, int max_retries_val, int initial
            enabled ? "enabled" : "disabled", max_retries, initial_delay_ms, max_delay_ms);
 }
 
-void websocket_set_timeout(int connect_timeout_ms, int operation_timeout_ms) {
-    printf("Timeouts set: connect=%dms, operation=%dms\n", connect_timeout_ms, operation_timeout_ms);
+void websocket_get_reconnect_stats(WebSocketReconnectStats* out) {
+    if (out) {
+        *out = reconnect_stats;
+    }
+}
+
+void websocket_set_timeout(int connect_timeout_ms_val, int operation_timeout_ms) {
+    connect_timeout_ms = connect_timeout_ms_val > 0 ? connect_timeout_ms_val : WS_DEFAULT_CONNECT_TIMEOUT_MS;
+    printf("Timeouts set: connect=%dms, operation=%dms\n", connect_timeout_ms_val, operation_timeout_ms);
 }
 
 void websocket_disconnect() {
+    closing_by_user = true;
+    reconnect_at_ms = 0;
+    begin_dispatch();
+    if (disconnected_at_ms != 0) {
+        // Give up the recovery in progress
+        disconnected_at_ms = 0;
+        subscription_table_clear(&subscriptions);
+        if (!connection) {
+            current_status = WS_STATUS_DISCONNECTED;
+        }
+    }
+    if (transport == WS_TRANSPORT_NETWORK && connection) {
+        // Closing handshake; on_conn_close reports the result
+        if (ws_conn_state(connection) != WS_CONN_CLOSED) {
+            printf("Disconnecting WebSocket\n");
+            ws_conn_close(connection, 1000, "Normal closure");
+            // Called from a handler, the connection is mid-dispatch: no nested event loop
+            uint64_t deadline = monotonic_ms() + WS_CLOSE_WAIT_MS;
+            while (dispatch_depth == 1 && ws_conn_state(connection) != WS_CONN_CLOSED && monotonic_ms() < deadline) {
+                pump_events(10);
+            }
+            // Not closed yet: report what on_conn_close would have
+            if (ws_conn_state(connection) != WS_CONN_CLOSED) {
+                ws_conn_flush(connection);
+                subscription_table_clear(&subscriptions);
+                notify(false, false, 1000, "Normal closure");
+            }
+        }
+        release_connection();
+        current_status = WS_STATUS_DISCONNECTED;
+    }
     if (current_status == WS_STATUS_CONNECTED) {
         printf("Disconnecting WebSocket\n");
-        if (close_cb) {
-            close_cb(1000, "Normal closure");
-        }
+        notify(false, false, 1000, "Normal closure");
         current_status = WS_STATUS_DISCONNECTED;
     }
+    fail_pending_calls();
+    closing_by_user = false;
+    end_dispatch();
 }
 
 void websocket_cleanup() {
     websocket_disconnect();
-    subscription_count = 0;
+    subscription_table_free(&subscriptions);
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
     printf("WebSocket client cleaned up\n");
 }
 
@@ -235,53 +1297,223 @@ WebSocketStatus websocket_get_status() {
     return current_status;
 }
 
+void websocket_set_synthetic_feed(SimFeed* feed) {
+    synthetic_feed = feed;
+}
+
 void websocket_process_events() {
+    if (transport == WS_TRANSPORT_NETWORK) {
+        check_reconnect(monotonic_ms());
+        if (!connection) {
+            return;
+        }
+        pump_events(0);
+        return;
+    }
+
+    if (current_status == WS_STATUS_CONNECTED && mock_reply_count > 0) {
+        deliver_mock_replies();
+    }
+    timer_wheel_advance(&timers, monotonic_ms());
+
+    // Synthetic load generator takes over the message stream when attached
+    if (synthetic_feed) {
+        if (current_status == WS_STATUS_CONNECTED) {
+            sim_feed_poll(synthetic_feed, message_cb);
+        }
+        return;
+    }
+
     // Simulate processing incoming messages
-    if (current_status == WS_STATUS_CONNECTED && subscription_count > 0 && rand() % 10 == 0) {
+    if (current_status == WS_STATUS_CONNECTED && subscriptions.count > 0 && rand() % 10 == 0) {
         // Randomly generate a message for an active subscription
-        int sub_idx = rand() % subscription_count;
+        const Subscription* sub = subscription_table_at(&subscriptions, (uint32_t)rand() % subscriptions.count);
         if (message_cb) {
             WebSocketMessage msg = {
                 .type = WS_MESSAGE_TEXT,
                 .data = "{\n  \"type\": \"update\",\n  \"data\": {\n    \"timestamp\": 1590399378456,\n    \"price\": 25010.50\n  }\n}",
                 .length = 98
             };
-            strncpy(msg.channel, subscriptions[sub_idx], sizeof(msg.channel) - 1);
+            strncpy(msg.channel, sub->channel, sizeof(msg.channel) - 1);
             message_cb(&msg);
         }
     }
 }
 
+void websocket_set_receive_policy(const WebSocketReceivePolicy* policy) {
+    if (!policy || policy->mode < WS_RECEIVE_BLOCKING || policy->mode > WS_RECEIVE_BUSY_POLL) {
+        return;
+    }
+    receive_policy = *policy;
+    if (connection && !ws_conn_set_busy_poll(connection, policy->socket_busy_poll_us)) {
+        printf("SO_BUSY_POLL refused (needs CAP_NET_ADMIN above net.core.busy_read)\n");
+    }
+}
+
+static void record_receive_delay(WebSocketReceiveStats* stats) {
+    uint64_t delay = ws_conn_receive_delay_ns(connection);
+    if (delay > 0) {
+        stats->delay_samples++;
+        stats->delay_total_ns += delay;
+        if (delay > stats->delay_max_ns) {
+            stats->delay_max_ns = delay;
+        }
+    }
+}
+
+int websocket_poll(int timeout_ms) {
+    if (transport != WS_TRANSPORT_NETWORK || (!connection && reconnect_at_ms == 0)) {
+        return 0;
+    }
+    WebSocketReceiveStats* stats = &receive_stats[receive_policy.mode];
+    uint64_t start_ns = clock_ns(CLOCK_MONOTONIC);
+    uint64_t start_cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t start_messages = messages_received;
+    uint64_t deadline_ns = timeout_ms >= 0 ? start_ns + (uint64_t)timeout_ms * 1000000ULL : UINT64_MAX;
+    uint64_t spin_budget_ns = (uint64_t)(receive_policy.spin_budget_us > 0 ? receive_policy.spin_budget_us : 0) * 1000ULL;
+    uint64_t last_data_ns = start_ns;
+    int empty_streak = 0;
+
+    for (;;) {
+        uint64_t now_ns = clock_ns(CLOCK_MONOTONIC);
+        if (now_ns >= deadline_ns) {
+            break;
+        }
+        WsConnState state = connection ? ws_conn_state(connection) : WS_CONN_CLOSED;
+        if (state == WS_CONN_CLOSED) {
+            if (reconnect_at_ms == 0) {
+                break;
+            }
+            // Backing off before the next reconnect attempt
+            uint64_t wake_ns = reconnect_at_ms * 1000000ULL;
+            if (wake_ns > deadline_ns) {
+                wake_ns = deadline_ns;
+            }
+            if (wake_ns > now_ns) {
+                struct timespec pause = { (time_t)((wake_ns - now_ns) / 1000000000ULL),
+                                          (long)((wake_ns - now_ns) % 1000000000ULL) };
+                nanosleep(&pause, NULL);
+            }
+            check_reconnect(monotonic_ms());
+            continue;
+        }
+        begin_dispatch();
+        timer_wheel_advance(&timers, now_ns / 1000000);
+        end_dispatch();
+        if (!connection) {
+            continue;
+        }
+
+        // Spin while data keeps arriving within the budget; handshakes and
+        // closing always go through epoll
+        if (receive_policy.mode == WS_RECEIVE_BUSY_POLL && state == WS_CONN_OPEN &&
+            now_ns - last_data_ns < spin_budget_ns) {
+            stats->reads++;
+            begin_dispatch();
+            bool received = ws_conn_poll(connection);
+            ws_conn_flush(connection);
+            end_dispatch();
+            if (received) {
+                record_receive_delay(stats);
+                last_data_ns = clock_ns(CLOCK_MONOTONIC);
+                empty_streak = 0;
+            } else {
+                stats->empty_reads++;
+                if (receive_policy.yield_interval > 0 && ++empty_streak >= receive_policy.yield_interval) {
+                    sched_yield();
+                    stats->yields++;
+                    empty_streak = 0;
+                }
+            }
+            continue;
+        }
+
+        // Idle: sleep until readiness, bounded so deadlines and keep-alives run
+        uint64_t wait_ns = deadline_ns - now_ns;
+        int wait_ms = wait_ns >= (uint64_t)WS_POLL_MAX_WAIT_MS * 1000000ULL ?
+            WS_POLL_MAX_WAIT_MS : (int)((wait_ns + 999999) / 1000000);
+        wait_ms = timer_wheel_timeout_ms(&timers, now_ns / 1000000, wait_ms);
+        stats->epoll_waits++;
+        if (pump_events(wait_ms) > 0) {
+            stats->wakeups++;
+            record_receive_delay(stats);
+            last_data_ns = clock_ns(CLOCK_MONOTONIC);
+        }
+    }
+
+    stats->wall_ns += clock_ns(CLOCK_MONOTONIC) - start_ns;
+    stats->cpu_ns += clock_ns(CLOCK_THREAD_CPUTIME_ID) - start_cpu_ns;
+    stats->messages += messages_received - start_messages;
+    return (int)(messages_received - start_messages);
+}
+
+void websocket_get_receive_stats(WebSocketReceiveMode mode, WebSocketReceiveStats* out) {
+    if (out && mode >= WS_RECEIVE_BLOCKING && mode <= WS_RECEIVE_BUSY_POLL) {
+        *out = receive_stats[mode];
+    }
+}
+
+void websocket_reset_receive_stats() {
+    memset(receive_stats, 0, sizeof(receive_stats));
+}
+
 bool websocket_is_subscribed(const char* channel) {
     if (!channel) {
         return false;
     }
-    
-    for (int i = 0; i < subscription_count; i++) {
-        if (strcmp(subscriptions[i], channel) == 0) {
-            return true;
-        }
+    return subscription_table_find(&subscriptions, channel, strlen(channel)) != NULL;
+}
+
+bool websocket_set_channel_handler(const char* channel, WebSocketMessageCallback handler) {
+    Subscription* sub = channel ? subscription_table_find(&subscriptions, channel, strlen(channel)) : NULL;
+    if (!sub) {
+        return false;
     }
-    
-    return false;
+    sub->handler = handler;
+    return true;
 }
 
 int websocket_get_subscription_count() {
-    return subscription_count;
+    return (int)subscriptions.count;
 }
 
 bool websocket_get_subscription_by_index(int index, char* channel_out, size_t channel_out_size) {
-    if (index < 0 || index >= subscription_count || !channel_out || channel_out_size == 0) {
+    const Subscription* sub = index >= 0 ? subscription_table_at(&subscriptions, (uint32_t)index) : NULL;
+    if (!sub || !channel_out || channel_out_size == 0) {
         return false;
     }
     
-    strncpy(channel_out, subscriptions[index], channel_out_size - 1);
+    strncpy(channel_out, sub->channel, channel_out_size - 1);
     channel_out[channel_out_size - 1] = '\0';
     return true;
 }
 
 void websocket_set_keepalive(int interval_ms) {
+    keepalive_interval_ms = interval_ms > 0 ? interval_ms : 0;
     printf("Keepalive interval set to %dms\n", interval_ms);
+    if (connection) {
+        ws_conn_set_keepalive(connection, &timers, keepalive_interval_ms, liveness_timeout_ms());
+    }
+}
+
+bool websocket_set_heartbeat(int interval_s) {
+    if (interval_s < 0) {
+        return false;
+    }
+    heartbeat_interval_s = interval_s;
+    printf("Heartbeat interval set to %ds\n", interval_s);
+    if (connection) {
+        ws_conn_set_keepalive(connection, &timers, keepalive_interval_ms, liveness_timeout_ms());
+    }
+    if (current_status != WS_STATUS_CONNECTED || transport != WS_TRANSPORT_NETWORK) {
+        return true;
+    }
+    if (interval_s == 0) {
+        return websocket_call("public/disable_heartbeat", "{}", NULL, NULL) != 0;
+    }
+    char params[32];
+    snprintf(params, sizeof(params), "{\"interval\":%d}", interval_s);
+    return websocket_call("public/set_heartbeat", params, NULL, NULL) != 0;
 }
 
 void websocket_build_channel_name(char* output, size_t output_size, 
@@ -306,7 +1538,9 @@ void websocket_build_channel_name(char* output, size_t output_size,
     }
     
     // Build channel name
-    if (type == SUBSCRIPTION_BOOK && depth > 0) {
+    if (type == SUBSCRIPTION_ORDER) {
+        snprintf(output, output_size, "user.orders.%s.raw", instrument_name);
+    } else if (type == SUBSCRIPTION_BOOK && depth > 0) {
         snprintf(output, output_size, "%s.%s.%d", type_str, instrument_name, depth);
     } else if ((type == SUBSCRIPTION_TICKER || type == SUBSCRIPTION_MARK_PRICE) && interval > 0) {
         snprintf(output, output_size, "%s.%s.%d", type_str, instrument_name, interval);
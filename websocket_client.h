@@ -1,12 +1,14 @@
 #ifndef WEBSOCKET_CLIENT_H
 #define WEBSOCKET_CLIENT_H
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #include <stdbool.h>
+#include "ws_message.h"
 
 // WebSocket connection status
 typedef enum {
@@ -16,23 +18,6 @@ typedef enum {
     WS_STATUS_ERROR
 } WebSocketStatus;
 
-// WebSocket message types
-typedef enum {
-    WS_MESSAGE_TEXT,
-    WS_MESSAGE_BINARY,
-    WS_MESSAGE_PING,
-    WS_MESSAGE_PONG,
-    WS_MESSAGE_CLOSE
-} WebSocketMessageType;
-
-// WebSocket message structure
-typedef struct {
-    WebSocketMessageType type;
-    char* data;
-    size_t length;
-    char channel[128];  // Added channel field to track message source
-} WebSocketMessage;
-
 // Subscription types for Deribit
 typedef enum {
     SUBSCRIPTION_BOOK,         // Order book
@@ -57,15 +42,70 @@ typedef struct {
 
 // Callback function types
 typedef void (*WebSocketConnectCallback)(bool success, const char* message);
-typedef void (*WebSocketMessageCallback)(const WebSocketMessage* message);
 typedef void (*WebSocketErrorCallback)(const char* error);
 typedef void (*WebSocketCloseCallback)(int code, const char* reason);
 typedef void (*WebSocketSubscriptionCallback)(const char* channel, bool success);
 
+// JSON-RPC response callback; response is NULL if the call failed before a
+// reply arrived (disconnect or cancel)
+typedef void (*WebSocketResponseCallback)(uint64_t request_id, const char* response, size_t length, void* user_data);
+
+// Connection transport
+typedef enum {
+    WS_TRANSPORT_MOCK,       // Simulated connection and messages, no network (default)
+    WS_TRANSPORT_NETWORK     // RFC 6455 over TCP or TLS, driven by websocket_process_events
+} WebSocketTransport;
+
+// Select transport; takes effect on the next websocket_connect
+void websocket_set_transport(WebSocketTransport transport);
+
+// How websocket_poll waits for network data
+typedef enum {
+    WS_RECEIVE_BLOCKING,     // Sleep in epoll_wait until the socket is readable (default)
+    WS_RECEIVE_BUSY_POLL     // Spin on non-blocking reads, then fall back to epoll_wait
+} WebSocketReceiveMode;
+
+typedef struct {
+    WebSocketReceiveMode mode;
+    int spin_budget_us;      // Idle time spent spinning before blocking in epoll_wait
+    int yield_interval;      // sched_yield after this many empty reads in a row; 0 never
+    int socket_busy_poll_us; // SO_BUSY_POLL for the socket; 0 leaves it off
+} WebSocketReceivePolicy;
+
+// Receive statistics for one mode, accumulated by websocket_poll
+typedef struct {
+    uint64_t wall_ns;        // Time spent in websocket_poll
+    uint64_t cpu_ns;         // Thread CPU time over the same span
+    uint64_t reads;          // Non-blocking read attempts while spinning
+    uint64_t empty_reads;
+    uint64_t yields;
+    uint64_t epoll_waits;
+    uint64_t wakeups;        // epoll_wait calls that returned events
+    uint64_t messages;
+    uint64_t delay_samples;  // Reads with a kernel receive timestamp (ws:// only)
+    uint64_t delay_total_ns; // Time data sat in the socket before being read
+    uint64_t delay_max_ns;
+} WebSocketReceiveStats;
+
+// Set the receive policy; SO_BUSY_POLL applies to the current connection too
+void websocket_set_receive_policy(const WebSocketReceivePolicy* policy);
+
+// Receive loop for a dedicated market-data thread with the network transport:
+// runs the policy for up to timeout_ms (negative: until the connection closes)
+// and returns the number of messages delivered
+int websocket_poll(int timeout_ms);
+
+void websocket_get_receive_stats(WebSocketReceiveMode mode, WebSocketReceiveStats* out);
+void websocket_reset_receive_stats();
+
 // Initialize WebSocket client
 bool websocket_init();
 
-// Connect to WebSocket server
+// Connect to WebSocket server. With the network transport this only starts
+// the connection; connect_callback runs from websocket_process_events once the
+// handshake completes or fails. Any callback may disconnect, reconnect or clean
+// up the client; connect and close callbacks run after the connection code has
+// returned.
 bool websocket_connect(const char* url, 
                       WebSocketConnectCallback connect_callback,
                       WebSocketMessageCallback message_callback,
@@ -81,25 +121,101 @@ bool websocket_send_binary(const unsigned char* data, size_t length);
 // Send JSON-RPC request
 bool websocket_send_request(const char* method, const char* params, int request_id);
 
+// Send a JSON-RPC call and route its reply, matched by id, to callback from
+// websocket_process_events instead of the message callback. A call with no
+// reply within the call timeout completes with a NULL response. Returns the
+// request id, 0 on failure.
+uint64_t websocket_call(const char* method, const char* params,
+                        WebSocketResponseCallback callback, void* user_data);
+
+// Forget a pending call; its callback runs with a NULL response
+bool websocket_cancel_call(uint64_t request_id);
+
+// Number of calls awaiting a reply
+int websocket_pending_calls();
+
+// How long websocket_call waits for a reply (default 10 s)
+void websocket_set_call_timeout(int timeout_ms);
+
+// Coalesce outgoing messages: sends made between event-loop iterations are
+// written together once per websocket_process_events / websocket_poll pass
+void websocket_set_write_coalescing(bool enabled);
+
+// Write anything held back now, e.g. right after a cancel
+bool websocket_flush();
+
+typedef struct {
+    uint64_t frames;         // Messages and control frames sent
+    uint64_t writes;         // Write syscalls that carried them
+    uint64_t bytes;
+    uint64_t writes_saved;   // frames - writes
+} WebSocketWriteStats;
+
+// Totals for the current connection (network transport)
+void websocket_get_write_stats(WebSocketWriteStats* out);
+
+// Offer permessage-deflate on the next connect (network transport). Compressed
+// messages are inflated inside the receive ring; compare the stats below to
+// see whether the bandwidth saved is worth the inflate time.
+void websocket_set_compression(bool enabled);
+
+typedef struct {
+    bool negotiated;            // The server accepted permessage-deflate
+    uint64_t messages;          // Compressed messages received
+    uint64_t compressed_bytes;
+    uint64_t inflated_bytes;
+    uint64_t inflate_ns;        // Total time spent inflating them
+} WebSocketCompressionStats;
+
+// Totals for the current connection
+void websocket_get_compression_stats(WebSocketCompressionStats* out);
+
 // Subscribe to channel with parameters
 bool websocket_subscribe_with_params(const SubscriptionRequest* request, 
                                     WebSocketSubscriptionCallback callback);
 
+// Subscribe with notifications decoded for the request's type (book, trades,
+// ticker or order) and delivered to the matching typed handler; the channel
+// is resolved once here and each message is dispatched by table index
+struct MarketDataHandlers;
+bool websocket_subscribe_typed(const SubscriptionRequest* request, const struct MarketDataHandlers* handlers,
+                               WebSocketSubscriptionCallback callback);
+
 // Subscribe to channel (simplified)
 bool websocket_subscribe(const char* channel, WebSocketSubscriptionCallback callback);
 
 // Unsubscribe from channel
 bool websocket_unsubscribe(const char* channel);
 
-// Authenticate with access token
-bool websocket_authenticate(const char* access_token);
+// Authenticate the session with a refresh_token grant (public/auth). The
+// token, rotated from each reply, is replayed after a reconnect; private
+// channels are resubscribed only once that succeeds.
+bool websocket_authenticate(const char* refresh_token);
 
-// Reconnect with exponential backoff
+// Drop the connection and recover it as after an unexpected loss, keeping
+// subscriptions
 bool websocket_reconnect();
 
-// Set auto-reconnect options
+// Set auto-reconnect options. After an unexpected loss (network transport)
+// the client retries with jittered exponential backoff: the first attempt is
+// immediate, then each waits a random time in [d/2, d] with d doubling from
+// initial_delay_ms up to max_delay_ms. Once open it re-authenticates,
+// resubscribes every channel in one call and resyncs typed book and
+// user.orders subscriptions from snapshots. connect_callback reports the
+// recovery; close_callback runs only if max_retries attempts all fail.
 void websocket_set_auto_reconnect(bool enabled, int max_retries, int initial_delay_ms, int max_delay_ms);
 
+typedef struct {
+    uint64_t disconnects;       // Unexpected connection losses
+    uint64_t reconnects;        // Recoveries completed
+    uint64_t failed_attempts;
+    uint64_t last_recovery_ms;  // From loss to resubscribed and resynced
+    uint64_t max_recovery_ms;
+    uint64_t total_recovery_ms;
+} WebSocketReconnectStats;
+
+void websocket_get_reconnect_stats(WebSocketReconnectStats* out);
+
 // Set connection timeout
 void websocket_set_timeout(int connect_timeout_ms, int operation_timeout_ms);
 
@@ -115,18 +231,36 @@ WebSocketStatus websocket_get_status();
 // Process WebSocket events (call in main loop)
 void websocket_process_events();
 
+// Drive the message callback from a synthetic generator (sim_feed.h) instead of
+// the canned mock messages; NULL detaches
+struct SimFeed;
+void websocket_set_synthetic_feed(struct SimFeed* feed);
+
 // Check if currently subscribed to a channel
 bool websocket_is_subscribed(const char* channel);
 
+// Route one subscribed channel's notifications to handler instead of the
+// message callback; NULL restores the default
+bool websocket_set_channel_handler(const char* channel, WebSocketMessageCallback handler);
+
 // Get active subscription count
 int websocket_get_subscription_count();
 
-// Get subscription by index
+// Get subscription by index; indexes shift when a channel is removed
 bool websocket_get_subscription_by_index(int index, char* channel_out, size_t channel_out_size);
 
-// Set keep-alive interval
+// Ping the server every interval_ms (0 disables). Pings and the liveness
+// check run on the event loop's timer wheel: after three intervals without
+// any traffic the connection is dropped and, with auto-reconnect on,
+// recovered like any other loss.
 void websocket_set_keepalive(int interval_ms);
 
+// Ask the server for heartbeats every interval_s seconds (Deribit's minimum is
+// 10; 0 disables), sent now and again on every connect. Test requests are
+// answered with public/test internally and heartbeats never reach the message
+// callback; two missed intervals count as a dead connection.
+bool websocket_set_heartbeat(int interval_s);
+
 // Generate specific Deribit subscription channel name
 void websocket_build_channel_name(char* output, size_t output_size, 
                                  SubscriptionType type, const char* instrument_name,
@@ -0,0 +1,1153 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <zlib.h>
+#include "ws_conn.h"
+
+#define WS_DEFAULT_RING_SIZE (4 * 1024 * 1024)
+#define WS_MAX_HANDSHAKE 16384
+#define WS_CLOSE_TIMEOUT_MS 1000
+#define WS_INFLATE_RESERVE_SHARE 4    // 1/n of the ring kept free for inflated messages
+
+// Close codes (RFC 6455 section 7.4.1)
+#define WS_CLOSE_NORMAL 1000
+#define WS_CLOSE_PROTOCOL_ERROR 1002
+#define WS_CLOSE_NO_STATUS 1005
+#define WS_CLOSE_ABNORMAL 1006
+#define WS_CLOSE_TOO_BIG 1009
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} WsBuffer;
+
+// Receive ring: capacity bytes mapped twice back to back, so any span of up to
+// capacity bytes starting inside the ring is contiguous in memory. Positions
+// are absolute byte counts; one byte is always left free.
+typedef struct {
+    char* base;
+    size_t capacity;              // Power of two, multiple of the page size
+    uint64_t head;                // Oldest byte still needed
+    uint64_t tail;                // Next byte to fill
+} WsRing;
+
+struct WsConn {
+    WsConnState state;
+    int fd;
+    int epoll_fd;
+    uint32_t registered_events;
+    bool tls;
+    SSL_CTX* ssl_ctx;
+    SSL* ssl;
+    bool want_write;              // Output pending or TLS needs the socket writable
+
+    char host[256];
+    char port[8];
+    char path[512];
+    char key[25];                 // Sec-WebSocket-Key
+    uint64_t deadline_ms;         // Handshake or closing deadline, 0 if none
+    uint64_t last_receive_ms;
+    uint64_t bytes_received;
+    int busy_poll_us;             // SO_BUSY_POLL, 0 if off
+    bool receive_timestamps;
+    uint64_t receive_delay_ns;    // Socket dwell time seen by the last read pass
+    uint64_t mask_state;          // xorshift state for frame masks
+
+    WsRing in;
+    size_t ring_size;
+    uint64_t next_frame;          // Ring position of the next unparsed frame
+    WsBuffer out;
+    size_t out_offset;
+    bool coalesce;                // Frames wait for ws_conn_flush
+    WsConnWriteStats write_stats;
+    TimerWheel* wheel;            // Owner's, for keep-alive; NULL if off
+    Timer ping_timer;
+    Timer liveness_timer;
+    int ping_interval_ms;
+    int liveness_timeout_ms;
+    uint64_t message_start;       // Fragmented message being reassembled in the ring
+    size_t message_size;
+    WsOpcode message_opcode;
+    bool in_message;
+    bool message_compressed;
+
+    bool deflate_offered;         // permessage-deflate requested in the upgrade
+    bool deflate;                 // Negotiated on this connection
+    bool inflater_ready;
+    z_stream inflater;            // Kept across messages: the server compresses with context takeover
+    size_t inflate_reserve;       // Ring space reads leave for inflated output
+    WsConnCompressionStats compression_stats;
+
+    WsConnHandlers handlers;
+    void* user_data;
+};
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Grow the output buffer to take extra more bytes
+static bool buffer_reserve(WsBuffer* buffer, size_t extra) {
+    if (buffer->size + extra + 1 <= buffer->capacity) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->size + extra + 1) {
+        capacity *= 2;
+    }
+    char* data = realloc(buffer->data, capacity);
+    if (!data) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool buffer_append(WsBuffer* buffer, const void* data, size_t length) {
+    if (!buffer_reserve(buffer, length)) {
+        return false;
+    }
+    memcpy(buffer->data + buffer->size, data, length);
+    buffer->size += length;
+    return true;
+}
+
+static void buffer_free(WsBuffer* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+static bool ring_init(WsRing* ring, size_t capacity) {
+    size_t size = (size_t)sysconf(_SC_PAGESIZE);
+    while (size < capacity) {
+        size *= 2;
+    }
+    int fd = memfd_create("ws_ring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char* base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0) {
+        base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (base != MAP_FAILED &&
+        (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+         mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+        munmap(base, 2 * size);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    ring->base = base;
+    ring->capacity = size;
+    ring->head = 0;
+    ring->tail = 0;
+    return true;
+}
+
+static void ring_free(WsRing* ring) {
+    if (ring->base) {
+        munmap(ring->base, 2 * ring->capacity);
+        ring->base = NULL;
+    }
+}
+
+static char* ring_at(const WsRing* ring, uint64_t position) {
+    return ring->base + (position & (ring->capacity - 1));
+}
+
+static size_t ring_free_space(const WsRing* ring) {
+    return ring->capacity - 1 - (size_t)(ring->tail - ring->head);
+}
+
+// Free space reads may fill, less the inflate reserve
+static size_t ring_read_space(const WsConn* conn) {
+    size_t space = ring_free_space(&conn->in);
+    return space > conn->inflate_reserve ? space - conn->inflate_reserve : 0;
+}
+
+// Frame masks only need to be unpredictable to intermediaries; a per-connection
+// generator seeded from the kernel avoids a syscall per frame
+static void next_mask(WsConn* conn, uint8_t mask[4]) {
+    uint64_t x = conn->mask_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    conn->mask_state = x;
+    uint32_t value = (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+    memcpy(mask, &value, 4);
+}
+
+WsConn* ws_conn_create(const WsConnHandlers* handlers, void* user_data) {
+    WsConn* conn = calloc(1, sizeof(WsConn));
+    if (!conn) {
+        return NULL;
+    }
+    conn->fd = -1;
+    conn->epoll_fd = -1;
+    conn->state = WS_CONN_CLOSED;
+    if (handlers) {
+        conn->handlers = *handlers;
+    }
+    conn->user_data = user_data;
+    conn->ring_size = WS_DEFAULT_RING_SIZE;
+    return conn;
+}
+
+bool ws_conn_set_receive_buffer(WsConn* conn, size_t bytes) {
+    if (!conn || conn->state != WS_CONN_CLOSED || bytes < WS_MAX_HANDSHAKE) {
+        return false;
+    }
+    ring_free(&conn->in);
+    conn->ring_size = bytes;
+    return true;
+}
+
+static bool apply_socket_options(const WsConn* conn, int fd) {
+    bool ok = true;
+    if (conn->busy_poll_us > 0) {
+        ok = setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &conn->busy_poll_us, sizeof(conn->busy_poll_us)) == 0;
+    }
+    if (conn->receive_timestamps && !conn->tls) {
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+    }
+    return ok;
+}
+
+bool ws_conn_set_busy_poll(WsConn* conn, int busy_poll_us) {
+    if (!conn || busy_poll_us < 0) {
+        return false;
+    }
+    conn->busy_poll_us = busy_poll_us;
+    return conn->fd < 0 || apply_socket_options(conn, conn->fd);
+}
+
+void ws_conn_set_receive_timestamps(WsConn* conn, bool enabled) {
+    if (conn) {
+        conn->receive_timestamps = enabled;
+        if (conn->fd >= 0) {
+            apply_socket_options(conn, conn->fd);
+        }
+    }
+}
+
+static void release_socket(WsConn* conn) {
+    if (conn->ssl) {
+        SSL_free(conn->ssl);
+        conn->ssl = NULL;
+    }
+    if (conn->fd >= 0) {
+        if (conn->epoll_fd >= 0) {
+            epoll_ctl(conn->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+        }
+        close(conn->fd);
+        conn->fd = -1;
+    }
+    if (conn->wheel) {
+        timer_wheel_cancel(conn->wheel, &conn->ping_timer);
+        timer_wheel_cancel(conn->wheel, &conn->liveness_timer);
+    }
+    conn->registered_events = 0;
+    conn->in.head = 0;
+    conn->in.tail = 0;
+    conn->next_frame = 0;
+    conn->out.size = 0;
+    conn->out_offset = 0;
+    conn->in_message = false;
+    conn->deflate = false;
+    conn->inflate_reserve = 0;
+    conn->want_write = false;
+    conn->deadline_ms = 0;
+}
+
+void ws_conn_destroy(WsConn* conn) {
+    if (!conn) {
+        return;
+    }
+    release_socket(conn);
+    if (conn->ssl_ctx) {
+        SSL_CTX_free(conn->ssl_ctx);
+    }
+    ring_free(&conn->in);
+    buffer_free(&conn->out);
+    if (conn->inflater_ready) {
+        inflateEnd(&conn->inflater);
+    }
+    free(conn);
+}
+
+// Tear the connection down and report it; nothing may touch conn afterwards
+// in the same call chain except returning
+static void finish(WsConn* conn, int code, const char* reason) {
+    if (conn->state == WS_CONN_CLOSED) {
+        return;
+    }
+    release_socket(conn);
+    conn->state = WS_CONN_CLOSED;
+    if (conn->handlers.on_close) {
+        conn->handlers.on_close(conn, code, reason, conn->user_data);
+    }
+}
+
+static void fail(WsConn* conn, int code, const char* error) {
+    if (conn->state == WS_CONN_CLOSED) {
+        return;
+    }
+    if (conn->handlers.on_error) {
+        conn->handlers.on_error(conn, error, conn->user_data);
+    }
+    finish(conn, code, error);
+}
+
+static void update_events(WsConn* conn) {
+    uint32_t events = EPOLLIN | (conn->want_write ? EPOLLOUT : 0);
+    if (conn->fd < 0 || events == conn->registered_events) {
+        return;
+    }
+    struct epoll_event ev = {0};
+    ev.events = events;
+    ev.data.ptr = conn;
+    epoll_ctl(conn->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+    conn->registered_events = events;
+}
+
+// recv that also measures the dwell time of the first data in a read pass from
+// the SO_TIMESTAMPNS control message
+static ssize_t recv_timestamped(WsConn* conn, void* data, size_t length) {
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct iovec iov = { .iov_base = data, .iov_len = length };
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(conn->fd, &msg, 0);
+    if (n <= 0 || conn->receive_delay_ns != 0) {
+        return n;
+    }
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec received;
+            struct timespec now;
+            memcpy(&received, CMSG_DATA(cmsg), sizeof(received));
+            clock_gettime(CLOCK_REALTIME, &now);
+            int64_t delay = (int64_t)(now.tv_sec - received.tv_sec) * 1000000000LL + (now.tv_nsec - received.tv_nsec);
+            conn->receive_delay_ns = delay > 0 ? (uint64_t)delay : 1;
+        }
+    }
+    return n;
+}
+
+// Socket I/O through TLS when enabled. Returns bytes transferred, 0 on EOF,
+// -1 if the socket would block, -2 on error.
+static ssize_t conn_read(WsConn* conn, void* data, size_t length) {
+    if (conn->ssl) {
+        int n = SSL_read(conn->ssl, data, (int)length);
+        if (n > 0) {
+            return n;
+        }
+        int err = SSL_get_error(conn->ssl, n);
+        if (err == SSL_ERROR_WANT_READ) {
+            return -1;
+        }
+        if (err == SSL_ERROR_WANT_WRITE) {
+            conn->want_write = true;
+            return -1;
+        }
+        return err == SSL_ERROR_ZERO_RETURN ? 0 : -2;
+    }
+    ssize_t n = conn->receive_timestamps ? recv_timestamped(conn, data, length) : recv(conn->fd, data, length, 0);
+    if (n >= 0) {
+        return n;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? -1 : -2;
+}
+
+static ssize_t conn_write(WsConn* conn, const void* data, size_t length) {
+    if (conn->ssl) {
+        int n = SSL_write(conn->ssl, data, (int)length);
+        if (n > 0) {
+            return n;
+        }
+        int err = SSL_get_error(conn->ssl, n);
+        return err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ ? -1 : -2;
+    }
+    ssize_t n = send(conn->fd, data, length, MSG_NOSIGNAL);
+    if (n >= 0) {
+        return n;
+    }
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? -1 : -2;
+}
+
+// Write queued output until the socket is full; false if the connection failed
+static bool flush_output(WsConn* conn) {
+    while (conn->out_offset < conn->out.size) {
+        ssize_t n = conn_write(conn, conn->out.data + conn->out_offset, conn->out.size - conn->out_offset);
+        if (n == -1) {
+            break;
+        }
+        if (n < 0) {
+            fail(conn, WS_CLOSE_ABNORMAL, "Write failed");
+            return false;
+        }
+        conn->out_offset += (size_t)n;
+        conn->write_stats.writes++;
+        conn->write_stats.bytes += (uint64_t)n;
+    }
+    if (conn->out_offset == conn->out.size) {
+        conn->out.size = 0;
+        conn->out_offset = 0;
+    }
+    conn->want_write = conn->out.size > 0;
+    update_events(conn);
+    return true;
+}
+
+static bool queue_frame(WsConn* conn, WsOpcode opcode, const void* data, size_t length) {
+    uint8_t header[WS_FRAME_MAX_HEADER];
+    uint8_t mask[4];
+    next_mask(conn, mask);
+    size_t header_length = ws_frame_write_header(header, opcode, true, false, length, mask);
+    if (!buffer_reserve(&conn->out, header_length + length)) {
+        return false;
+    }
+    buffer_append(&conn->out, header, header_length);
+    if (length > 0) {
+        uint8_t* payload = (uint8_t*)conn->out.data + conn->out.size;
+        memcpy(payload, data, length);
+        ws_frame_apply_mask(payload, length, mask, 0);
+        conn->out.size += length;
+    }
+    conn->write_stats.frames++;
+    if (conn->coalesce && opcode != WS_OP_CLOSE) {
+        return true;
+    }
+    return flush_output(conn);
+}
+
+static void on_ping_timer(Timer* timer, uint64_t now_ms, void* user_data) {
+    WsConn* conn = user_data;
+    if (conn->state == WS_CONN_OPEN) {
+        queue_frame(conn, WS_OP_PING, NULL, 0);
+        timer_wheel_schedule(conn->wheel, timer, now_ms + (uint64_t)conn->ping_interval_ms);
+    }
+}
+
+// Re-armed from the last receive time rather than on every read, so the
+// receive path only records the time
+static void on_liveness_timer(Timer* timer, uint64_t now_ms, void* user_data) {
+    WsConn* conn = user_data;
+    uint64_t deadline = conn->last_receive_ms + (uint64_t)conn->liveness_timeout_ms;
+    if (now_ms >= deadline) {
+        fail(conn, WS_CLOSE_ABNORMAL, "Keep-alive timed out");
+        return;
+    }
+    timer_wheel_schedule(conn->wheel, timer, deadline);
+}
+
+static void start_keepalive(WsConn* conn) {
+    if (!conn->wheel) {
+        return;
+    }
+    uint64_t now = monotonic_ms();
+    conn->last_receive_ms = now;
+    if (conn->ping_interval_ms > 0) {
+        timer_wheel_schedule(conn->wheel, &conn->ping_timer, now + (uint64_t)conn->ping_interval_ms);
+    }
+    if (conn->liveness_timeout_ms > 0) {
+        timer_wheel_schedule(conn->wheel, &conn->liveness_timer, now + (uint64_t)conn->liveness_timeout_ms);
+    }
+}
+
+static bool parse_url(WsConn* conn, const char* url) {
+    const char* rest;
+    if (strncmp(url, "wss://", 6) == 0) {
+        conn->tls = true;
+        rest = url + 6;
+    } else if (strncmp(url, "ws://", 5) == 0) {
+        conn->tls = false;
+        rest = url + 5;
+    } else {
+        return false;
+    }
+
+    const char* path = strchr(rest, '/');
+    size_t authority_length = path ? (size_t)(path - rest) : strlen(rest);
+    const char* colon = memchr(rest, ':', authority_length);
+    size_t host_length = colon ? (size_t)(colon - rest) : authority_length;
+    if (host_length == 0 || host_length >= sizeof(conn->host)) {
+        return false;
+    }
+    memcpy(conn->host, rest, host_length);
+    conn->host[host_length] = '\0';
+
+    if (colon) {
+        size_t port_length = authority_length - host_length - 1;
+        if (port_length == 0 || port_length >= sizeof(conn->port)) {
+            return false;
+        }
+        memcpy(conn->port, colon + 1, port_length);
+        conn->port[port_length] = '\0';
+    } else {
+        strcpy(conn->port, conn->tls ? "443" : "80");
+    }
+
+    const char* request_path = path ? path : "/";
+    if (strlen(request_path) >= sizeof(conn->path)) {
+        return false;
+    }
+    strcpy(conn->path, request_path);
+    return true;
+}
+
+static bool send_upgrade(WsConn* conn) {
+    uint8_t nonce[16];
+    if (getrandom(nonce, sizeof(nonce), 0) != (ssize_t)sizeof(nonce)) {
+        fail(conn, WS_CLOSE_ABNORMAL, "No randomness for handshake key");
+        return false;
+    }
+    ws_frame_base64(nonce, sizeof(nonce), conn->key);
+
+    char request[1024];
+    bool default_port = strcmp(conn->port, conn->tls ? "443" : "80") == 0;
+    int length = snprintf(request, sizeof(request),
+        "GET %s HTTP/1.1\r\n"
+        "Host: %s%s%s\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: %s\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "%s"
+        "\r\n",
+        conn->path, conn->host, default_port ? "" : ":", default_port ? "" : conn->port, conn->key,
+        conn->deflate_offered ? "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n" : "");
+    if (length < 0 || (size_t)length >= sizeof(request) || !buffer_append(&conn->out, request, (size_t)length)) {
+        fail(conn, WS_CLOSE_ABNORMAL, "Upgrade request too long");
+        return false;
+    }
+    conn->state = WS_CONN_UPGRADING;
+    return flush_output(conn);
+}
+
+static bool start_tls(WsConn* conn) {
+    if (!conn->ssl_ctx) {
+        conn->ssl_ctx = SSL_CTX_new(TLS_client_method());
+        if (!conn->ssl_ctx) {
+            fail(conn, WS_CLOSE_ABNORMAL, "Failed to create TLS context");
+            return false;
+        }
+        SSL_CTX_set_default_verify_paths(conn->ssl_ctx);
+        SSL_CTX_set_verify(conn->ssl_ctx, SSL_VERIFY_PEER, NULL);
+        SSL_CTX_set_min_proto_version(conn->ssl_ctx, TLS1_2_VERSION);
+    }
+    conn->ssl = SSL_new(conn->ssl_ctx);
+    if (!conn->ssl) {
+        fail(conn, WS_CLOSE_ABNORMAL, "Failed to create TLS session");
+        return false;
+    }
+    SSL_set_fd(conn->ssl, conn->fd);
+    SSL_set_tlsext_host_name(conn->ssl, conn->host);
+    SSL_set1_host(conn->ssl, conn->host);
+    conn->state = WS_CONN_TLS_HANDSHAKE;
+    return true;
+}
+
+// Advance the TLS handshake; true once it is complete
+static bool continue_tls(WsConn* conn) {
+    int result = SSL_connect(conn->ssl);
+    if (result == 1) {
+        return true;
+    }
+    int err = SSL_get_error(conn->ssl, result);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+        conn->want_write = err == SSL_ERROR_WANT_WRITE;
+        update_events(conn);
+        return false;
+    }
+    char error[256];
+    snprintf(error, sizeof(error), "TLS handshake failed: %s", ERR_reason_error_string(ERR_get_error()));
+    fail(conn, WS_CLOSE_ABNORMAL, error);
+    return false;
+}
+
+bool ws_conn_open(WsConn* conn, const char* url, int epoll_fd, int timeout_ms) {
+    if (!conn || !url || epoll_fd < 0 || conn->state != WS_CONN_CLOSED) {
+        return false;
+    }
+    if (!parse_url(conn, url)) {
+        if (conn->handlers.on_error) {
+            conn->handlers.on_error(conn, "Invalid WebSocket URL", conn->user_data);
+        }
+        return false;
+    }
+    if (!conn->in.base && !ring_init(&conn->in, conn->ring_size)) {
+        if (conn->handlers.on_error) {
+            conn->handlers.on_error(conn, "Failed to map receive buffer", conn->user_data);
+        }
+        return false;
+    }
+    if (conn->mask_state == 0 && getrandom(&conn->mask_state, sizeof(conn->mask_state), 0) != sizeof(conn->mask_state)) {
+        conn->mask_state = (uint64_t)monotonic_ms() * 0x9E3779B97F4A7C15ULL;
+    }
+    conn->mask_state |= 1;
+
+    // Name resolution is the one blocking step
+    struct addrinfo hints = {0};
+    struct addrinfo* addresses = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(conn->host, conn->port, &hints, &addresses) != 0 || !addresses) {
+        if (conn->handlers.on_error) {
+            conn->handlers.on_error(conn, "Failed to resolve host", conn->user_data);
+        }
+        return false;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = addresses; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        apply_socket_options(conn, fd);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        if (conn->handlers.on_error) {
+            conn->handlers.on_error(conn, "Failed to connect", conn->user_data);
+        }
+        return false;
+    }
+
+    conn->fd = fd;
+    conn->epoll_fd = epoll_fd;
+    conn->state = WS_CONN_CONNECTING;
+    conn->deadline_ms = timeout_ms > 0 ? monotonic_ms() + (uint64_t)timeout_ms : 0;
+    conn->last_receive_ms = monotonic_ms();
+
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = conn;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        conn->fd = -1;
+        conn->state = WS_CONN_CLOSED;
+        return false;
+    }
+    conn->registered_events = ev.events;
+    return true;
+}
+
+// A new connection starts a new compression context
+static bool start_inflate(WsConn* conn) {
+    if (!conn->inflater_ready) {
+        if (inflateInit2(&conn->inflater, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+        conn->inflater_ready = true;
+    } else if (inflateReset(&conn->inflater) != Z_OK) {
+        return false;
+    }
+    conn->deflate = true;
+    conn->inflate_reserve = conn->in.capacity / WS_INFLATE_RESERVE_SHARE;
+    return true;
+}
+
+// Parse the 101 response; true once the connection is open
+static bool finish_upgrade(WsConn* conn) {
+    char* response = ring_at(&conn->in, conn->in.head);
+    size_t size = (size_t)(conn->in.tail - conn->in.head);
+    char* end = size >= 4 ? memmem(response, size, "\r\n\r\n", 4) : NULL;
+    if (!end) {
+        if (size > WS_MAX_HANDSHAKE) {
+            fail(conn, WS_CLOSE_PROTOCOL_ERROR, "Upgrade response too large");
+        }
+        return false;
+    }
+    size_t header_length = (size_t)(end - response) + 4;
+    response[header_length - 2] = '\0';
+
+    if (strncmp(response, "HTTP/1.1 101", 12) != 0) {
+        char error[128];
+        char* eol = strstr(response, "\r\n");
+        int status_length = eol ? (int)(eol - response) : 0;
+        snprintf(error, sizeof(error), "Upgrade rejected: %.*s", status_length > 64 ? 64 : status_length, response);
+        fail(conn, WS_CLOSE_PROTOCOL_ERROR, error);
+        return false;
+    }
+
+    char expected[WS_ACCEPT_KEY_SIZE];
+    ws_frame_accept_key(conn->key, expected);
+    bool accepted = false;
+    bool deflate = false;
+    for (char* line = strstr(response, "\r\n"); line && line[2]; line = strstr(line + 2, "\r\n")) {
+        const char* name = line + 2;
+        if (strncasecmp(name, "Sec-WebSocket-Accept:", 21) == 0) {
+            const char* value = name + 21;
+            while (*value == ' ' || *value == '\t') {
+                value++;
+            }
+            accepted = strncmp(value, expected, WS_ACCEPT_KEY_SIZE - 1) == 0;
+        } else if (strncasecmp(name, "Sec-WebSocket-Extensions:", 25) == 0) {
+            // Any window the server picks fits the 15-bit inflate window
+            const char* eol = strstr(name, "\r\n");
+            size_t line_length = eol ? (size_t)(eol - name) : strlen(name);
+            deflate |= memmem(name, line_length, "permessage-deflate", 18) != NULL;
+        }
+    }
+    if (!accepted) {
+        fail(conn, WS_CLOSE_PROTOCOL_ERROR, "Invalid Sec-WebSocket-Accept");
+        return false;
+    }
+    if (deflate && !conn->deflate_offered) {
+        fail(conn, WS_CLOSE_PROTOCOL_ERROR, "Server enabled an extension that was not offered");
+        return false;
+    }
+    if (deflate && !start_inflate(conn)) {
+        fail(conn, WS_CLOSE_ABNORMAL, "Failed to initialise inflate");
+        return false;
+    }
+
+    conn->in.head += header_length;
+    conn->next_frame = conn->in.head;
+    conn->state = WS_CONN_OPEN;
+    conn->deadline_ms = 0;
+    start_keepalive(conn);
+    if (conn->handlers.on_open) {
+        conn->handlers.on_open(conn, conn->user_data);
+    }
+    return conn->state == WS_CONN_OPEN;
+}
+
+// data is a view into the ring. The byte after it is either unparsed input or
+// the ring's free byte; it is borrowed for the terminator and put back.
+static void deliver(WsConn* conn, WsOpcode opcode, char* data, size_t length) {
+    char saved = data[length];
+    data[length] = '\0';
+    if (conn->handlers.on_message) {
+        conn->handlers.on_message(conn, opcode, data, length, conn->user_data);
+    }
+    if (conn->state != WS_CONN_CLOSED) {
+        data[length] = saved;
+    }
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Inflate a complete compressed message into the free ring space past tail
+// and deliver it from there. position is the ring position of the compressed
+// data: everything from it to tail is still needed, anything before it is not,
+// so the output may use the whole ring but that span.
+static void deliver_inflated(WsConn* conn, WsOpcode opcode, const char* data, size_t length, uint64_t position) {
+    static const uint8_t trailer[4] = {0x00, 0x00, 0xff, 0xff};     // Stripped by the sender (RFC 7692 7.2.1)
+    WsRing* ring = &conn->in;
+    z_stream* stream = &conn->inflater;
+    char* out = ring_at(ring, ring->tail);
+    size_t space = ring->capacity - 2 - (size_t)(ring->tail - position);   // One byte for the terminator
+    uint64_t start_ns = monotonic_ns();
+
+    stream->next_out = (Bytef*)out;
+    stream->avail_out = (uInt)space;
+    int status = Z_OK;
+    if (length > 0) {
+        stream->next_in = (Bytef*)data;
+        stream->avail_in = (uInt)length;
+        status = inflate(stream, Z_SYNC_FLUSH);
+    }
+    if ((status == Z_OK && stream->avail_in == 0) && stream->avail_out > 0) {
+        stream->next_in = (Bytef*)trailer;
+        stream->avail_in = sizeof(trailer);
+        status = inflate(stream, Z_SYNC_FLUSH);
+    }
+    bool complete = (status == Z_OK || status == Z_STREAM_END) && stream->avail_in == 0 && stream->avail_out > 0;
+    if (status == Z_STREAM_END) {
+        inflateReset(stream);
+    }
+    if (!complete) {
+        fail(conn, stream->avail_out == 0 ? WS_CLOSE_TOO_BIG : WS_CLOSE_PROTOCOL_ERROR,
+             stream->avail_out == 0 ? "Inflated message too large" : "Invalid compressed message");
+        return;
+    }
+
+    size_t inflated = space - stream->avail_out;
+    conn->compression_stats.messages++;
+    conn->compression_stats.compressed_bytes += length;
+    conn->compression_stats.inflated_bytes += inflated;
+    conn->compression_stats.inflate_ns += monotonic_ns() - start_ns;
+    deliver(conn, opcode, out, inflated);
+}
+
+static void handle_close_frame(WsConn* conn, const uint8_t* payload, size_t length) {
+    int code = WS_CLOSE_NO_STATUS;
+    char reason[124] = "";
+    if (length >= 2) {
+        code = (payload[0] << 8) | payload[1];
+        size_t reason_length = length - 2 < sizeof(reason) - 1 ? length - 2 : sizeof(reason) - 1;
+        memcpy(reason, payload + 2, reason_length);
+        reason[reason_length] = '\0';
+    }
+    if (conn->state == WS_CONN_OPEN) {
+        // Echo the close and let the server drop the connection
+        uint8_t echo[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+        queue_frame(conn, WS_OP_CLOSE, echo, code == WS_CLOSE_NO_STATUS ? 0 : 2);
+    }
+    finish(conn, code, reason);
+}
+
+// Dispatch every complete frame in the ring. Payloads are delivered where they
+// were received; continuation payloads are moved down onto the end of the
+// message so far, over the headers in between.
+static void process_frames(WsConn* conn) {
+    WsRing* ring = &conn->in;
+    while (conn->state == WS_CONN_OPEN || conn->state == WS_CONN_CLOSING) {
+        WsFrameHeader header;
+        uint8_t* frame = (uint8_t*)ring_at(ring, conn->next_frame);
+        int parsed = ws_frame_parse_header(frame, (size_t)(ring->tail - conn->next_frame), &header);
+        if (parsed == 0) {
+            break;
+        }
+        // RSV1 marks the first frame of a compressed message
+        bool compressed_start = header.opcode == WS_OP_TEXT || header.opcode == WS_OP_BINARY;
+        if (parsed < 0 || header.masked || (header.rsv1 && (!conn->deflate || !compressed_start))) {
+            fail(conn, WS_CLOSE_PROTOCOL_ERROR, "Invalid frame from server");
+            return;
+        }
+        // The frame and whatever of the message precedes it must fit in the ring
+        uint64_t held = conn->next_frame - (conn->in_message ? conn->message_start : conn->next_frame);
+        if (held + header.header_length + header.payload_length > ring->capacity - 1 - conn->inflate_reserve) {
+            fail(conn, WS_CLOSE_TOO_BIG, "Message too large");
+            return;
+        }
+        size_t frame_length = header.header_length + (size_t)header.payload_length;
+        if (ring->tail - conn->next_frame < frame_length) {
+            break;
+        }
+
+        char* payload = (char*)frame + header.header_length;
+        size_t length = (size_t)header.payload_length;
+        uint64_t payload_start = conn->next_frame + header.header_length;
+        conn->next_frame += frame_length;
+
+        switch (header.opcode) {
+            case WS_OP_TEXT:
+            case WS_OP_BINARY:
+                if (conn->in_message) {
+                    fail(conn, WS_CLOSE_PROTOCOL_ERROR, "New message inside a fragmented one");
+                    return;
+                }
+                if (header.fin && header.rsv1) {
+                    deliver_inflated(conn, header.opcode, payload, length, payload_start);
+                } else if (header.fin) {
+                    deliver(conn, header.opcode, payload, length);
+                } else {
+                    conn->message_start = payload_start;
+                    conn->message_size = length;
+                    conn->message_opcode = header.opcode;
+                    conn->message_compressed = header.rsv1;
+                    conn->in_message = true;
+                }
+                break;
+            case WS_OP_CONTINUATION: {
+                if (!conn->in_message) {
+                    fail(conn, WS_CLOSE_PROTOCOL_ERROR, "Unexpected continuation frame");
+                    return;
+                }
+                // Both addresses are taken from the same mapping of the message
+                // start so that memmove sees their true order
+                char* message = ring_at(ring, conn->message_start);
+                uint64_t end = conn->message_start + conn->message_size;
+                memmove(message + conn->message_size, message + conn->message_size + (payload_start - end), length);
+                conn->message_size += length;
+                if (header.fin) {
+                    conn->in_message = false;
+                    if (conn->message_compressed) {
+                        deliver_inflated(conn, conn->message_opcode, message, conn->message_size, conn->message_start);
+                    } else {
+                        deliver(conn, conn->message_opcode, message, conn->message_size);
+                    }
+                }
+                break;
+            }
+            case WS_OP_PING:
+                if (conn->state == WS_CONN_OPEN) {
+                    queue_frame(conn, WS_OP_PONG, payload, length);
+                }
+                break;
+            case WS_OP_PONG:
+                break;
+            case WS_OP_CLOSE:
+                handle_close_frame(conn, (const uint8_t*)payload, length);
+                return;
+        }
+    }
+    if (conn->state != WS_CONN_CLOSED) {
+        ring->head = conn->in_message ? conn->message_start : conn->next_frame;
+    }
+}
+
+// Read straight into the ring until the socket is drained or the ring is full.
+// Returns 1 if drained, 2 if the ring filled first, 0 at end of stream
+// (buffered frames still to process), -1 if the connection failed.
+static int read_input(WsConn* conn) {
+    conn->receive_delay_ns = 0;
+    for (;;) {
+        size_t space = ring_read_space(conn);
+        if (space == 0) {
+            return 2;
+        }
+        ssize_t n = conn_read(conn, ring_at(&conn->in, conn->in.tail), space);
+        if (n == -1) {
+            return 1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        if (n < 0) {
+            fail(conn, WS_CLOSE_ABNORMAL, "Read failed");
+            return -1;
+        }
+        conn->in.tail += (uint64_t)n;
+        conn->bytes_received += (uint64_t)n;
+        conn->last_receive_ms = monotonic_ms();
+    }
+}
+
+void ws_conn_handle_events(WsConn* conn, uint32_t events) {
+    if (!conn || conn->state == WS_CONN_CLOSED) {
+        return;
+    }
+
+    if (conn->state == WS_CONN_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if ((events & (EPOLLERR | EPOLLHUP)) ||
+            getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            fail(conn, WS_CLOSE_ABNORMAL, error ? strerror(error) : "Connection failed");
+            return;
+        }
+        if (!(events & EPOLLOUT)) {
+            return;
+        }
+        if (conn->tls) {
+            if (!start_tls(conn)) {
+                return;
+            }
+        } else {
+            send_upgrade(conn);
+            return;
+        }
+    }
+
+    if (conn->state == WS_CONN_TLS_HANDSHAKE) {
+        if (!continue_tls(conn)) {
+            return;
+        }
+        send_upgrade(conn);
+        return;
+    }
+
+    if ((events & EPOLLOUT) && !flush_output(conn)) {
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        // Alternate reads and parsing while the ring is the limit, so nothing
+        // is left behind in the TLS layer where epoll cannot see it
+        int status;
+        do {
+            status = read_input(conn);
+            if (status < 0) {
+                return;
+            }
+            if (conn->state == WS_CONN_UPGRADING && !finish_upgrade(conn)) {
+                if (status == 0) {
+                    fail(conn, WS_CLOSE_ABNORMAL, "Connection closed during upgrade");
+                }
+                return;
+            }
+            process_frames(conn);
+        } while (status == 2 && conn->state != WS_CONN_CLOSED && ring_read_space(conn) > 0);
+        if (status == 2 && conn->state != WS_CONN_CLOSED) {
+            fail(conn, WS_CLOSE_TOO_BIG, "Message too large");
+            return;
+        }
+        if (status == 0) {
+            // Usually already closed by the server's close frame
+            finish(conn, WS_CLOSE_ABNORMAL, "Connection closed by server");
+        }
+    }
+}
+
+bool ws_conn_poll(WsConn* conn) {
+    if (!conn || (conn->state != WS_CONN_OPEN && conn->state != WS_CONN_CLOSING)) {
+        return false;
+    }
+    uint64_t received = conn->bytes_received;
+    ws_conn_handle_events(conn, EPOLLIN | (conn->want_write ? EPOLLOUT : 0));
+    return conn->bytes_received != received;
+}
+
+void ws_conn_check_timeout(WsConn* conn) {
+    if (!conn || conn->state == WS_CONN_CLOSED || conn->deadline_ms == 0 || monotonic_ms() < conn->deadline_ms) {
+        return;
+    }
+    if (conn->state == WS_CONN_CLOSING) {
+        finish(conn, WS_CLOSE_NORMAL, "Closing handshake timed out");
+    } else {
+        fail(conn, WS_CLOSE_ABNORMAL, "WebSocket handshake timed out");
+    }
+}
+
+bool ws_conn_send(WsConn* conn, WsOpcode opcode, const void* data, size_t length) {
+    if (!conn || conn->state != WS_CONN_OPEN || ((opcode & 0x8) && length > 125)) {
+        return false;
+    }
+    return queue_frame(conn, opcode, data, length);
+}
+
+bool ws_conn_ping(WsConn* conn) {
+    return ws_conn_send(conn, WS_OP_PING, NULL, 0);
+}
+
+void ws_conn_set_keepalive(WsConn* conn, TimerWheel* wheel, int ping_interval_ms, int timeout_ms) {
+    if (!conn) {
+        return;
+    }
+    if (conn->wheel) {
+        timer_wheel_cancel(conn->wheel, &conn->ping_timer);
+        timer_wheel_cancel(conn->wheel, &conn->liveness_timer);
+    }
+    conn->wheel = wheel;
+    conn->ping_interval_ms = ping_interval_ms > 0 ? ping_interval_ms : 0;
+    conn->liveness_timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+    timer_init(&conn->ping_timer, on_ping_timer, conn);
+    timer_init(&conn->liveness_timer, on_liveness_timer, conn);
+    if (conn->state == WS_CONN_OPEN) {
+        start_keepalive(conn);
+    }
+}
+
+bool ws_conn_set_compression(WsConn* conn, bool enabled) {
+    if (!conn || conn->state != WS_CONN_CLOSED) {
+        return false;
+    }
+    conn->deflate_offered = enabled;
+    return true;
+}
+
+bool ws_conn_compression_active(const WsConn* conn) {
+    return conn && conn->deflate;
+}
+
+void ws_conn_get_compression_stats(const WsConn* conn, WsConnCompressionStats* out) {
+    if (conn && out) {
+        *out = conn->compression_stats;
+    }
+}
+
+void ws_conn_set_coalescing(WsConn* conn, bool enabled) {
+    if (!conn) {
+        return;
+    }
+    conn->coalesce = enabled;
+    if (!enabled) {
+        ws_conn_flush(conn);
+    }
+}
+
+bool ws_conn_flush(WsConn* conn) {
+    if (!conn || conn->fd < 0) {
+        return false;
+    }
+    // A blocked socket is left to EPOLLOUT
+    if (conn->out.size == conn->out_offset || conn->want_write) {
+        return true;
+    }
+    return flush_output(conn);
+}
+
+size_t ws_conn_output_pending(const WsConn* conn) {
+    return conn ? conn->out.size - conn->out_offset : 0;
+}
+
+void ws_conn_get_write_stats(const WsConn* conn, WsConnWriteStats* out) {
+    if (!conn || !out) {
+        return;
+    }
+    *out = conn->write_stats;
+    out->writes_saved = out->frames > out->writes ? out->frames - out->writes : 0;
+}
+
+bool ws_conn_close(WsConn* conn, uint16_t code, const char* reason) {
+    if (!conn || conn->state == WS_CONN_CLOSED || conn->state == WS_CONN_CLOSING) {
+        return false;
+    }
+    if (conn->state != WS_CONN_OPEN) {
+        finish(conn, WS_CLOSE_ABNORMAL, "Closed before the handshake completed");
+        return true;
+    }
+
+    uint8_t payload[125];
+    size_t reason_length = reason ? strlen(reason) : 0;
+    if (reason_length > sizeof(payload) - 2) {
+        reason_length = sizeof(payload) - 2;
+    }
+    payload[0] = (uint8_t)(code >> 8);
+    payload[1] = (uint8_t)code;
+    if (reason_length > 0) {
+        memcpy(payload + 2, reason, reason_length);
+    }
+    if (!queue_frame(conn, WS_OP_CLOSE, payload, reason_length + 2)) {
+        return false;
+    }
+    if (conn->state == WS_CONN_OPEN) {
+        conn->state = WS_CONN_CLOSING;
+        conn->deadline_ms = monotonic_ms() + WS_CLOSE_TIMEOUT_MS;
+    }
+    return true;
+}
+
+WsConnState ws_conn_state(const WsConn* conn) {
+    return conn ? conn->state : WS_CONN_CLOSED;
+}
+
+uint64_t ws_conn_last_receive_ms(const WsConn* conn) {
+    return conn ? conn->last_receive_ms : 0;
+}
+
+uint64_t ws_conn_receive_delay_ns(const WsConn* conn) {
+    return conn ? conn->receive_delay_ns : 0;
+}
@@ -0,0 +1,139 @@
+#ifndef WS_CONN_H
+#define WS_CONN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ws_frame.h"
+#include "timer_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One RFC 6455 client connection (ws:// or wss://) on a non-blocking socket.
+// The owner's epoll instance drives it: ws_conn_open registers the socket with
+// data.ptr = conn, and every readiness event goes to ws_conn_handle_events.
+// Handlers run from there; they may send or close but must not destroy.
+
+typedef enum {
+    WS_CONN_CLOSED,
+    WS_CONN_CONNECTING,       // TCP connect in progress
+    WS_CONN_TLS_HANDSHAKE,
+    WS_CONN_UPGRADING,        // Upgrade request sent, waiting for 101
+    WS_CONN_OPEN,
+    WS_CONN_CLOSING           // Close frame sent, waiting for the server's
+} WsConnState;
+
+typedef struct WsConn WsConn;
+
+typedef struct {
+    uint64_t frames;          // Frames queued by ws_conn_send and control replies
+    uint64_t writes;          // Socket (or SSL_write) calls that moved data
+    uint64_t bytes;           // Bytes written, framing included
+    uint64_t writes_saved;    // frames - writes, when coalescing wins
+} WsConnWriteStats;
+
+typedef struct {
+    uint64_t messages;        // Compressed messages inflated
+    uint64_t compressed_bytes;    // Their payload bytes as received
+    uint64_t inflated_bytes;  // The same messages after inflating
+    uint64_t inflate_ns;      // Time spent in inflate
+} WsConnCompressionStats;
+
+typedef struct {
+    void (*on_open)(WsConn* conn, void* user_data);
+    // A complete (reassembled) message as a view into the receive ring; text is
+    // NUL-terminated. Valid only until the handler returns.
+    void (*on_message)(WsConn* conn, WsOpcode opcode, const char* data, size_t length, void* user_data);
+    // The connection is gone; code 1006 if it ended without a close handshake
+    void (*on_close)(WsConn* conn, int code, const char* reason, void* user_data);
+    void (*on_error)(WsConn* conn, const char* error, void* user_data);
+} WsConnHandlers;
+
+WsConn* ws_conn_create(const WsConnHandlers* handlers, void* user_data);
+void ws_conn_destroy(WsConn* conn);
+
+// Receive ring size (rounded up to a power of two, default 4 MB), set while
+// closed. It bounds the largest message, including any fragment headers.
+bool ws_conn_set_receive_buffer(WsConn* conn, size_t bytes);
+
+// SO_BUSY_POLL for the socket: microseconds the kernel may spin on the device
+// queue before a read reports no data; 0 leaves it off. Applied at open, or
+// immediately if already open (false if the kernel refuses it).
+bool ws_conn_set_busy_poll(WsConn* conn, int busy_poll_us);
+
+// Kernel receive timestamps (SO_TIMESTAMPNS) on ws:// sockets, so
+// ws_conn_receive_delay_ns can report how long data sat in the socket
+void ws_conn_set_receive_timestamps(WsConn* conn, bool enabled);
+
+// Offer permessage-deflate (RFC 7692) in the upgrade; set while closed. If the
+// server accepts, compressed messages are inflated straight into the free
+// part of the receive ring by one zlib stream kept for the connection's
+// lifetime, and a quarter of the ring is held back from reads for that
+// output, which bounds the largest inflated message. Outgoing messages are
+// sent uncompressed.
+bool ws_conn_set_compression(WsConn* conn, bool enabled);
+
+// Whether the open connection negotiated permessage-deflate
+bool ws_conn_compression_active(const WsConn* conn);
+
+// Totals since the connection was created
+void ws_conn_get_compression_stats(const WsConn* conn, WsConnCompressionStats* out);
+
+// Keep-alive on the owner's timer wheel: a ping every ping_interval_ms, and
+// the connection fails (on_close with 1006) once nothing at all has been
+// received for timeout_ms. Either may be 0 to disable it. The timers run from
+// timer_wheel_advance, never from the receive path; they start when the
+// connection opens (or now, if it is open) and stop when it closes.
+void ws_conn_set_keepalive(WsConn* conn, TimerWheel* wheel, int ping_interval_ms, int timeout_ms);
+
+// Start connecting; the handshake completes from ws_conn_handle_events and
+// fails if it takes longer than timeout_ms
+bool ws_conn_open(WsConn* conn, const char* url, int epoll_fd, int timeout_ms);
+
+// Process readiness reported by epoll_wait
+void ws_conn_handle_events(WsConn* conn, uint32_t events);
+
+// Read and process whatever the open socket holds without waiting for
+// readiness, for owners that spin instead of blocking in epoll_wait. True if
+// any data arrived. Handshakes still complete from ws_conn_handle_events.
+bool ws_conn_poll(WsConn* conn);
+
+// Enforce handshake and closing deadlines; call from the event loop
+void ws_conn_check_timeout(WsConn* conn);
+
+// Send one unfragmented message (or control frame); masked, queued if the socket is full
+bool ws_conn_send(WsConn* conn, WsOpcode opcode, const void* data, size_t length);
+bool ws_conn_ping(WsConn* conn);
+
+// Hold outgoing frames in the outbound buffer instead of writing each one, so
+// everything sent in one loop iteration leaves in a single write; the owner
+// calls ws_conn_flush once per iteration. Close frames are never held.
+void ws_conn_set_coalescing(WsConn* conn, bool enabled);
+
+// Write held output now; false if the connection failed
+bool ws_conn_flush(WsConn* conn);
+
+// Bytes queued but not yet written
+size_t ws_conn_output_pending(const WsConn* conn);
+
+void ws_conn_get_write_stats(const WsConn* conn, WsConnWriteStats* out);
+
+// Start the closing handshake
+bool ws_conn_close(WsConn* conn, uint16_t code, const char* reason);
+
+WsConnState ws_conn_state(const WsConn* conn);
+
+// Monotonic time (ms) of the last frame received, for keep-alive checks
+uint64_t ws_conn_last_receive_ms(const WsConn* conn);
+
+// Nanoseconds between the kernel receiving data and the last read pass picking
+// it up; 0 if that pass read nothing or no timestamp was available (wss://)
+uint64_t ws_conn_receive_delay_ns(const WsConn* conn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS_CONN_H
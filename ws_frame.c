@@ -0,0 +1,242 @@
+#include <string.h>
+#include "ws_frame.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+int ws_frame_parse_header(const uint8_t* data, size_t length, WsFrameHeader* header) {
+    if (length < 2) {
+        return 0;
+    }
+
+    uint8_t b0 = data[0];
+    uint8_t b1 = data[1];
+    if (b0 & 0x30) {
+        return -1;               // RSV2/RSV3 are never negotiated
+    }
+
+    header->fin = (b0 & 0x80) != 0;
+    header->rsv1 = (b0 & 0x40) != 0;
+    header->opcode = (WsOpcode)(b0 & 0x0f);
+    header->masked = (b1 & 0x80) != 0;
+
+    size_t pos = 2;
+    uint64_t payload_length = b1 & 0x7f;
+    if (payload_length == 126) {
+        if (length < pos + 2) {
+            return 0;
+        }
+        payload_length = ((uint64_t)data[2] << 8) | data[3];
+        pos += 2;
+    } else if (payload_length == 127) {
+        if (length < pos + 8) {
+            return 0;
+        }
+        payload_length = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_length = (payload_length << 8) | data[pos + i];
+        }
+        if (payload_length >> 63) {
+            return -1;
+        }
+        pos += 8;
+    }
+
+    bool control = (header->opcode & 0x8) != 0;
+    if (control && (!header->fin || payload_length > 125)) {
+        return -1;
+    }
+    switch (header->opcode) {
+        case WS_OP_CONTINUATION:
+        case WS_OP_TEXT:
+        case WS_OP_BINARY:
+        case WS_OP_CLOSE:
+        case WS_OP_PING:
+        case WS_OP_PONG:
+            break;
+        default:
+            return -1;
+    }
+
+    if (header->masked) {
+        if (length < pos + 4) {
+            return 0;
+        }
+        memcpy(header->mask, data + pos, 4);
+        pos += 4;
+    } else {
+        memset(header->mask, 0, 4);
+    }
+
+    header->payload_length = payload_length;
+    header->header_length = pos;
+    return 1;
+}
+
+size_t ws_frame_write_header(uint8_t* out, WsOpcode opcode, bool fin, bool rsv1,
+                             uint64_t payload_length, const uint8_t* mask) {
+    size_t pos = 0;
+    out[pos++] = (uint8_t)((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | (opcode & 0x0f));
+
+    uint8_t mask_bit = mask ? 0x80 : 0;
+    if (payload_length < 126) {
+        out[pos++] = (uint8_t)(mask_bit | payload_length);
+    } else if (payload_length <= 0xffff) {
+        out[pos++] = (uint8_t)(mask_bit | 126);
+        out[pos++] = (uint8_t)(payload_length >> 8);
+        out[pos++] = (uint8_t)payload_length;
+    } else {
+        out[pos++] = (uint8_t)(mask_bit | 127);
+        for (int i = 7; i >= 0; i--) {
+            out[pos++] = (uint8_t)(payload_length >> (i * 8));
+        }
+    }
+
+    if (mask) {
+        memcpy(out + pos, mask, 4);
+        pos += 4;
+    }
+    return pos;
+}
+
+void ws_frame_apply_mask(uint8_t* data, size_t length, const uint8_t mask[4], size_t offset) {
+    size_t i = 0;
+
+    // Byte-wise until the mask lines up, then eight bytes at a time
+    while (i < length && ((offset + i) & 3) != 0) {
+        data[i] ^= mask[(offset + i) & 3];
+        i++;
+    }
+    if (length - i >= 8) {
+        uint8_t wide_bytes[8] = {mask[0], mask[1], mask[2], mask[3], mask[0], mask[1], mask[2], mask[3]};
+        uint64_t wide;
+        memcpy(&wide, wide_bytes, 8);
+        for (; length - i >= 8; i += 8) {
+            uint64_t chunk;
+            memcpy(&chunk, data + i, 8);
+            chunk ^= wide;
+            memcpy(data + i, &chunk, 8);
+        }
+    }
+    for (; i < length; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+// SHA-1, only used for the handshake accept key
+typedef struct {
+    uint32_t state[5];
+    uint64_t bit_count;
+    uint8_t block[64];
+    size_t block_length;
+} Sha1;
+
+static uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1_block(Sha1* ctx, const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3], e = ctx->state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t temp = rotl32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl32(b, 30);
+        b = a;
+        a = temp;
+    }
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+}
+
+static void sha1_init(Sha1* ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xc3d2e1f0;
+    ctx->bit_count = 0;
+    ctx->block_length = 0;
+}
+
+static void sha1_update(Sha1* ctx, const uint8_t* data, size_t length) {
+    ctx->bit_count += (uint64_t)length * 8;
+    for (size_t i = 0; i < length; i++) {
+        ctx->block[ctx->block_length++] = data[i];
+        if (ctx->block_length == 64) {
+            sha1_block(ctx, ctx->block);
+            ctx->block_length = 0;
+        }
+    }
+}
+
+static void sha1_final(Sha1* ctx, uint8_t digest[20]) {
+    uint64_t bit_count = ctx->bit_count;
+    uint8_t pad = 0x80;
+    sha1_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->block_length != 56) {
+        sha1_update(ctx, &pad, 1);
+    }
+    uint8_t length_bytes[8];
+    for (int i = 0; i < 8; i++) {
+        length_bytes[i] = (uint8_t)(bit_count >> (56 - i * 8));
+    }
+    sha1_update(ctx, length_bytes, 8);
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+void ws_frame_base64(const uint8_t* data, size_t length, char* out) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t pos = 0;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t chunk = (uint32_t)data[i] << 16;
+        if (i + 1 < length) chunk |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) chunk |= data[i + 2];
+        out[pos++] = ALPHABET[(chunk >> 18) & 0x3f];
+        out[pos++] = ALPHABET[(chunk >> 12) & 0x3f];
+        out[pos++] = i + 1 < length ? ALPHABET[(chunk >> 6) & 0x3f] : '=';
+        out[pos++] = i + 2 < length ? ALPHABET[chunk & 0x3f] : '=';
+    }
+    out[pos] = '\0';
+}
+
+void ws_frame_accept_key(const char* client_key, char out[WS_ACCEPT_KEY_SIZE]) {
+    Sha1 ctx;
+    uint8_t digest[20];
+    sha1_init(&ctx);
+    sha1_update(&ctx, (const uint8_t*)client_key, strlen(client_key));
+    sha1_update(&ctx, (const uint8_t*)WS_GUID, strlen(WS_GUID));
+    sha1_final(&ctx, digest);
+    ws_frame_base64(digest, sizeof(digest), out);
+}
@@ -0,0 +1,59 @@
+#ifndef WS_FRAME_H
+#define WS_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// RFC 6455 frame codec shared by the client and the mock exchange server
+
+#define WS_FRAME_MAX_HEADER 14
+#define WS_ACCEPT_KEY_SIZE 29     // Base64 SHA-1 plus terminator
+
+// Frame opcodes
+typedef enum {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+} WsOpcode;
+
+typedef struct {
+    bool fin;
+    bool rsv1;                    // Set on compressed messages (permessage-deflate)
+    WsOpcode opcode;
+    bool masked;
+    uint8_t mask[4];
+    uint64_t payload_length;
+    size_t header_length;
+} WsFrameHeader;
+
+// Parse a frame header; returns 1 when parsed, 0 if more bytes are needed,
+// -1 on a protocol error
+int ws_frame_parse_header(const uint8_t* data, size_t length, WsFrameHeader* header);
+
+// Write a frame header into out (WS_FRAME_MAX_HEADER bytes); mask is NULL for
+// server frames. Returns the header length.
+size_t ws_frame_write_header(uint8_t* out, WsOpcode opcode, bool fin, bool rsv1,
+                             uint64_t payload_length, const uint8_t* mask);
+
+// XOR data with mask, starting offset bytes into the payload
+void ws_frame_apply_mask(uint8_t* data, size_t length, const uint8_t mask[4], size_t offset);
+
+// Sec-WebSocket-Accept value for a Sec-WebSocket-Key
+void ws_frame_accept_key(const char* client_key, char out[WS_ACCEPT_KEY_SIZE]);
+
+// Base64 encode; out needs 4 * ((length + 2) / 3) + 1 bytes
+void ws_frame_base64(const uint8_t* data, size_t length, char* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS_FRAME_H
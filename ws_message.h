@@ -0,0 +1,36 @@
+#ifndef WS_MESSAGE_H
+#define WS_MESSAGE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Message type shared by the WebSocket client and the feed simulator, so the
+// simulator (and the mock server built on it) does not pull in the client
+
+// WebSocket message types
+typedef enum {
+    WS_MESSAGE_TEXT,
+    WS_MESSAGE_BINARY,
+    WS_MESSAGE_PING,
+    WS_MESSAGE_PONG,
+    WS_MESSAGE_CLOSE
+} WebSocketMessageType;
+
+// WebSocket message structure
+typedef struct {
+    WebSocketMessageType type;
+    char* data;         // View into the receive buffer; valid only during the callback
+    size_t length;
+    char channel[128];  // Added channel field to track message source
+} WebSocketMessage;
+
+typedef void (*WebSocketMessageCallback)(const WebSocketMessage* message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS_MESSAGE_H
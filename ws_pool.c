@@ -0,0 +1,852 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "ws_pool.h"
+#include "subscription_table.h"
+
+#define WS_POOL_MAX_EVENTS 8
+#define WS_POOL_WAIT_MS 100             // Servicing threads wake at least this often for timers
+#define WS_POOL_CLOSE_WAIT_MS 1000
+#define WS_POOL_DEFAULT_CONNECT_TIMEOUT_MS 10000
+#define WS_POOL_BATCH_CHANNELS 64       // Channels per subscribe call
+#define WS_POOL_TIMER_TICK_MS 10
+#define WS_POOL_KEEPALIVE_MISSES 3      // Silent ping intervals before a connection is dropped
+#define WS_POOL_DEFAULT_RECONNECT_DELAY_MS 1000
+#define WS_POOL_DEFAULT_MAX_RECONNECT_DELAY_MS 30000
+
+typedef enum {
+    POOL_COMMAND_SUBSCRIBE,
+    POOL_COMMAND_UNSUBSCRIBE
+} PoolCommandType;
+
+typedef struct {
+    PoolCommandType type;
+    char channel[SUBSCRIPTION_CHANNEL_SIZE];
+    bool typed;
+    SubscriptionType subscription_type;
+    MarketDataHandlers handlers;
+    WebSocketSubscriptionCallback callback;
+    bool cancelled;                     // Unsubscribed while its subscribe call was in flight
+} PoolCommand;
+
+// Subscribe call awaiting its response
+typedef struct {
+    uint64_t request_id;
+    PoolCommand* channels;
+    int count;
+} PoolBatch;
+
+typedef struct {
+    WsPool* pool;
+    int index;
+    WsConn* conn;
+    int epoll_fd;
+    int wake_fd;                        // eventfd, signalled when commands are queued
+    pthread_t thread;
+    bool thread_started;
+
+    // Control queue, filled from any thread
+    pthread_mutex_t lock;
+    PoolCommand* commands;
+    int command_count;
+    int command_capacity;
+
+    // Servicing thread only
+    SubscriptionTable subscriptions;
+    PoolCommand* unsent;                // Subscribes waiting for the connection to open
+    int unsent_count;
+    int unsent_capacity;
+    PoolBatch* batches;
+    int batch_count;
+    int batch_capacity;
+    uint64_t next_request_id;
+    uint64_t auth_request_id;           // 0 unless public/auth is outstanding
+    TimerWheel timers;                  // Keep-alive and reconnect deadlines
+    Timer reconnect_timer;
+    int reconnect_attempt;              // Since the connection was last open
+    unsigned int random_state;          // Backoff jitter
+    bool closing;                       // Being destroyed; no reconnect
+    MarketDataScratch scratch;
+
+    // Written by the servicing thread, read by ws_pool_get_stats
+    int state;
+    uint64_t messages;
+    uint64_t sequence_gaps;
+    WsConnCompressionStats compression;
+    bool compressed;
+    uint64_t reconnects;
+} PoolShard;
+
+typedef struct {
+    char channel[SUBSCRIPTION_CHANNEL_SIZE];
+    int connection;
+    double expected_rate;
+} PoolPlacement;
+
+struct WsPool {
+    WsPoolConfig config;
+    WebSocketMessageCallback message_cb;
+    WebSocketErrorCallback error_cb;
+    char url[256];
+    char client_id[128];
+    char client_secret[128];
+    PoolShard* shards;
+    int running;
+
+    // Channel placement, shared by the control calls
+    pthread_mutex_t lock;
+    PoolPlacement* placements;
+    int placement_count;
+    int placement_capacity;
+    double loads[WS_POOL_MAX_CONNECTIONS];
+    int channel_counts[WS_POOL_MAX_CONNECTIONS];
+};
+
+static uint64_t monotonic_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Grow a dynamic array to hold needed items
+static bool reserve(void** items, int* capacity, int needed, size_t item_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    int grown = *capacity ? *capacity * 2 : 16;
+    while (grown < needed) {
+        grown *= 2;
+    }
+    void* resized = realloc(*items, (size_t)grown * item_size);
+    if (!resized) {
+        return false;
+    }
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+static void report_error(PoolShard* shard, const char* error) {
+    printf("WebSocket pool connection %d: %s\n", shard->index, error);
+    if (shard->pool->error_cb) {
+        shard->pool->error_cb(error);
+    }
+}
+
+static bool send_call(PoolShard* shard, uint64_t request_id, const char* method, const char* params) {
+    size_t size = strlen(method) + strlen(params) + 64;
+    char* request = malloc(size);
+    if (!request) {
+        return false;
+    }
+    int length = snprintf(request, size, "{\"jsonrpc\":\"2.0\",\"id\":%llu,\"method\":\"%s\",\"params\":%s}",
+                          (unsigned long long)request_id, method, params);
+    bool sent = ws_conn_send(shard->conn, WS_OP_TEXT, request, (size_t)length);
+    free(request);
+    return sent;
+}
+
+static void send_unsubscribe(PoolShard* shard, const char* channel) {
+    char params[SUBSCRIPTION_CHANNEL_SIZE + 32];
+    snprintf(params, sizeof(params), "{\"channels\":[\"%s\"]}", channel);
+    send_call(shard, shard->next_request_id++,
+              strncmp(channel, "user.", 5) == 0 ? "private/unsubscribe" : "public/unsubscribe", params);
+}
+
+// Channel of a subscribe call still awaiting its answer, or NULL
+static PoolCommand* find_in_flight(PoolShard* shard, const char* channel) {
+    for (int i = 0; i < shard->batch_count; i++) {
+        for (int j = 0; j < shard->batches[i].count; j++) {
+            if (strcmp(shard->batches[i].channels[j].channel, channel) == 0) {
+                return &shard->batches[i].channels[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+// Send waiting subscribes, up to WS_POOL_BATCH_CHANNELS per call
+static void flush_unsent(PoolShard* shard) {
+    while (shard->unsent_count > 0 && ws_conn_state(shard->conn) == WS_CONN_OPEN) {
+        int count = shard->unsent_count < WS_POOL_BATCH_CHANNELS ? shard->unsent_count : WS_POOL_BATCH_CHANNELS;
+        if (!reserve((void**)&shard->batches, &shard->batch_capacity, shard->batch_count + 1, sizeof(PoolBatch))) {
+            return;
+        }
+        PoolBatch batch = { .request_id = shard->next_request_id++, .count = count };
+        batch.channels = malloc((size_t)count * sizeof(PoolCommand));
+        char* params = malloc((size_t)count * (SUBSCRIPTION_CHANNEL_SIZE + 3) + 16);
+        if (!batch.channels || !params) {
+            free(batch.channels);
+            free(params);
+            return;
+        }
+        memcpy(batch.channels, shard->unsent, (size_t)count * sizeof(PoolCommand));
+
+        // private/subscribe also takes public channels
+        bool private_channels = false;
+        size_t length = (size_t)sprintf(params, "{\"channels\":[");
+        for (int i = 0; i < count; i++) {
+            private_channels |= strncmp(batch.channels[i].channel, "user.", 5) == 0;
+            length += (size_t)sprintf(params + length, "%s\"%s\"", i ? "," : "", batch.channels[i].channel);
+        }
+        sprintf(params + length, "]}");
+        bool sent = send_call(shard, batch.request_id, private_channels ? "private/subscribe" : "public/subscribe", params);
+        free(params);
+        if (!sent) {
+            free(batch.channels);
+            return;
+        }
+
+        shard->batches[shard->batch_count++] = batch;
+        shard->unsent_count -= count;
+        memmove(shard->unsent, shard->unsent + count, (size_t)shard->unsent_count * sizeof(PoolCommand));
+    }
+}
+
+// The server lists the channels it accepted in the result array
+static void complete_batch(PoolShard* shard, int index, const char* response) {
+    PoolBatch batch = shard->batches[index];
+    shard->batches[index] = shard->batches[--shard->batch_count];
+
+    const char* result = response ? strstr(response, "\"result\":[") : NULL;
+    for (int i = 0; i < batch.count; i++) {
+        const PoolCommand* request = &batch.channels[i];
+        char quoted[SUBSCRIPTION_CHANNEL_SIZE + 2];
+        snprintf(quoted, sizeof(quoted), "\"%s\"", request->channel);
+        bool accepted = result && strstr(result, quoted);
+        if (request->cancelled) {
+            // The unsubscribe was held back until the server had the channel
+            if (accepted && ws_conn_state(shard->conn) == WS_CONN_OPEN) {
+                send_unsubscribe(shard, request->channel);
+            }
+            continue;
+        }
+        Subscription* sub = accepted ? subscription_table_add(&shard->subscriptions, request->channel, NULL) : NULL;
+        if (sub && request->typed) {
+            sub->typed = true;
+            sub->type = request->subscription_type;
+            sub->typed_handlers = request->handlers;
+        }
+        if (request->callback) {
+            request->callback(request->channel, sub != NULL);
+        }
+    }
+    free(batch.channels);
+}
+
+static void fail_batches(PoolShard* shard) {
+    while (shard->batch_count > 0) {
+        complete_batch(shard, shard->batch_count - 1, NULL);
+    }
+}
+
+// Replies to the pool's own calls and heartbeats are handled here;
+// notifications go to their channel's typed handler, else the message callback
+static void deliver(PoolShard* shard, const char* data, size_t length) {
+    if (!strstr(data, "\"method\":\"subscription\"")) {
+        const char* id_field = strstr(data, "\"id\":");
+        uint64_t request_id = id_field ? strtoull(id_field + 5, NULL, 10) : 0;
+        if (request_id != 0 && request_id == shard->auth_request_id) {
+            shard->auth_request_id = 0;
+            if (strstr(data, "\"error\":")) {
+                report_error(shard, "Authentication failed");
+            }
+            return;
+        }
+        for (int i = 0; request_id != 0 && i < shard->batch_count; i++) {
+            if (shard->batches[i].request_id == request_id) {
+                complete_batch(shard, i, data);
+                return;
+            }
+        }
+        // Unsubscribe and public/test replies
+        if (request_id != 0 && request_id < shard->next_request_id) {
+            return;
+        }
+        MarketDataHeartbeat heartbeat = market_data_heartbeat(data);
+        if (heartbeat == MARKET_DATA_TEST_REQUEST) {
+            send_call(shard, shard->next_request_id++, "public/test", "{}");
+        }
+        if (heartbeat != MARKET_DATA_NOT_HEARTBEAT) {
+            return;
+        }
+    }
+
+    WebSocketMessage msg = {
+        .type = WS_MESSAGE_TEXT,
+        .data = (char*)data,
+        .length = length
+    };
+    WebSocketMessageCallback handler = shard->pool->message_cb;
+    const char* channel = strstr(data, "\"channel\":\"");
+    if (channel) {
+        channel += 11;
+        const char* end = strchr(channel, '"');
+        size_t channel_length = end ? (size_t)(end - channel) : 0;
+        if (channel_length < sizeof(msg.channel)) {
+            memcpy(msg.channel, channel, channel_length);
+            msg.channel[channel_length] = '\0';
+            Subscription* sub = subscription_table_find(&shard->subscriptions, channel, channel_length);
+            if (sub) {
+                sub->messages++;
+                __atomic_store_n(&shard->messages, shard->messages + 1, __ATOMIC_RELAXED);
+                uint64_t gaps = sub->sequence_gaps;
+                subscription_track_sequence(sub, data);
+                if (sub->sequence_gaps != gaps) {
+                    __atomic_store_n(&shard->sequence_gaps, shard->sequence_gaps + 1, __ATOMIC_RELAXED);
+                }
+                if (sub->typed && market_data_dispatch(sub->type, &sub->typed_handlers, sub->instrument_id,
+                        subscription_table_instrument_name(&shard->subscriptions, sub->instrument_id),
+                        data, &shard->scratch)) {
+                    return;
+                }
+                if (sub->handler) {
+                    handler = sub->handler;
+                }
+            }
+        }
+    }
+    if (handler) {
+        handler(&msg);
+    }
+}
+
+static void on_conn_open(WsConn* conn, void* user_data) {
+    (void)conn;
+    PoolShard* shard = user_data;
+    WsPool* pool = shard->pool;
+    printf("WebSocket pool connection %d open\n", shard->index);
+    if (shard->reconnect_attempt > 0) {
+        __atomic_store_n(&shard->reconnects, shard->reconnects + 1, __ATOMIC_RELAXED);
+    }
+    shard->reconnect_attempt = 0;
+    if (pool->client_id[0]) {
+        char params[512];
+        snprintf(params, sizeof(params),
+                 "{\"grant_type\":\"client_credentials\",\"client_id\":\"%s\",\"client_secret\":\"%s\"}",
+                 pool->client_id, pool->client_secret);
+        shard->auth_request_id = shard->next_request_id++;
+        send_call(shard, shard->auth_request_id, "public/auth", params);
+    }
+    flush_unsent(shard);
+}
+
+static void on_conn_message(WsConn* conn, WsOpcode opcode, const char* data, size_t length, void* user_data) {
+    (void)conn;
+    if (opcode == WS_OP_TEXT) {
+        deliver(user_data, data, length);
+    }
+}
+
+static void on_conn_error(WsConn* conn, const char* error, void* user_data) {
+    (void)conn;
+    report_error(user_data, error);
+}
+
+// Put the channels of a lost connection, subscribed or awaiting an answer,
+// back in front of the unsent queue so the next open sends them together
+static void requeue_channels(PoolShard* shard) {
+    int count = (int)shard->subscriptions.count;
+    for (int i = 0; i < shard->batch_count; i++) {
+        count += shard->batches[i].count;
+    }
+    if (!reserve((void**)&shard->unsent, &shard->unsent_capacity, shard->unsent_count + count, sizeof(PoolCommand))) {
+        report_error(shard, "Out of memory; subscriptions dropped");
+        subscription_table_clear(&shard->subscriptions);
+        fail_batches(shard);
+        return;
+    }
+    memmove(shard->unsent + count, shard->unsent, (size_t)shard->unsent_count * sizeof(PoolCommand));
+    int next = 0;
+    for (uint32_t i = 0; i < shard->subscriptions.count; i++) {
+        const Subscription* sub = subscription_table_at(&shard->subscriptions, i);
+        PoolCommand* command = &shard->unsent[next++];
+        memset(command, 0, sizeof(*command));
+        command->type = POOL_COMMAND_SUBSCRIBE;
+        snprintf(command->channel, sizeof(command->channel), "%s", sub->channel);
+        command->typed = sub->typed;
+        command->subscription_type = sub->type;
+        command->handlers = sub->typed_handlers;
+    }
+    for (int i = 0; i < shard->batch_count; i++) {
+        for (int j = 0; j < shard->batches[i].count; j++) {
+            if (!shard->batches[i].channels[j].cancelled) {
+                shard->unsent[next++] = shard->batches[i].channels[j];
+            }
+        }
+        free(shard->batches[i].channels);
+    }
+    shard->batch_count = 0;
+    memmove(shard->unsent + next, shard->unsent + count, (size_t)shard->unsent_count * sizeof(PoolCommand));
+    shard->unsent_count += next;
+    subscription_table_clear(&shard->subscriptions);
+}
+
+// Jittered exponential backoff: the first attempt is immediate, later ones
+// wait a random time in [d/2, d], d doubling up to max_reconnect_delay_ms
+static void schedule_reconnect(PoolShard* shard) {
+    const WsPoolConfig* config = &shard->pool->config;
+    uint64_t delay = 0;
+    if (shard->reconnect_attempt > 0) {
+        uint64_t ceiling = (uint64_t)config->reconnect_delay_ms;
+        for (int i = 1; i < shard->reconnect_attempt && ceiling < (uint64_t)config->max_reconnect_delay_ms; i++) {
+            ceiling *= 2;
+        }
+        if (ceiling > (uint64_t)config->max_reconnect_delay_ms) {
+            ceiling = (uint64_t)config->max_reconnect_delay_ms;
+        }
+        delay = ceiling / 2 + (uint64_t)rand_r(&shard->random_state) % (ceiling / 2 + 1);
+    }
+    shard->reconnect_attempt++;
+    printf("WebSocket pool connection %d: reconnect attempt %d in %llums\n",
+           shard->index, shard->reconnect_attempt, (unsigned long long)delay);
+    timer_wheel_schedule(&shard->timers, &shard->reconnect_timer, monotonic_ms() + delay);
+}
+
+// Runs from the servicing loop, never from connection handlers
+static void on_reconnect_timer(Timer* timer, uint64_t now_ms, void* user_data) {
+    (void)timer;
+    (void)now_ms;
+    PoolShard* shard = user_data;
+    if (shard->closing || ws_conn_state(shard->conn) != WS_CONN_CLOSED) {
+        return;
+    }
+    if (!ws_conn_open(shard->conn, shard->pool->url, shard->epoll_fd, shard->pool->config.connect_timeout_ms)) {
+        schedule_reconnect(shard);
+    }
+}
+
+static void on_conn_close(WsConn* conn, int code, const char* reason, void* user_data) {
+    (void)conn;
+    PoolShard* shard = user_data;
+    printf("WebSocket pool connection %d closed: %d %s\n", shard->index, code, reason);
+    shard->auth_request_id = 0;
+    if (shard->closing) {
+        subscription_table_clear(&shard->subscriptions);
+        fail_batches(shard);
+        return;
+    }
+    requeue_channels(shard);
+    schedule_reconnect(shard);
+}
+
+// Apply queued control commands on the servicing thread
+static void drain_commands(PoolShard* shard) {
+    uint64_t signalled;
+    if (read(shard->wake_fd, &signalled, sizeof(signalled)) < 0) {
+        // Nothing pending; the queue is checked anyway
+    }
+    pthread_mutex_lock(&shard->lock);
+    for (int i = 0; i < shard->command_count; i++) {
+        const PoolCommand* command = &shard->commands[i];
+        PoolCommand* in_flight = find_in_flight(shard, command->channel);
+        if (command->type == POOL_COMMAND_SUBSCRIBE) {
+            if (in_flight && in_flight->cancelled) {
+                // Resubscribed before the first call was answered: take it over
+                *in_flight = *command;
+                continue;
+            }
+            if (reserve((void**)&shard->unsent, &shard->unsent_capacity, shard->unsent_count + 1, sizeof(PoolCommand))) {
+                shard->unsent[shard->unsent_count++] = *command;
+            }
+            continue;
+        }
+        for (int j = 0; j < shard->unsent_count; j++) {
+            if (strcmp(shard->unsent[j].channel, command->channel) == 0) {
+                shard->unsent[j] = shard->unsent[--shard->unsent_count];
+                break;
+            }
+        }
+        if (in_flight) {
+            in_flight->cancelled = true;
+        }
+        if (subscription_table_remove(&shard->subscriptions, command->channel) &&
+            ws_conn_state(shard->conn) == WS_CONN_OPEN) {
+            send_unsubscribe(shard, command->channel);
+        }
+    }
+    shard->command_count = 0;
+    pthread_mutex_unlock(&shard->lock);
+    flush_unsent(shard);
+}
+
+static bool queue_command(PoolShard* shard, const PoolCommand* command) {
+    pthread_mutex_lock(&shard->lock);
+    bool queued = reserve((void**)&shard->commands, &shard->command_capacity, shard->command_count + 1, sizeof(PoolCommand));
+    if (queued) {
+        shard->commands[shard->command_count++] = *command;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    uint64_t one = 1;
+    if (queued && write(shard->wake_fd, &one, sizeof(one)) < 0) {
+        // Counter saturated; the servicing thread is already due to wake
+    }
+    return queued;
+}
+
+// One epoll round on a shard; returns the notifications handled
+static uint64_t service(PoolShard* shard, int timeout_ms) {
+    uint64_t before = shard->messages;
+    struct epoll_event events[WS_POOL_MAX_EVENTS];
+    timeout_ms = timer_wheel_timeout_ms(&shard->timers, monotonic_ms(), timeout_ms);
+    int count = epoll_wait(shard->epoll_fd, events, WS_POOL_MAX_EVENTS, timeout_ms);
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.ptr == shard) {
+            drain_commands(shard);
+        } else {
+            ws_conn_handle_events(events[i].data.ptr, events[i].events);
+        }
+    }
+    ws_conn_check_timeout(shard->conn);
+    timer_wheel_advance(&shard->timers, monotonic_ms());
+    __atomic_store_n(&shard->state, (int)ws_conn_state(shard->conn), __ATOMIC_RELAXED);
+    if (shard->pool->config.compression) {
+        WsConnCompressionStats compression;
+        ws_conn_get_compression_stats(shard->conn, &compression);
+        __atomic_store_n(&shard->compressed, ws_conn_compression_active(shard->conn), __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->compression.compressed_bytes, compression.compressed_bytes, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->compression.inflated_bytes, compression.inflated_bytes, __ATOMIC_RELAXED);
+        __atomic_store_n(&shard->compression.inflate_ns, compression.inflate_ns, __ATOMIC_RELAXED);
+    }
+    return shard->messages - before;
+}
+
+static void* shard_main(void* arg) {
+    PoolShard* shard = arg;
+    while (__atomic_load_n(&shard->pool->running, __ATOMIC_ACQUIRE)) {
+        service(shard, WS_POOL_WAIT_MS);
+    }
+    return NULL;
+}
+
+static bool shard_init(WsPool* pool, PoolShard* shard, int index) {
+    shard->pool = pool;
+    shard->index = index;
+    shard->next_request_id = 1;
+    shard->random_state = (unsigned int)monotonic_ms() ^ (unsigned int)index * 0x9E3779B9u;
+    timer_init(&shard->reconnect_timer, on_reconnect_timer, shard);
+    shard->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    pthread_mutex_init(&shard->lock, NULL);
+    if (shard->epoll_fd < 0 || shard->wake_fd < 0 || !subscription_table_init(&shard->subscriptions, 0)) {
+        return false;
+    }
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = shard;
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, shard->wake_fd, &ev) != 0) {
+        return false;
+    }
+
+    WsConnHandlers handlers = {
+        .on_open = on_conn_open,
+        .on_message = on_conn_message,
+        .on_close = on_conn_close,
+        .on_error = on_conn_error
+    };
+    shard->conn = ws_conn_create(&handlers, shard);
+    if (!shard->conn) {
+        return false;
+    }
+    ws_conn_set_compression(shard->conn, pool->config.compression);
+    int keepalive = pool->config.keepalive_interval_ms;
+    timer_wheel_init(&shard->timers, WS_POOL_TIMER_TICK_MS, monotonic_ms());
+    if (keepalive > 0) {
+        ws_conn_set_keepalive(shard->conn, &shard->timers, keepalive, keepalive * WS_POOL_KEEPALIVE_MISSES);
+    }
+    return pool->config.receive_buffer == 0 || ws_conn_set_receive_buffer(shard->conn, pool->config.receive_buffer);
+}
+
+static void shard_free(PoolShard* shard) {
+    shard->closing = true;
+    timer_wheel_cancel(&shard->timers, &shard->reconnect_timer);
+    if (shard->conn) {
+        if (ws_conn_state(shard->conn) != WS_CONN_CLOSED) {
+            ws_conn_close(shard->conn, 1000, "Normal closure");
+            uint64_t deadline = monotonic_ms() + WS_POOL_CLOSE_WAIT_MS;
+            while (ws_conn_state(shard->conn) != WS_CONN_CLOSED && monotonic_ms() < deadline) {
+                service(shard, 10);
+            }
+        }
+        ws_conn_destroy(shard->conn);
+    }
+    fail_batches(shard);
+    if (shard->epoll_fd >= 0) {
+        close(shard->epoll_fd);
+    }
+    if (shard->wake_fd >= 0) {
+        close(shard->wake_fd);
+    }
+    pthread_mutex_destroy(&shard->lock);
+    subscription_table_free(&shard->subscriptions);
+    free(shard->commands);
+    free(shard->unsent);
+    free(shard->batches);
+}
+
+WsPool* ws_pool_create(const WsPoolConfig* config, WebSocketMessageCallback message_callback,
+                       WebSocketErrorCallback error_callback) {
+    if (!config || config->connections < 1 || config->connections > WS_POOL_MAX_CONNECTIONS) {
+        return NULL;
+    }
+    WsPool* pool = calloc(1, sizeof(WsPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->config = *config;
+    if (pool->config.connect_timeout_ms <= 0) {
+        pool->config.connect_timeout_ms = WS_POOL_DEFAULT_CONNECT_TIMEOUT_MS;
+    }
+    if (pool->config.reconnect_delay_ms <= 0) {
+        pool->config.reconnect_delay_ms = WS_POOL_DEFAULT_RECONNECT_DELAY_MS;
+    }
+    if (pool->config.max_reconnect_delay_ms <= 0) {
+        pool->config.max_reconnect_delay_ms = WS_POOL_DEFAULT_MAX_RECONNECT_DELAY_MS;
+    }
+    if (pool->config.max_reconnect_delay_ms < pool->config.reconnect_delay_ms) {
+        pool->config.max_reconnect_delay_ms = pool->config.reconnect_delay_ms;
+    }
+    pool->message_cb = message_callback;
+    pool->error_cb = error_callback;
+    pthread_mutex_init(&pool->lock, NULL);
+
+    pool->shards = calloc((size_t)config->connections, sizeof(PoolShard));
+    if (!pool->shards) {
+        free(pool);
+        return NULL;
+    }
+    for (int i = 0; i < config->connections; i++) {
+        pool->shards[i].epoll_fd = -1;
+        pool->shards[i].wake_fd = -1;
+    }
+    for (int i = 0; i < config->connections; i++) {
+        if (!shard_init(pool, &pool->shards[i], i)) {
+            ws_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void ws_pool_destroy(WsPool* pool) {
+    if (!pool) {
+        return;
+    }
+    ws_pool_stop(pool);
+    for (int i = 0; i < pool->config.connections; i++) {
+        shard_free(&pool->shards[i]);
+    }
+    free(pool->shards);
+    free(pool->placements);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+void ws_pool_set_credentials(WsPool* pool, const char* client_id, const char* client_secret) {
+    if (pool && client_id && client_secret) {
+        snprintf(pool->client_id, sizeof(pool->client_id), "%s", client_id);
+        snprintf(pool->client_secret, sizeof(pool->client_secret), "%s", client_secret);
+    }
+}
+
+bool ws_pool_connect(WsPool* pool, const char* url) {
+    if (!pool || !url || strlen(url) >= sizeof(pool->url) || __atomic_load_n(&pool->running, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    snprintf(pool->url, sizeof(pool->url), "%s", url);
+    printf("Connecting %d WebSocket pool connections to: %s\n", pool->config.connections, url);
+    bool ok = true;
+    for (int i = 0; i < pool->config.connections; i++) {
+        PoolShard* shard = &pool->shards[i];
+        if (ws_conn_state(shard->conn) == WS_CONN_CLOSED &&
+            !ws_conn_open(shard->conn, url, shard->epoll_fd, pool->config.connect_timeout_ms)) {
+            ok = false;
+        }
+        shard->state = (int)ws_conn_state(shard->conn);
+    }
+    return ok;
+}
+
+bool ws_pool_start(WsPool* pool) {
+    if (!pool || __atomic_load_n(&pool->running, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    __atomic_store_n(&pool->running, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < pool->config.connections; i++) {
+        PoolShard* shard = &pool->shards[i];
+        if (pthread_create(&shard->thread, NULL, shard_main, shard) != 0) {
+            ws_pool_stop(pool);
+            return false;
+        }
+        shard->thread_started = true;
+    }
+    return true;
+}
+
+void ws_pool_stop(WsPool* pool) {
+    if (!pool) {
+        return;
+    }
+    __atomic_store_n(&pool->running, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < pool->config.connections; i++) {
+        PoolShard* shard = &pool->shards[i];
+        if (shard->thread_started) {
+            uint64_t one = 1;
+            if (write(shard->wake_fd, &one, sizeof(one)) < 0) {
+                // Still wakes within WS_POOL_WAIT_MS
+            }
+            pthread_join(shard->thread, NULL);
+            shard->thread_started = false;
+        }
+    }
+}
+
+int ws_pool_poll(WsPool* pool, int connection, int timeout_ms) {
+    if (!pool || connection < 0 || connection >= pool->config.connections ||
+        __atomic_load_n(&pool->running, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    PoolShard* shard = &pool->shards[connection];
+    uint64_t deadline = monotonic_ms() + (uint64_t)(timeout_ms > 0 ? timeout_ms : 0);
+    uint64_t handled = 0;
+    for (;;) {
+        uint64_t now = monotonic_ms();
+        int wait_ms = now >= deadline ? 0 : (int)(deadline - now);
+        handled += service(shard, wait_ms < WS_POOL_WAIT_MS ? wait_ms : WS_POOL_WAIT_MS);
+        if (monotonic_ms() >= deadline) {
+            break;
+        }
+    }
+    return (int)handled;
+}
+
+static int find_placement(const WsPool* pool, const char* channel) {
+    for (int i = 0; i < pool->placement_count; i++) {
+        if (strcmp(pool->placements[i].channel, channel) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Least expected load wins, then fewest channels; user.* channels get
+// connection 0 to themselves when dedicated_private is set
+static int choose_connection(const WsPool* pool, const char* channel) {
+    int first = 0;
+    if (pool->config.dedicated_private && pool->config.connections > 1) {
+        if (strncmp(channel, "user.", 5) == 0) {
+            return 0;
+        }
+        first = 1;
+    }
+    int best = first;
+    for (int i = first + 1; i < pool->config.connections; i++) {
+        if (pool->loads[i] < pool->loads[best] ||
+            (pool->loads[i] == pool->loads[best] && pool->channel_counts[i] < pool->channel_counts[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+int ws_pool_subscribe(WsPool* pool, const SubscriptionRequest* request, double expected_rate,
+                      const MarketDataHandlers* handlers, WebSocketSubscriptionCallback callback) {
+    if (!pool || !request || (handlers && !market_data_has_decoder(request->type))) {
+        return -1;
+    }
+    PoolCommand command = {0};
+    command.type = POOL_COMMAND_SUBSCRIBE;
+    command.typed = handlers != NULL;
+    command.subscription_type = request->type;
+    command.callback = callback;
+    if (handlers) {
+        command.handlers = *handlers;
+    }
+    websocket_build_channel_name(command.channel, sizeof(command.channel), request->type,
+                                 request->instrument_name, request->interval, request->depth);
+
+    // A channel already placed is resubscribed where it is, rebinding handlers
+    pthread_mutex_lock(&pool->lock);
+    int placement = find_placement(pool, command.channel);
+    int connection;
+    if (placement >= 0) {
+        connection = pool->placements[placement].connection;
+    } else if (reserve((void**)&pool->placements, &pool->placement_capacity, pool->placement_count + 1,
+                       sizeof(PoolPlacement))) {
+        connection = choose_connection(pool, command.channel);
+        PoolPlacement* entry = &pool->placements[pool->placement_count++];
+        memcpy(entry->channel, command.channel, sizeof(entry->channel));
+        entry->connection = connection;
+        entry->expected_rate = expected_rate;
+        pool->loads[connection] += expected_rate;
+        pool->channel_counts[connection]++;
+    } else {
+        connection = -1;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (connection < 0 || !queue_command(&pool->shards[connection], &command)) {
+        return -1;
+    }
+    return connection;
+}
+
+bool ws_pool_unsubscribe(WsPool* pool, const char* channel) {
+    if (!pool || !channel) {
+        return false;
+    }
+    pthread_mutex_lock(&pool->lock);
+    int placement = find_placement(pool, channel);
+    int connection = -1;
+    if (placement >= 0) {
+        connection = pool->placements[placement].connection;
+        pool->loads[connection] -= pool->placements[placement].expected_rate;
+        pool->channel_counts[connection]--;
+        pool->placements[placement] = pool->placements[--pool->placement_count];
+    }
+    pthread_mutex_unlock(&pool->lock);
+    if (connection < 0) {
+        return false;
+    }
+
+    PoolCommand command = {0};
+    command.type = POOL_COMMAND_UNSUBSCRIBE;
+    snprintf(command.channel, sizeof(command.channel), "%s", channel);
+    return queue_command(&pool->shards[connection], &command);
+}
+
+int ws_pool_connection_of(WsPool* pool, const char* channel) {
+    if (!pool || !channel) {
+        return -1;
+    }
+    pthread_mutex_lock(&pool->lock);
+    int placement = find_placement(pool, channel);
+    int connection = placement >= 0 ? pool->placements[placement].connection : -1;
+    pthread_mutex_unlock(&pool->lock);
+    return connection;
+}
+
+bool ws_pool_get_stats(WsPool* pool, int connection, WsPoolConnectionStats* out) {
+    if (!pool || !out || connection < 0 || connection >= pool->config.connections) {
+        return false;
+    }
+    PoolShard* shard = &pool->shards[connection];
+    pthread_mutex_lock(&pool->lock);
+    out->channels = pool->channel_counts[connection];
+    out->expected_rate = pool->loads[connection];
+    pthread_mutex_unlock(&pool->lock);
+    out->state = (WsConnState)__atomic_load_n(&shard->state, __ATOMIC_RELAXED);
+    out->messages = __atomic_load_n(&shard->messages, __ATOMIC_RELAXED);
+    out->sequence_gaps = __atomic_load_n(&shard->sequence_gaps, __ATOMIC_RELAXED);
+    out->compressed = __atomic_load_n(&shard->compressed, __ATOMIC_RELAXED);
+    out->compressed_bytes = __atomic_load_n(&shard->compression.compressed_bytes, __ATOMIC_RELAXED);
+    out->inflated_bytes = __atomic_load_n(&shard->compression.inflated_bytes, __ATOMIC_RELAXED);
+    out->inflate_ns = __atomic_load_n(&shard->compression.inflate_ns, __ATOMIC_RELAXED);
+    out->reconnects = __atomic_load_n(&shard->reconnects, __ATOMIC_RELAXED);
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef WS_POOL_H
+#define WS_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "websocket_client.h"
+#include "market_data.h"
+#include "ws_conn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Market-data client over several WebSocket connections. Each channel is
+// placed on a connection by its expected message rate, so heavy book streams
+// do not share a socket and parser with latency-sensitive channels such as
+// user.orders. Every connection has its own epoll loop, subscription table
+// and decode scratch, and can be serviced by its own thread.
+//
+// Handlers and the message callback run on the thread servicing the
+// connection that carries the channel. The control calls (subscribe,
+// unsubscribe, stats) may be made from any thread.
+
+#define WS_POOL_MAX_CONNECTIONS 32
+
+typedef struct {
+    int connections;                // 1 .. WS_POOL_MAX_CONNECTIONS
+    bool dedicated_private;         // With 2+ connections, user.* channels get connection 0 to themselves
+    size_t receive_buffer;          // Per-connection receive ring, 0 for the default
+    int connect_timeout_ms;         // 0 for the default
+    int keepalive_interval_ms;      // Ping interval, 0 to disable; three silent intervals drop the connection
+    bool compression;               // Offer permessage-deflate on every connection
+    int reconnect_delay_ms;         // Backoff after a lost connection, doubling up to
+    int max_reconnect_delay_ms;     // the maximum; 0 for the defaults (1 s, 30 s)
+} WsPoolConfig;
+
+typedef struct {
+    WsConnState state;
+    int channels;                   // Placed on this connection
+    double expected_rate;           // Sum of their expected messages/s
+    uint64_t messages;              // Notifications received
+    uint64_t sequence_gaps;         // Book updates lost
+    bool compressed;                // permessage-deflate negotiated
+    uint64_t compressed_bytes;      // Compressed payload received, and the same after inflating
+    uint64_t inflated_bytes;
+    uint64_t inflate_ns;
+    uint64_t reconnects;            // Times reopened after a loss
+} WsPoolConnectionStats;
+
+typedef struct WsPool WsPool;
+
+WsPool* ws_pool_create(const WsPoolConfig* config, WebSocketMessageCallback message_callback,
+                       WebSocketErrorCallback error_callback);
+
+// Stops the threads and closes every connection
+void ws_pool_destroy(WsPool* pool);
+
+// Authenticate each connection with public/auth as soon as it opens (before
+// its subscriptions); set before ws_pool_connect
+void ws_pool_set_credentials(WsPool* pool, const char* client_id, const char* client_secret);
+
+// Start opening every connection; handshakes complete on the servicing threads.
+// A connection that is lost (or fails its handshake) is reopened with jittered
+// backoff and its channels resubscribed together once it is back.
+bool ws_pool_connect(WsPool* pool, const char* url);
+
+// Service every connection from its own thread until ws_pool_stop
+bool ws_pool_start(WsPool* pool);
+void ws_pool_stop(WsPool* pool);
+
+// Or service one connection from a caller-owned thread for up to timeout_ms;
+// returns the messages handled. Not while ws_pool_start threads run.
+int ws_pool_poll(WsPool* pool, int connection, int timeout_ms);
+
+// Place a channel on the least loaded eligible connection and subscribe there;
+// typed handlers are optional (NULL for raw messages). Returns the connection
+// index, -1 on failure. The callback runs on that connection's thread once the
+// server answers; requests made before the connection opens go out in one
+// batch when it does.
+int ws_pool_subscribe(WsPool* pool, const SubscriptionRequest* request, double expected_rate,
+                      const MarketDataHandlers* handlers, WebSocketSubscriptionCallback callback);
+bool ws_pool_unsubscribe(WsPool* pool, const char* channel);
+
+// Connection carrying a channel, -1 if not placed
+int ws_pool_connection_of(WsPool* pool, const char* channel);
+
+bool ws_pool_get_stats(WsPool* pool, int connection, WsPoolConnectionStats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WS_POOL_H